@@ -131,8 +131,9 @@ Aws::Client::ClientConfiguration common_config(const SdkOptions& options) {
 }
 
 Downloader::Downloader(std::shared_ptr<Synchronizer> synchronizer, int pool_size,
-                       std::shared_ptr<MetricsManager> metrics, const SdkOptions& options)
-    : queue_(synchronizer, pool_size),
+                       std::shared_ptr<MetricsManager> metrics, const SdkOptions& options,
+                       Executor* executor)
+    : queue_(synchronizer, pool_size, 1024, Lane::IO, executor),
       metrics_manager_(metrics),
       pool_size_(pool_size),
       synchronizer_(synchronizer) {
@@ -233,22 +234,42 @@ void Downloader::InitConnections(std::string bucket, int max_init_count) {
   }
 }
 
-void Downloader::ScheduleDownload(DownloadRequest request) {
+void Downloader::CancelInits() {
   // cancel all pending inits to replace them with real work
   {
     const std::lock_guard<std::mutex> lock(init_interruption_mutex_);
     init_counter_ = pool_size_;
   }
   init_interruption_cv_.notify_all();
-  // queue the request
-  queue_.PushRequest([request, this]() -> Result<DownloadResponse> {
-    metrics_manager_->NewEvent("get_obj_start");
-    ARROW_ASSIGN_OR_RAISE(auto result,
-                          GetObjectRange(dl_client_, request.path, request.range_start,
-                                         request.range_end, metrics_manager_));
-    metrics_manager_->NewEvent("get_obj_end");
-    return DownloadResponse{request, result.raw_data, result.file_size};
+}
+
+Result<DownloadResponse> Downloader::Fetch(const DownloadRequest& request) {
+  metrics_manager_->NewEvent("get_obj_start");
+  ARROW_ASSIGN_OR_RAISE(auto result,
+                        GetObjectRange(dl_client_, request.path, request.range_start,
+                                       request.range_end, metrics_manager_));
+  metrics_manager_->NewEvent("get_obj_end");
+  return DownloadResponse{request, result.raw_data, result.file_size};
+}
+
+void Downloader::ScheduleDownload(DownloadRequest request) {
+  CancelInits();
+  queue_.PushRequest([request, this]() { return Fetch(request); });
+}
+
+void Downloader::ScheduleDownload(DownloadRequest request,
+                                  DownloadCallback on_complete) {
+  CancelInits();
+  queue_.PushTask([request, on_complete, this]() { on_complete(Fetch(request)); });
+}
+
+std::future<Result<DownloadResponse>> Downloader::Download(DownloadRequest request) {
+  auto promise = std::make_shared<std::promise<Result<DownloadResponse>>>();
+  auto future = promise->get_future();
+  ScheduleDownload(std::move(request), [promise](Result<DownloadResponse> response) {
+    promise->set_value(std::move(response));
   });
+  return future;
 }
 
 std::vector<Result<DownloadResponse>> Downloader::ProcessResponses() {
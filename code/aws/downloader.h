@@ -18,14 +18,18 @@
 #pragma once
 
 #include <arrow/buffer.h>
+#include <aws/core/client/ClientConfiguration.h>
 #include <aws/s3/S3Client.h>
 #include <result.h>
 
 #include <condition_variable>
+#include <functional>
+#include <future>
 #include <string>
 #include <vector>
 
 #include "async_queue.h"
+#include "coro-scheduler.h"
 #include "metrics.h"
 #include "sdk-init.h"
 
@@ -58,24 +62,58 @@ struct DownloadResponse {
   int64_t file_size;
 };
 
+/// Called on the download thread once the download is over. The request is carried
+/// back with the response, any other context should be captured by the callback.
+using DownloadCallback = std::function<void(Result<DownloadResponse>)>;
+
+/// Configuration of the S3 clients for the given SDK options
+Aws::Client::ClientConfiguration common_config(const SdkOptions& options);
+
 class Downloader {
  public:
   /// The Synchronizer allows the downloader to notify the dispatcher when a new
-  /// download is ready
+  /// download is ready. The downloads run on the IO lane of `executor`, the default
+  /// one if null.
   Downloader(std::shared_ptr<Synchronizer> synchronizer, int pool_size,
-             std::shared_ptr<MetricsManager> metrics, const SdkOptions& options);
+             std::shared_ptr<MetricsManager> metrics, const SdkOptions& options,
+             Executor* executor = nullptr);
 
   /// max_init_count should be <= than pool_size
   /// TODO: if called again before previous init complete, behaviour is undefined
   void InitConnections(std::string bucket, int max_init_count);
 
-  /// Add a new download to the threadpool queue
+  /// Add a new download to the threadpool queue, its response is pushed to the
+  /// response queue and the synchronizer is notified
   void ScheduleDownload(DownloadRequest request);
 
+  /// Add a new download to the threadpool queue, `on_complete` runs the next stage
+  /// directly on the download thread without going through the response queue. It
+  /// holds back a download slot, so heavy work should be handed to the CPU lane.
+  void ScheduleDownload(DownloadRequest request, DownloadCallback on_complete);
+
+  /// Same as the callback variant, with the response delivered through a future
+  std::future<Result<DownloadResponse>> Download(DownloadRequest request);
+
+#if BUZZ_HAS_COROUTINES
+  /// `co_await downloader.Get(request)` suspends the coroutine until the download is
+  /// over, it then resumes on the given lane
+  auto Get(DownloadRequest request, Executor* executor = &Executor::Default(),
+           Lane lane = Lane::CPU) {
+    return MakeCallbackAwaitable<Result<DownloadResponse>>(
+        [this, request = std::move(request)](DownloadCallback on_complete) mutable {
+          ScheduleDownload(std::move(request), std::move(on_complete));
+        },
+        executor, lane);
+  }
+#endif
+
   /// Get all the responses in the response queue
   std::vector<Result<DownloadResponse>> ProcessResponses();
 
  private:
+  void CancelInits();
+  Result<DownloadResponse> Fetch(const DownloadRequest& request);
+
   int pool_size_;
   std::shared_ptr<Synchronizer> synchronizer_;
   AsyncQueue<DownloadResponse> queue_;
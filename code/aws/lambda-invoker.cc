@@ -0,0 +1,392 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "lambda-invoker.h"
+
+#include <aws/core/auth/AWSAuthSigner.h>
+#include <aws/core/auth/AWSCredentialsProviderChain.h>
+#include <aws/core/http/standard/StandardHttpRequest.h>
+#include <aws/core/utils/memory/stl/AWSStringStream.h>
+#include <curl/curl.h>
+#include <toolbox.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+
+namespace Buzz {
+
+namespace {
+/// poll interval of the event loop while requests are in flight, it bounds the delay
+/// before newly submitted invocations are sent
+const int kPollMs = 2;
+
+size_t WriteResponse(char* data, size_t size, size_t nmemb, void* userdata) {
+  static_cast<std::string*>(userdata)->append(data, size * nmemb);
+  return size * nmemb;
+}
+
+/// Lambda endpoint of the region, unless it is overridden (e.g. by a local emulator)
+std::string LambdaEndpoint(const SdkOptions& options) {
+  return options.scheme + "://" +
+         (options.endpoint_override.empty()
+              ? "lambda." + options.region + ".amazonaws.com"
+              : options.endpoint_override);
+}
+
+std::string InvocationUrl(const std::string& endpoint, const std::string& function_name) {
+  return endpoint + "/2015-03-31/functions/" + function_name + "/invocations";
+}
+
+/// The headers of a signed request for curl, which should not wait for a 100-continue
+/// from the server before sending the body
+template <typename Headers>
+curl_slist* MakeCurlHeaders(const Headers& headers) {
+  auto curl_headers = curl_slist_append(nullptr, "expect:");
+  for (auto& header : headers) {
+    auto line = header.first + ": " + header.second;
+    curl_headers = curl_slist_append(curl_headers, line.c_str());
+  }
+  return curl_headers;
+}
+
+/// HTTP/2 multiplexes the invocations on few connections, but libcurl might be built
+/// without it
+long PreferredHttpVersion(const curl_version_info_data& info) {  // NOLINT
+  return (info.features & CURL_VERSION_HTTP2) != 0 ? CURL_HTTP_VERSION_2TLS
+                                                   : CURL_HTTP_VERSION_1_1;
+}
+
+enum class AttemptOutcome : int8_t { Accepted, Retry, Failed };
+
+/// Throttled (429), failed (5xx) and network errors are retried while attempts remain
+AttemptOutcome ClassifyAttempt(CURLcode code, long http_code,  // NOLINT
+                               int attempts, int max_attempts) {
+  if (code == CURLE_OK && http_code >= 200 && http_code < 300) {
+    return AttemptOutcome::Accepted;
+  }
+  auto retryable = code != CURLE_OK || http_code == 429 || http_code >= 500;
+  if (retryable && attempts < max_attempts) {
+    return AttemptOutcome::Retry;
+  }
+  return AttemptOutcome::Failed;
+}
+
+std::string AttemptError(CURLcode code, long http_code,  // NOLINT
+                         const std::string& response) {
+  return code != CURLE_OK ? std::string(curl_easy_strerror(code))
+                          : "HTTP " + std::to_string(http_code) + " " + response;
+}
+
+struct Invocation {
+  int64_t id;
+  std::string url;
+  std::string payload;
+  curl_slist* headers = nullptr;
+  int attempts = 0;
+  time::time_point first_attempt;
+  time::time_point not_before;
+  std::string response;
+
+  ~Invocation() { curl_slist_free_all(headers); }
+};
+}  // namespace
+
+class LambdaInvoker::Impl {
+ public:
+  Impl(std::shared_ptr<Synchronizer> synchronizer, const SdkOptions& options,
+       const InvokerOptions& invoker_options)
+      : synchronizer_(synchronizer),
+        options_(invoker_options),
+        region_(options.region),
+        signer_(Aws::MakeShared<Aws::Auth::DefaultAWSCredentialsProviderChain>(
+                    "LambdaInvoker"),
+                "lambda", options.region.c_str()),
+        rng_(std::random_device()()),
+        endpoint_(LambdaEndpoint(options)),
+        http_version_(PreferredHttpVersion(*curl_version_info(CURLVERSION_NOW))) {
+    multi_ = curl_multi_init();
+    curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS,
+                      static_cast<long>(options_.max_connections));  // NOLINT
+    curl_multi_setopt(multi_, CURLMOPT_MAXCONNECTS,
+                      static_cast<long>(options_.max_connections));  // NOLINT
+    curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    loop_ = std::thread([this]() { Loop(); });
+  }
+
+  ~Impl() {
+    {
+      std::lock_guard<std::mutex> lock(submitted_mutex_);
+      stop_ = true;
+    }
+    submitted_cv_.notify_one();
+    loop_.join();
+    for (auto& easy : idle_handles_) {
+      curl_easy_cleanup(easy);
+    }
+    curl_multi_cleanup(multi_);
+  }
+
+  int64_t Invoke(const std::string& function_name, const std::string& payload) {
+    auto invocation = std::make_unique<Invocation>();
+    invocation->url = InvocationUrl(endpoint_, function_name);
+    invocation->payload = payload;
+    auto status = Sign(invocation.get());
+    std::lock_guard<std::mutex> lock(submitted_mutex_);
+    invocation->id = next_id_++;
+    if (!status.ok()) {
+      PushResponse(status.WithMessage("Invoke ", invocation->id, ": ", status.message()));
+    } else {
+      submitted_.push_back(std::move(invocation));
+      submitted_cv_.notify_one();
+    }
+    return next_id_ - 1;
+  }
+
+  std::vector<Result<InvokeResponse>> ProcessResponses() {
+    std::vector<Result<InvokeResponse>> result;
+    std::lock_guard<std::mutex> lock(responses_mutex_);
+    result.reserve(responses_.size());
+    while (!responses_.empty()) {
+      result.push_back(responses_.front());
+      responses_.pop();
+    }
+    synchronizer_->consume(result.size());
+    return result;
+  }
+
+  int64_t LatencyQuantileUs(double quantile) const {
+    std::lock_guard<std::mutex> lock(responses_mutex_);
+    if (latencies_us_.empty()) {
+      return 0;
+    }
+    auto sorted = latencies_us_;
+    auto rank =
+        std::min(sorted.size() - 1, static_cast<size_t>(quantile * sorted.size()));
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+  }
+
+ private:
+  /// SigV4 sign the request and keep its headers for curl, the body is signed like
+  /// the SDK LambdaClient does
+  Status Sign(Invocation* invocation) {
+    Aws::Http::Standard::StandardHttpRequest request(
+        Aws::Http::URI(invocation->url.c_str()), Aws::Http::HttpMethod::HTTP_POST);
+    auto body = Aws::MakeShared<Aws::StringStream>("LambdaInvoker");
+    *body << invocation->payload;
+    request.AddContentBody(body);
+    request.SetContentType("application/json");
+    request.SetContentLength(std::to_string(invocation->payload.size()));
+    request.SetHeaderValue("x-amz-invocation-type", "Event");
+    if (!signer_.SignRequest(request, region_.c_str(), "lambda", true)) {
+      return Status::IOError("Failed to sign the Lambda invocation");
+    }
+    curl_slist_free_all(invocation->headers);
+    invocation->headers = MakeCurlHeaders(request.GetHeaders());
+    return Status::OK();
+  }
+
+  void PushResponse(Result<InvokeResponse> response) {
+    {
+      std::lock_guard<std::mutex> lock(responses_mutex_);
+      if (response.ok()) {
+        latencies_us_.push_back(response.ValueOrDie().latency_us);
+      }
+      responses_.push(std::move(response));
+    }
+    synchronizer_->notify();
+  }
+
+  int BackoffMs(int retry) {
+    int64_t ceiling = int64_t{options_.base_backoff_ms} << std::min(retry, 20);
+    ceiling = std::min<int64_t>(ceiling, options_.max_backoff_ms);
+    return std::uniform_int_distribution<int>(0, static_cast<int>(ceiling))(rng_);
+  }
+
+  void Start(std::unique_ptr<Invocation> invocation) {
+    CURL* easy;
+    if (idle_handles_.empty()) {
+      easy = curl_easy_init();
+    } else {
+      easy = idle_handles_.back();
+      idle_handles_.pop_back();
+      curl_easy_reset(easy);
+    }
+    if (invocation->attempts == 0) {
+      invocation->first_attempt = time::now();
+    }
+    invocation->attempts++;
+    invocation->response.clear();
+    curl_easy_setopt(easy, CURLOPT_URL, invocation->url.c_str());
+    curl_easy_setopt(easy, CURLOPT_POST, 1L);
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDS, invocation->payload.data());
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE,
+                     static_cast<curl_off_t>(invocation->payload.size()));
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, invocation->headers);
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, WriteResponse);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &invocation->response);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS,
+                     static_cast<long>(options_.attempt_timeout_ms));  // NOLINT
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, http_version_);
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, invocation.get());
+    curl_multi_add_handle(multi_, easy);
+    in_flight_[easy] = std::move(invocation);
+  }
+
+  void Complete(CURL* easy, CURLcode code) {
+    curl_multi_remove_handle(multi_, easy);
+    auto invocation = std::move(in_flight_[easy]);
+    in_flight_.erase(easy);
+    long http_code = 0;  // NOLINT
+    curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &http_code);
+    idle_handles_.push_back(easy);
+
+    switch (ClassifyAttempt(code, http_code, invocation->attempts,
+                            options_.max_attempts)) {
+      case AttemptOutcome::Accepted:
+        PushResponse(InvokeResponse{
+            invocation->id, invocation->attempts,
+            util::get_duration_micro(invocation->first_attempt, time::now())});
+        return;
+      case AttemptOutcome::Retry:
+        invocation->not_before =
+            time::now() + std::chrono::milliseconds(BackoffMs(invocation->attempts - 1));
+        backing_off_.push_back(std::move(invocation));
+        return;
+      case AttemptOutcome::Failed:
+        PushResponse(Status::IOError(
+            "Invoke ", invocation->id, " failed after ", invocation->attempts,
+            " attempts: ", AttemptError(code, http_code, invocation->response)));
+        return;
+    }
+  }
+
+  void Loop() {
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(submitted_mutex_);
+        if (in_flight_.empty() && ready_.empty() && backing_off_.empty()) {
+          submitted_cv_.wait(lock, [this]() { return stop_ || !submitted_.empty(); });
+        }
+        if (stop_) {
+          break;
+        }
+        for (auto& invocation : submitted_) {
+          ready_.push_back(std::move(invocation));
+        }
+        submitted_.clear();
+      }
+      // the retries are signed again as the previous signature might be stale
+      auto now = time::now();
+      for (auto it = backing_off_.begin(); it != backing_off_.end();) {
+        if ((*it)->not_before > now) {
+          ++it;
+          continue;
+        }
+        auto status = Sign(it->get());
+        if (status.ok()) {
+          ready_.push_back(std::move(*it));
+        } else {
+          PushResponse(status.WithMessage("Invoke ", (*it)->id, ": ", status.message()));
+        }
+        it = backing_off_.erase(it);
+      }
+      while (!ready_.empty() &&
+             static_cast<int>(in_flight_.size()) < options_.max_in_flight) {
+        Start(std::move(ready_.front()));
+        ready_.pop_front();
+      }
+
+      int running;
+      curl_multi_perform(multi_, &running);
+      CURLMsg* message;
+      int remaining;
+      while ((message = curl_multi_info_read(multi_, &remaining)) != nullptr) {
+        if (message->msg == CURLMSG_DONE) {
+          Complete(message->easy_handle, message->data.result);
+        }
+      }
+      if (!in_flight_.empty()) {
+        curl_multi_wait(multi_, nullptr, 0, kPollMs, nullptr);
+      } else if (ready_.empty() && !backing_off_.empty()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kPollMs));
+      }
+    }
+    for (auto& invocation : in_flight_) {
+      curl_multi_remove_handle(multi_, invocation.first);
+      idle_handles_.push_back(invocation.first);
+    }
+  }
+
+  std::shared_ptr<Synchronizer> synchronizer_;
+  InvokerOptions options_;
+  std::string region_;
+  Aws::Client::AWSAuthV4Signer signer_;
+  std::mt19937 rng_;
+  std::string endpoint_;
+  long http_version_;  // NOLINT
+
+  // submitted by the callers, guarded by submitted_mutex_
+  std::mutex submitted_mutex_;
+  std::condition_variable submitted_cv_;
+  std::vector<std::unique_ptr<Invocation>> submitted_;
+  int64_t next_id_ = 0;
+  bool stop_ = false;
+
+  // only accessed by the event loop
+  CURLM* multi_;
+  std::deque<std::unique_ptr<Invocation>> ready_;
+  std::vector<std::unique_ptr<Invocation>> backing_off_;
+  std::map<CURL*, std::unique_ptr<Invocation>> in_flight_;
+  std::vector<CURL*> idle_handles_;
+
+  mutable std::mutex responses_mutex_;
+  std::queue<Result<InvokeResponse>> responses_;
+  std::vector<int64_t> latencies_us_;
+
+  std::thread loop_;
+};
+
+LambdaInvoker::LambdaInvoker(std::shared_ptr<Synchronizer> synchronizer,
+                             const SdkOptions& options,
+                             const InvokerOptions& invoker_options)
+    : impl_(new Impl(synchronizer, options, invoker_options)) {}
+
+LambdaInvoker::~LambdaInvoker() = default;
+
+int64_t LambdaInvoker::Invoke(const std::string& function_name,
+                              const std::string& payload) {
+  return impl_->Invoke(function_name, payload);
+}
+
+std::vector<Result<InvokeResponse>> LambdaInvoker::ProcessResponses() {
+  return impl_->ProcessResponses();
+}
+
+int64_t LambdaInvoker::LatencyQuantileUs(double quantile) const {
+  return impl_->LatencyQuantileUs(quantile);
+}
+
+}  // namespace Buzz
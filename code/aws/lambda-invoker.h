@@ -0,0 +1,83 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <result.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "async_queue.h"
+#include "sdk-init.h"
+
+namespace Buzz {
+
+struct InvokerOptions {
+  /// invocations sent concurrently, the others wait in the invoker queue
+  int max_in_flight = 256;
+  /// connections kept alive to the Lambda endpoint, reused across invocations
+  int max_connections = 64;
+  /// attempts of an invocation before it is reported as failed
+  int max_attempts = 5;
+  /// retry n waits a random delay below min(max_backoff_ms, base_backoff_ms * 2^n)
+  int base_backoff_ms = 25;
+  int max_backoff_ms = 2000;
+  /// timeout of each attempt
+  int attempt_timeout_ms = 10000;
+};
+
+struct InvokeResponse {
+  int64_t invoke_id;
+  /// attempts it took, including the accepted one
+  int attempts;
+  /// from the first attempt until Lambda accepted the invocation
+  int64_t latency_us;
+};
+
+/// Send asynchronous (Event) Lambda invocations at a high rate:
+/// - the requests are signed when they are submitted, so that sending them is only IO
+/// - a single thread multiplexes all the requests in flight over a pool of keep-alive
+///   connections (curl multi interface)
+/// - throttled (429) and failed (5xx, network) attempts are retried with a jittered
+///   exponential backoff, the invocations that exhaust their attempts are reported
+///   as errors instead of stopping the process
+class LambdaInvoker {
+ public:
+  /// The Synchronizer allows the invoker to notify the dispatcher when an invocation
+  /// is accepted or failed
+  LambdaInvoker(std::shared_ptr<Synchronizer> synchronizer, const SdkOptions& options,
+                const InvokerOptions& invoker_options = {});
+  ~LambdaInvoker();
+
+  /// Sign the invocation of `function_name` with the JSON `payload` and queue it,
+  /// returns the id of the invocation
+  int64_t Invoke(const std::string& function_name, const std::string& payload);
+
+  /// Get all the invocations accepted or failed since the last call
+  std::vector<Result<InvokeResponse>> ProcessResponses();
+
+  /// The quantile (e.g. 0.5 or 0.99) of the latency of the accepted invocations
+  int64_t LatencyQuantileUs(double quantile) const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace Buzz
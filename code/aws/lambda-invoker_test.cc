@@ -0,0 +1,83 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "lambda-invoker.cc"
+
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <vector>
+
+namespace Buzz {
+
+TEST(InvokerHelpers, InvocationUrl) {
+  SdkOptions options;
+  options.region = "eu-west-1";
+  ASSERT_EQ(LambdaEndpoint(options), "https://lambda.eu-west-1.amazonaws.com");
+  ASSERT_EQ(InvocationUrl("https://lambda", "bee"),
+            "https://lambda/2015-03-31/functions/bee/invocations");
+  options.endpoint_override = "localhost:9001";
+  options.scheme = "http";
+  ASSERT_EQ(LambdaEndpoint(options), "http://localhost:9001");
+}
+
+TEST(InvokerHelpers, MakeCurlHeaders) {
+  std::map<std::string, std::string> headers = {
+      {"authorization", "AWS4-HMAC-SHA256 Credential=x"},
+      {"x-amz-invocation-type", "Event"}};
+  auto curl_headers = MakeCurlHeaders(headers);
+  std::vector<std::string> lines;
+  for (auto header = curl_headers; header != nullptr; header = header->next) {
+    lines.push_back(header->data);
+  }
+  curl_slist_free_all(curl_headers);
+  std::vector<std::string> expected = {"expect:",
+                                       "authorization: AWS4-HMAC-SHA256 Credential=x",
+                                       "x-amz-invocation-type: Event"};
+  ASSERT_EQ(lines, expected);
+}
+
+TEST(InvokerHelpers, PreferredHttpVersion) {
+  curl_version_info_data info{};
+  info.features = CURL_VERSION_SSL | CURL_VERSION_HTTP2;
+  ASSERT_EQ(PreferredHttpVersion(info), CURL_HTTP_VERSION_2TLS);
+  info.features = CURL_VERSION_SSL;
+  ASSERT_EQ(PreferredHttpVersion(info), CURL_HTTP_VERSION_1_1);
+}
+
+TEST(InvokerHelpers, ClassifyAttempt) {
+  ASSERT_EQ(ClassifyAttempt(CURLE_OK, 202, 1, 3), AttemptOutcome::Accepted);
+  // accepted even on the last attempt
+  ASSERT_EQ(ClassifyAttempt(CURLE_OK, 200, 3, 3), AttemptOutcome::Accepted);
+  ASSERT_EQ(ClassifyAttempt(CURLE_OK, 429, 1, 3), AttemptOutcome::Retry);
+  ASSERT_EQ(ClassifyAttempt(CURLE_OK, 503, 2, 3), AttemptOutcome::Retry);
+  ASSERT_EQ(ClassifyAttempt(CURLE_OPERATION_TIMEDOUT, 0, 1, 3), AttemptOutcome::Retry);
+  ASSERT_EQ(ClassifyAttempt(CURLE_OK, 429, 3, 3), AttemptOutcome::Failed);
+  // client errors such as a missing function are not retried
+  ASSERT_EQ(ClassifyAttempt(CURLE_OK, 404, 1, 3), AttemptOutcome::Failed);
+  ASSERT_EQ(ClassifyAttempt(CURLE_OK, 403, 1, 3), AttemptOutcome::Failed);
+}
+
+TEST(InvokerHelpers, AttemptError) {
+  ASSERT_EQ(AttemptError(CURLE_OK, 404, "{\"Message\":\"Function not found\"}"),
+            "HTTP 404 {\"Message\":\"Function not found\"}");
+  ASSERT_EQ(AttemptError(CURLE_COULDNT_CONNECT, 0, ""),
+            curl_easy_strerror(CURLE_COULDNT_CONNECT));
+}
+
+}  // namespace Buzz
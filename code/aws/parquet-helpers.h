@@ -20,57 +20,32 @@
 #include <arrow/api.h>
 #include <parquet/arrow/reader.h>
 
+#include <functional>
+#include <future>
 #include <iostream>
 
+#include "dictionary-filter.h"
 #include "downloader.h"
+#include "footer-payload.h"
 #include "partial-file.h"
 
 namespace Buzz {
 
-namespace {
-
-struct RequestWeakHash {
-  std::size_t operator()(const DownloadRequest& a) const {
-    return std::hash<int>()(a.range_end);
-  }
-};
-
-struct RequestEqual {
-  bool operator()(const DownloadRequest& a, const DownloadRequest& b) const {
-    return a.path.bucket == b.path.bucket && a.path.key == b.path.key &&
-           a.range_start == b.range_start && a.range_end == b.range_end;
-  }
-};
-
-struct ParquetColumnChunckIds {
+struct ColChunckFile {
+  S3Path path;
   int row_group;
   int column;
+  /// if true, the file only contains the dictionary page of the column chunck
+  bool dictionary_page;
+  std::shared_ptr<PartialFile> file;
 };
 
-}  // namespace
-
-std::unordered_map<DownloadRequest, ParquetColumnChunckIds, RequestWeakHash, RequestEqual>
-    rg_start_map;
-
-std::shared_ptr<parquet::FileMetaData> GetMetadata(
-    std::shared_ptr<Downloader> downloader, std::shared_ptr<Synchronizer> synchronizer,
-    arrow::MemoryPool* mem_pool, S3Path path, int nb_init) {
-  downloader->ScheduleDownload({std::nullopt, 64 * 1024, path});
-
-  downloader->InitConnections(path.bucket, nb_init);
-
-  DownloadResponse footer_response{{}, nullptr, 0};
-  while (footer_response.file_size == 0) {
-    synchronizer->wait();
-    auto results = downloader->ProcessResponses();
-    for (auto& result : results) {
-      auto response = result.ValueOrDie();
-      if (response.request.range_start.value_or(0) != 0 ||
-          response.request.range_end != 0) {
-        footer_response = response;
-      }
-    }
-  }
+/// Called on the download thread with the downloaded column chunck
+using ColChunckCallback = std::function<void(Result<ColChunckFile>)>;
+
+/// Parse the footer from the download of the end of the file
+std::shared_ptr<parquet::FileMetaData> ParseFooterResponse(
+    const DownloadResponse& footer_response, arrow::MemoryPool* mem_pool) {
   auto footer_start_pos = footer_response.file_size - footer_response.request.range_end;
   std::vector<FileChunck> footer_chuncks{{footer_start_pos, footer_response.raw_data}};
   auto footer_file =
@@ -81,49 +56,115 @@ std::shared_ptr<parquet::FileMetaData> GetMetadata(
   std::unique_ptr<parquet::ParquetFileReader> parquet_reader =
       parquet::ParquetFileReader::Open(footer_file, props, nullptr);
 
+  return parquet_reader->metadata();
+}
+
+std::shared_ptr<parquet::FileMetaData> GetMetadata(std::shared_ptr<Downloader> downloader,
+                                                   arrow::MemoryPool* mem_pool,
+                                                   S3Path path, int nb_init) {
+  auto footer_download = downloader->Download({std::nullopt, 64 * 1024, path});
+
+  if (nb_init > 0) {
+    downloader->InitConnections(path.bucket, nb_init);
+  }
+
   // Get the File MetaData
-  std::shared_ptr<parquet::FileMetaData> file_metadata = parquet_reader->metadata();
+  auto footer_response = footer_download.get().ValueOrDie();
+  auto file_metadata = ParseFooterResponse(footer_response, mem_pool);
   std::cout << "file_metadata->num_rows:" << file_metadata->num_rows() << std::endl;
 
   return file_metadata;
 }
 
+/// Fetch the footers of several files of a bucket concurrently, in the order of `paths`
+std::vector<std::shared_ptr<parquet::FileMetaData>> GetMetadatas(
+    std::shared_ptr<Downloader> downloader, arrow::MemoryPool* mem_pool,
+    const std::vector<S3Path>& paths, int nb_init) {
+  std::vector<std::future<Result<DownloadResponse>>> footer_downloads;
+  for (auto& path : paths) {
+    footer_downloads.push_back(downloader->Download({std::nullopt, 64 * 1024, path}));
+  }
+  if (!paths.empty() && nb_init > 0) {
+    downloader->InitConnections(paths[0].bucket, nb_init);
+  }
+
+  std::vector<std::shared_ptr<parquet::FileMetaData>> file_metadatas;
+  for (auto& footer_download : footer_downloads) {
+    file_metadatas.push_back(
+        ParseFooterResponse(footer_download.get().ValueOrDie(), mem_pool));
+  }
+  return file_metadatas;
+}
+
+/// Use the footer of the invocation payload if there is one, otherwise fetch it
+std::shared_ptr<parquet::FileMetaData> GetMetadata(std::shared_ptr<Downloader> downloader,
+                                                   arrow::MemoryPool* mem_pool,
+                                                   S3Path path, int nb_init,
+                                                   const FooterPayload& payload) {
+  if (payload.file_metadata == nullptr) {
+    return GetMetadata(downloader, mem_pool, path, nb_init);
+  }
+  // the connections are still opened ahead of the column chunck downloads
+  if (nb_init > 0) {
+    downloader->InitConnections(path.bucket, nb_init);
+  }
+  std::cout << "file_metadata->num_rows:" << payload.file_metadata->num_rows()
+            << " (from payload)" << std::endl;
+  return payload.file_metadata;
+}
+
+/// Schedule the download of a byte range of a column chunck, `on_complete` gets the
+/// chunck ids back with the data
+void DownloadColumnChunckRange(std::shared_ptr<Downloader> downloader, S3Path path,
+                               int row_group, int column, bool dictionary_page,
+                               int64_t start, int64_t end,
+                               ColChunckCallback on_complete) {
+  downloader->ScheduleDownload(
+      {start, end, path}, [path, row_group, column, dictionary_page,
+                           on_complete](Result<DownloadResponse> result) {
+        if (!result.ok()) {
+          on_complete(result.status());
+          return;
+        }
+        auto& response = result.ValueUnsafe();
+        std::vector<FileChunck> rg_chuncks{
+            {response.request.range_start.value(), response.raw_data}};
+        on_complete(ColChunckFile{
+            path, row_group, column, dictionary_page,
+            std::make_shared<PartialFile>(rg_chuncks, response.file_size)});
+      });
+}
+
 void DownloadColumnChunck(std::shared_ptr<Downloader> downloader,
                           std::shared_ptr<parquet::FileMetaData> file_metadata,
-                          S3Path path, int row_group, int column) {
+                          S3Path path, int row_group, int column,
+                          ColChunckCallback on_complete) {
   auto col_chunck_meta = file_metadata->RowGroup(row_group)->ColumnChunk(column);
   auto col_chunck_start = col_chunck_meta->file_offset();
   auto col_chunck_end = col_chunck_start + col_chunck_meta->total_compressed_size();
-  downloader->ScheduleDownload({col_chunck_start, col_chunck_end, path});
-  rg_start_map.emplace(DownloadRequest{col_chunck_start, col_chunck_end, path},
-                       ParquetColumnChunckIds{row_group, column});
+  DownloadColumnChunckRange(downloader, path, row_group, column, false,
+                            col_chunck_start, col_chunck_end, std::move(on_complete));
 }
 
-struct ColChunckFile {
-  int row_group;
-  int column;
-  std::shared_ptr<PartialFile> file;
-};
+/// Download only the dictionary page of a column chunck
+void DownloadDictionaryPage(std::shared_ptr<Downloader> downloader, S3Path path,
+                            int row_group, int column, DictionaryPageRange range,
+                            ColChunckCallback on_complete) {
+  DownloadColumnChunckRange(downloader, path, row_group, column, true, range.start,
+                            range.end, std::move(on_complete));
+}
 
-std::vector<ColChunckFile> GetColumnChunckFiles(std::shared_ptr<Downloader> downloader) {
-  auto results = downloader->ProcessResponses();
-  std::vector<ColChunckFile> rg_files;
-  for (auto& result : results) {
-    if (result.status().message() == STATUS_ABORTED.message()) {
-      continue;
-    }
-    auto response = result.ValueOrDie();
-    if (response.request.range_start.value_or(0) == 0 &&
-        response.request.range_end == 0) {
-      continue;
-    }
-    std::vector<FileChunck> rg_chuncks{
-        {response.request.range_start.value(), response.raw_data}};
-    auto chunck_ids = rg_start_map[response.request];
-    rg_files.push_back({chunck_ids.row_group, chunck_ids.column,
-                        std::make_shared<PartialFile>(rg_chuncks, response.file_size)});
-  }
-  return rg_files;
+#if BUZZ_HAS_COROUTINES
+/// `co_await` the download of a column chunck, the coroutine resumes on the CPU lane
+auto GetColumnChunck(std::shared_ptr<Downloader> downloader,
+                     std::shared_ptr<parquet::FileMetaData> file_metadata, S3Path path,
+                     int row_group, int column) {
+  return MakeCallbackAwaitable<Result<ColChunckFile>>(
+      [=](ColChunckCallback on_complete) {
+        DownloadColumnChunck(downloader, file_metadata, path, row_group, column,
+                             std::move(on_complete));
+      });
 }
+#endif
 
 }  // namespace Buzz
@@ -0,0 +1,245 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <arrow/api.h>
+#include <arrow/io/memory.h>
+#include <aws/lambda-runtime/runtime.h>
+#include <parquet/api/reader.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/exception.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "async_queue.h"
+#include "bootstrap.h"
+#include "cpu-topology.h"
+#include "downloader.h"
+#include "executor.h"
+#include "parquet-helpers.h"
+#include "partial-file.h"
+#include "sdk-init.h"
+#include "toolbox.h"
+
+using namespace Buzz;
+
+static const int NB_ROW_GROUPS = util::getenv_int("NB_ROW_GROUPS", 64);
+static const int64_t ROWS_PER_GROUP = util::getenv_int("ROWS_PER_GROUP", 100000);
+static const int NB_RUNS = util::getenv_int("NB_RUNS", 3);
+// simulated latency of the download of each column chunck, spent on the IO lane
+static const int FETCH_MICROS = util::getenv_int("FETCH_MICROS", 2000);
+static const int MAX_CONCURRENT_DL = util::getenv_int("MAX_CONCURRENT_DL", 8);
+// if not empty, the column chuncks of COLUMN_ID are downloaded from S3 and decoded the
+// way the readers do instead of the generated file
+static const std::string KEY_NAME = util::getenv("KEY_NAME", "");
+static const char* BUCKET_NAME = util::getenv("BUCKET_NAME", "defaultbucket");
+static const int64_t COLUMN_ID = util::getenv_int("COLUMN_ID", 16);
+static const int NB_CONN_INIT = util::getenv_int("NB_CONN_INIT", 1);
+static const bool IS_LOCAL = util::getenv_bool("IS_LOCAL", false);
+
+namespace {
+
+constexpr int64_t BATCH_SIZE = 1024 * 2;
+
+/// Gzipped random int64 column, decoding it keeps a core busy
+std::shared_ptr<arrow::Buffer> WriteFile() {
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<int64_t> value_dist(0, 1 << 20);
+  arrow::Int64Builder builder;
+  for (int64_t i = 0; i < NB_ROW_GROUPS * ROWS_PER_GROUP; i++) {
+    PARQUET_THROW_NOT_OK(builder.Append(value_dist(rng)));
+  }
+  std::shared_ptr<arrow::Array> values;
+  PARQUET_THROW_NOT_OK(builder.Finish(&values));
+  auto schema = arrow::schema({arrow::field("value", arrow::int64())});
+  auto table = arrow::Table::Make(schema, {values});
+  auto sink = arrow::io::BufferOutputStream::Create().ValueOrDie();
+  auto props = parquet::WriterProperties::Builder()
+                   .compression(parquet::Compression::GZIP)
+                   ->build();
+  PARQUET_THROW_NOT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(),
+                                                  sink, ROWS_PER_GROUP, props));
+  return sink->Finish().ValueOrDie();
+}
+
+/// Decode a column chunck the way the raw reader does
+int64_t ScanColumnChunck(const std::shared_ptr<PartialFile>& chunck_file,
+                         const std::shared_ptr<parquet::FileMetaData>& metadata, int rg) {
+  auto reader = parquet::ParquetFileReader::Open(chunck_file,
+                                                 parquet::default_reader_properties(),
+                                                 metadata);
+  auto column = reader->RowGroup(rg)->Column(0);
+  auto typed_reader = static_cast<parquet::Int64Reader*>(column.get());
+  std::vector<int64_t> values(BATCH_SIZE);
+  int64_t sum = 0;
+  while (typed_reader->HasNext()) {
+    int64_t values_read = 0;
+    typed_reader->ReadBatch(BATCH_SIZE, nullptr, nullptr, values.data(), &values_read);
+    for (int64_t i = 0; i < values_read; i++) {
+      sum += values[i];
+    }
+  }
+  return sum;
+}
+
+/// Decode a column chunck of any type the way the arrow reader does
+Result<int64_t> ReadColumnChunck(const std::shared_ptr<PartialFile>& chunck_file,
+                                 const std::shared_ptr<parquet::FileMetaData>& metadata,
+                                 int rg) {
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  parquet::arrow::FileReaderBuilder builder;
+  RETURN_NOT_OK(
+      builder.Open(chunck_file, parquet::default_reader_properties(), metadata));
+  RETURN_NOT_OK(builder.Build(&reader));
+  std::shared_ptr<arrow::ChunkedArray> array;
+  RETURN_NOT_OK(reader->RowGroup(rg)->Column(COLUMN_ID)->Read(&array));
+  return array->length();
+}
+
+void PrintRun(const std::string& name, int run, time::time_point start, int64_t rows,
+              const std::string& result) {
+  auto duration_ms = util::get_duration_ms(start, time::now());
+  std::cout << "placement:" << name << "/run:" << run << "/duration_ms:" << duration_ms
+            << "/rows_per_sec:"
+            << static_cast<int64_t>(rows * 1000. / std::max<int64_t>(1, duration_ms))
+            << "/" << result << std::endl;
+}
+
+/// Download the column chuncks from S3 on the IO lane of the executor and decode them
+/// on its CPU lane, as the readers do
+void RunS3Scan(const std::string& name, const PlacementPolicy& placement,
+               const SdkOptions& options) {
+  Executor executor(placement);
+  auto downloader = std::make_shared<Downloader>(std::make_shared<Synchronizer>(),
+                                                 MAX_CONCURRENT_DL,
+                                                 std::make_shared<MetricsManager>(),
+                                                 options, &executor);
+  S3Path path{BUCKET_NAME, KEY_NAME};
+  auto metadata =
+      GetMetadata(downloader, arrow::default_memory_pool(), path, NB_CONN_INIT);
+  for (int run = 0; run < NB_RUNS; run++) {
+    std::atomic<int64_t> rows{0};
+    auto pending = std::make_shared<WaitGroup>();
+    pending->Add(metadata->num_row_groups());
+    auto start = time::now();
+    for (int rg = 0; rg < metadata->num_row_groups(); rg++) {
+      DownloadColumnChunck(
+          downloader, metadata, path, rg, COLUMN_ID,
+          [&, pending](Result<ColChunckFile> result) {
+            if (!result.ok()) {
+              pending->Done(result.status());
+              return;
+            }
+            executor.Submit(Lane::CPU, [&, pending, chunck = result.ValueOrDie()]() {
+              auto read = ReadColumnChunck(chunck.file, metadata, chunck.row_group);
+              if (read.ok()) {
+                rows += read.ValueOrDie();
+              }
+              pending->Done(read.status());
+            });
+          });
+    }
+    pending->Wait();
+    PrintRun(name, run, start, rows.load(), "status:" + pending->status().ToString());
+  }
+}
+
+/// Download each column chunck on the IO lane, then decode it on the CPU lane
+void RunScan(const std::string& name, const PlacementPolicy& placement,
+             const std::shared_ptr<arrow::Buffer>& file_buffer,
+             const std::shared_ptr<parquet::FileMetaData>& metadata) {
+  Executor executor(placement);
+  executor.Reserve(Lane::IO, MAX_CONCURRENT_DL);
+  for (int run = 0; run < NB_RUNS; run++) {
+    std::atomic<int64_t> sum{0};
+    auto pending = std::make_shared<WaitGroup>();
+    pending->Add(NB_ROW_GROUPS);
+    auto start = time::now();
+    for (int rg = 0; rg < NB_ROW_GROUPS; rg++) {
+      executor.Submit(Lane::IO, [&, rg, pending]() {
+        auto chunck_meta = metadata->RowGroup(rg)->ColumnChunk(0);
+        auto chunck_start = chunck_meta->has_dictionary_page()
+                                ? chunck_meta->dictionary_page_offset()
+                                : chunck_meta->data_page_offset();
+        auto chunck_size = chunck_meta->total_compressed_size();
+        std::this_thread::sleep_for(std::chrono::microseconds(FETCH_MICROS));
+        auto data = arrow::AllocateBuffer(chunck_size).ValueOrDie();
+        std::memcpy(data->mutable_data(), file_buffer->data() + chunck_start,
+                    chunck_size);
+        std::vector<FileChunck> chuncks{{chunck_start, std::move(data)}};
+        auto chunck_file =
+            std::make_shared<PartialFile>(chuncks, file_buffer->size());
+        executor.Submit(Lane::CPU, [&, rg, chunck_file, pending]() {
+          sum += ScanColumnChunck(chunck_file, metadata, rg);
+          pending->Done();
+        });
+      });
+    }
+    pending->Wait();
+    PrintRun(name, run, start, NB_ROW_GROUPS * ROWS_PER_GROUP,
+             "sum:" + std::to_string(sum.load()));
+  }
+}
+
+}  // namespace
+
+static aws::lambda_runtime::invocation_response my_handler(
+    aws::lambda_runtime::invocation_request const& req, const SdkOptions& options) {
+  auto topology = CpuTopology::Detect();
+  std::cout << "topology:" << topology.ToString() << std::endl;
+  if (!KEY_NAME.empty()) {
+    for (auto pin : {false, true}) {
+      auto placement = PlacementPolicy::Make(topology, pin);
+      std::cout << "placement:" << (pin ? "pinned" : "unpinned") << "/"
+                << placement.ToString() << std::endl;
+      RunS3Scan(pin ? "pinned" : "unpinned", placement, options);
+    }
+    return aws::lambda_runtime::invocation_response::success("Done", "text/plain");
+  }
+  auto file_buffer = WriteFile();
+  auto file = std::make_shared<arrow::io::BufferReader>(file_buffer);
+  auto metadata = parquet::ParquetFileReader::Open(file)->metadata();
+  std::cout << "file_bytes:" << file_buffer->size()
+            << "/row_groups:" << metadata->num_row_groups() << std::endl;
+  for (auto pin : {false, true}) {
+    auto placement = PlacementPolicy::Make(topology, pin);
+    std::cout << "placement:" << (pin ? "pinned" : "unpinned") << "/"
+              << placement.ToString() << std::endl;
+    RunScan(pin ? "pinned" : "unpinned", placement, file_buffer, metadata);
+  }
+  return aws::lambda_runtime::invocation_response::success("Done", "text/plain");
+}
+
+/// Compare the scan throughput with the workers of the executor pinned by the
+/// PlacementPolicy of the detected topology or left to the scheduler of the OS
+int main() {
+  InitializeAwsSdk(AwsSdkLogLevel::Off);
+  SdkOptions options;
+  options.region = "eu-west-1";
+  if (IS_LOCAL) {
+    options.endpoint_override = "minio:9000";
+    options.scheme = "http";
+  }
+  bootstrap([&options](aws::lambda_runtime::invocation_request const& req) {
+    return my_handler(req, options);
+  });
+  FinalizeAwsSdk();
+}
@@ -0,0 +1,120 @@
+#include <arrow/memory_pool.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "cust_memory_pool.h"
+#include "toolbox.h"
+
+using namespace Buzz;
+
+// comma separated thread counts to benchmark
+static const std::string THREADS = util::getenv("THREADS", "1,2,4,8,16");
+// number of allocate/free pairs of each thread
+static const int64_t NB_OPS = util::getenv_int("NB_OPS", 200000);
+// buffers each thread keeps alive, like the pages being decoded by a worker
+static const int WINDOW = util::getenv_int("WINDOW", 4);
+// the allocation sizes are drawn uniformly between these bounds (at most 1MB so that
+// they fit in the blocks of the pool allocator)
+static const int64_t MIN_SIZE = util::getenv_int("MIN_SIZE", 16 * 1024);
+static const int64_t MAX_SIZE = util::getenv_int("MAX_SIZE", 1024 * 1024);
+// blocks kept by each thread in the cached variant of the pool allocator
+static const int THREAD_CACHE_BLOCKS = util::getenv_int("THREAD_CACHE_BLOCKS", 16);
+
+namespace {
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                   start)
+      .count();
+}
+
+/// Each thread replaces its buffers one after the other with buffers of random sizes,
+/// writing to them as a decoder would
+Status BenchPool(const std::string& name, arrow::MemoryPool* pool, int threads) {
+  std::vector<Status> statuses(threads);
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t]() {
+      std::mt19937_64 rng(t);
+      std::uniform_int_distribution<int64_t> size_dist(MIN_SIZE, MAX_SIZE);
+      std::vector<std::pair<uint8_t*, int64_t>> buffers(WINDOW, {nullptr, 0});
+      for (int64_t i = 0; i < NB_OPS; i++) {
+        auto& buffer = buffers[i % WINDOW];
+        if (buffer.first != nullptr) {
+          pool->Free(buffer.first, buffer.second);
+        }
+        buffer.second = size_dist(rng);
+        statuses[t] = pool->Allocate(buffer.second, &buffer.first);
+        if (!statuses[t].ok()) {
+          return;
+        }
+        buffer.first[0] = static_cast<uint8_t>(i);
+        buffer.first[buffer.second - 1] = static_cast<uint8_t>(i);
+      }
+      for (auto& buffer : buffers) {
+        pool->Free(buffer.first, buffer.second);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  auto duration_ms = ElapsedMs(start);
+  for (auto& status : statuses) {
+    RETURN_NOT_OK(status);
+  }
+  std::cout << "pool:" << name << "/threads:" << threads
+            << "/duration_ms:" << duration_ms << "/ops_per_sec:"
+            << static_cast<int64_t>(threads * NB_OPS / duration_ms * 1000) << std::endl;
+  return Status::OK();
+}
+
+Status BenchCustom(const std::string& name, int thread_cache_blocks, int threads) {
+  CustomMemoryPoolOptions options;
+  options.runway_allocator = false;
+  options.pool_allocator = true;
+  options.thread_cache_blocks = thread_cache_blocks;
+  // enough blocks for the buffers and the caches of all the threads
+  options.prealloc_count = threads * (WINDOW + thread_cache_blocks + 1);
+  CustomMemoryPool pool(arrow::default_memory_pool(), options);
+  return BenchPool(name, &pool, threads);
+}
+
+Status Run() {
+  arrow::MemoryPool* jemalloc_pool = nullptr;
+  auto jemalloc_status = arrow::jemalloc_memory_pool(&jemalloc_pool);
+  if (!jemalloc_status.ok()) {
+    std::cout << "jemalloc unavailable: " << jemalloc_status.ToString() << std::endl;
+  }
+  std::stringstream thread_counts(THREADS);
+  std::string threads_str;
+  while (std::getline(thread_counts, threads_str, ',')) {
+    auto threads = std::stoi(threads_str);
+    // every block goes through the depot lock, as with the former global free list
+    RETURN_NOT_OK(BenchCustom("custom_locked", 0, threads));
+    RETURN_NOT_OK(BenchCustom("custom_thread_cache", THREAD_CACHE_BLOCKS, threads));
+    if (jemalloc_pool != nullptr) {
+      RETURN_NOT_OK(BenchPool("jemalloc", jemalloc_pool, threads));
+    }
+    RETURN_NOT_OK(BenchPool("system", arrow::system_memory_pool(), threads));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+/// Compare the allocate/free throughput of the pool allocator of CustomMemoryPool,
+/// with and without the thread caches, to jemalloc and the system allocator
+int main() {
+  auto status = Run();
+  if (!status.ok()) {
+    std::cerr << status.ToString() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -4,30 +4,27 @@
 #include <csignal>
 #include <iostream>
 
-namespace arrow {
-
-namespace flight {
-
-class MyFlightServer : public FlightServerBase {
-  Status ListFlights(const ServerCallContext& context, const Criteria* criteria,
-                     std::unique_ptr<FlightListing>* listings) override {
-    std::vector<FlightInfo> flights = {FlightInfo(FlightInfo::Data{
-        .schema = "",
-        .descriptor = {},
-        .endpoints = {},
-        .total_records = 0,
-        .total_bytes = 0,
-    })};
-    *listings = std::unique_ptr<FlightListing>(new SimpleFlightListing(flights));
-    return Status::OK();
-  }
-};
-
-}  // namespace flight
-}  // namespace arrow
+#include "hive-server.h"
+#include "toolbox.h"
+
+// number of merge workers of each query, the usable CPUs (affinity and quota) if 0
+static const int MERGE_PARTITIONS = Buzz::util::getenv_int("MERGE_PARTITIONS", 0);
+// a task straggles if it shows no activity for SPECULATION_MULTIPLIER times the
+// SPECULATION_QUANTILE of the completion times of the fleet
+static const double SPECULATION_QUANTILE =
+    Buzz::util::getenv_int("SPECULATION_QUANTILE_PCT", 90) / 100.;
+static const double SPECULATION_MULTIPLIER =
+    Buzz::util::getenv_int("SPECULATION_MULTIPLIER_PCT", 150) / 100.;
+static const int SPECULATION_MAX_ATTEMPTS =
+    Buzz::util::getenv_int("SPECULATION_MAX_ATTEMPTS", 2);
 
 int main() {
-  auto server = std::make_unique<arrow::flight::MyFlightServer>();
+  Buzz::HiveServerOptions server_options;
+  server_options.merge_partitions = MERGE_PARTITIONS;
+  server_options.speculation.quantile = SPECULATION_QUANTILE;
+  server_options.speculation.multiplier = SPECULATION_MULTIPLIER;
+  server_options.speculation.max_attempts = SPECULATION_MAX_ATTEMPTS;
+  auto server = std::make_unique<Buzz::HiveFlightServer>(server_options);
   // Initialize server
   arrow::flight::Location location;
   int port = 80;
@@ -45,4 +42,4 @@ int main() {
 
   std::cout << "Server listening on localhost:" << server->port() << std::endl;
   ARROW_CHECK_OK(server->Serve());
-}
\ No newline at end of file
+}
@@ -0,0 +1,159 @@
+#include <arrow/api.h>
+
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include "hash-aggregator.h"
+#include "hive-client.h"
+#include "ipc-compression.h"
+#include "toolbox.h"
+
+using namespace Buzz;
+
+// number of groups in the partial aggregates of a bee
+static const int64_t NB_GROUPS = util::getenv_int("NB_GROUPS", 100000);
+// number of distinct keys the groups are drawn from
+static const int64_t KEY_CARDINALITY = util::getenv_int("KEY_CARDINALITY", 1000000);
+// comma separated link throughputs in MB/s for which the transfer time is estimated
+static const std::string LINK_MBPS = util::getenv("LINK_MBPS", "10,50,100,300,1000");
+// if not empty, the partials are also sent to this hive ("host:port") with each codec
+static const std::string HIVE_ENDPOINT = util::getenv("HIVE_ENDPOINT", "");
+// number of rows of the batches sent to the hive
+static const int64_t HIVE_BATCH_SIZE = util::getenv_int("HIVE_BATCH_SIZE", 65536);
+
+namespace {
+
+/// A shape of partial aggregates, as produced by a bee running a GROUP BY
+struct Shape {
+  std::string name;
+  std::shared_ptr<arrow::Schema> input_schema;
+  std::vector<std::string> keys;
+  std::vector<AggregateSpec> specs;
+};
+
+std::vector<Shape> Shapes() {
+  auto input_schema = arrow::schema({arrow::field("id", arrow::int64()),
+                                     arrow::field("name", arrow::utf8()),
+                                     arrow::field("flag", arrow::int32()),
+                                     arrow::field("price", arrow::float64())});
+  return {
+      {"int_key_count", input_schema, {"id"}, {{AggregateKind::Count, ""}}},
+      {"int_key_sum_avg",
+       input_schema,
+       {"id"},
+       {{AggregateKind::Sum, "price"}, {AggregateKind::Avg, "price"}}},
+      {"str_key_count_max",
+       input_schema,
+       {"name"},
+       {{AggregateKind::Count, ""}, {AggregateKind::Max, "price"}}},
+      {"composite_key_sum",
+       input_schema,
+       {"flag", "name"},
+       {{AggregateKind::Count, ""}, {AggregateKind::Sum, "price"}}},
+  };
+}
+
+/// Input rows with NB_GROUPS random ids out of KEY_CARDINALITY, the names are derived
+/// from the ids like in generated datasets (e.g. "Customer#000012345")
+Result<std::shared_ptr<arrow::RecordBatch>> MakeInput(
+    const std::shared_ptr<arrow::Schema>& schema) {
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<int64_t> id_dist(0, KEY_CARDINALITY - 1);
+  std::uniform_int_distribution<int> price_dist(100, 100000);
+  arrow::Int64Builder id_builder;
+  arrow::StringBuilder name_builder;
+  arrow::Int32Builder flag_builder;
+  arrow::DoubleBuilder price_builder;
+  for (int64_t i = 0; i < NB_GROUPS; i++) {
+    auto id = id_dist(rng);
+    auto id_str = std::to_string(id);
+    RETURN_NOT_OK(id_builder.Append(id));
+    RETURN_NOT_OK(
+        name_builder.Append("Customer#" + std::string(9 - id_str.size(), '0') + id_str));
+    RETURN_NOT_OK(flag_builder.Append(id % 3));
+    RETURN_NOT_OK(price_builder.Append(price_dist(rng) / 100.));
+  }
+  std::shared_ptr<arrow::Array> ids, names, flags, prices;
+  RETURN_NOT_OK(id_builder.Finish(&ids));
+  RETURN_NOT_OK(name_builder.Finish(&names));
+  RETURN_NOT_OK(flag_builder.Finish(&flags));
+  RETURN_NOT_OK(price_builder.Finish(&prices));
+  return arrow::RecordBatch::Make(schema, NB_GROUPS, {ids, names, flags, prices});
+}
+
+Result<std::shared_ptr<arrow::RecordBatch>> MakePartials(const Shape& shape) {
+  ARROW_ASSIGN_OR_RAISE(auto input, MakeInput(shape.input_schema));
+  ARROW_ASSIGN_OR_RAISE(auto aggregator, HashAggregator::Make(shape.input_schema,
+                                                              shape.keys, shape.specs));
+  RETURN_NOT_OK(aggregator->Consume(*input));
+  return aggregator->Finish();
+}
+
+Status BenchShape(const Shape& shape, const std::vector<double>& links_mbps) {
+  ARROW_ASSIGN_OR_RAISE(auto partials, MakePartials(shape));
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  for (int64_t offset = 0; offset < partials->num_rows(); offset += HIVE_BATCH_SIZE) {
+    batches.push_back(partials->Slice(offset, HIVE_BATCH_SIZE));
+  }
+  // profile the whole partials to estimate their actual transfer time
+  ARROW_ASSIGN_OR_RAISE(auto profiles, ProfileIpcCompressions(*partials));
+  for (auto& profile : profiles) {
+    auto codec = arrow::util::Codec::GetCodecAsString(profile.compression);
+    std::cout << "shape:" << shape.name << "/rows:" << partials->num_rows()
+              << "/codec:" << codec << "/bytes:" << profile.encoded_bytes
+              << "/encode_ms:" << profile.encode_seconds * 1e3
+              << "/decode_ms:" << profile.decode_seconds * 1e3 << std::endl;
+    for (auto link_mbps : links_mbps) {
+      auto seconds = profile.EstimateTransferSeconds(profile.raw_bytes, link_mbps * 1e6);
+      std::cout << "shape:" << shape.name << "/codec:" << codec
+                << "/link_MBps:" << link_mbps
+                << "/estimated_transfer_ms:" << seconds * 1e3 << std::endl;
+    }
+    if (!HIVE_ENDPOINT.empty()) {
+      ARROW_ASSIGN_OR_RAISE(auto write_options, MakeIpcWriteOptions(profile.compression));
+      auto start = time::now();
+      RETURN_NOT_OK(SendToHive(HIVE_ENDPOINT, "ipc-bench-" + shape.name + "-" + codec,
+                               partials->schema(), batches, write_options));
+      std::cout << "shape:" << shape.name << "/codec:" << codec
+                << "/measured_transfer_ms:" << util::get_duration_ms(start, time::now())
+                << std::endl;
+    }
+  }
+  // the auto mode only profiles the first batch, as on the bees
+  ARROW_ASSIGN_OR_RAISE(auto sample_profiles, ProfileIpcCompressions(*batches[0]));
+  for (auto link_mbps : links_mbps) {
+    auto chosen = ChooseIpcCompression(sample_profiles, link_mbps * 1e6);
+    std::cout << "shape:" << shape.name << "/link_MBps:" << link_mbps
+              << "/auto_codec:" << arrow::util::Codec::GetCodecAsString(chosen)
+              << std::endl;
+  }
+  return Status::OK();
+}
+
+Status Run() {
+  std::vector<double> links_mbps;
+  std::stringstream links_stream(LINK_MBPS);
+  std::string link_mbps;
+  while (std::getline(links_stream, link_mbps, ',')) {
+    links_mbps.push_back(std::stod(link_mbps));
+  }
+  for (auto& shape : Shapes()) {
+    RETURN_NOT_OK(BenchShape(shape, links_mbps));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+/// Compare the time to encode, send and decode partial aggregates of various shapes
+/// with each IPC compression, estimated for several link throughputs and optionally
+/// measured against a running hive
+int main() {
+  auto status = Run();
+  if (!status.ok()) {
+    std::cerr << status.ToString() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,169 @@
+#include <arrow/api.h>
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "hash-aggregator.h"
+#include "partitioned-merger.h"
+#include "toolbox.h"
+
+using namespace Buzz;
+
+// number of simulated bees, each sending its partial aggregates as one stream
+static const int NB_STREAMS = util::getenv_int("NB_STREAMS", 512);
+// number of groups in the partial aggregates of each bee
+static const int GROUPS_PER_STREAM = util::getenv_int("GROUPS_PER_STREAM", 20000);
+// number of distinct groups across all the bees
+static const int64_t KEY_CARDINALITY = util::getenv_int("KEY_CARDINALITY", 1000000);
+// number of rows of the batches sent by the bees
+static const int BATCH_SIZE = util::getenv_int("BATCH_SIZE", 4096);
+// number of threads receiving the streams concurrently, like the Flight server threads
+static const int NB_PRODUCERS = util::getenv_int("NB_PRODUCERS", 8);
+// comma separated partition counts to benchmark
+static const std::string PARTITIONS = util::getenv("PARTITIONS", "1,2,4,8,16");
+
+namespace {
+
+/// Partial aggregates of each bee, split in batches
+Result<std::vector<std::vector<std::shared_ptr<arrow::RecordBatch>>>> MakePartials() {
+  auto input_schema = arrow::schema({arrow::field("key", arrow::int64()),
+                                     arrow::field("value", arrow::float64())});
+  std::vector<AggregateSpec> specs{{AggregateKind::Count, ""},
+                                   {AggregateKind::Sum, "value"},
+                                   {AggregateKind::Max, "value"}};
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<int64_t> key_dist(0, KEY_CARDINALITY - 1);
+  std::vector<std::vector<std::shared_ptr<arrow::RecordBatch>>> streams(NB_STREAMS);
+  for (auto& stream : streams) {
+    ARROW_ASSIGN_OR_RAISE(auto bee, HashAggregator::Make(input_schema, {"key"}, specs));
+    arrow::Int64Builder key_builder;
+    arrow::DoubleBuilder value_builder;
+    for (int i = 0; i < GROUPS_PER_STREAM; i++) {
+      RETURN_NOT_OK(key_builder.Append(key_dist(rng)));
+      RETURN_NOT_OK(value_builder.Append(i));
+    }
+    std::shared_ptr<arrow::Array> keys, values;
+    RETURN_NOT_OK(key_builder.Finish(&keys));
+    RETURN_NOT_OK(value_builder.Finish(&values));
+    RETURN_NOT_OK(bee->Consume(
+        *arrow::RecordBatch::Make(input_schema, keys->length(), {keys, values})));
+    ARROW_ASSIGN_OR_RAISE(auto partial, bee->Finish());
+    for (int64_t offset = 0; offset < partial->num_rows(); offset += BATCH_SIZE) {
+      stream.push_back(partial->Slice(offset, BATCH_SIZE));
+    }
+  }
+  return streams;
+}
+
+/// Feed the streams from NB_PRODUCERS threads, each stream to a single thread
+template <typename MergeFn>
+Status ReplayStreams(
+    const std::vector<std::vector<std::shared_ptr<arrow::RecordBatch>>>& streams,
+    MergeFn&& merge) {
+  std::vector<Status> statuses(NB_PRODUCERS);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < NB_PRODUCERS; p++) {
+    producers.emplace_back([&, p]() {
+      for (size_t s = p; s < streams.size(); s += NB_PRODUCERS) {
+        for (auto& batch : streams[s]) {
+          statuses[p] = merge(batch);
+          if (!statuses[p].ok()) {
+            return;
+          }
+        }
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  for (auto& status : statuses) {
+    RETURN_NOT_OK(status);
+  }
+  return Status::OK();
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                   start)
+      .count();
+}
+
+void PrintResult(const std::string& name, double duration_ms, int64_t merged_rows,
+                 int64_t groups) {
+  std::cout << "merger:" << name << "/duration_ms:" << duration_ms
+            << "/rows_per_sec:" << static_cast<int64_t>(merged_rows / duration_ms * 1000)
+            << "/groups:" << groups << std::endl;
+}
+
+/// A single hash table behind a mutex, as the hive did before partitioning
+Status BenchSingle(
+    const std::vector<std::vector<std::shared_ptr<arrow::RecordBatch>>>& streams,
+    int64_t merged_rows) {
+  auto start = std::chrono::steady_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto aggregator,
+                        HashAggregator::MakeFromPartialSchema(streams[0][0]->schema()));
+  std::mutex mutex;
+  RETURN_NOT_OK(ReplayStreams(streams, [&](const std::shared_ptr<arrow::RecordBatch>& b) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return aggregator->Merge(*b);
+  }));
+  ARROW_ASSIGN_OR_RAISE(auto result, aggregator->Finalize());
+  PrintResult("single", ElapsedMs(start), merged_rows, result->num_rows());
+  return Status::OK();
+}
+
+Status BenchPartitioned(
+    const std::vector<std::vector<std::shared_ptr<arrow::RecordBatch>>>& streams,
+    int64_t merged_rows, int num_partitions) {
+  auto start = std::chrono::steady_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto merger,
+                        PartitionedMerger::Make(streams[0][0]->schema(), num_partitions));
+  RETURN_NOT_OK(ReplayStreams(streams, [&](const std::shared_ptr<arrow::RecordBatch>& b) {
+    return merger->Merge(b);
+  }));
+  ARROW_ASSIGN_OR_RAISE(auto result, merger->Finalize());
+  PrintResult("partitioned_" + std::to_string(num_partitions), ElapsedMs(start),
+              merged_rows, result->num_rows());
+  return Status::OK();
+}
+
+Status Run() {
+  auto start = std::chrono::steady_clock::now();
+  ARROW_ASSIGN_OR_RAISE(auto streams, MakePartials());
+  int64_t merged_rows = 0;
+  for (auto& stream : streams) {
+    for (auto& batch : stream) {
+      merged_rows += batch->num_rows();
+    }
+  }
+  std::cout << "streams:" << NB_STREAMS << "/merged_rows:" << merged_rows
+            << "/producers:" << NB_PRODUCERS
+            << "/hardware_concurrency:" << std::thread::hardware_concurrency()
+            << "/generation_ms:" << ElapsedMs(start) << std::endl;
+
+  RETURN_NOT_OK(BenchSingle(streams, merged_rows));
+  std::stringstream partitions(PARTITIONS);
+  std::string num_partitions;
+  while (std::getline(partitions, num_partitions, ',')) {
+    RETURN_NOT_OK(BenchPartitioned(streams, merged_rows, std::stoi(num_partitions)));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+/// Compare the merge throughput of a single locked hash table with the partitioned
+/// merger, on synthetic partial aggregates replayed as concurrent bee streams
+int main() {
+  auto status = Run();
+  if (!status.ok()) {
+    std::cerr << status.ToString() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -16,16 +16,27 @@
 // under the License.
 
 #include <aws/lambda-runtime/runtime.h>
+#include <parquet/arrow/schema.h>
 
 #include <iostream>
+#include <mutex>
 
 #include "bootstrap.h"
+#include "buffer-sizes.h"
 #include "cust_memory_pool.h"
+#include "dictionary-aggregator.h"
+#include "dictionary-filter.h"
 #include "downloader.h"
+#include "executor.h"
+#include "footer-payload.h"
+#include "hash-aggregator.h"
+#include "hive-client.h"
+#include "ipc-compression.h"
 #include "logger.h"
 #include "parquet-helpers.h"
 #include "partial-file.h"
 #include "sdk-init.h"
+#include "task-tracker.h"
 #include "toolbox.h"
 
 using namespace Buzz;
@@ -36,28 +47,162 @@ static const int64_t MAX_CONCURRENT_DL = util::getenv_int("MAX_CONCURRENT_DL", 8
 static const int NB_CONN_INIT = util::getenv_int("NB_CONN_INIT", 1);
 static const int64_t COLUMN_ID = util::getenv_int("COLUMN_ID", 16);
 static const bool AS_DICT = util::getenv_bool("AS_DICT", true);
+// if not empty, only read the row groups where COLUMN_ID might be equal to FILTER_VALUE
+static const std::string FILTER_VALUE = util::getenv("FILTER_VALUE", "");
+// if true, count the rows grouped by the values of COLUMN_ID
+static const bool GROUP_BY = util::getenv_bool("GROUP_BY", false);
 static const auto mem_pool = new CustomMemoryPool(arrow::default_memory_pool());
 static const bool IS_LOCAL = util::getenv_bool("IS_LOCAL", false);
 static const char* BUCKET_NAME = util::getenv("BUCKET_NAME", "defaultbucket");
 static const char* KEY_NAME = util::getenv("KEY_NAME", "default.parquet");
+// if not empty, the "host:port" of the hive to which the GROUP_BY partials are sent
+static const std::string HIVE_ENDPOINT = util::getenv("HIVE_ENDPOINT", "");
+static const std::string QUERY_ID = util::getenv("QUERY_ID", "default");
+// compression of the batches sent to the hive: none, lz4, zstd or auto
+static const std::string IPC_COMPRESSION = util::getenv("IPC_COMPRESSION", "auto");
+// link throughput to the hive in MB/s used by IPC_COMPRESSION=auto, measured on the
+// column chunck downloads if 0
+static const int64_t LINK_MBPS = util::getenv_int("LINK_MBPS", 0);
+// number of rows of the batches sent to the hive
+static const int64_t HIVE_BATCH_SIZE = util::getenv_int("HIVE_BATCH_SIZE", 65536);
+
+// Read a column chunck, flat BYTE_ARRAY columns that are not read as dictionaries are
+// decoded into buffers presized from the chunck metadata
+Result<std::shared_ptr<arrow::ChunkedArray>> read_column_chunck(
+    std::shared_ptr<::arrow::io::RandomAccessFile> rg_file,
+    std::shared_ptr<parquet::FileMetaData> file_metadata, int rg) {
+  parquet::ReaderProperties parquet_props(mem_pool);
+  auto descr = file_metadata->schema()->Column(COLUMN_ID);
+  if (!AS_DICT && descr->physical_type() == parquet::Type::BYTE_ARRAY &&
+      descr->max_repetition_level() == 0) {
+    try {
+      auto file_reader =
+          parquet::ParquetFileReader::Open(rg_file, parquet_props, file_metadata);
+      auto col_reader = file_reader->RowGroup(rg)->Column(COLUMN_ID);
+      auto col_chunck_meta = file_metadata->RowGroup(rg)->ColumnChunk(COLUMN_ID);
+      ARROW_ASSIGN_OR_RAISE(auto array, ReadByteArrayChunck(col_reader.get(),
+                                                            *col_chunck_meta, *descr,
+                                                            mem_pool));
+      return std::make_shared<arrow::ChunkedArray>(array);
+    } catch (const parquet::ParquetException& e) {
+      return Status::IOError("Could not open column chunck: ", e.what());
+    }
+  }
 
-// Read a column chunck
-Result<int64_t> read_column_chunck(std::shared_ptr<::arrow::io::RandomAccessFile> rg_file,
-                                   std::shared_ptr<parquet::FileMetaData> file_metadata,
-                                   int rg) {
   std::unique_ptr<parquet::arrow::FileReader> reader;
   parquet::arrow::FileReaderBuilder builder;
-  parquet::ReaderProperties parquet_props(mem_pool);
-  PARQUET_THROW_NOT_OK(builder.Open(rg_file, parquet_props, file_metadata));
+  RETURN_NOT_OK(builder.Open(rg_file, parquet_props, file_metadata));
   builder.memory_pool(mem_pool);
   auto arrow_props = parquet::ArrowReaderProperties();
   arrow_props.set_read_dictionary(COLUMN_ID, AS_DICT);
   builder.properties(arrow_props);
-  PARQUET_THROW_NOT_OK(builder.Build(&reader));
+  RETURN_NOT_OK(builder.Build(&reader));
 
   std::shared_ptr<arrow::ChunkedArray> array;
-  PARQUET_THROW_NOT_OK(reader->RowGroup(rg)->Column(COLUMN_ID)->Read(&array));
-  return array->length();
+  RETURN_NOT_OK(reader->RowGroup(rg)->Column(COLUMN_ID)->Read(&array));
+  return array;
+}
+
+// Count the rows of a column chunck by value
+Status group_column_chunck(const std::shared_ptr<arrow::ChunkedArray>& array,
+                           const std::string& column_name,
+                           std::unique_ptr<HashAggregator>& aggregator) {
+  auto schema = arrow::schema({arrow::field(column_name, array->type())});
+  if (aggregator == nullptr) {
+    ARROW_ASSIGN_OR_RAISE(aggregator,
+                          HashAggregator::Make(schema, {column_name},
+                                               {{AggregateKind::Count, ""}}, mem_pool));
+  }
+  for (auto& chunk : array->chunks()) {
+    RETURN_NOT_OK(
+        aggregator->Consume(*arrow::RecordBatch::Make(schema, chunk->length(), {chunk})));
+  }
+  return Status::OK();
+}
+
+// Count the rows of a dictionary encoded column chunck by dictionary index
+Status group_dict_column_chunck(const std::shared_ptr<arrow::ChunkedArray>& array,
+                                const std::string& column_name,
+                                std::unique_ptr<DictionaryCounter>& counter) {
+  if (counter == nullptr) {
+    auto& dict_type = static_cast<const arrow::DictionaryType&>(*array->type());
+    ARROW_ASSIGN_OR_RAISE(counter, DictionaryCounter::Make(
+                                       column_name, dict_type.value_type(), mem_pool));
+  }
+  for (auto& chunk : array->chunks()) {
+    RETURN_NOT_OK(counter->Consume(static_cast<const arrow::DictionaryArray&>(*chunk)));
+  }
+  return Status::OK();
+}
+
+// Partial aggregates of a column chunck
+Result<std::shared_ptr<arrow::RecordBatch>> aggregate_column_chunck(
+    const std::shared_ptr<arrow::ChunkedArray>& array, const std::string& column_name) {
+  if (array->type()->id() == arrow::Type::DICTIONARY) {
+    std::unique_ptr<DictionaryCounter> counter;
+    RETURN_NOT_OK(group_dict_column_chunck(array, column_name, counter));
+    return counter->Finish();
+  }
+  std::unique_ptr<HashAggregator> aggregator;
+  RETURN_NOT_OK(group_column_chunck(array, column_name, aggregator));
+  return aggregator->Finish();
+}
+
+// Merge the partial aggregates of a column chunck into the ones of the task
+Status merge_partials(const arrow::RecordBatch& partial,
+                      std::unique_ptr<HashAggregator>& aggregator) {
+  if (aggregator == nullptr) {
+    ARROW_ASSIGN_OR_RAISE(
+        aggregator, HashAggregator::MakeFromPartialSchema(partial.schema(), mem_pool));
+  }
+  return aggregator->Merge(partial);
+}
+
+// Partial aggregates of all the chuncks read, without any group if none was read
+Result<std::shared_ptr<arrow::RecordBatch>> finish_partials(
+    const parquet::FileMetaData& file_metadata, const std::string& column_name,
+    std::unique_ptr<HashAggregator>& aggregator) {
+  if (aggregator == nullptr) {
+    // the hive still needs the schema of the partials
+    std::shared_ptr<arrow::Schema> arrow_schema;
+    RETURN_NOT_OK(
+        parquet::arrow::FromParquetSchema(file_metadata.schema(), &arrow_schema));
+    auto field = arrow_schema->GetFieldByName(column_name);
+    if (field == nullptr) {
+      return Status::NotImplemented("Cannot group by nested column ", column_name);
+    }
+    RETURN_NOT_OK(group_column_chunck(
+        std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{}, field->type()),
+        column_name, aggregator));
+  }
+  return aggregator->Finish();
+}
+
+// Send the partial aggregates to the hive, picking the IPC compression if it is auto.
+// The stream is sent even without any group so that the hive knows the task is done.
+Status send_partials(const std::shared_ptr<arrow::RecordBatch>& partials,
+                     const std::string& command, double link_bytes_per_sec) {
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  for (int64_t offset = 0; offset < partials->num_rows(); offset += HIVE_BATCH_SIZE) {
+    batches.push_back(partials->Slice(offset, HIVE_BATCH_SIZE));
+  }
+  ARROW_ASSIGN_OR_RAISE(auto compression, ParseIpcCompression(IPC_COMPRESSION));
+  if (!compression.has_value() && batches.empty()) {
+    compression = arrow::Compression::UNCOMPRESSED;
+  } else if (!compression.has_value()) {
+    ARROW_ASSIGN_OR_RAISE(auto profiles, ProfileIpcCompressions(*batches[0]));
+    compression = ChooseIpcCompression(profiles, link_bytes_per_sec);
+    for (auto& profile : profiles) {
+      auto ratio = static_cast<double>(profile.raw_bytes) / profile.encoded_bytes;
+      std::cout << "codec:" << arrow::util::Codec::GetCodecAsString(profile.compression)
+                << "/ratio:" << ratio << "/encode_us:" << profile.encode_seconds * 1e6
+                << "/decode_us:" << profile.decode_seconds * 1e6 << std::endl;
+    }
+  }
+  std::cout << "link_MBps:" << link_bytes_per_sec / 1e6 << "/ipc_compression:"
+            << arrow::util::Codec::GetCodecAsString(*compression) << std::endl;
+  ARROW_ASSIGN_OR_RAISE(auto write_options, MakeIpcWriteOptions(*compression));
+  return SendToHive(HIVE_ENDPOINT, command, partials->schema(), batches, write_options);
 }
 
 static aws::lambda_runtime::invocation_response my_handler(
@@ -69,45 +214,190 @@ static aws::lambda_runtime::invocation_response my_handler(
   auto downloader = std::make_shared<Downloader>(synchronizer, MAX_CONCURRENT_DL,
                                                  metrics_manager, options);
 
-  S3Path file_path{BUCKET_NAME, KEY_NAME};
-
-  auto file_metadata =
-      GetMetadata(downloader, synchronizer, mem_pool, file_path, NB_CONN_INIT);
+  auto payload = ParseTaskPayload(req.payload);
+  if (!payload.ok()) {
+    return aws::lambda_runtime::invocation_response::failure(
+        payload.status().message(), "InvalidParameter");
+  }
+  // the footers are all fetched before the column chuncks, the payload has at least one
+  // file and its row groups are checked before any chunck is scheduled
+  std::vector<S3Path> file_paths;
+  std::vector<std::shared_ptr<parquet::FileMetaData>> file_metadatas;
+  std::vector<std::vector<int>> file_row_groups;
+  for (auto& file_payload : payload.ValueOrDie()) {
+    S3Path file_path{BUCKET_NAME, file_payload.key.empty() ? KEY_NAME : file_payload.key};
+    // the connections are only initialized once for the bucket
+    auto file_metadata = GetMetadata(downloader, mem_pool, file_path,
+                                     file_paths.empty() ? NB_CONN_INIT : 0, file_payload);
+    auto row_groups = file_payload.AssignedRowGroups(file_metadata->num_row_groups());
+    if (!row_groups.ok()) {
+      return aws::lambda_runtime::invocation_response::failure(
+          row_groups.status().message(), "InvalidParameter");
+    }
+    file_metadatas.push_back(file_metadata);
+    file_row_groups.push_back(row_groups.ValueOrDie());
+    file_paths.push_back(file_path);
+  }
 
   metrics_manager->ExitPhase("wait_foot");
-  std::cout << "col processed: " << file_metadata->schema()->Column(COLUMN_ID)->name()
-            << std::endl;
+  auto column_name = file_metadatas[0]->schema()->Column(COLUMN_ID)->name();
+  std::cout << "col processed: " << column_name << std::endl;
+  // merges the partial aggregates of the chuncks
+  std::unique_ptr<HashAggregator> aggregator;
 
-  // Download column chuncks
-  for (int i = 0; i < file_metadata->num_row_groups(); i++) {
-    // TODO a more progressive scheduling of new connections
-    DownloadColumnChunck(downloader, file_metadata, file_path, i, COLUMN_ID);
-  }
-
-  // Process chuncks
+  // The chuncks are decoded and aggregated on the CPU lane so that the download threads
+  // only wait on the network, only the merge into the task state is serialized
+  std::mutex proc_mutex;
   int downloaded_chuncks = 0;
+  int pruned_chuncks = 0;
   int64_t rows_read = 0;
+  // the download throughput approximates the link throughput to the hive
+  auto dl_start = time::now();
+  auto dl_end = dl_start;
+  int64_t downloaded_bytes = 0;
+  auto pending_chuncks = std::make_shared<WaitGroup>();
+
+  auto decode_chunck = [&](const ColChunckFile& col_chunck_file,
+                           std::shared_ptr<parquet::FileMetaData> file_metadata,
+                           time::time_point chunck_dl_end) -> Status {
+    metrics_manager->NewEvent("starting_proc");
+    ARROW_ASSIGN_OR_RAISE(auto array, read_column_chunck(col_chunck_file.file,
+                                                         file_metadata,
+                                                         col_chunck_file.row_group));
+    std::shared_ptr<arrow::RecordBatch> partial;
+    if (GROUP_BY) {
+      metrics_manager->NewEvent("starting_group_by");
+      ARROW_ASSIGN_OR_RAISE(partial, aggregate_column_chunck(array, column_name));
+    }
+    std::lock_guard<std::mutex> lock(proc_mutex);
+    dl_end = std::max(dl_end, chunck_dl_end);
+    rows_read += array->length();
+    downloaded_bytes += file_metadata->RowGroup(col_chunck_file.row_group)
+                            ->ColumnChunk(COLUMN_ID)
+                            ->total_compressed_size();
+    downloaded_chuncks++;
+    return partial == nullptr ? Status::OK() : merge_partials(*partial, aggregator);
+  };
+
+  auto process_chunck = [&, pending_chuncks](
+                            std::shared_ptr<parquet::FileMetaData> file_metadata) {
+    return [&, file_metadata, pending_chuncks](Result<ColChunckFile> result) {
+      if (!result.ok()) {
+        pending_chuncks->Done(result.status());
+        return;
+      }
+      Executor::Default().Submit(
+          Lane::CPU, [&, file_metadata, pending_chuncks, chunck_dl_end = time::now(),
+                      col_chunck_file = result.ValueOrDie()]() {
+            pending_chuncks->Done(
+                decode_chunck(col_chunck_file, file_metadata, chunck_dl_end));
+          });
+    };
+  };
+
+  // only fetch the full chunck if its dictionary might contain FILTER_VALUE
+  auto probe_chunck = [&](const ColChunckFile& col_chunck_file, const S3Path& file_path,
+                          std::shared_ptr<parquet::FileMetaData> file_metadata) {
+    auto col_chunck_meta =
+        file_metadata->RowGroup(col_chunck_file.row_group)->ColumnChunk(COLUMN_ID);
+    auto range = GetPrunableDictionaryPage(*col_chunck_meta).value();
+    ARROW_ASSIGN_OR_RAISE(auto page_data,
+                          col_chunck_file.file->ReadAt(range.start, range.length()));
+    auto contains = DictionaryContains(page_data, *col_chunck_meta, FILTER_VALUE);
+    if (contains.ok() && !contains.ValueOrDie()) {
+      std::lock_guard<std::mutex> lock(proc_mutex);
+      pruned_chuncks++;
+      return Status::OK();
+    }
+    pending_chuncks->Add();
+    DownloadColumnChunck(downloader, file_metadata, file_path, col_chunck_file.row_group,
+                         COLUMN_ID, process_chunck(file_metadata));
+    return Status::OK();
+  };
+
+  auto probe_dictionary = [&, pending_chuncks](
+                              S3Path file_path,
+                              std::shared_ptr<parquet::FileMetaData> file_metadata) {
+    return [&, file_path, file_metadata, pending_chuncks](Result<ColChunckFile> result) {
+      if (!result.ok()) {
+        pending_chuncks->Done(result.status());
+        return;
+      }
+      Executor::Default().Submit(
+          Lane::CPU, [&, file_path, file_metadata, pending_chuncks,
+                      col_chunck_file = result.ValueOrDie()]() {
+            pending_chuncks->Done(
+                probe_chunck(col_chunck_file, file_path, file_metadata));
+          });
+    };
+  };
+
+  // Download the column chuncks of the row groups assigned to the task, or only their
+  // dictionary page if they can be pruned by it
   metrics_manager->NewEvent("start_scheduler");
-  while (downloaded_chuncks < file_metadata->num_row_groups()) {
-    metrics_manager->EnterPhase("wait_dl");
-    synchronizer->wait();
-    metrics_manager->ExitPhase("wait_dl");
-    auto col_chunck_files = GetColumnChunckFiles(downloader);
-    for (auto& col_chunck_file : col_chunck_files) {
-      metrics_manager->EnterPhase("proc");
-      metrics_manager->NewEvent("starting_proc");
-      // read chunck
-      rows_read += read_column_chunck(col_chunck_file.file, file_metadata,
-                                      col_chunck_file.row_group)
-                       .ValueOrDie();
-      downloaded_chuncks++;
-      metrics_manager->ExitPhase("proc");
+  for (size_t f = 0; f < file_paths.size(); f++) {
+    auto& file_metadata = file_metadatas[f];
+    auto& row_groups = file_row_groups[f];
+    // only the dictionaries of strings can be probed for FILTER_VALUE
+    bool probe_dictionaries =
+        !FILTER_VALUE.empty() &&
+        file_metadata->schema()->Column(COLUMN_ID)->physical_type() ==
+            parquet::Type::BYTE_ARRAY;
+    pending_chuncks->Add(row_groups.size());
+    for (auto row_group : row_groups) {
+      // TODO a more progressive scheduling of new connections
+      auto col_chunck_meta = file_metadata->RowGroup(row_group)->ColumnChunk(COLUMN_ID);
+      auto dict_page_range = GetPrunableDictionaryPage(*col_chunck_meta);
+      if (probe_dictionaries && dict_page_range.has_value()) {
+        DownloadDictionaryPage(downloader, file_paths[f], row_group, COLUMN_ID,
+                               dict_page_range.value(),
+                               probe_dictionary(file_paths[f], file_metadata));
+      } else {
+        DownloadColumnChunck(downloader, file_metadata, file_paths[f], row_group,
+                             COLUMN_ID, process_chunck(file_metadata));
+      }
     }
   }
+
+  metrics_manager->EnterPhase("wait_dl");
+  pending_chuncks->Wait();
+  metrics_manager->ExitPhase("wait_dl");
   metrics_manager->NewEvent("processings_finished");
+  if (!pending_chuncks->status().ok()) {
+    return aws::lambda_runtime::invocation_response::failure(
+        pending_chuncks->status().ToString(), "ScanError");
+  }
 
-  std::cout << "downloaded_chuncks:" << downloaded_chuncks << "/rows_read:" << rows_read
+  std::cout << "downloaded_chuncks:" << downloaded_chuncks
+            << "/pruned_chuncks:" << pruned_chuncks << "/rows_read:" << rows_read
             << std::endl;
+  std::shared_ptr<arrow::RecordBatch> partials;
+  if (GROUP_BY) {
+    auto finished = finish_partials(*file_metadatas[0], column_name, aggregator);
+    if (!finished.ok()) {
+      return aws::lambda_runtime::invocation_response::failure(
+          finished.status().ToString(), "ScanError");
+    }
+    partials = finished.ValueOrDie();
+    std::cout << "groups:" << partials->num_rows() << std::endl;
+  }
+  std::cout << "copied_bytes:" << mem_pool->copied_bytes() << std::endl;
+  if (!HIVE_ENDPOINT.empty() && partials != nullptr) {
+    metrics_manager->EnterPhase("send_hive");
+    auto dl_micro = std::max<int64_t>(1, util::get_duration_micro(dl_start, dl_end));
+    auto link_bytes_per_sec =
+        LINK_MBPS > 0 ? LINK_MBPS * 1e6 : downloaded_bytes * 1e6 / dl_micro;
+    // the task id lets the hive discard the duplicates of speculated invocations
+    auto task_id = GetPayloadTaskId(req.payload).ValueOrDie();
+    auto command =
+        task_id.has_value() ? MakeTaskCommand(QUERY_ID, task_id.value()) : QUERY_ID;
+    auto sent = send_partials(partials, command, link_bytes_per_sec);
+    metrics_manager->ExitPhase("send_hive");
+    if (!sent.ok()) {
+      return aws::lambda_runtime::invocation_response::failure(sent.ToString(),
+                                                               "HiveError");
+    }
+  }
   metrics_manager->Print();
 
   return aws::lambda_runtime::invocation_response::success("Done", "text/plain");
@@ -0,0 +1,259 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <arrow/api.h>
+#include <aws/lambda-runtime/runtime.h>
+#include <parquet/api/reader.h>
+#include <parquet/exception.h>
+
+#include <iostream>
+#include <mutex>
+
+#include "bootstrap.h"
+#include "cust_memory_pool.h"
+#include "downloader.h"
+#include "executor.h"
+#include "footer-aggregates.h"
+#include "logger.h"
+#include "parquet-helpers.h"
+#include "partial-file.h"
+#include "sdk-init.h"
+#include "toolbox.h"
+
+using namespace Buzz;
+
+static const int MAX_CONCURRENT_DL = util::getenv_int("MAX_CONCURRENT_DL", 8);
+static const int NB_CONN_INIT = util::getenv_int("NB_CONN_INIT", 1);
+// one of count, min or max
+static const std::string AGGREGATE = util::getenv("AGGREGATE", "count");
+// aggregated column, a negative id with AGGREGATE=count means COUNT(*)
+static const int64_t COLUMN_ID = util::getenv_int("COLUMN_ID", 16);
+static const auto mem_pool = new CustomMemoryPool(arrow::default_memory_pool());
+static const bool IS_LOCAL = util::getenv_bool("IS_LOCAL", false);
+static const char* BUCKET_NAME = util::getenv("BUCKET_NAME", "defaultbucket");
+static const char* KEY_NAME = util::getenv("KEY_NAME", "default.parquet");
+
+constexpr int64_t BATCH_SIZE = 1024 * 2;
+
+Result<AggregateSpec> parse_aggregate(const parquet::FileMetaData& file_metadata) {
+  std::string column_name;
+  if (COLUMN_ID >= 0) {
+    if (COLUMN_ID >= file_metadata.num_columns()) {
+      return Status::Invalid("COLUMN_ID out of range");
+    }
+    column_name = file_metadata.schema()->Column(COLUMN_ID)->name();
+  }
+  if (AGGREGATE == "count") {
+    return AggregateSpec{AggregateKind::Count, column_name};
+  }
+  if (column_name.empty()) {
+    return Status::Invalid("MIN and MAX require a COLUMN_ID");
+  }
+  if (AGGREGATE == "min") {
+    return AggregateSpec{AggregateKind::Min, column_name};
+  }
+  if (AGGREGATE == "max") {
+    return AggregateSpec{AggregateKind::Max, column_name};
+  }
+  return Status::Invalid("Unknown AGGREGATE ", AGGREGATE);
+}
+
+// Read the statistics of a column chunck that has none in the footer
+template <typename DType>
+Result<ColumnStats<DType>> scan_column_chunck(
+    std::shared_ptr<PartialFile> rg_file,
+    std::shared_ptr<parquet::FileMetaData> file_metadata, int rg) {
+  using CType = typename DType::c_type;
+  try {
+    parquet::ReaderProperties props(mem_pool);
+    auto reader = parquet::ParquetFileReader::Open(rg_file, props, file_metadata);
+    auto untyped_col = reader->RowGroup(rg)->Column(COLUMN_ID);
+    auto typed_reader =
+        static_cast<parquet::TypedColumnReader<DType>*>(untyped_col.get());
+    std::vector<CType> values(BATCH_SIZE);
+    std::vector<int16_t> def_levels(BATCH_SIZE);
+    ColumnStats<DType> stats;
+    while (typed_reader->HasNext()) {
+      int64_t values_read = 0;
+      auto levels_read = typed_reader->ReadBatch(BATCH_SIZE, def_levels.data(), nullptr,
+                                                 values.data(), &values_read);
+      stats.Update(values.data(), values_read, levels_read);
+    }
+    return stats;
+  } catch (const parquet::ParquetException& e) {
+    return Status::IOError("Scanning column chunck failed: ", e.what());
+  }
+}
+
+// Answer from the footer statistics, only the row groups without them are downloaded
+template <typename DType>
+Status run_footer_aggregate(const AggregateSpec& spec,
+                            std::shared_ptr<parquet::FileMetaData> file_metadata,
+                            std::shared_ptr<Downloader> downloader,
+                            std::shared_ptr<MetricsManager> metrics_manager,
+                            const S3Path& file_path) {
+  ARROW_ASSIGN_OR_RAISE(auto footer_stats,
+                        GetFooterStats<DType>(*file_metadata, COLUMN_ID));
+  auto nb_to_scan = footer_stats.row_groups_to_scan.size();
+  // the chuncks are scanned concurrently on the CPU lane so that the download threads
+  // only wait on the network, only the merge of their statistics is serialized
+  std::mutex stats_mutex;
+  auto scan_chunck = [&](const ColChunckFile& col_chunck_file) -> Status {
+    ARROW_ASSIGN_OR_RAISE(auto chunck_stats,
+                          scan_column_chunck<DType>(col_chunck_file.file, file_metadata,
+                                                    col_chunck_file.row_group));
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    footer_stats.Merge(chunck_stats);
+    return Status::OK();
+  };
+#if BUZZ_HAS_COROUTINES
+  // each chunck is scanned by a coroutine that suspends on its download and resumes on
+  // the CPU lane, the closure outlives the coroutines as they are all awaited below
+  std::mutex status_mutex;
+  Status scan_status;
+  auto scan_row_group = [&](int rg) -> Task<void> {
+    auto result =
+        co_await GetColumnChunck(downloader, file_metadata, file_path, rg, COLUMN_ID);
+    auto status = result.ok() ? scan_chunck(result.ValueOrDie()) : result.status();
+    std::lock_guard<std::mutex> lock(status_mutex);
+    if (scan_status.ok()) {
+      scan_status = status;
+    }
+  };
+  CoroScheduler scheduler;
+  for (auto rg : footer_stats.row_groups_to_scan) {
+    scheduler.Spawn(scan_row_group(rg));
+  }
+
+  metrics_manager->EnterPhase("wait_dl");
+  scheduler.Wait();
+  metrics_manager->ExitPhase("wait_dl");
+  RETURN_NOT_OK(scan_status);
+#else
+  auto pending_chuncks = std::make_shared<WaitGroup>();
+  pending_chuncks->Add(nb_to_scan);
+  for (auto rg : footer_stats.row_groups_to_scan) {
+    DownloadColumnChunck(
+        downloader, file_metadata, file_path, rg, COLUMN_ID,
+        [&, pending_chuncks](Result<ColChunckFile> result) {
+          if (!result.ok()) {
+            pending_chuncks->Done(result.status());
+            return;
+          }
+          Executor::Default().Submit(
+              Lane::CPU, [&, pending_chuncks, col_chunck_file = result.ValueOrDie()]() {
+                pending_chuncks->Done(scan_chunck(col_chunck_file));
+              });
+        });
+  }
+
+  metrics_manager->EnterPhase("wait_dl");
+  pending_chuncks->Wait();
+  metrics_manager->ExitPhase("wait_dl");
+  RETURN_NOT_OK(pending_chuncks->status());
+#endif
+
+  std::cout << "scanned_row_groups:" << nb_to_scan << "/footer_row_groups:"
+            << file_metadata->num_row_groups() - nb_to_scan << std::endl;
+  std::cout << ToString(spec) << ":";
+  if (spec.kind == AggregateKind::Count) {
+    std::cout << footer_stats.count;
+  } else if (footer_stats.count == 0) {
+    std::cout << "null";
+  } else {
+    std::cout << (spec.kind == AggregateKind::Min ? footer_stats.min : footer_stats.max);
+  }
+  std::cout << std::endl;
+  return Status::OK();
+}
+
+static aws::lambda_runtime::invocation_response my_handler(
+    aws::lambda_runtime::invocation_request const& req, const SdkOptions& options) {
+  auto synchronizer = std::make_shared<Synchronizer>();
+  auto metrics_manager = std::make_shared<MetricsManager>();
+  metrics_manager->EnterPhase("wait_foot");
+  auto downloader = std::make_shared<Downloader>(synchronizer, MAX_CONCURRENT_DL,
+                                                 metrics_manager, options);
+
+  S3Path file_path{BUCKET_NAME, KEY_NAME};
+
+  auto file_metadata =
+      GetMetadata(downloader, mem_pool, file_path, NB_CONN_INIT);
+
+  metrics_manager->ExitPhase("wait_foot");
+  auto spec = parse_aggregate(*file_metadata);
+  if (!spec.ok()) {
+    return aws::lambda_runtime::invocation_response::failure(spec.status().message(),
+                                                             "InvalidParameter");
+  }
+  if (spec->column.empty()) {
+    // COUNT(*) is the sum of the row counts of the row groups
+    std::cout << ToString(*spec) << ":" << file_metadata->num_rows() << std::endl;
+    metrics_manager->Print();
+    return aws::lambda_runtime::invocation_response::success("Done", "text/plain");
+  }
+  auto support = CheckFooterStatsSupport(*file_metadata->schema()->Column(COLUMN_ID));
+  if (!support.ok()) {
+    return aws::lambda_runtime::invocation_response::failure(support.message(),
+                                                             "InvalidParameter");
+  }
+
+  Status status;
+  switch (file_metadata->schema()->Column(COLUMN_ID)->physical_type()) {
+    case parquet::Type::INT32:
+      status = run_footer_aggregate<parquet::Int32Type>(*spec, file_metadata, downloader,
+                                                        metrics_manager, file_path);
+      break;
+    case parquet::Type::INT64:
+      status = run_footer_aggregate<parquet::Int64Type>(*spec, file_metadata, downloader,
+                                                        metrics_manager, file_path);
+      break;
+    case parquet::Type::FLOAT:
+      status = run_footer_aggregate<parquet::FloatType>(*spec, file_metadata, downloader,
+                                                        metrics_manager, file_path);
+      break;
+    default:
+      status = run_footer_aggregate<parquet::DoubleType>(
+          *spec, file_metadata, downloader, metrics_manager, file_path);
+  }
+  if (!status.ok()) {
+    return aws::lambda_runtime::invocation_response::failure(status.ToString(),
+                                                             "ScanError");
+  }
+  metrics_manager->Print();
+
+  return aws::lambda_runtime::invocation_response::success("Done", "text/plain");
+}
+
+/** LAMBDA MAIN **/
+int main() {
+  InitializeAwsSdk(AwsSdkLogLevel::Off);
+  // init s3 client
+  SdkOptions options;
+  options.region = "eu-west-1";
+  if (IS_LOCAL) {
+    options.endpoint_override = "minio:9000";
+    std::cout << "endpoint_override=" << options.endpoint_override << std::endl;
+    options.scheme = "http";
+  }
+  bootstrap([&options](aws::lambda_runtime::invocation_request const& req) {
+    return my_handler(req, options);
+  });
+  // this is mainly usefull to avoid Valgrind errors as Lambda do not guaranty the
+  // execution of this code before killing the container
+  FinalizeAwsSdk();
+}
@@ -22,14 +22,23 @@
 #include <parquet/exception.h>
 
 #include <iostream>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
 
 #include "bootstrap.h"
+#include "buffer-sizes.h"
 #include "cust_memory_pool.h"
 #include "downloader.h"
+#include "executor.h"
+#include "hyperloglog.h"
+#include "kll-sketch.h"
 #include "logger.h"
+#include "page-decompressor.h"
 #include "parquet-helpers.h"
 #include "partial-file.h"
 #include "sdk-init.h"
+#include "space-saving.h"
 #include "stats.h"
 #include "toolbox.h"
 
@@ -40,45 +49,273 @@ using namespace Buzz;
 static const int MAX_CONCURRENT_DL = util::getenv_int("MAX_CONCURRENT_DL", 8);
 static const int NB_CONN_INIT = util::getenv_int("NB_CONN_INIT", 1);
 static const int64_t COLUMN_ID = util::getenv_int("COLUMN_ID", 16);
+// if true, estimate the number of distinct values of COLUMN_ID
+static const bool DISTINCT_COUNT = util::getenv_bool("DISTINCT_COUNT", false);
+// if not 0, print the TOP_K most frequent values of COLUMN_ID
+static const int64_t TOP_K = util::getenv_int("TOP_K", 0);
+// if true, print the p50/p95/p99 of COLUMN_ID (numeric columns only)
+static const bool QUANTILES = util::getenv_bool("QUANTILES", false);
+// if true, also decode COLUMN_ID into Arrow arrays sized upfront from the chunck metadata
+static const bool MATERIALIZE = util::getenv_bool("MATERIALIZE", false);
+// if more than 1, the pages of a chunck are decompressed in parallel before decoding
+static const int DECOMPRESSION_THREADS = util::getenv_int("DECOMPRESSION_THREADS", 1);
 static const auto mem_pool = new CustomMemoryPool(arrow::default_memory_pool());
 static const bool IS_LOCAL = util::getenv_bool("IS_LOCAL", false);
 static const char* BUCKET_NAME = util::getenv("BUCKET_NAME", "defaultbucket");
 static const char* KEY_NAME = util::getenv("KEY_NAME", "default.parquet");
 
-// Read a column chunck
-int64_t read_column_chunck(std::shared_ptr<PartialFile> rg_file,
-                           std::shared_ptr<parquet::FileMetaData> file_metadata, int rg) {
-  parquet::ReaderProperties props(mem_pool);
-  std::unique_ptr<parquet::ParquetFileReader> reader =
-      parquet::ParquetFileReader::Open(rg_file, props, file_metadata);
-  // reader->metadata()->schema()->Column(col_index)->logical_type();
-  auto untyped_col = reader->RowGroup(rg)->Column(COLUMN_ID);
-  // untyped_col->type()
-  // BOOLEAN = 0,
-  // INT32 = 1,
-  // INT64 = 2,
-  // INT96 = 3,
-  // FLOAT = 4,
-  // DOUBLE = 5,
-  // BYTE_ARRAY = 6,
-  // FIXED_LEN_BYTE_ARRAY = 7,
-  // UNDEFINED = 8
-  auto* typed_reader = static_cast<parquet::ByteArrayReader*>(untyped_col.get());
-  constexpr int batch_size = 1024 * 2;
-  int64_t total_values_read = 0;
-  // this should be aligned
-  uint8_t* values;
-  mem_pool->Allocate(batch_size * sizeof(parquet::ByteArray), &values);
-  auto values_casted = reinterpret_cast<parquet::ByteArray*>(values);
-  // CountStat<parquet::ByteArray> count_stat;
-  while (typed_reader->HasNext()) {
-    int64_t values_read = 0;
-    typed_reader->ReadBatch(batch_size, nullptr, nullptr, values_casted, &values_read);
-    // count_stat.Add(values_casted, values_read);
-    total_values_read += values_read;
-  }
-  // count_stat.Print();
-  return total_values_read;
+constexpr int64_t BATCH_SIZE = 1024 * 2;
+
+/// Arrow builder for the values of a physical type
+template <typename DType>
+struct ArrowBuilderTraits;
+template <>
+struct ArrowBuilderTraits<parquet::BooleanType> {
+  using BuilderType = arrow::BooleanBuilder;
+};
+template <>
+struct ArrowBuilderTraits<parquet::Int32Type> {
+  using BuilderType = arrow::Int32Builder;
+};
+template <>
+struct ArrowBuilderTraits<parquet::Int64Type> {
+  using BuilderType = arrow::Int64Builder;
+};
+template <>
+struct ArrowBuilderTraits<parquet::FloatType> {
+  using BuilderType = arrow::FloatBuilder;
+};
+template <>
+struct ArrowBuilderTraits<parquet::DoubleType> {
+  using BuilderType = arrow::DoubleBuilder;
+};
+template <>
+struct ArrowBuilderTraits<parquet::ByteArrayType> {
+  using BuilderType = arrow::BinaryBuilder;
+};
+template <>
+struct ArrowBuilderTraits<parquet::FLBAType> {
+  using BuilderType = arrow::FixedSizeBinaryBuilder;
+};
+
+/// Scan of the values of a column, dispatched once on the physical type of the column
+class ColumnScan {
+ public:
+  virtual ~ColumnScan() = default;
+  /// Read a whole column chunck, returns the number of rows read
+  virtual int64_t Read(parquet::ColumnReader* untyped_col,
+                       const parquet::ColumnChunkMetaData& chunck_metadata) = 0;
+  /// Accumulate the values read by another scan of the same column
+  virtual Status Merge(const ColumnScan& other) = 0;
+  virtual void Print() const = 0;
+};
+
+template <typename DType>
+class TypedColumnScan : public ColumnScan {
+ public:
+  using CType = typename DType::c_type;
+  using BuilderType = typename ArrowBuilderTraits<DType>::BuilderType;
+  static constexpr bool IS_NUMERIC =
+      std::is_arithmetic<CType>::value && !std::is_same<CType, bool>::value;
+
+  TypedColumnScan(const parquet::ColumnDescriptor* descr, ColumnStats<DType> stats)
+      : descr_(descr),
+        stats_(std::move(stats)),
+        distinct_sketch_(HyperLogLog::Make().ValueOrDie()),
+        quantile_sketch_(KllSketch::Make().ValueOrDie()),
+        // monitor more values than requested to get accurate counts for the top ones
+        top_k_summary_(
+            SpaceSaving::Make(std::max<int64_t>(1024, 10 * TOP_K)).ValueOrDie()) {
+    // the batch buffers are reused for all the column chuncks
+    PARQUET_THROW_NOT_OK(mem_pool->Allocate(BATCH_SIZE * sizeof(CType), &values_));
+    PARQUET_THROW_NOT_OK(mem_pool->Allocate(BATCH_SIZE * sizeof(int16_t), &def_levels_));
+    if constexpr (std::is_same<DType, parquet::FLBAType>::value) {
+      builder_ = std::make_unique<BuilderType>(
+          arrow::fixed_size_binary(descr->type_length()), mem_pool);
+    } else {
+      builder_ = std::make_unique<BuilderType>(mem_pool);
+    }
+  }
+
+  ~TypedColumnScan() override {
+    mem_pool->Free(values_, BATCH_SIZE * sizeof(CType));
+    mem_pool->Free(def_levels_, BATCH_SIZE * sizeof(int16_t));
+  }
+
+  int64_t Read(parquet::ColumnReader* untyped_col,
+               const parquet::ColumnChunkMetaData& chunck_metadata) override {
+    auto typed_reader = static_cast<parquet::TypedColumnReader<DType>*>(untyped_col);
+    if (MATERIALIZE) {
+      // reserve the whole chunck at once so that the builders never reallocate and copy
+      auto sizes = EstimateDecodedSizes(chunck_metadata, *descr_);
+      PARQUET_THROW_NOT_OK(builder_->Reserve(sizes.length));
+      if constexpr (std::is_same<DType, parquet::ByteArrayType>::value) {
+        PARQUET_THROW_NOT_OK(builder_->ReserveData(sizes.values_bytes));
+      }
+    }
+    auto values = reinterpret_cast<CType*>(values_);
+    // definition levels are required to read the nulls of optional columns
+    auto def_levels = reinterpret_cast<int16_t*>(def_levels_);
+    int64_t total_levels_read = 0;
+    while (typed_reader->HasNext()) {
+      int64_t values_read = 0;
+      auto levels_read =
+          typed_reader->ReadBatch(BATCH_SIZE, def_levels, nullptr, values, &values_read);
+      Consume(values, values_read, levels_read);
+      if (MATERIALIZE) {
+        Materialize(values, def_levels, levels_read);
+      }
+      total_levels_read += levels_read;
+    }
+    if (MATERIALIZE) {
+      std::shared_ptr<arrow::Array> array;
+      PARQUET_THROW_NOT_OK(builder_->Finish(&array));
+      materialized_rows_ += array->length();
+    }
+    return total_levels_read;
+  }
+
+  Status Merge(const ColumnScan& other) override {
+    auto& typed_other = static_cast<const TypedColumnScan&>(other);
+    stats_.Merge(typed_other.stats_);
+    materialized_rows_ += typed_other.materialized_rows_;
+    if (DISTINCT_COUNT) {
+      RETURN_NOT_OK(distinct_sketch_.Merge(typed_other.distinct_sketch_));
+    }
+    if (IS_NUMERIC && QUANTILES) {
+      RETURN_NOT_OK(quantile_sketch_.Merge(typed_other.quantile_sketch_));
+    }
+    if (TOP_K > 0) {
+      RETURN_NOT_OK(top_k_summary_.Merge(typed_other.top_k_summary_));
+    }
+    return Status::OK();
+  }
+
+  void Print() const override {
+    std::cout << "stats:" << stats_.ToString() << std::endl;
+    if (MATERIALIZE) {
+      std::cout << "materialized_rows:" << materialized_rows_ << std::endl;
+    }
+    if (DISTINCT_COUNT) {
+      std::cout << "distinct_estimate:" << distinct_sketch_.Estimate() << std::endl;
+    }
+    if (IS_NUMERIC && QUANTILES) {
+      auto quantiles = quantile_sketch_.Quantiles({0.5, 0.95, 0.99});
+      std::cout << "p50:" << quantiles[0] << "/p95:" << quantiles[1]
+                << "/p99:" << quantiles[2] << std::endl;
+    }
+    for (auto& entry : top_k_summary_.TopK(TOP_K)) {
+      std::cout << "top_value:" << entry.value << "/count:" << entry.count
+                << "/error:" << entry.error << std::endl;
+    }
+  }
+
+ private:
+  /// Statically dispatched to the accumulators that support the type
+  void Consume(const CType* values, int64_t values_read, int64_t levels_read) {
+    stats_.Update(values, values_read, levels_read);
+    if constexpr (!std::is_same<DType, parquet::FLBAType>::value) {
+      if (DISTINCT_COUNT) {
+        distinct_sketch_.Update(values, values_read);
+      }
+    }
+    if constexpr (IS_NUMERIC) {
+      if (QUANTILES) {
+        quantile_sketch_.Update(values, values_read);
+      }
+    }
+    if constexpr (std::is_same<DType, parquet::ByteArrayType>::value) {
+      if (TOP_K > 0) {
+        top_k_summary_.Update(values, values_read);
+      }
+    }
+  }
+
+  /// Append the values of a batch and a null for each undefined level
+  void Materialize(const CType* values, const int16_t* def_levels, int64_t levels_read) {
+    auto max_def_level = descr_->max_definition_level();
+    int64_t value_idx = 0;
+    for (int64_t i = 0; i < levels_read; i++) {
+      if (max_def_level > 0 && def_levels[i] < max_def_level) {
+        builder_->UnsafeAppendNull();
+        continue;
+      }
+      auto& value = values[value_idx++];
+      if constexpr (std::is_same<DType, parquet::ByteArrayType>::value) {
+        // the data size of dictionary encoded chuncks is only an estimate
+        PARQUET_THROW_NOT_OK(builder_->Append(value.ptr, value.len));
+      } else if constexpr (std::is_same<DType, parquet::FLBAType>::value) {
+        builder_->UnsafeAppend(value.ptr);
+      } else {
+        builder_->UnsafeAppend(value);
+      }
+    }
+  }
+
+  const parquet::ColumnDescriptor* descr_;
+  ColumnStats<DType> stats_;
+  HyperLogLog distinct_sketch_;
+  KllSketch quantile_sketch_;
+  SpaceSaving top_k_summary_;
+  uint8_t* values_;
+  uint8_t* def_levels_;
+  std::unique_ptr<BuilderType> builder_;
+  int64_t materialized_rows_ = 0;
+};
+
+/// INT96 (legacy timestamps) is not supported
+std::unique_ptr<ColumnScan> MakeColumnScan(const parquet::ColumnDescriptor* descr) {
+  switch (descr->physical_type()) {
+    case parquet::Type::BOOLEAN:
+      return std::make_unique<TypedColumnScan<parquet::BooleanType>>(
+          descr, ColumnStats<parquet::BooleanType>());
+    case parquet::Type::INT32:
+      return std::make_unique<TypedColumnScan<parquet::Int32Type>>(
+          descr, ColumnStats<parquet::Int32Type>());
+    case parquet::Type::INT64:
+      return std::make_unique<TypedColumnScan<parquet::Int64Type>>(
+          descr, ColumnStats<parquet::Int64Type>());
+    case parquet::Type::FLOAT:
+      return std::make_unique<TypedColumnScan<parquet::FloatType>>(
+          descr, ColumnStats<parquet::FloatType>());
+    case parquet::Type::DOUBLE:
+      return std::make_unique<TypedColumnScan<parquet::DoubleType>>(
+          descr, ColumnStats<parquet::DoubleType>());
+    case parquet::Type::BYTE_ARRAY:
+      return std::make_unique<TypedColumnScan<parquet::ByteArrayType>>(
+          descr, ColumnStats<parquet::ByteArrayType>());
+    case parquet::Type::FIXED_LEN_BYTE_ARRAY:
+      return std::make_unique<TypedColumnScan<parquet::FLBAType>>(
+          descr, ColumnStats<parquet::FLBAType>(descr->type_length()));
+    default:
+      return nullptr;
+  }
+}
+
+// Read a column chunck, returns the number of rows read
+Result<int64_t> read_column_chunck(std::shared_ptr<PartialFile> rg_file,
+                                   std::shared_ptr<parquet::FileMetaData> file_metadata,
+                                   int rg, ColumnScan* scan) {
+  try {
+    parquet::ReaderProperties props(mem_pool);
+    std::unique_ptr<parquet::ParquetFileReader> reader =
+        parquet::ParquetFileReader::Open(rg_file, props, file_metadata);
+    auto rg_reader = reader->RowGroup(rg);
+    auto col_chunck_meta = rg_reader->metadata()->ColumnChunk(COLUMN_ID);
+    std::shared_ptr<parquet::ColumnReader> untyped_col;
+    if (DECOMPRESSION_THREADS > 1) {
+      ARROW_ASSIGN_OR_RAISE(auto page_reader,
+                            DecompressColumnChunck(rg_file, *col_chunck_meta,
+                                                   DECOMPRESSION_THREADS, mem_pool));
+      untyped_col = parquet::ColumnReader::Make(
+          file_metadata->schema()->Column(COLUMN_ID), std::move(page_reader), mem_pool);
+    } else {
+      untyped_col = rg_reader->Column(COLUMN_ID);
+    }
+    return scan->Read(untyped_col.get(), *col_chunck_meta);
+  } catch (const parquet::ParquetException& e) {
+    return Status::IOError("Reading column chunck failed: ", e.what());
+  }
 }
 
 static aws::lambda_runtime::invocation_response my_handler(
@@ -90,42 +327,118 @@ static aws::lambda_runtime::invocation_response my_handler(
   auto downloader = std::make_shared<Downloader>(synchronizer, MAX_CONCURRENT_DL,
                                                  metrics_manager, options);
 
-  S3Path file_path{BUCKET_NAME, KEY_NAME};
-
-  auto file_metadata =
-      GetMetadata(downloader, synchronizer, mem_pool, file_path, NB_CONN_INIT);
-
+  auto payload = ParseTaskPayload(req.payload);
+  if (!payload.ok()) {
+    return aws::lambda_runtime::invocation_response::failure(
+        payload.status().message(), "InvalidParameter");
+  }
+  // the footers are all fetched before the column chuncks so that the scan can be
+  // built from the schema of the first file, the payload has at least one file and its
+  // row groups are checked before any chunck is scheduled
+  std::vector<S3Path> file_paths;
+  std::unordered_map<std::string, std::shared_ptr<parquet::FileMetaData>> file_metadatas;
+  std::vector<std::vector<int>> file_row_groups;
+  for (auto& file_payload : payload.ValueOrDie()) {
+    S3Path file_path{BUCKET_NAME, file_payload.key.empty() ? KEY_NAME : file_payload.key};
+    // the connections are only initialized once for the bucket
+    auto file_metadata = GetMetadata(downloader, mem_pool, file_path,
+                                     file_paths.empty() ? NB_CONN_INIT : 0, file_payload);
+    auto row_groups = file_payload.AssignedRowGroups(file_metadata->num_row_groups());
+    if (!row_groups.ok()) {
+      return aws::lambda_runtime::invocation_response::failure(
+          row_groups.status().message(), "InvalidParameter");
+    }
+    file_metadatas[file_path.key] = file_metadata;
+    file_row_groups.push_back(row_groups.ValueOrDie());
+    file_paths.push_back(file_path);
+  }
   metrics_manager->ExitPhase("wait_foot");
 
-  // Download column chuncks
-  for (int i = 0; i < file_metadata->num_row_groups(); i++) {
-    // TODO a more progressive scheduling of new connections
-    DownloadColumnChunck(downloader, file_metadata, file_path, i, COLUMN_ID);
+  auto column_descr = file_metadatas.at(file_paths[0].key)->schema()->Column(COLUMN_ID);
+  auto scan = MakeColumnScan(column_descr);
+  if (scan == nullptr) {
+    return aws::lambda_runtime::invocation_response::failure(
+        "Unsupported physical type for COLUMN_ID", "InvalidParameter");
   }
 
-  // Process chuncks
+  // The chuncks are decoded concurrently, each one into a scan that no other chunck
+  // uses meanwhile. There are never more scans than busy CPU workers and they are
+  // merged once all the chuncks are read.
+  std::mutex scans_mutex;
+  std::vector<std::unique_ptr<ColumnScan>> scans;
+  std::vector<ColumnScan*> idle_scans = {scan.get()};
+  scans.push_back(std::move(scan));
   int downloaded_chuncks = 0;
   int64_t rows_read = 0;
+  auto process_chunck = [&](const ColChunckFile& col_chunck_file,
+                            std::shared_ptr<parquet::FileMetaData> file_metadata) {
+    ColumnScan* worker_scan;
+    {
+      std::lock_guard<std::mutex> lock(scans_mutex);
+      if (idle_scans.empty()) {
+        scans.push_back(MakeColumnScan(column_descr));
+        idle_scans.push_back(scans.back().get());
+      }
+      worker_scan = idle_scans.back();
+      idle_scans.pop_back();
+    }
+    auto chunck_rows = read_column_chunck(col_chunck_file.file, file_metadata,
+                                          col_chunck_file.row_group, worker_scan);
+    std::lock_guard<std::mutex> lock(scans_mutex);
+    idle_scans.push_back(worker_scan);
+    RETURN_NOT_OK(chunck_rows.status());
+    rows_read += chunck_rows.ValueOrDie();
+    downloaded_chuncks++;
+    return Status::OK();
+  };
+
+  // Download column chuncks, each one is decoded on the CPU lane as soon as it is
+  // downloaded so that the download threads only wait on the network
+  auto pending_chuncks = std::make_shared<WaitGroup>();
   metrics_manager->NewEvent("start_scheduler");
-  while (downloaded_chuncks < file_metadata->num_row_groups()) {
-    metrics_manager->EnterPhase("wait_dl");
-    synchronizer->wait();
-    metrics_manager->ExitPhase("wait_dl");
-    auto col_chunck_files = GetColumnChunckFiles(downloader);
-    for (auto& col_chunck_file : col_chunck_files) {
-      metrics_manager->EnterPhase("proc");
-      metrics_manager->NewEvent("starting_proc");
-      // read chunck
-      rows_read += read_column_chunck(col_chunck_file.file, file_metadata,
-                                      col_chunck_file.row_group);
-      downloaded_chuncks++;
-      metrics_manager->ExitPhase("proc");
+  for (size_t i = 0; i < file_paths.size(); i++) {
+    auto& file_metadata = file_metadatas.at(file_paths[i].key);
+    for (auto row_group : file_row_groups[i]) {
+      // TODO a more progressive scheduling of new connections
+      pending_chuncks->Add();
+      DownloadColumnChunck(
+          downloader, file_metadata, file_paths[i], row_group, COLUMN_ID,
+          [&, file_metadata, pending_chuncks](Result<ColChunckFile> result) {
+            if (!result.ok()) {
+              pending_chuncks->Done(result.status());
+              return;
+            }
+            Executor::Default().Submit(
+                Lane::CPU, [&, file_metadata, pending_chuncks,
+                            col_chunck_file = result.ValueOrDie()]() {
+                  metrics_manager->NewEvent("starting_proc");
+                  pending_chuncks->Done(process_chunck(col_chunck_file, file_metadata));
+                });
+          });
     }
   }
+
+  // Wait for the chuncks to be processed
+  metrics_manager->EnterPhase("wait_dl");
+  pending_chuncks->Wait();
+  metrics_manager->ExitPhase("wait_dl");
   metrics_manager->NewEvent("processings_finished");
+  if (!pending_chuncks->status().ok()) {
+    return aws::lambda_runtime::invocation_response::failure(
+        pending_chuncks->status().ToString(), "ScanError");
+  }
+  for (size_t i = 1; i < scans.size(); i++) {
+    auto status = scans[0]->Merge(*scans[i]);
+    if (!status.ok()) {
+      return aws::lambda_runtime::invocation_response::failure(status.ToString(),
+                                                               "ScanError");
+    }
+  }
 
   std::cout << "downloaded_chuncks:" << downloaded_chuncks << "/rows_read:" << rows_read
-            << std::endl;
+            << "/scans:" << scans.size() << std::endl;
+  scans[0]->Print();
+  std::cout << "copied_bytes:" << mem_pool->copied_bytes() << std::endl;
   metrics_manager->Print();
 
   return aws::lambda_runtime::invocation_response::success("Done", "text/plain");
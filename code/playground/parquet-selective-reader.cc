@@ -0,0 +1,283 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <aws/lambda-runtime/runtime.h>
+#include <parquet/api/reader.h>
+#include <parquet/exception.h>
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include "bootstrap.h"
+#include "cust_memory_pool.h"
+#include "downloader.h"
+#include "executor.h"
+#include "logger.h"
+#include "parquet-helpers.h"
+#include "partial-file.h"
+#include "row-selection.h"
+#include "sdk-init.h"
+#include "toolbox.h"
+
+using namespace Buzz;
+
+static const int MAX_CONCURRENT_DL = util::getenv_int("MAX_CONCURRENT_DL", 8);
+static const int NB_CONN_INIT = util::getenv_int("NB_CONN_INIT", 1);
+// BYTE_ARRAY column on which the equality filter is evaluated
+static const int64_t FILTER_COLUMN_ID = util::getenv_int("FILTER_COLUMN_ID", 16);
+static const std::string FILTER_VALUE = util::getenv("FILTER_VALUE", "");
+// comma separated ids of the columns read for the rows that match the filter
+static const char* PROJECTED_COLUMN_IDS = util::getenv("PROJECTED_COLUMN_IDS", "0,1");
+static const auto mem_pool = new CustomMemoryPool(arrow::default_memory_pool());
+static const bool IS_LOCAL = util::getenv_bool("IS_LOCAL", false);
+static const char* BUCKET_NAME = util::getenv("BUCKET_NAME", "defaultbucket");
+static const char* KEY_NAME = util::getenv("KEY_NAME", "default.parquet");
+
+constexpr int64_t BATCH_SIZE = 1024 * 2;
+
+std::vector<int> parse_column_ids(const std::string& column_ids) {
+  std::vector<int> result;
+  std::stringstream stream(column_ids);
+  std::string column_id;
+  while (std::getline(stream, column_id, ',')) {
+    // the filter column is already fully read
+    if (!column_id.empty() && std::stoi(column_id) != FILTER_COLUMN_ID) {
+      result.push_back(std::stoi(column_id));
+    }
+  }
+  return result;
+}
+
+std::unique_ptr<parquet::ParquetFileReader> open_column_chunck(
+    std::shared_ptr<PartialFile> rg_file,
+    std::shared_ptr<parquet::FileMetaData> file_metadata) {
+  parquet::ReaderProperties props(mem_pool);
+  return parquet::ParquetFileReader::Open(rg_file, props, file_metadata);
+}
+
+// Phase one: select the rows of a row group where the filter column equals FILTER_VALUE
+Result<RowSelection> filter_column_chunck(
+    std::shared_ptr<PartialFile> rg_file,
+    std::shared_ptr<parquet::FileMetaData> file_metadata, int rg) {
+  try {
+    auto reader = open_column_chunck(rg_file, file_metadata);
+    auto untyped_col = reader->RowGroup(rg)->Column(FILTER_COLUMN_ID);
+    auto* typed_reader = static_cast<parquet::ByteArrayReader*>(untyped_col.get());
+    auto max_def_level = untyped_col->descr()->max_definition_level();
+
+    std::vector<uint8_t> mask(file_metadata->RowGroup(rg)->num_rows(), 0);
+    std::vector<parquet::ByteArray> values(BATCH_SIZE);
+    std::vector<int16_t> def_levels(BATCH_SIZE);
+    int64_t row = 0;
+    while (typed_reader->HasNext()) {
+      int64_t values_read = 0;
+      auto levels_read = typed_reader->ReadBatch(BATCH_SIZE, def_levels.data(), nullptr,
+                                                 values.data(), &values_read);
+      // values are only returned for the non null rows
+      int64_t value_index = 0;
+      for (int64_t i = 0; i < levels_read; i++) {
+        if (max_def_level == 0 || def_levels[i] == max_def_level) {
+          auto& value = values[value_index++];
+          mask[row + i] = value.len == FILTER_VALUE.size() &&
+                          std::memcmp(value.ptr, FILTER_VALUE.data(), value.len) == 0;
+        }
+      }
+      row += levels_read;
+    }
+    return RowSelection::FromMask(mask.data(), mask.size());
+  } catch (const parquet::ParquetException& e) {
+    return Status::IOError("Filtering column chunck failed: ", e.what());
+  }
+}
+
+template <typename DType>
+int64_t read_selected_typed(parquet::ColumnReader* untyped_col,
+                            const RowSelection& selection) {
+  auto typed_reader = static_cast<parquet::TypedColumnReader<DType>*>(untyped_col);
+  auto values = std::make_unique<typename DType::c_type[]>(BATCH_SIZE);
+  auto def_levels = std::make_unique<int16_t[]>(BATCH_SIZE);
+  int64_t total_values_read = 0;
+  ReadSelectedRows(typed_reader, selection, BATCH_SIZE, values.get(), def_levels.get(),
+                   [&](const typename DType::c_type*, int64_t values_read, int64_t) {
+                     total_values_read += values_read;
+                   });
+  return total_values_read;
+}
+
+// Phase two: decode only the selected rows of a projected column chunck
+Result<int64_t> read_selected_rows(std::shared_ptr<PartialFile> rg_file,
+                                   std::shared_ptr<parquet::FileMetaData> file_metadata,
+                                   int rg, int column, const RowSelection& selection) {
+  try {
+    auto reader = open_column_chunck(rg_file, file_metadata);
+    auto col = reader->RowGroup(rg)->Column(column);
+    switch (col->type()) {
+      case parquet::Type::BOOLEAN:
+        return read_selected_typed<parquet::BooleanType>(col.get(), selection);
+      case parquet::Type::INT32:
+        return read_selected_typed<parquet::Int32Type>(col.get(), selection);
+      case parquet::Type::INT64:
+        return read_selected_typed<parquet::Int64Type>(col.get(), selection);
+      case parquet::Type::INT96:
+        return read_selected_typed<parquet::Int96Type>(col.get(), selection);
+      case parquet::Type::FLOAT:
+        return read_selected_typed<parquet::FloatType>(col.get(), selection);
+      case parquet::Type::DOUBLE:
+        return read_selected_typed<parquet::DoubleType>(col.get(), selection);
+      case parquet::Type::BYTE_ARRAY:
+        return read_selected_typed<parquet::ByteArrayType>(col.get(), selection);
+      case parquet::Type::FIXED_LEN_BYTE_ARRAY:
+        return read_selected_typed<parquet::FLBAType>(col.get(), selection);
+      default:
+        return Status::NotImplemented("Unsupported physical type for column ", column);
+    }
+  } catch (const parquet::ParquetException& e) {
+    return Status::IOError("Reading selected rows failed: ", e.what());
+  }
+}
+
+static aws::lambda_runtime::invocation_response my_handler(
+    aws::lambda_runtime::invocation_request const& req, const SdkOptions& options) {
+  auto synchronizer = std::make_shared<Synchronizer>();
+  auto metrics_manager = std::make_shared<MetricsManager>();
+  metrics_manager->EnterPhase("wait_foot");
+  auto downloader = std::make_shared<Downloader>(synchronizer, MAX_CONCURRENT_DL,
+                                                 metrics_manager, options);
+
+  S3Path file_path{BUCKET_NAME, KEY_NAME};
+
+  auto file_metadata =
+      GetMetadata(downloader, mem_pool, file_path, NB_CONN_INIT);
+
+  metrics_manager->ExitPhase("wait_foot");
+  if (file_metadata->schema()->Column(FILTER_COLUMN_ID)->physical_type() !=
+      parquet::Type::BYTE_ARRAY) {
+    return aws::lambda_runtime::invocation_response::failure(
+        "FILTER_COLUMN_ID should be a BYTE_ARRAY column", "InvalidParameter");
+  }
+  auto projected_columns = parse_column_ids(PROJECTED_COLUMN_IDS);
+
+  // The chuncks are decoded on the CPU lane so that the download threads only wait on
+  // the network, the projected chuncks of a row group are scheduled as soon as it is
+  // filtered and carry its selection with them
+  std::atomic<int> filtered_chuncks{0};
+  std::atomic<int> pruned_row_groups{0};
+  std::atomic<int64_t> selected_rows{0};
+  std::atomic<int64_t> values_read{0};
+  auto pending_chuncks = std::make_shared<WaitGroup>();
+
+  auto read_projected = [&](std::shared_ptr<RowSelection> selection) {
+    return [&, selection, pending_chuncks](Result<ColChunckFile> result) {
+      if (!result.ok()) {
+        pending_chuncks->Done(result.status());
+        return;
+      }
+      Executor::Default().Submit(
+          Lane::CPU,
+          [&, selection, pending_chuncks, col_chunck_file = result.ValueOrDie()]() {
+            metrics_manager->NewEvent("starting_proc");
+            auto read =
+                read_selected_rows(col_chunck_file.file, file_metadata,
+                                   col_chunck_file.row_group, col_chunck_file.column,
+                                   *selection);
+            if (read.ok()) {
+              values_read += read.ValueOrDie();
+            }
+            pending_chuncks->Done(read.status());
+          });
+    };
+  };
+
+  auto filter_chunck = [&](const ColChunckFile& col_chunck_file) -> Status {
+    auto rg = col_chunck_file.row_group;
+    metrics_manager->NewEvent("starting_filter");
+    ARROW_ASSIGN_OR_RAISE(auto selection,
+                          filter_column_chunck(col_chunck_file.file, file_metadata, rg));
+    filtered_chuncks++;
+    selected_rows += selection.num_selected();
+    if (selection.empty()) {
+      pruned_row_groups++;
+      return Status::OK();
+    }
+    // Phase two: only the row groups with selected rows are downloaded
+    auto shared_selection = std::make_shared<RowSelection>(std::move(selection));
+    pending_chuncks->Add(projected_columns.size());
+    for (auto column : projected_columns) {
+      DownloadColumnChunck(downloader, file_metadata, file_path, rg, column,
+                           read_projected(shared_selection));
+    }
+    return Status::OK();
+  };
+
+  // Phase one: download the filter column chuncks
+  metrics_manager->NewEvent("start_scheduler");
+  pending_chuncks->Add(file_metadata->num_row_groups());
+  for (int i = 0; i < file_metadata->num_row_groups(); i++) {
+    DownloadColumnChunck(
+        downloader, file_metadata, file_path, i, FILTER_COLUMN_ID,
+        [&, pending_chuncks](Result<ColChunckFile> result) {
+          if (!result.ok()) {
+            pending_chuncks->Done(result.status());
+            return;
+          }
+          Executor::Default().Submit(
+              Lane::CPU, [&, pending_chuncks, col_chunck_file = result.ValueOrDie()]() {
+                pending_chuncks->Done(filter_chunck(col_chunck_file));
+              });
+        });
+  }
+
+  metrics_manager->EnterPhase("wait_dl");
+  pending_chuncks->Wait();
+  metrics_manager->ExitPhase("wait_dl");
+  metrics_manager->NewEvent("processings_finished");
+  if (!pending_chuncks->status().ok()) {
+    return aws::lambda_runtime::invocation_response::failure(
+        pending_chuncks->status().ToString(), "ScanError");
+  }
+
+  std::cout << "filtered_chuncks:" << filtered_chuncks
+            << "/pruned_row_groups:" << pruned_row_groups
+            << "/selected_rows:" << selected_rows << "/values_read:" << values_read
+            << std::endl;
+  metrics_manager->Print();
+
+  return aws::lambda_runtime::invocation_response::success("Done", "text/plain");
+}
+
+/** LAMBDA MAIN **/
+int main() {
+  InitializeAwsSdk(AwsSdkLogLevel::Off);
+  // init s3 client
+  SdkOptions options;
+  options.region = "eu-west-1";
+  if (IS_LOCAL) {
+    options.endpoint_override = "minio:9000";
+    std::cout << "endpoint_override=" << options.endpoint_override << std::endl;
+    options.scheme = "http";
+  }
+  bootstrap([&options](aws::lambda_runtime::invocation_request const& req) {
+    return my_handler(req, options);
+  });
+  // this is mainly usefull to avoid Valgrind errors as Lambda do not guaranty the
+  // execution of this code before killing the container
+  FinalizeAwsSdk();
+}
@@ -1,87 +1,243 @@
-#include <aws/core/client/RetryStrategy.h>
-#include <aws/lambda/LambdaClient.h>
-#include <aws/lambda/model/InvokeRequest.h>
+#include <arrow/util/logging.h>
+#include <aws/s3/model/ListObjectsV2Request.h>
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
 
 #include "async_queue.h"
+#include "downloader.h"
+#include "footer-payload.h"
+#include "hive-client.h"
+#include "lambda-invoker.h"
+#include "parquet-helpers.h"
+#include "row-group-planner.h"
 #include "sdk-init.h"
 #include "toolbox.h"
 
 using namespace Buzz;
 
 static bool IS_LOCAL = false;  // util::getenv_bool("IS_LOCAL", false);
-static int NB_PARALLEL = util::getenv_int("NB_PARALLEL", 1);
+// invocations in flight, multiplexed over NB_CONNECTIONS keep-alive connections
+static int NB_PARALLEL = util::getenv_int("NB_PARALLEL", 256);
+static int NB_CONNECTIONS = util::getenv_int("NB_CONNECTIONS", 64);
+// attempts of a throttled or failed invocation before giving up on it
+static int INVOKE_MAX_ATTEMPTS = util::getenv_int("INVOKE_MAX_ATTEMPTS", 5);
 static int NB_INVOKE = util::getenv_int("NB_INVOKE", 1);
 static const char* BEE_FUNCTION_NAME =
     util::getenv("BEE_FUNCTION_NAME", "cloudfuse-lab-cpp-generic-playground-static-dev");
+// if "full" or "subset", the footers are read once here and sent to the bees with their
+// share of the row groups (see FooterPayload), if empty the bees fetch them
+static const std::string PAYLOAD_FOOTER = util::getenv("PAYLOAD_FOOTER", "");
+// the payloads leave room for the "task_id" added by SetPayloadTaskId()
+static const size_t PAYLOAD_MAX_BYTES = kMaxPayloadBytes - 32;
+static const char* BUCKET_NAME = util::getenv("BUCKET_NAME", "defaultbucket");
+static const char* KEY_NAME = util::getenv("KEY_NAME", "default.parquet");
+// if not empty, the row groups of all the parquet objects of BUCKET_NAME under this
+// prefix are bin-packed into at most NB_INVOKE bee tasks of even download time
+static const std::string TABLE_PREFIX = util::getenv("TABLE_PREFIX", "");
+// comma separated ids of the columns read by the bees, all of them if empty
+static const std::string PLAN_COLUMNS = util::getenv("PLAN_COLUMNS", "");
+// KB that a bee downloads during the latency of one request, paid per column chunck
+static const int64_t REQUEST_COST_KB = util::getenv_int("REQUEST_COST_KB", 1024);
+// footers are cached in this directory by key and ETag, not cached if empty
+static const std::string FOOTER_CACHE_DIR =
+    util::getenv("FOOTER_CACHE_DIR", "/tmp/footer-cache");
+static const int NB_FOOTER_DL = util::getenv_int("NB_FOOTER_DL", 16);
+// if not empty, the tasks are registered on the hive ("host:port") that collects their
+// results under QUERY_ID, and the straggling ones are invoked again
+static const std::string HIVE_ENDPOINT = util::getenv("HIVE_ENDPOINT", "");
+static const std::string QUERY_ID = util::getenv("QUERY_ID", "default");
+static const int SPECULATION_POLL_MS = util::getenv_int("SPECULATION_POLL_MS", 200);
+static const int QUERY_TIMEOUT_MS = util::getenv_int("QUERY_TIMEOUT_MS", 300000);
 
-namespace {
-class ConnectRetryStrategy : public Aws::Client::RetryStrategy {
- public:
-  static const int32_t kDefaultRetryInterval = 200;     /* milliseconds */
-  static const int32_t kDefaultMaxRetryDuration = 6000; /* milliseconds */
-
-  explicit ConnectRetryStrategy(int32_t retry_interval = kDefaultRetryInterval,
-                                int32_t max_retry_duration = kDefaultMaxRetryDuration)
-      : retry_interval_(retry_interval), max_retry_duration_(max_retry_duration) {}
-
-  bool ShouldRetry(const Aws::Client::AWSError<Aws::Client::CoreErrors>& error,
-                   long attempted_retries) const override {  // NOLINT
-    return attempted_retries * retry_interval_ < max_retry_duration_;
+PayloadFooter payload_footer() {
+  if (PAYLOAD_FOOTER == "full") {
+    return PayloadFooter::Full;
   }
+  return PAYLOAD_FOOTER == "subset" ? PayloadFooter::Subset : PayloadFooter::None;
+}
 
-  long CalculateDelayBeforeNextRetry(  // NOLINT
-      const Aws::Client::AWSError<Aws::Client::CoreErrors>& error,
-      long attempted_retries) const override {  // NOLINT
-    return retry_interval_;
+/// Read the footer once and split its row groups round robin between the bees
+std::vector<std::string> make_payloads(const SdkOptions& options) {
+  std::vector<std::string> payloads(NB_INVOKE);
+  if (PAYLOAD_FOOTER.empty()) {
+    return payloads;
   }
+  auto synchronizer = std::make_shared<Synchronizer>();
+  auto metrics_manager = std::make_shared<MetricsManager>();
+  auto downloader =
+      std::make_shared<Downloader>(synchronizer, 1, metrics_manager, options);
+  auto file_metadata =
+      GetMetadata(downloader, arrow::default_memory_pool(), {BUCKET_NAME, KEY_NAME}, 1);
+  for (int i = 0; i < NB_INVOKE; i++) {
+    std::vector<int> row_groups;
+    for (int rg = i; rg < file_metadata->num_row_groups(); rg += NB_INVOKE) {
+      row_groups.push_back(rg);
+    }
+    // an empty key is the default file of the bee
+    payloads[i] = MakeBoundedTaskPayload({{"", file_metadata, row_groups}},
+                                         payload_footer(), PAYLOAD_MAX_BYTES)
+                      .ValueOrDie();
+  }
+  std::cout << "payload_bytes=" << payloads[0].size() << std::endl;
+  return payloads;
+}
 
- protected:
-  int32_t retry_interval_;
-  int32_t max_retry_duration_;
+struct TableFile {
+  std::string key;
+  std::string etag;
 };
-}  // namespace
-
-struct InvokeResponse {};
-
-class Fume {
- public:
-  Fume(std::shared_ptr<Synchronizer> synchronizer, int pool_size, SdkOptions& options)
-      : queue_(synchronizer, pool_size) {
-    Aws::Client::ClientConfiguration client_config_;
-    client_config_.region = Aws::Utils::StringUtils::to_string(options.region);
-    client_config_.endpointOverride =
-        Aws::Utils::StringUtils::to_string(options.endpoint_override);
-    if (options.scheme == "http") {
-      client_config_.scheme = Aws::Http::Scheme::HTTP;
-    } else if (options.scheme == "https") {
-      client_config_.scheme = Aws::Http::Scheme::HTTPS;
-    } else {
-      throw "Invalid Lambda connection scheme '", options.scheme, "'";
+
+/// List the parquet objects of the table
+std::vector<TableFile> list_table_files(const SdkOptions& options) {
+  Aws::S3::S3Client client(common_config(options),
+                           Aws::Client::AWSAuthV4Signer::PayloadSigningPolicy::Never,
+                           options.endpoint_override.empty());
+  Aws::S3::Model::ListObjectsV2Request req;
+  req.SetBucket(BUCKET_NAME);
+  req.SetPrefix(TABLE_PREFIX);
+  std::vector<TableFile> files;
+  while (true) {
+    auto outcome = client.ListObjectsV2(req);
+    if (!outcome.IsSuccess()) {
+      std::cerr << "list_error=" << outcome.GetError().GetMessage() << std::endl;
+      exit(1);
     }
-    client_config_.retryStrategy = std::make_shared<ConnectRetryStrategy>();
-    client_.reset(new Aws::Lambda::LambdaClient(client_config_));
-  }
-
-  void Invoke(const char* function_name) {
-    queue_.PushRequest([function_name, this]() {
-      Aws::Lambda::Model::InvokeRequest req;
-      req.SetFunctionName(function_name);
-      req.SetInvocationType(Aws::Lambda::Model::InvocationType::Event);
-      auto object_outcome = client_->Invoke(req);
-      if (!object_outcome.IsSuccess()) {
-        exit(1);
+    for (auto& object : outcome.GetResult().GetContents()) {
+      auto& key = object.GetKey();
+      if (key.size() >= 8 && key.compare(key.size() - 8, 8, ".parquet") == 0) {
+        files.push_back({key, object.GetETag()});
       }
+    }
+    if (!outcome.GetResult().GetIsTruncated()) {
+      break;
+    }
+    req.SetContinuationToken(outcome.GetResult().GetNextContinuationToken());
+  }
+  return files;
+}
+
+std::string footer_cache_path(const TableFile& file) {
+  std::stringstream path;
+  path << FOOTER_CACHE_DIR << "/" << std::hex
+       << std::hash<std::string>()(std::string(BUCKET_NAME) + "/" + file.key + file.etag);
+  return path.str();
+}
 
-      return InvokeResponse{};
-    });
+/// Read the footers of the files, from the cache if they did not change
+std::vector<std::shared_ptr<parquet::FileMetaData>> get_footers(
+    const SdkOptions& options, const std::vector<TableFile>& files) {
+  std::vector<std::shared_ptr<parquet::FileMetaData>> footers(files.size());
+  std::vector<S3Path> missing_paths;
+  std::vector<size_t> missing_positions;
+  for (size_t i = 0; i < files.size(); i++) {
+    if (!FOOTER_CACHE_DIR.empty()) {
+      std::ifstream cached(footer_cache_path(files[i]));
+      std::string encoded;
+      if (cached >> encoded) {
+        auto footer = DeserializeFooter(encoded);
+        if (footer.ok()) {
+          footers[i] = footer.ValueOrDie();
+          continue;
+        }
+      }
+    }
+    missing_paths.push_back({BUCKET_NAME, files[i].key});
+    missing_positions.push_back(i);
+  }
+  std::cout << "cached_footers=" << files.size() - missing_paths.size() << std::endl;
+  if (missing_paths.empty()) {
+    return footers;
   }
 
-  std::vector<Result<InvokeResponse>> ProcessResponses() { return queue_.PopResponses(); }
+  auto synchronizer = std::make_shared<Synchronizer>();
+  auto metrics_manager = std::make_shared<MetricsManager>();
+  auto downloader = std::make_shared<Downloader>(synchronizer, NB_FOOTER_DL,
+                                                 metrics_manager, options);
+  auto fetched =
+      GetMetadatas(downloader, arrow::default_memory_pool(), missing_paths, 0);
+  if (!FOOTER_CACHE_DIR.empty()) {
+    std::filesystem::create_directories(FOOTER_CACHE_DIR);
+  }
+  for (size_t i = 0; i < fetched.size(); i++) {
+    auto position = missing_positions[i];
+    footers[position] = fetched[i];
+    if (!FOOTER_CACHE_DIR.empty()) {
+      std::ofstream cached(footer_cache_path(files[position]));
+      cached << SerializeFooter(*fetched[i]).ValueOrDie();
+    }
+  }
+  return footers;
+}
 
- private:
-  std::shared_ptr<Aws::Lambda::LambdaClient> client_;
-  AsyncQueue<InvokeResponse> queue_;
-};
+/// Bin-pack the row groups of the table into bee tasks with their footers
+std::vector<std::string> plan_payloads(const SdkOptions& options) {
+  auto files = list_table_files(options);
+  auto footers = get_footers(options, files);
+  std::vector<int> columns;
+  std::stringstream columns_stream(PLAN_COLUMNS);
+  std::string column;
+  while (std::getline(columns_stream, column, ',')) {
+    columns.push_back(std::stoi(column));
+  }
+  auto tasks =
+      PlanBeeTasks(RowGroupCosts(footers, columns, REQUEST_COST_KB * 1024), NB_INVOKE);
+
+  std::vector<std::string> payloads;
+  int64_t min_bytes = -1;
+  int64_t max_bytes = 0;
+  for (auto& task : tasks) {
+    std::vector<FileAssignment> assignments;
+    for (auto& file_row_groups : task.row_groups) {
+      auto file = file_row_groups.first;
+      assignments.push_back({files[file].key, footers[file], file_row_groups.second});
+    }
+    payloads.push_back(
+        MakeBoundedTaskPayload(assignments, payload_footer(), PAYLOAD_MAX_BYTES)
+            .ValueOrDie());
+    min_bytes = min_bytes < 0 ? task.compressed_bytes
+                              : std::min(min_bytes, task.compressed_bytes);
+    max_bytes = std::max(max_bytes, task.compressed_bytes);
+  }
+  std::cout << "files=" << files.size() << "/bee_tasks=" << tasks.size()
+            << "/min_task_bytes=" << min_bytes << "/max_task_bytes=" << max_bytes
+            << std::endl;
+  return payloads;
+}
+
+/// Poll the hive for stragglers and invoke them again until all the tasks completed
+void speculate(LambdaInvoker& invoker, HiveClient& hive,
+               const std::vector<std::string>& payloads) {
+  auto start = time::now();
+  int nb_speculated = 0;
+  int completed = 0;
+  while (completed < static_cast<int>(payloads.size())) {
+    if (util::get_duration_ms(start, time::now()) > QUERY_TIMEOUT_MS) {
+      std::cerr << "query_timeout/completed_tasks=" << completed << std::endl;
+      exit(1);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(SPECULATION_POLL_MS));
+    auto stragglers = hive.TakeStragglers(QUERY_ID).ValueOrDie();
+    for (auto task_id : stragglers) {
+      invoker.Invoke(BEE_FUNCTION_NAME, payloads[task_id]);
+    }
+    nb_speculated += stragglers.size();
+    // only the failures matter, the Event invokes return before the bees complete
+    for (auto& res : invoker.ProcessResponses()) {
+      if (!res.ok()) {
+        std::cerr << "invoke_error=" << res.status().ToString() << std::endl;
+      }
+    }
+    completed = hive.CompletedTasks(QUERY_ID).ValueOrDie();
+  }
+  std::cout << "tasks_completed=" << completed << std::endl;
+  std::cout << "speculative_invokes=" << nb_speculated << std::endl;
+  std::cout << "query_duration_ms=" << util::get_duration_ms(start, time::now())
+            << std::endl;
+}
 
 void execute() {
   SdkOptions options;
@@ -91,25 +247,51 @@ void execute() {
     std::cout << "endpoint_override=" << options.endpoint_override << std::endl;
     options.scheme = "http";
   }
+  auto payloads = TABLE_PREFIX.empty() ? make_payloads(options) : plan_payloads(options);
+  int nb_invoke = payloads.size();
   auto synchronizer = std::make_shared<Synchronizer>();
-  Fume fume{synchronizer, NB_PARALLEL, options};
-  for (int i = 0; i < NB_INVOKE; i++) {
-    fume.Invoke(BEE_FUNCTION_NAME);
+  InvokerOptions invoker_options;
+  invoker_options.max_in_flight = NB_PARALLEL;
+  invoker_options.max_connections = NB_CONNECTIONS;
+  invoker_options.max_attempts = INVOKE_MAX_ATTEMPTS;
+  LambdaInvoker invoker{synchronizer, options, invoker_options};
+  std::unique_ptr<HiveClient> hive;
+  if (!HIVE_ENDPOINT.empty()) {
+    hive = HiveClient::Connect(HIVE_ENDPOINT).ValueOrDie();
+    for (int i = 0; i < nb_invoke; i++) {
+      payloads[i] = SetPayloadTaskId(payloads[i], i).ValueOrDie();
+    }
+    ARROW_CHECK_OK(hive->RegisterTasks(QUERY_ID, nb_invoke));
+  }
+  // the invocations are signed as they are submitted, the fan-out ends once Lambda
+  // accepted all of them
+  auto fan_out_start = time::now();
+  for (int i = 0; i < nb_invoke; i++) {
+    invoker.Invoke(BEE_FUNCTION_NAME, payloads[i]);
   }
   int invokes_completed = 0;
   int invokes_successful = 0;
-  while (invokes_completed < NB_INVOKE) {
+  while (invokes_completed < nb_invoke) {
     synchronizer->wait();
-    auto results = fume.ProcessResponses();
+    auto results = invoker.ProcessResponses();
     invokes_completed += results.size();
     for (auto& res : results) {
       if (res.ok()) {
         invokes_successful++;
+      } else {
+        std::cerr << "invoke_error=" << res.status().ToString() << std::endl;
       }
     }
   }
-  std::cout << "invokes_scheduled=" << NB_INVOKE << std::endl;
+  std::cout << "invokes_scheduled=" << nb_invoke << std::endl;
   std::cout << "invokes_successful=" << invokes_successful << std::endl;
+  std::cout << "fan_out_ms=" << util::get_duration_ms(fan_out_start, time::now())
+            << std::endl;
+  std::cout << "invoke_p50_us=" << invoker.LatencyQuantileUs(0.5) << std::endl;
+  std::cout << "invoke_p99_us=" << invoker.LatencyQuantileUs(0.99) << std::endl;
+  if (hive != nullptr) {
+    speculate(invoker, *hive, payloads);
+  }
 }
 
 int main() {
@@ -0,0 +1,246 @@
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <thread>
+
+#include "async_queue.h"
+#include "mpmc-queue.h"
+#include "toolbox.h"
+
+using namespace Buzz;
+
+// comma separated thread counts to benchmark
+static const std::string THREADS = util::getenv("THREADS", "2,8,64");
+// number of items passed from the producers to the consumers of the rings
+static const int64_t NB_ITEMS = util::getenv_int("NB_ITEMS", 2000000);
+// number of trivial tasks run through the AsyncQueues
+static const int64_t NB_TASKS = util::getenv_int("NB_TASKS", 500000);
+// tasks kept in flight by the dispatcher, like the downloads of a reader
+static const int64_t WINDOW = util::getenv_int("WINDOW", 512);
+
+namespace {
+
+/// The mutex and condition variable queue that AsyncQueue used before the rings
+template <typename T>
+class LockedQueue {
+ public:
+  bool TryPush(T value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push(std::move(value));
+    return true;
+  }
+
+  bool TryPop(T* value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty()) {
+      return false;
+    }
+    *value = std::move(queue_.front());
+    queue_.pop();
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::queue<T> queue_;
+};
+
+class LockedSynchronizer {
+ public:
+  void notify() {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_++;
+    }
+    cv_.notify_one();
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return work_ > 0; });
+  }
+
+  void consume(int work_units) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_ -= work_units;
+  }
+
+ private:
+  std::condition_variable cv_;
+  std::mutex mutex_;
+  int work_ = 0;
+};
+
+/// AsyncQueue as it was before the rings
+template <typename ResponseType>
+class LockedAsyncQueue {
+ public:
+  LockedAsyncQueue(std::shared_ptr<LockedSynchronizer> synchronizer, int pool_size)
+      : synchronizer_(synchronizer) {
+    for (int i = 0; i < pool_size; ++i)
+      workers_.emplace_back([this] {
+        for (;;) {
+          std::function<void()> task;
+          {
+            std::unique_lock<std::mutex> lock(request_queue_mutex_);
+            request_cv_.wait(lock, [this] { return stop_ || !request_queue_.empty(); });
+            if (stop_ && request_queue_.empty()) return;
+            task = std::move(request_queue_.front());
+            request_queue_.pop();
+          }
+          task();
+        }
+      });
+  }
+
+  ~LockedAsyncQueue() {
+    {
+      std::unique_lock<std::mutex> lock(request_queue_mutex_);
+      stop_ = true;
+    }
+    request_cv_.notify_all();
+    for (auto& worker : workers_) worker.join();
+  }
+
+  void PushRequest(std::function<Result<ResponseType>()> request_func) {
+    {
+      std::unique_lock<std::mutex> lock(request_queue_mutex_);
+      request_queue_.push([this, request_func]() {
+        auto response = request_func();
+        {
+          std::unique_lock<std::mutex> lock(resp_queue_mutex_);
+          resp_queue_.push(response);
+        }
+        synchronizer_->notify();
+      });
+    }
+    request_cv_.notify_one();
+  }
+
+  std::vector<Result<ResponseType>> PopResponses() {
+    std::vector<Result<ResponseType>> result;
+    std::unique_lock<std::mutex> lock(resp_queue_mutex_);
+    while (!resp_queue_.empty()) {
+      result.push_back(resp_queue_.front());
+      resp_queue_.pop();
+    }
+    synchronizer_->consume(result.size());
+    return result;
+  }
+
+ private:
+  std::queue<std::function<void()>> request_queue_;
+  std::mutex request_queue_mutex_;
+  std::condition_variable request_cv_;
+  std::queue<Result<ResponseType>> resp_queue_;
+  std::mutex resp_queue_mutex_;
+  std::shared_ptr<LockedSynchronizer> synchronizer_;
+  std::vector<std::thread> workers_;
+  bool stop_ = false;
+};
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                   start)
+      .count();
+}
+
+void PrintResult(const std::string& bench, const std::string& queue, int threads,
+                 int64_t items, double duration_ms) {
+  std::cout << "bench:" << bench << "/queue:" << queue << "/threads:" << threads
+            << "/duration_ms:" << duration_ms
+            << "/ops_per_sec:" << static_cast<int64_t>(items / duration_ms * 1000)
+            << std::endl;
+}
+
+/// Half of the threads push NB_ITEMS through the queue, the other half pop them
+template <typename Queue>
+void BenchRing(const std::string& name, Queue& queue, int threads) {
+  auto nb_producers = std::max(1, threads / 2);
+  auto nb_consumers = std::max(1, threads - nb_producers);
+  auto per_producer = NB_ITEMS / nb_producers;
+  std::atomic<int64_t> popped{0};
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int p = 0; p < nb_producers; p++) {
+    workers.emplace_back([&]() {
+      for (int64_t i = 0; i < per_producer; i++) {
+        while (!queue.TryPush(i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int c = 0; c < nb_consumers; c++) {
+    workers.emplace_back([&]() {
+      int64_t value;
+      while (popped.load(std::memory_order_relaxed) < per_producer * nb_producers) {
+        if (queue.TryPop(&value)) {
+          popped.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  PrintResult("ring", name, threads, per_producer * nb_producers, ElapsedMs(start));
+}
+
+/// Run NB_TASKS trivial tasks on a pool of `threads` workers, keeping WINDOW of them
+/// in flight like a dispatcher does with its downloads
+template <typename Queue, typename Sync>
+void BenchAsyncQueue(const std::string& name, int threads) {
+  auto synchronizer = std::make_shared<Sync>();
+  Queue queue(synchronizer, threads);
+  auto start = std::chrono::steady_clock::now();
+  int64_t pushed = 0;
+  int64_t completed = 0;
+  int64_t checksum = 0;
+  while (completed < NB_TASKS) {
+    while (pushed < NB_TASKS && pushed - completed < WINDOW) {
+      queue.PushRequest([pushed]() -> Result<int64_t> { return pushed; });
+      pushed++;
+    }
+    synchronizer->wait();
+    for (auto& response : queue.PopResponses()) {
+      checksum += response.ValueOrDie();
+      completed++;
+    }
+  }
+  PrintResult("async_queue", name, threads, NB_TASKS, ElapsedMs(start));
+  if (checksum != NB_TASKS * (NB_TASKS - 1) / 2) {
+    std::cerr << "unexpected checksum " << checksum << std::endl;
+    exit(1);
+  }
+}
+
+}  // namespace
+
+/// Compare the locked queues AsyncQueue used before with the lock-free rings, both
+/// raw and through AsyncQueue with trivial tasks, for several thread counts
+int main() {
+  std::cout << "hardware_concurrency:" << std::thread::hardware_concurrency()
+            << std::endl;
+  std::stringstream threads_stream(THREADS);
+  std::string threads_str;
+  while (std::getline(threads_stream, threads_str, ',')) {
+    auto threads = std::stoi(threads_str);
+    {
+      LockedQueue<int64_t> queue;
+      BenchRing("locked", queue, threads);
+    }
+    {
+      MpmcQueue<int64_t> queue(1024);
+      BenchRing("mpmc", queue, threads);
+    }
+    BenchAsyncQueue<LockedAsyncQueue<int64_t>, LockedSynchronizer>("locked", threads);
+    BenchAsyncQueue<AsyncQueue<int64_t>, Synchronizer>("mpmc", threads);
+  }
+  return 0;
+}
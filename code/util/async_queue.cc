@@ -20,21 +20,55 @@
 namespace Buzz {
 
 void Synchronizer::notify() {
-  {
-    std::unique_lock<std::mutex> lock(this->mutex_);
-    this->work_++;
-  }
-  this->cv_.notify_one();
+  this->work_.fetch_add(1);
+  this->events_.NotifyOne();
 }
 
 void Synchronizer::wait() {
-  std::unique_lock<std::mutex> lock(this->mutex_);
-  this->cv_.wait(lock, [this]() { return this->work_ > 0; });
+  while (this->work_.load() <= 0) {
+    auto key = this->events_.PrepareWait();
+    if (this->work_.load() > 0) {
+      this->events_.CancelWait();
+      return;
+    }
+    this->events_.Wait(key);
+  }
+}
+
+void Synchronizer::consume(int work_units) { this->work_.fetch_sub(work_units); }
+
+void WaitGroup::Add(int64_t count) { pending_.fetch_add(count); }
+
+void WaitGroup::Done() {
+  if (pending_.fetch_sub(1) == 1) {
+    events_.NotifyAll();
+  }
+}
+
+void WaitGroup::Done(const Status& status) {
+  if (!status.ok()) {
+    std::lock_guard<std::mutex> lock(status_mutex_);
+    if (status_.ok()) {
+      status_ = status;
+    }
+  }
+  Done();
+}
+
+void WaitGroup::Wait() {
+  while (true) {
+    auto key = events_.PrepareWait();
+    if (pending_.load() == 0) {
+      events_.CancelWait();
+      return;
+    }
+    events_.Wait(key);
+  }
 }
 
-void Synchronizer::consume(int work_units) {
-  std::unique_lock<std::mutex> lock(this->mutex_);
-  this->work_ -= work_units;
+Status WaitGroup::status() const {
+  std::lock_guard<std::mutex> lock(status_mutex_);
+  return status_;
 }
 
 }  // namespace Buzz
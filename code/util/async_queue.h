@@ -17,12 +17,15 @@
 
 #pragma once
 
-#include <condition_variable>
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
-#include <thread>
+#include <stdexcept>
 
+#include "executor.h"
+#include "mpmc-queue.h"
 #include "result.h"
 
 namespace Buzz {
@@ -35,10 +38,30 @@ class Synchronizer {
   void consume(int work_units);
 
  private:
-  std::condition_variable cv_;
-  std::mutex mutex_;
+  EventCount events_;
   // TODO count work by notifiers
-  int work_;
+  std::atomic<int> work_{0};
+};
+
+/// Count the work in progress and wait for all of it. The last Done() touches the
+/// group after Wait() might have returned, share it (e.g. std::shared_ptr) with the
+/// threads calling Done().
+class WaitGroup {
+ public:
+  void Add(int64_t count = 1);
+  void Done();
+  /// Done() for work that may have failed, the group keeps the first error
+  void Done(const Status& status);
+  void Wait();
+
+  /// The first error reported to Done(), OK if none
+  Status status() const;
+
+ private:
+  EventCount events_;
+  std::atomic<int64_t> pending_{0};
+  mutable std::mutex status_mutex_;
+  Status status_;
 };
 
 template <typename ResponseType>
@@ -46,81 +69,165 @@ class AsyncQueue {
  public:
   using RequestType = std::function<Result<ResponseType>()>;
 
-  AsyncQueue(std::shared_ptr<Synchronizer> synchronizer, int pool_size);
+  /// The requests run on a lane of the shared executor (the default one if null), at
+  /// most `pool_size` at a time. The requests and responses go through lock-free rings
+  /// of `ring_capacity` slots, they only spill to a locked queue while a ring is full.
+  AsyncQueue(std::shared_ptr<Synchronizer> synchronizer, int pool_size,
+             size_t ring_capacity = 1024, Lane lane = Lane::IO,
+             Executor* executor = nullptr);
+  /// Waits for the requests already pushed and the producers still pushing
   ~AsyncQueue();
 
   void PushRequest(RequestType request);
 
+  /// Run a task within the same concurrency limit as the requests, it has no response
+  void PushTask(std::function<void()> task);
+
   std::vector<Result<ResponseType>> PopResponses();
 
   void PushResponse(Result<ResponseType> response);
 
  private:
-  // input queue
-  std::queue<std::function<void()>> request_queue_;
-  std::mutex request_queue_mutex_;
-  std::condition_variable request_cv_;
-
-  // output queue
-  std::queue<Result<ResponseType>> resp_queue_;
-  std::mutex resp_queue_mutex_;
+  /// The queue admits up to pool_size drain tasks on the executor. They may outlive
+  /// the queue for an instant when leaving, so their count lives in a shared state.
+  struct Drainers {
+    std::atomic<int> active{0};
+    std::atomic<int64_t> pending{0};
+    /// producers still inside a push, their work might already be done
+    std::atomic<int> pushing{0};
+    EventCount idle;
+  };
+
+  template <typename T>
+  void Push(SpillQueue<T>* queue, T item);
+  void StartDrainer();
+  static void Drain(AsyncQueue* queue, Drainers* drainers);
+
+  SpillQueue<RequestType> requests_;
+  SpillQueue<std::function<void()>> tasks_;
+  SpillQueue<Result<ResponseType>> responses_;
   std::shared_ptr<Synchronizer> synchronizer_;
 
-  std::vector<std::thread> workers_;
-  bool stop_;
+  int pool_size_;
+  Lane lane_;
+  Executor* executor_;
+  std::shared_ptr<Drainers> drainers_;
+  std::atomic<bool> stop_;
 };
 
 //// AsyncQueue HEADER ONLY BECAUSE OF TEMPLATING ////
 
 template <typename ResponseType>
 AsyncQueue<ResponseType>::AsyncQueue(std::shared_ptr<Synchronizer> synchronizer,
-                                     int pool_size)
-    : synchronizer_(synchronizer), stop_(false) {
-  for (size_t i = 0; i < pool_size; ++i)
-    workers_.emplace_back([this] {
-      for (;;) {
-        std::function<void()> task;
-        {
-          std::unique_lock<std::mutex> lock(this->request_queue_mutex_);
-          this->request_cv_.wait(
-              lock, [this] { return this->stop_ || !this->request_queue_.empty(); });
-          if (this->stop_ && this->request_queue_.empty()) return;
-          task = std::move(this->request_queue_.front());
-          this->request_queue_.pop();
-        }
-        task();
-      }
-    });
+                                     int pool_size, size_t ring_capacity, Lane lane,
+                                     Executor* executor)
+    : requests_(ring_capacity),
+      tasks_(ring_capacity),
+      responses_(ring_capacity),
+      synchronizer_(synchronizer),
+      pool_size_(std::max(pool_size, 1)),
+      lane_(lane),
+      executor_(executor == nullptr ? &Executor::Default() : executor),
+      drainers_(std::make_shared<Drainers>()),
+      stop_(false) {
+  // the IO requests block, the lane needs a worker for each of them. The CPU lane is
+  // sized to the cores and shared.
+  if (lane_ == Lane::IO) {
+    executor_->Reserve(lane_, pool_size_);
+  }
 }
 
 template <typename ResponseType>
 void AsyncQueue<ResponseType>::PushRequest(AsyncQueue::RequestType request_func) {
-  {
-    std::unique_lock<std::mutex> lock(this->request_queue_mutex_);
+  Push(&requests_, std::move(request_func));
+}
+
+template <typename ResponseType>
+void AsyncQueue<ResponseType>::PushTask(std::function<void()> task) {
+  Push(&tasks_, std::move(task));
+}
 
-    // don't allow enqueueing after stopping the pool
-    if (this->stop_) throw std::runtime_error("Queue stopped");
+template <typename ResponseType>
+template <typename T>
+void AsyncQueue<ResponseType>::Push(SpillQueue<T>* queue, T item) {
+  // the work might complete and the queue be destroyed before the push returns, the
+  // copy of the shared state outlives the producer's count
+  auto drainers = drainers_;
+  drainers->pushing.fetch_add(1);
+  // don't allow enqueueing after stopping the pool
+  if (this->stop_.load()) {
+    drainers->pushing.fetch_sub(1);
+    throw std::runtime_error("Queue stopped");
+  }
+  queue->Push(std::move(item));
+  drainers->pending.fetch_add(1);
+  StartDrainer();
+  if (drainers->pushing.fetch_sub(1) == 1) {
+    drainers->idle.NotifyAll();
+  }
+}
+
+template <typename ResponseType>
+void AsyncQueue<ResponseType>::StartDrainer() {
+  auto active = drainers_->active.load();
+  while (active < pool_size_) {
+    if (drainers_->active.compare_exchange_weak(active, active + 1)) {
+      // the copy of the shared state keeps it alive until the task returns
+      executor_->Submit(lane_, [this, drainers = drainers_]() {
+        Drain(this, drainers.get());
+      });
+      return;
+    }
+  }
+}
 
-    request_queue_.push([this, request_func]() {
-      auto response = request_func();
-      {
-        std::unique_lock<std::mutex> lock(this->resp_queue_mutex_);
-        this->resp_queue_.push(response);
+template <typename ResponseType>
+void AsyncQueue<ResponseType>::Drain(AsyncQueue* queue, Drainers* drainers) {
+  RequestType request;
+  std::function<void()> task;
+  while (true) {
+    while (true) {
+      if (queue->requests_.TryPop(&request)) {
+        drainers->pending.fetch_sub(1);
+        queue->PushResponse(request());
+      } else if (queue->tasks_.TryPop(&task)) {
+        drainers->pending.fetch_sub(1);
+        task();
+        task = nullptr;
+      } else {
+        break;
+      }
+    }
+    // a request pushed while the drainers were all busy is run by one of them, as
+    // its producer did not start a new drainer
+    auto active = drainers->active.fetch_sub(1) - 1;
+    bool resumed = false;
+    while (drainers->pending.load() > 0 && active < queue->pool_size_) {
+      if (drainers->active.compare_exchange_weak(active, active + 1)) {
+        resumed = true;
+        break;
       }
-      synchronizer_->notify();
-    });
+    }
+    if (!resumed) {
+      // the queue might be gone as soon as it saw this drainer leave
+      drainers->idle.NotifyAll();
+      return;
+    }
   }
-  request_cv_.notify_one();
+}
+
+template <typename ResponseType>
+void AsyncQueue<ResponseType>::PushResponse(Result<ResponseType> response) {
+  responses_.Push(std::move(response));
+  synchronizer_->notify();
 }
 
 template <typename ResponseType>
 std::vector<Result<ResponseType>> AsyncQueue<ResponseType>::PopResponses() {
   std::vector<Result<ResponseType>> result;
-  std::unique_lock<std::mutex> lock(this->resp_queue_mutex_);
-  result.reserve(this->resp_queue_.size());
-  while (!this->resp_queue_.empty()) {
-    result.push_back(this->resp_queue_.front());
-    this->resp_queue_.pop();
+  Result<ResponseType> response;
+  while (responses_.TryPop(&response)) {
+    result.push_back(std::move(response));
   }
   this->synchronizer_->consume(result.size());
   return result;
@@ -128,12 +235,16 @@ std::vector<Result<ResponseType>> AsyncQueue<ResponseType>::PopResponses() {
 
 template <typename ResponseType>
 AsyncQueue<ResponseType>::~AsyncQueue() {
-  {
-    std::unique_lock<std::mutex> lock(request_queue_mutex_);
-    this->stop_ = true;
+  this->stop_.store(true);
+  while (true) {
+    auto key = drainers_->idle.PrepareWait();
+    if (drainers_->active.load() == 0 && drainers_->pending.load() == 0 &&
+        drainers_->pushing.load() == 0) {
+      drainers_->idle.CancelWait();
+      return;
+    }
+    drainers_->idle.Wait(key);
   }
-  request_cv_.notify_all();
-  for (std::thread& worker : workers_) worker.join();
 }
 
 }  // namespace Buzz
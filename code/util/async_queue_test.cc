@@ -50,6 +50,23 @@ TEST(AsyncQueue, IntMultiThread) {
   ASSERT_THAT(processed, UnorderedElementsAreArray(expected_response));
 }
 
+TEST(AsyncQueue, SpillWhenRingFull) {
+  auto synchronizer = std::make_shared<Synchronizer>();
+  auto queue = AsyncQueue<int>(synchronizer, 2, 2);
+  std::vector<Result<int>> expected_response;
+  for (int i = 0; i < 100; i++) {
+    queue.PushRequest([i]() { return i; });
+    expected_response.push_back(Result<int>(i));
+  }
+  std::vector<Result<int>> processed;
+  while (processed.size() < 100) {
+    synchronizer->wait();
+    auto responses = queue.PopResponses();
+    processed.insert(processed.end(), responses.begin(), responses.end());
+  }
+  ASSERT_THAT(processed, UnorderedElementsAreArray(expected_response));
+}
+
 TEST(AsyncQueue, SharedPointer) {
   auto synchronizer = std::make_shared<Synchronizer>();
   auto queue = AsyncQueue<std::shared_ptr<int>>(synchronizer, 1);
@@ -61,4 +78,40 @@ TEST(AsyncQueue, SharedPointer) {
   ASSERT_EQ(*(responses[0].ValueOrDie()), 2);
 }
 
+TEST(AsyncQueue, TasksCompleteWithoutResponses) {
+  auto synchronizer = std::make_shared<Synchronizer>();
+  auto queue = AsyncQueue<int>(synchronizer, 4);
+  auto pending = std::make_shared<WaitGroup>();
+  std::atomic<int> sum{0};
+  pending->Add(100);
+  for (int i = 0; i < 100; i++) {
+    queue.PushTask([i, &sum, pending]() {
+      // tasks can schedule further work before they are done
+      if (i % 10 == 0) {
+        pending->Add();
+        sum += 1000;
+        pending->Done();
+      }
+      sum += i;
+      pending->Done();
+    });
+  }
+  pending->Wait();
+  ASSERT_EQ(sum.load(), 4950 + 10 * 1000);
+  ASSERT_EQ(queue.PopResponses().size(), 0);
+}
+
+TEST(AsyncQueue, WaitGroupKeepsFirstError) {
+  auto synchronizer = std::make_shared<Synchronizer>();
+  auto queue = AsyncQueue<int>(synchronizer, 4);
+  auto pending = std::make_shared<WaitGroup>();
+  pending->Add(3);
+  queue.PushTask([pending]() { pending->Done(Status::OK()); });
+  pending->Done(Status::IOError("first"));
+  pending->Done(Status::IOError("second"));
+  pending->Wait();
+  ASSERT_TRUE(pending->status().IsIOError());
+  ASSERT_EQ(pending->status().message(), "first");
+}
+
 }  // namespace Buzz
@@ -0,0 +1,137 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "buffer-sizes.h"
+
+#include <arrow/builder.h>
+#include <arrow/util/bit_util.h>
+#include <parquet/exception.h>
+#include <parquet/statistics.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace Buzz {
+
+namespace {
+
+constexpr int64_t BATCH_SIZE = 1024 * 2;
+
+bool IsDictionaryEncoded(const parquet::ColumnChunkMetaData& col_chunck_meta) {
+  for (auto encoding : col_chunck_meta.encodings()) {
+    if (encoding == parquet::Encoding::PLAIN_DICTIONARY ||
+        encoding == parquet::Encoding::RLE_DICTIONARY) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Values with a length prefix in PLAIN pages, 0 if the null count is unknown so that
+/// the size remains an upper bound
+int64_t NonNullValues(const parquet::ColumnChunkMetaData& col_chunck_meta) {
+  auto stats = col_chunck_meta.statistics();
+  if (stats == nullptr || !stats->HasNullCount()) {
+    return 0;
+  }
+  return col_chunck_meta.num_values() - stats->null_count();
+}
+
+}  // namespace
+
+DecodedChunckSizes EstimateDecodedSizes(
+    const parquet::ColumnChunkMetaData& col_chunck_meta,
+    const parquet::ColumnDescriptor& descr) {
+  DecodedChunckSizes sizes{};
+  sizes.length = col_chunck_meta.num_values();
+  if (descr.max_definition_level() > 0) {
+    sizes.validity_bytes = arrow::BitUtil::BytesForBits(sizes.length);
+  }
+  sizes.values_bytes_exact = true;
+  switch (descr.physical_type()) {
+    case parquet::Type::BOOLEAN:
+      sizes.values_bytes = arrow::BitUtil::BytesForBits(sizes.length);
+      break;
+    case parquet::Type::BYTE_ARRAY: {
+      sizes.offsets_bytes = (sizes.length + 1) * sizeof(int32_t);
+      auto uncompressed_size = col_chunck_meta.total_uncompressed_size();
+      if (IsDictionaryEncoded(col_chunck_meta)) {
+        sizes.values_bytes = uncompressed_size;
+        sizes.values_bytes_exact = false;
+      } else {
+        // remove the length prefixes of the non null values, what remains also includes
+        // the page headers and levels so it is an upper bound
+        sizes.values_bytes = std::max<int64_t>(
+            0, uncompressed_size - NonNullValues(col_chunck_meta) *
+                                       static_cast<int64_t>(sizeof(int32_t)));
+        sizes.values_bytes_exact = false;
+      }
+      break;
+    }
+    case parquet::Type::FIXED_LEN_BYTE_ARRAY:
+      sizes.values_bytes = sizes.length * descr.type_length();
+      break;
+    default:
+      sizes.values_bytes = sizes.length * parquet::GetTypeByteSize(descr.physical_type());
+  }
+  return sizes;
+}
+
+Result<std::shared_ptr<arrow::Array>> ReadByteArrayChunck(
+    parquet::ColumnReader* reader, const parquet::ColumnChunkMetaData& col_chunck_meta,
+    const parquet::ColumnDescriptor& descr, arrow::MemoryPool* pool) {
+  if (descr.physical_type() != parquet::Type::BYTE_ARRAY ||
+      descr.max_repetition_level() > 0) {
+    return Status::NotImplemented("Presized read of ", descr.ToString());
+  }
+  // StringBuilder only overrides the type of BinaryBuilder
+  auto builder = descr.logical_type()->is_string()
+                     ? std::make_unique<arrow::StringBuilder>(pool)
+                     : std::make_unique<arrow::BinaryBuilder>(pool);
+  auto sizes = EstimateDecodedSizes(col_chunck_meta, descr);
+  RETURN_NOT_OK(builder->Reserve(sizes.length));
+  RETURN_NOT_OK(builder->ReserveData(sizes.values_bytes));
+
+  auto typed_reader = static_cast<parquet::ByteArrayReader*>(reader);
+  auto max_def_level = descr.max_definition_level();
+  std::vector<parquet::ByteArray> values(BATCH_SIZE);
+  std::vector<int16_t> def_levels(BATCH_SIZE);
+  try {
+    while (typed_reader->HasNext()) {
+      int64_t values_read = 0;
+      auto levels_read = typed_reader->ReadBatch(BATCH_SIZE, def_levels.data(), nullptr,
+                                                 values.data(), &values_read);
+      int64_t value_idx = 0;
+      for (int64_t i = 0; i < levels_read; i++) {
+        if (max_def_level > 0 && def_levels[i] < max_def_level) {
+          RETURN_NOT_OK(builder->AppendNull());
+          continue;
+        }
+        auto& value = values[value_idx++];
+        // only grows if the estimate of a dictionary encoded chunck was too low
+        RETURN_NOT_OK(builder->Append(value.ptr, value.len));
+      }
+    }
+  } catch (const parquet::ParquetException& e) {
+    return Status::IOError("Could not decode column chunck: ", e.what());
+  }
+  std::shared_ptr<arrow::Array> array;
+  RETURN_NOT_OK(builder->Finish(&array));
+  return array;
+}
+
+}  // namespace Buzz
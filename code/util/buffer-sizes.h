@@ -0,0 +1,63 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+#include <parquet/column_reader.h>
+#include <parquet/metadata.h>
+#include <parquet/schema.h>
+#include <parquet/types.h>
+#include <result.h>
+
+#include <cstdint>
+#include <memory>
+
+namespace Buzz {
+
+/// Sizes of the Arrow buffers that hold a decoded column chunck
+struct DecodedChunckSizes {
+  /// number of slots, nulls included
+  int64_t length;
+  int64_t validity_bytes;
+  /// 0 if the type has no offsets buffer
+  int64_t offsets_bytes;
+  int64_t values_bytes;
+  /// false if values_bytes is an upper bound or only an estimate
+  bool values_bytes_exact;
+};
+
+/// Compute the buffer sizes of a flat column chunck from the footer metadata, so that
+/// builders can reserve them up front instead of growing by reallocations.
+///
+/// The values of BYTE_ARRAY chuncks are bounded by the uncompressed size of PLAIN pages
+/// (each value is prefixed by its 4 byte length). Dictionary encoded chuncks can expand
+/// beyond their uncompressed size, in that case the size is only a lower estimate.
+DecodedChunckSizes EstimateDecodedSizes(
+    const parquet::ColumnChunkMetaData& col_chunck_meta,
+    const parquet::ColumnDescriptor& descr);
+
+/// Decode a flat BYTE_ARRAY column chunck into a string (or binary if not annotated as
+/// a string) array whose buffers are reserved once from EstimateDecodedSizes().
+/// parquet::arrow grows the values of binary columns page by page instead.
+Result<std::shared_ptr<arrow::Array>> ReadByteArrayChunck(
+    parquet::ColumnReader* reader, const parquet::ColumnChunkMetaData& col_chunck_meta,
+    const parquet::ColumnDescriptor& descr,
+    arrow::MemoryPool* pool = arrow::default_memory_pool());
+
+}  // namespace Buzz
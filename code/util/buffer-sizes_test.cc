@@ -0,0 +1,161 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "buffer-sizes.h"
+
+#include <arrow/api.h>
+#include <arrow/io/memory.h>
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/file_reader.h>
+
+namespace Buzz {
+
+namespace {
+/// one nullable int64 column and one string column of nb_rows rows
+std::shared_ptr<arrow::Buffer> WriteColumns(int nb_rows, bool dictionary) {
+  arrow::Int64Builder int_builder;
+  arrow::StringBuilder string_builder;
+  for (int i = 0; i < nb_rows; i++) {
+    if (i % 7 == 0) {
+      ARROW_EXPECT_OK(int_builder.AppendNull());
+    } else {
+      ARROW_EXPECT_OK(int_builder.Append(i));
+    }
+    ARROW_EXPECT_OK(string_builder.Append("value_" + std::to_string(i % 100)));
+  }
+  std::shared_ptr<arrow::Array> ints, strings;
+  ARROW_EXPECT_OK(int_builder.Finish(&ints));
+  ARROW_EXPECT_OK(string_builder.Finish(&strings));
+  auto table = arrow::Table::Make(arrow::schema({arrow::field("ints", arrow::int64()),
+                                                 arrow::field("strings", arrow::utf8())}),
+                                  {ints, strings});
+  auto sink = arrow::io::BufferOutputStream::Create().ValueOrDie();
+  parquet::WriterProperties::Builder props_builder;
+  if (!dictionary) {
+    props_builder.disable_dictionary();
+  }
+  ARROW_EXPECT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), sink,
+                                             nb_rows, props_builder.build()));
+  return sink->Finish().ValueOrDie();
+}
+
+/// one string column of nb_rows rows, null except every `every` rows
+std::shared_ptr<arrow::Buffer> WriteSparseStrings(int nb_rows, int every,
+                                                  bool dictionary) {
+  arrow::StringBuilder string_builder;
+  for (int i = 0; i < nb_rows; i++) {
+    if (i % every == 0) {
+      ARROW_EXPECT_OK(string_builder.Append("value_" + std::to_string(i % 1000)));
+    } else {
+      ARROW_EXPECT_OK(string_builder.AppendNull());
+    }
+  }
+  std::shared_ptr<arrow::Array> strings;
+  ARROW_EXPECT_OK(string_builder.Finish(&strings));
+  auto table = arrow::Table::Make(
+      arrow::schema({arrow::field("strings", arrow::utf8())}), {strings});
+  auto sink = arrow::io::BufferOutputStream::Create().ValueOrDie();
+  parquet::WriterProperties::Builder props_builder;
+  if (!dictionary) {
+    props_builder.disable_dictionary();
+  }
+  ARROW_EXPECT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), sink,
+                                             nb_rows, props_builder.build()));
+  return sink->Finish().ValueOrDie();
+}
+}  // namespace
+
+TEST(BufferSizes, PlainColumns) {
+  constexpr int nb_rows = 10000;
+  auto reader = parquet::ParquetFileReader::Open(
+      std::make_shared<arrow::io::BufferReader>(WriteColumns(nb_rows, false)));
+  auto metadata = reader->metadata();
+
+  auto int_sizes =
+      EstimateDecodedSizes(*metadata->RowGroup(0)->ColumnChunk(0),
+                           *metadata->schema()->Column(0));
+  ASSERT_EQ(int_sizes.length, nb_rows);
+  ASSERT_EQ(int_sizes.validity_bytes, nb_rows / 8);
+  ASSERT_EQ(int_sizes.offsets_bytes, 0);
+  ASSERT_EQ(int_sizes.values_bytes, nb_rows * 8);
+
+  auto string_sizes =
+      EstimateDecodedSizes(*metadata->RowGroup(0)->ColumnChunk(1),
+                           *metadata->schema()->Column(1));
+  ASSERT_EQ(string_sizes.offsets_bytes, (nb_rows + 1) * 4);
+  ASSERT_FALSE(string_sizes.values_bytes_exact);
+  // "value_0".."value_9" take 7 bytes, "value_10".."value_99" take 8 bytes
+  int64_t data_bytes = nb_rows / 100 * (10 * 7 + 90 * 8);
+  ASSERT_GE(string_sizes.values_bytes, data_bytes);
+  ASSERT_LT(string_sizes.values_bytes, data_bytes * 11 / 10);
+}
+
+TEST(BufferSizes, DictionaryColumn) {
+  auto reader = parquet::ParquetFileReader::Open(
+      std::make_shared<arrow::io::BufferReader>(WriteColumns(1000, true)));
+  auto metadata = reader->metadata();
+  auto string_sizes =
+      EstimateDecodedSizes(*metadata->RowGroup(0)->ColumnChunk(1),
+                           *metadata->schema()->Column(1));
+  ASSERT_FALSE(string_sizes.values_bytes_exact);
+}
+
+TEST(BufferSizes, SparseStringsUpperBound) {
+  constexpr int nb_rows = 10000;
+  auto reader = parquet::ParquetFileReader::Open(
+      std::make_shared<arrow::io::BufferReader>(WriteSparseStrings(nb_rows, 10, false)));
+  auto metadata = reader->metadata();
+  auto string_sizes = EstimateDecodedSizes(*metadata->RowGroup(0)->ColumnChunk(0),
+                                           *metadata->schema()->Column(0));
+  // the nulls have no length prefix to remove
+  int64_t data_bytes = 0;
+  for (int i = 0; i < nb_rows; i += 10) {
+    data_bytes += ("value_" + std::to_string(i % 1000)).size();
+  }
+  ASSERT_FALSE(string_sizes.values_bytes_exact);
+  ASSERT_GE(string_sizes.values_bytes, data_bytes);
+}
+
+TEST(BufferSizes, ReadByteArrayChunck) {
+  for (auto dictionary : {false, true}) {
+    auto buffer = WriteSparseStrings(5000, 3, dictionary);
+    auto reader = parquet::ParquetFileReader::Open(
+        std::make_shared<arrow::io::BufferReader>(buffer));
+    auto metadata = reader->metadata();
+    ASSERT_OK_AND_ASSIGN(
+        auto array,
+        ReadByteArrayChunck(reader->RowGroup(0)->Column(0).get(),
+                            *metadata->RowGroup(0)->ColumnChunk(0),
+                            *metadata->schema()->Column(0)));
+
+    std::unique_ptr<parquet::arrow::FileReader> arrow_reader;
+    ASSERT_OK(parquet::arrow::FileReader::Make(
+        arrow::default_memory_pool(),
+        parquet::ParquetFileReader::Open(
+            std::make_shared<arrow::io::BufferReader>(buffer)),
+        &arrow_reader));
+    std::shared_ptr<arrow::ChunkedArray> expected;
+    ASSERT_OK(arrow_reader->RowGroup(0)->Column(0)->Read(&expected));
+    ASSERT_EQ(expected->num_chunks(), 1);
+    ASSERT_TRUE(array->Equals(*expected->chunk(0))) << array->ToString();
+  }
+}
+
+}  // namespace Buzz
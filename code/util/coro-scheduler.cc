@@ -0,0 +1,109 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "coro-scheduler.h"
+
+#include <algorithm>
+#include <new>
+
+namespace Buzz {
+
+namespace {
+struct FrameHeader {
+  FrameArena* arena;
+};
+}  // namespace
+
+FrameArena::FrameArena(size_t chunk_size)
+    : chunk_size_(std::max(chunk_size, size_t(1) << (kMinClassBits + kNbClasses - 1))),
+      chunk_offset_(chunk_size_) {}
+
+FrameArena::~FrameArena() = default;
+
+FrameArena& FrameArena::Default() {
+  // never destroyed, the frames of detached coroutines might outlive static destructors
+  static auto arena = new FrameArena();
+  return *arena;
+}
+
+void* FrameArena::AllocateFrame(size_t size) {
+  auto block = static_cast<uint8_t*>(Allocate(size + kHeaderSize));
+  reinterpret_cast<FrameHeader*>(block)->arena = this;
+  return block + kHeaderSize;
+}
+
+void FrameArena::FreeFrame(void* frame, size_t size) {
+  auto block = static_cast<uint8_t*>(frame) - kHeaderSize;
+  reinterpret_cast<FrameHeader*>(block)->arena->Free(block, size + kHeaderSize);
+}
+
+namespace {
+/// index of the smallest power of 2 size class that fits `size`
+int SizeClassIndex(size_t size, int min_class_bits) {
+  int index = 0;
+  while ((size_t(1) << (index + min_class_bits)) < size) {
+    index++;
+  }
+  return index;
+}
+}  // namespace
+
+void* FrameArena::Allocate(size_t size) {
+  auto index = SizeClassIndex(size, kMinClassBits);
+  if (index >= kNbClasses) {
+    oversized_frames_.fetch_add(1);
+    return ::operator new(size);
+  }
+  auto& size_class = classes_[index];
+  {
+    std::lock_guard<std::mutex> lock(size_class.mutex);
+    if (size_class.free_blocks != nullptr) {
+      auto block = size_class.free_blocks;
+      size_class.free_blocks = block->next;
+      return block;
+    }
+  }
+  return Carve(size_t(1) << (index + kMinClassBits));
+}
+
+void FrameArena::Free(void* block, size_t size) {
+  auto index = SizeClassIndex(size, kMinClassBits);
+  if (index >= kNbClasses) {
+    ::operator delete(block);
+    return;
+  }
+  auto& size_class = classes_[index];
+  auto free_block = static_cast<FreeBlock*>(block);
+  std::lock_guard<std::mutex> lock(size_class.mutex);
+  free_block->next = size_class.free_blocks;
+  size_class.free_blocks = free_block;
+}
+
+void* FrameArena::Carve(size_t size) {
+  std::lock_guard<std::mutex> lock(chunks_mutex_);
+  if (chunk_offset_ + size > chunk_size_) {
+    // the tail of the previous chunk is lost, it is smaller than the largest class
+    chunks_.emplace_back(new uint8_t[chunk_size_]);
+    chunk_offset_ = 0;
+    reserved_bytes_.fetch_add(chunk_size_);
+  }
+  auto block = chunks_.back().get() + chunk_offset_;
+  chunk_offset_ += size;
+  return block;
+}
+
+}  // namespace Buzz
@@ -0,0 +1,352 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "async_queue.h"
+#include "executor.h"
+
+// the coroutines require C++20 (BUZZ_CXX_STANDARD=20), the frame arena does not
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define BUZZ_HAS_COROUTINES 1
+#include <coroutine>
+#else
+#define BUZZ_HAS_COROUTINES 0
+#endif
+
+namespace Buzz {
+
+/// Arena for coroutine frames. The frames are carved from large chunks and recycled
+/// through free lists of power of 2 size classes, so that once the arena is warm,
+/// starting a coroutine does not reach the heap. The chunks are only released with the
+/// arena. Frames can be freed from any thread.
+class FrameArena {
+ public:
+  explicit FrameArena(size_t chunk_size = 256 * 1024);
+  ~FrameArena();
+
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  /// Arena of the coroutines that do not name one
+  static FrameArena& Default();
+
+  /// Allocate a frame, the arena is remembered in a header in front of it
+  void* AllocateFrame(size_t size);
+  static void FreeFrame(void* frame, size_t size);
+
+  int64_t reserved_bytes() const { return reserved_bytes_.load(); }
+  /// frames larger than the biggest size class go straight to the heap
+  int64_t oversized_frames() const { return oversized_frames_.load(); }
+
+ private:
+  static constexpr int kMinClassBits = 6;
+  static constexpr int kNbClasses = 8;
+  /// keeps the frames aligned as operator new would
+  static constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+  struct SizeClass {
+    std::mutex mutex;
+    FreeBlock* free_blocks = nullptr;
+  };
+
+  void* Allocate(size_t size);
+  void Free(void* block, size_t size);
+  void* Carve(size_t size);
+
+  size_t chunk_size_;
+  std::array<SizeClass, kNbClasses> classes_;
+  std::mutex chunks_mutex_;
+  std::vector<std::unique_ptr<uint8_t[]>> chunks_;
+  size_t chunk_offset_;
+  std::atomic<int64_t> reserved_bytes_{0};
+  std::atomic<int64_t> oversized_frames_{0};
+};
+
+#if BUZZ_HAS_COROUTINES
+
+namespace detail {
+
+inline FrameArena* PickArena(FrameArena*, FrameArena& argument) {
+  return &argument;
+}
+template <typename T>
+FrameArena* PickArena(FrameArena* arena, const T&) {
+  return arena;
+}
+
+/// Frames of the promises deriving from it are allocated in a FrameArena: the last one
+/// among the arguments of the coroutine if any, the default one otherwise
+struct ArenaPromise {
+  static void* operator new(size_t size) {
+    return FrameArena::Default().AllocateFrame(size);
+  }
+  template <typename... Args>
+  static void* operator new(size_t size, Args&&... args) {
+    auto arena = &FrameArena::Default();
+    ((arena = PickArena(arena, args)), ...);
+    return arena->AllocateFrame(size);
+  }
+  static void operator delete(void* frame, size_t size) {
+    FrameArena::FreeFrame(frame, size);
+  }
+};
+
+template <typename Promise>
+struct FinalAwaiter {
+  bool await_ready() noexcept { return false; }
+  /// symmetric transfer to the awaiting coroutine, so that long chains of tasks that
+  /// complete synchronously do not grow the stack
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+    auto continuation = handle.promise().continuation;
+    return continuation ? continuation : std::noop_coroutine();
+  }
+  void await_resume() noexcept {}
+};
+
+template <typename Promise>
+struct TaskPromiseBase : ArenaPromise {
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  FinalAwaiter<Promise> final_suspend() noexcept { return {}; }
+  void unhandled_exception() { exception = std::current_exception(); }
+};
+
+}  // namespace detail
+
+/// Lazy coroutine producing a T. It starts when it is awaited and resumes its awaiter
+/// when it is done, exceptions are rethrown to the awaiter.
+template <typename T = void>
+class Task {
+ public:
+  struct promise_type : detail::TaskPromiseBase<promise_type> {
+    std::optional<T> value;
+
+    Task get_return_object() {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    template <typename U>
+    void return_value(U&& result) {
+      value.emplace(std::forward<U>(result));
+    }
+  };
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+  Task& operator=(Task&& other) noexcept {
+    std::swap(handle_, other.handle_);
+    return *this;
+  }
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+    handle_.promise().continuation = awaiter;
+    return handle_;
+  }
+  T await_resume() {
+    if (handle_.promise().exception) {
+      std::rethrow_exception(handle_.promise().exception);
+    }
+    return std::move(*handle_.promise().value);
+  }
+
+ private:
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+template <>
+class Task<void> {
+ public:
+  struct promise_type : detail::TaskPromiseBase<promise_type> {
+    Task get_return_object() {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    void return_void() {}
+  };
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+  Task& operator=(Task&& other) noexcept {
+    std::swap(handle_, other.handle_);
+    return *this;
+  }
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+    handle_.promise().continuation = awaiter;
+    return handle_;
+  }
+  void await_resume() {
+    if (handle_.promise().exception) {
+      std::rethrow_exception(handle_.promise().exception);
+    }
+  }
+
+ private:
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+/// Resume the awaiting coroutine on a lane of the executor. The submitted closure only
+/// holds the coroutine handle, it fits in the small buffer of std::function and the
+/// suspension does not allocate.
+class ResumeOn {
+ public:
+  ResumeOn(Executor* executor, Lane lane) : executor_(executor), lane_(lane) {}
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle) {
+    executor_->Submit(lane_, [handle]() { handle.resume(); });
+  }
+  void await_resume() const noexcept {}
+
+ private:
+  Executor* executor_;
+  Lane lane_;
+};
+
+/// Adapt a callback based operation: `start(on_complete)` is called on suspension and
+/// the coroutine resumes on the executor lane with the value passed to `on_complete`,
+/// which can be called from any thread, even before `start` returns.
+template <typename T, typename StartFn>
+class CallbackAwaitable {
+ public:
+  CallbackAwaitable(StartFn start, Executor* executor, Lane lane)
+      : start_(std::move(start)), executor_(executor), lane_(lane) {}
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle) {
+    // the awaitable lives in the suspended frame, which might be resumed and destroyed
+    // as soon as the completion is handed out, so the start function is moved out first
+    auto start = std::move(start_);
+    start([this, handle](T result) {
+      result_.emplace(std::move(result));
+      executor_->Submit(lane_, [handle]() { handle.resume(); });
+    });
+  }
+  T await_resume() { return std::move(*result_); }
+
+ private:
+  StartFn start_;
+  Executor* executor_;
+  Lane lane_;
+  std::optional<T> result_;
+};
+
+template <typename T, typename StartFn>
+CallbackAwaitable<T, StartFn> MakeCallbackAwaitable(
+    StartFn start, Executor* executor = &Executor::Default(), Lane lane = Lane::CPU) {
+  return CallbackAwaitable<T, StartFn>(std::move(start), executor, lane);
+}
+
+/// Runs detached root tasks on a lane of the executor and waits for them. The tasks
+/// are written sequentially and suspend on their downloads, so that thousands of them
+/// can be in flight with only the lane workers.
+class CoroScheduler {
+ public:
+  explicit CoroScheduler(Executor* executor = &Executor::Default(), Lane lane = Lane::CPU)
+      : executor_(executor), lane_(lane), pending_(std::make_shared<WaitGroup>()) {}
+
+  /// The task starts on the lane, it is owned by the scheduler until it is over
+  void Spawn(Task<void> task) {
+    pending_->Add();
+    Detach(std::move(task), pending_, this).Start(executor_, lane_);
+  }
+
+  /// Wait for all the spawned tasks, rethrows the first exception of one of them
+  void Wait() {
+    pending_->Wait();
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+  /// `co_await scheduler.Schedule()` moves the coroutine to the lane
+  ResumeOn Schedule() const { return ResumeOn(executor_, lane_); }
+
+ private:
+  /// Root coroutine that destroys itself when it is done
+  struct DetachedTask {
+    struct promise_type : detail::ArenaPromise {
+      DetachedTask get_return_object() {
+        return {std::coroutine_handle<promise_type>::from_promise(*this)};
+      }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      std::suspend_never final_suspend() noexcept { return {}; }
+      void return_void() {}
+      void unhandled_exception() { std::terminate(); }
+    };
+
+    void Start(Executor* executor, Lane lane) {
+      auto handle = handle_;
+      executor->Submit(lane, [handle]() { handle.resume(); });
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+  };
+
+  /// the frame owns a reference to the group, which outlives the last Done()
+  static DetachedTask Detach(Task<void> task, std::shared_ptr<WaitGroup> pending,
+                             CoroScheduler* scheduler) {
+    try {
+      // the task is destroyed before Done(), its frame might belong to an arena that
+      // does not outlive Wait()
+      auto root = std::move(task);
+      co_await root;
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(scheduler->error_mutex_);
+      if (!scheduler->error_) {
+        scheduler->error_ = std::current_exception();
+      }
+    }
+    pending->Done();
+  }
+
+  Executor* executor_;
+  Lane lane_;
+  std::shared_ptr<WaitGroup> pending_;
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+};
+
+#endif  // BUZZ_HAS_COROUTINES
+
+}  // namespace Buzz
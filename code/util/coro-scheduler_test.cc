@@ -0,0 +1,145 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "coro-scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+
+namespace Buzz {
+
+#if BUZZ_HAS_COROUTINES
+
+namespace {
+
+Task<int> Square(int value) { co_return value* value; }
+
+Task<int> SumOfSquares(int count) {
+  int sum = 0;
+  for (int i = 0; i < count; i++) {
+    sum += co_await Square(i);
+  }
+  co_return sum;
+}
+
+Task<int> Fail() {
+  throw std::runtime_error("failed task");
+  co_return 0;
+}
+
+/// The frame is allocated in the arena passed as argument
+Task<void> Noop(FrameArena& arena, int i) { co_return; }
+
+/// Completes on a thread of the queue, like a download
+auto AsyncIncrement(AsyncQueue<int>& queue, int value) {
+  return MakeCallbackAwaitable<int>([&queue, value](auto on_complete) {
+    queue.PushTask([on_complete, value]() { on_complete(value + 1); });
+  });
+}
+
+}  // namespace
+
+TEST(CoroScheduler, NestedTasks) {
+  Executor executor(2, 0);
+  CoroScheduler scheduler(&executor, Lane::CPU);
+  int result = 0;
+  scheduler.Spawn([](int* result) -> Task<void> {
+    *result = co_await SumOfSquares(1000);
+  }(&result));
+  scheduler.Wait();
+  ASSERT_EQ(result, 332833500);
+}
+
+TEST(CoroScheduler, RethrowsExceptions) {
+  Executor executor(1, 0);
+  CoroScheduler scheduler(&executor, Lane::CPU);
+  bool caught = false;
+  scheduler.Spawn([](bool* caught) -> Task<void> {
+    try {
+      co_await Fail();
+    } catch (const std::runtime_error&) {
+      *caught = true;
+    }
+  }(&caught));
+  scheduler.Spawn([]() -> Task<void> { co_await Fail(); }());
+  ASSERT_THROW(scheduler.Wait(), std::runtime_error);
+  ASSERT_TRUE(caught);
+}
+
+TEST(CoroScheduler, ManyTasksInFlight) {
+  Executor executor(2, 0);
+  CoroScheduler scheduler(&executor, Lane::CPU);
+  auto synchronizer = std::make_shared<Synchronizer>();
+  AsyncQueue<int> queue(synchronizer, 4, 1024, Lane::IO, &executor);
+  std::atomic<int64_t> sum{0};
+  for (int i = 0; i < 2000; i++) {
+    scheduler.Spawn([](AsyncQueue<int>& queue, std::atomic<int64_t>& sum,
+                       int i) -> Task<void> {
+      // each task suspends sequentially on several operations
+      auto value = co_await AsyncIncrement(queue, i);
+      value = co_await AsyncIncrement(queue, value);
+      sum += value;
+    }(queue, sum, i));
+  }
+  scheduler.Wait();
+  ASSERT_EQ(sum.load(), 1999 * 1000 + 2 * 2000);
+}
+
+TEST(FrameArena, RecyclesFrames) {
+  FrameArena arena(4096);
+  Executor executor(1, 0);
+  CoroScheduler scheduler(&executor, Lane::CPU);
+  auto run_batch = [&]() {
+    // the frames are all allocated before the first one completes
+    std::vector<Task<void>> tasks;
+    for (int i = 0; i < 100; i++) {
+      tasks.push_back(Noop(arena, i));
+    }
+    for (auto& task : tasks) {
+      scheduler.Spawn(std::move(task));
+    }
+    scheduler.Wait();
+  };
+  run_batch();
+  auto warm_bytes = arena.reserved_bytes();
+  ASSERT_GT(warm_bytes, 0);
+  for (int batch = 0; batch < 10; batch++) {
+    run_batch();
+  }
+  ASSERT_EQ(arena.reserved_bytes(), warm_bytes);
+  ASSERT_EQ(arena.oversized_frames(), 0);
+}
+
+#endif  // BUZZ_HAS_COROUTINES
+
+TEST(FrameArena, AllocatesAlignedFrames) {
+  FrameArena arena(4096);
+  std::vector<std::pair<void*, size_t>> frames;
+  for (size_t size = 1; size < 10000; size += 97) {
+    auto frame = arena.AllocateFrame(size);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(frame) % alignof(std::max_align_t), 0);
+    frames.emplace_back(frame, size);
+  }
+  for (auto& frame : frames) {
+    FrameArena::FreeFrame(frame.first, frame.second);
+  }
+  ASSERT_GT(arena.oversized_frames(), 0);
+}
+
+}  // namespace Buzz
@@ -0,0 +1,321 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "cpu-topology.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <thread>
+
+namespace Buzz {
+
+namespace {
+std::optional<std::string> ReadLine(const std::string& path) {
+  std::ifstream file(path);
+  std::string line;
+  if (!file.is_open() || !std::getline(file, line)) {
+    return std::nullopt;
+  }
+  return line;
+}
+
+constexpr double kUnlimited = std::numeric_limits<double>::infinity();
+
+/// v2 "cpu.max" is "<quota> <period>" or "max <period>", unset if there is no file or
+/// it is malformed
+std::optional<double> ReadCpuMax(const std::string& cgroup_dir) {
+  auto cpu_max = ReadLine(cgroup_dir + "/cpu.max");
+  if (!cpu_max.has_value()) {
+    return std::nullopt;
+  }
+  std::istringstream stream(cpu_max.value());
+  std::string quota;
+  double period = 0;
+  stream >> quota >> period;
+  if (quota == "max" || period <= 0) {
+    return kUnlimited;
+  }
+  try {
+    return std::stod(quota) / period;
+  } catch (const std::exception&) {
+    return std::nullopt;
+  }
+}
+
+/// v1 has a file for the quota and the period, the quota is -1 when unlimited
+std::optional<double> ReadCfsQuota(const std::string& cgroup_dir) {
+  auto quota = ReadLine(cgroup_dir + "/cpu.cfs_quota_us");
+  auto period = ReadLine(cgroup_dir + "/cpu.cfs_period_us");
+  if (!quota.has_value() || !period.has_value()) {
+    return std::nullopt;
+  }
+  double quota_us = 0;
+  double period_us = 0;
+  try {
+    quota_us = std::stod(quota.value());
+    period_us = std::stod(period.value());
+  } catch (const std::exception&) {
+    return std::nullopt;
+  }
+  if (quota_us <= 0 || period_us <= 0) {
+    return kUnlimited;
+  }
+  return quota_us / period_us;
+}
+
+/// The cgroup paths of the process by controller list, "" for v2, from the
+/// "<hierarchy id>:<controllers>:<path>" lines of /proc/<pid>/cgroup
+std::map<std::string, std::string> ReadCgroupPaths(const std::string& proc_cgroup) {
+  std::map<std::string, std::string> paths;
+  std::ifstream file(proc_cgroup);
+  std::string line;
+  while (std::getline(file, line)) {
+    auto first_colon = line.find(':');
+    auto second_colon = line.find(':', first_colon + 1);
+    if (first_colon == std::string::npos || second_colon == std::string::npos) {
+      continue;
+    }
+    paths[line.substr(first_colon + 1, second_colon - first_colon - 1)] =
+        line.substr(second_colon + 1);
+  }
+  return paths;
+}
+
+/// A cgroup is limited by the lowest quota of its ancestors. The mount may also be
+/// the cgroup of the process itself (containers without a cgroup namespace), so the
+/// ancestors missing under the mount are skipped up to its root.
+std::optional<double> ReadHierarchyQuota(
+    const std::string& mount, std::string cgroup_path,
+    std::optional<double> (*read_quota)(const std::string&)) {
+  std::optional<double> result;
+  while (true) {
+    auto quota = read_quota(mount + cgroup_path);
+    if (quota.has_value()) {
+      result = std::min(result.value_or(kUnlimited), quota.value());
+    }
+    auto slash = cgroup_path.rfind('/');
+    if (slash == std::string::npos || cgroup_path == "/") {
+      return result;
+    }
+    cgroup_path.resize(slash);
+  }
+}
+
+/// The quota of the cgroup of the process listed in `proc_cgroup`, the cgroup v2
+/// hierarchy is expected at `cgroup_root` and the v1 controllers in its sub-directories
+std::optional<double> ReadCpuQuota(const std::string& cgroup_root,
+                                   const std::string& proc_cgroup) {
+  auto paths = ReadCgroupPaths(proc_cgroup);
+  auto v2_path = paths.count("") > 0 ? paths.at("") : "/";
+  auto quota = ReadHierarchyQuota(cgroup_root, v2_path, ReadCpuMax);
+  if (!quota.has_value()) {
+    // the cpu controller is usually co-mounted with cpuacct
+    std::string v1_path = "/";
+    std::vector<std::string> mounts = {"/cpu", "/cpu,cpuacct"};
+    for (auto& entry : paths) {
+      auto controllers = "," + entry.first + ",";
+      if (controllers.find(",cpu,") != std::string::npos) {
+        v1_path = entry.second;
+        mounts.insert(mounts.begin(), "/" + entry.first);
+      }
+    }
+    for (auto& mount : mounts) {
+      quota = ReadHierarchyQuota(cgroup_root + mount, v1_path, ReadCfsQuota);
+      if (quota.has_value()) {
+        break;
+      }
+    }
+  }
+  if (!quota.has_value() || quota.value() == kUnlimited) {
+    return std::nullopt;
+  }
+  return quota;
+}
+
+std::string FormatCpus(const std::vector<int>& cpus) {
+  std::string result;
+  for (auto cpu : cpus) {
+    result += (result.empty() ? "" : ",") + std::to_string(cpu);
+  }
+  return result;
+}
+}  // namespace
+
+Result<std::vector<int>> ParseCpuList(const std::string& cpu_list) {
+  std::vector<int> cpus;
+  std::istringstream stream(cpu_list);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    if (range.empty() || range == "\n") {
+      continue;
+    }
+    try {
+      auto dash = range.find('-');
+      auto first = std::stoi(range.substr(0, dash));
+      auto last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      if (first < 0 || last < first) {
+        return Status::Invalid("Invalid CPU range: ", range);
+      }
+      for (int cpu = first; cpu <= last; cpu++) {
+        cpus.push_back(cpu);
+      }
+    } catch (const std::exception&) {
+      return Status::Invalid("Invalid CPU list: ", cpu_list);
+    }
+  }
+  return cpus;
+}
+
+int CpuTopology::num_cpus() const {
+  int count = 0;
+  for (auto& core : cores) {
+    count += core.size();
+  }
+  return count;
+}
+
+int CpuTopology::usable_cpus() const {
+  auto usable = std::max(1, num_cpus());
+  if (cpu_quota.has_value()) {
+    // a partial CPU still serves a thread, throttled
+    usable = std::min<int>(usable, std::max(1., std::ceil(cpu_quota.value() - 0.01)));
+  }
+  return usable;
+}
+
+std::string CpuTopology::ToString() const {
+  std::string result;
+  for (auto& core : cores) {
+    result += "[" + FormatCpus(core) + "]";
+  }
+  result += "/quota:" + (cpu_quota.has_value() ? std::to_string(cpu_quota.value())
+                                                 : std::string("none"));
+  return result;
+}
+
+CpuTopology CpuTopology::Detect() {
+  std::vector<int> allowed_cpus;
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  if (sched_getaffinity(0, sizeof(cpuset), &cpuset) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &cpuset)) {
+        allowed_cpus.push_back(cpu);
+      }
+    }
+  }
+  if (allowed_cpus.empty()) {
+    for (int cpu = 0; cpu < std::max<int>(1, std::thread::hardware_concurrency());
+         cpu++) {
+      allowed_cpus.push_back(cpu);
+    }
+  }
+  return Read(allowed_cpus, "/sys", "/proc");
+}
+
+CpuTopology CpuTopology::Read(const std::vector<int>& allowed_cpus,
+                              const std::string& sys_root, const std::string& proc_root) {
+  // the cores are identified by their first sibling, a CPU without topology information
+  // is a core of its own
+  std::map<int, std::vector<int>> cores;
+  for (auto cpu : allowed_cpus) {
+    auto siblings_list = ReadLine(sys_root + "/devices/system/cpu/cpu" +
+                                  std::to_string(cpu) + "/topology/thread_siblings_list");
+    auto core_id = cpu;
+    if (siblings_list.has_value()) {
+      auto siblings = ParseCpuList(siblings_list.value());
+      if (siblings.ok() && !siblings->empty()) {
+        core_id = *std::min_element(siblings->begin(), siblings->end());
+      }
+    }
+    cores[core_id].push_back(cpu);
+  }
+  CpuTopology topology;
+  for (auto& core : cores) {
+    topology.cores.push_back(std::move(core.second));
+  }
+  topology.cpu_quota =
+      ReadCpuQuota(sys_root + "/fs/cgroup", proc_root + "/self/cgroup");
+  return topology;
+}
+
+PlacementPolicy PlacementPolicy::Make(const CpuTopology& topology, bool pin) {
+  PlacementPolicy policy;
+  auto usable = topology.usable_cpus();
+  if (usable <= 1 || topology.num_cpus() <= 1) {
+    return policy;
+  }
+  // the IO workers get the first core, or its first sibling if it is the only core
+  std::vector<std::vector<int>> decode_cores;
+  if (topology.cores.size() > 1) {
+    policy.io_cpus = topology.cores[0];
+    decode_cores.assign(topology.cores.begin() + 1, topology.cores.end());
+  } else {
+    policy.io_cpus = {topology.cores[0][0]};
+    decode_cores = {{topology.cores[0].begin() + 1, topology.cores[0].end()}};
+  }
+  // one worker per core first, then the SMT siblings
+  for (size_t sibling = 0; policy.cpu_worker_cpus.size() < size_t(usable - 1);
+       sibling++) {
+    bool found = false;
+    for (auto& core : decode_cores) {
+      if (sibling < core.size() && policy.cpu_worker_cpus.size() < size_t(usable - 1)) {
+        policy.cpu_worker_cpus.push_back(core[sibling]);
+        found = true;
+      }
+    }
+    if (!found) {
+      break;
+    }
+  }
+  policy.cpu_workers = std::max<int>(1, policy.cpu_worker_cpus.size());
+  if (!pin || policy.cpu_worker_cpus.empty()) {
+    policy.io_cpus.clear();
+    policy.cpu_worker_cpus.clear();
+  }
+  return policy;
+}
+
+std::string PlacementPolicy::ToString() const {
+  if (!pinned()) {
+    return "cpu_workers:" + std::to_string(cpu_workers) + "/unpinned";
+  }
+  return "cpu_workers:" + std::to_string(cpu_workers) + "/io_cpus:" +
+         FormatCpus(io_cpus) + "/cpu_worker_cpus:" + FormatCpus(cpu_worker_cpus);
+}
+
+Status PinCurrentThread(const std::vector<int>& cpus) {
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (auto cpu : cpus) {
+    CPU_SET(cpu, &cpuset);
+  }
+  auto rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+  if (rc != 0) {
+    return Status::IOError("pthread_setaffinity_np failed with code ", rc);
+  }
+  return Status::OK();
+}
+
+}  // namespace Buzz
@@ -0,0 +1,78 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <result.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Buzz {
+
+/// CPUs available to the process. On Lambda the vCPUs are SMT siblings of a few cores
+/// and the CPU share grows with the memory, it is enforced as a cgroup quota.
+struct CpuTopology {
+  /// usable CPUs grouped by physical core, the SMT siblings of a core together
+  std::vector<std::vector<int>> cores;
+  /// CPU quota of the cgroup in CPUs, unset if unlimited
+  std::optional<double> cpu_quota;
+
+  int num_cpus() const;
+  /// number of threads that can be busy at the same time without being throttled
+  int usable_cpus() const;
+  std::string ToString() const;
+
+  /// The CPUs of sched_getaffinity(), with their siblings from /sys and the quota of
+  /// the cgroup of the process (v2 cpu.max or v1 cpu.cfs_quota_us). Falls back to
+  /// hardware_concurrency() unrelated CPUs if they cannot be read.
+  static CpuTopology Detect();
+  /// Group `allowed_cpus` with the topology and quota found under `sys_root` (normally
+  /// "/sys"). The cgroup of the process is resolved from the self/cgroup file of
+  /// `proc_root` (normally "/proc") under the fs/cgroup mount of `sys_root`.
+  static CpuTopology Read(const std::vector<int>& allowed_cpus,
+                          const std::string& sys_root, const std::string& proc_root);
+};
+
+/// Parse a kernel CPU list, e.g. "0-3,8,10-11"
+Result<std::vector<int>> ParseCpuList(const std::string& cpu_list);
+
+/// Where the workers of the Executor lanes run. The IO workers mostly wait on the
+/// network as long as the download callbacks hand the decoding to the CPU lane, they
+/// share one core so that the decode workers each get a core of their own. The decode
+/// workers never outnumber the cgroup quota, they would otherwise be throttled in the
+/// middle of the scan.
+struct PlacementPolicy {
+  /// number of workers of the CPU lane
+  int cpu_workers = 1;
+  /// CPUs of all the IO lane workers, not pinned if empty
+  std::vector<int> io_cpus;
+  /// CPU lane worker i runs on cpu_worker_cpus[i % size], not pinned if empty
+  std::vector<int> cpu_worker_cpus;
+
+  bool pinned() const { return !io_cpus.empty(); }
+  std::string ToString() const;
+
+  /// With a single usable CPU there is nothing to place and the workers are not pinned
+  static PlacementPolicy Make(const CpuTopology& topology, bool pin = true);
+};
+
+/// Restrict the calling thread to `cpus`
+Status PinCurrentThread(const std::vector<int>& cpus);
+
+}  // namespace Buzz
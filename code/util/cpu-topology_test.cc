@@ -0,0 +1,187 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "cpu-topology.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace Buzz {
+
+namespace {
+/// A fake /sys tree with a fake /proc in it, removed with the fixture
+class FakeSysfs {
+ public:
+  FakeSysfs()
+      : root_(std::filesystem::temp_directory_path() /
+              ("cpu-topology-test-" + std::to_string(::getpid()))) {
+    std::filesystem::create_directories(root_);
+  }
+  ~FakeSysfs() { std::filesystem::remove_all(root_); }
+
+  void Write(const std::string& path, const std::string& content) {
+    auto full_path = root_ / path;
+    std::filesystem::create_directories(full_path.parent_path());
+    std::ofstream(full_path) << content << "\n";
+  }
+
+  /// cpus [first, first + nb_siblings) are siblings
+  void AddCore(int first, int nb_siblings) {
+    auto siblings = std::to_string(first) + "-" + std::to_string(first + nb_siblings - 1);
+    for (int cpu = first; cpu < first + nb_siblings; cpu++) {
+      Write("devices/system/cpu/cpu" + std::to_string(cpu) +
+                "/topology/thread_siblings_list",
+            siblings);
+    }
+  }
+
+  std::string root() const { return root_.string(); }
+  std::string proc_root() const { return (root_ / "proc").string(); }
+
+ private:
+  std::filesystem::path root_;
+};
+}  // namespace
+
+TEST(CpuTopology, ParseCpuList) {
+  ASSERT_EQ(ParseCpuList("0-3,8,10-11").ValueOrDie(),
+            std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+  ASSERT_EQ(ParseCpuList("5").ValueOrDie(), std::vector<int>({5}));
+  ASSERT_FALSE(ParseCpuList("3-1").ok());
+  ASSERT_FALSE(ParseCpuList("a-b").ok());
+}
+
+TEST(CpuTopology, GroupsSiblingsAndReadsQuotaV2) {
+  FakeSysfs sysfs;
+  sysfs.AddCore(0, 2);
+  sysfs.AddCore(2, 2);
+  sysfs.Write("fs/cgroup/cpu.max", "150000 100000");
+  // cpu 3 is not in the affinity mask
+  auto topology = CpuTopology::Read({0, 1, 2}, sysfs.root(), sysfs.proc_root());
+  ASSERT_EQ(topology.cores, std::vector<std::vector<int>>({{0, 1}, {2}}));
+  ASSERT_DOUBLE_EQ(topology.cpu_quota.value(), 1.5);
+  ASSERT_EQ(topology.num_cpus(), 3);
+  ASSERT_EQ(topology.usable_cpus(), 2);
+}
+
+TEST(CpuTopology, ReadsQuotaV1AndUnlimited) {
+  FakeSysfs sysfs;
+  sysfs.Write("fs/cgroup/cpu,cpuacct/cpu.cfs_quota_us", "-1");
+  sysfs.Write("fs/cgroup/cpu,cpuacct/cpu.cfs_period_us", "100000");
+  // without topology information each CPU is a core
+  auto topology = CpuTopology::Read({0, 1}, sysfs.root(), sysfs.proc_root());
+  ASSERT_EQ(topology.cores, std::vector<std::vector<int>>({{0}, {1}}));
+  ASSERT_FALSE(topology.cpu_quota.has_value());
+  sysfs.Write("fs/cgroup/cpu,cpuacct/cpu.cfs_quota_us", "200000");
+  ASSERT_DOUBLE_EQ(
+      CpuTopology::Read({0, 1}, sysfs.root(), sysfs.proc_root()).cpu_quota.value(), 2.);
+}
+
+TEST(CpuTopology, IgnoresMalformedQuota) {
+  FakeSysfs sysfs;
+  sysfs.Write("fs/cgroup/cpu.max", "abc 100000");
+  ASSERT_FALSE(
+      CpuTopology::Read({0, 1}, sysfs.root(), sysfs.proc_root()).cpu_quota.has_value());
+  std::filesystem::remove(sysfs.root() + "/fs/cgroup/cpu.max");
+  sysfs.Write("fs/cgroup/cpu,cpuacct/cpu.cfs_quota_us", "");
+  sysfs.Write("fs/cgroup/cpu,cpuacct/cpu.cfs_period_us", "100000");
+  ASSERT_FALSE(
+      CpuTopology::Read({0, 1}, sysfs.root(), sysfs.proc_root()).cpu_quota.has_value());
+}
+
+TEST(CpuTopology, ResolvesCgroupV2Path) {
+  FakeSysfs sysfs;
+  sysfs.Write("proc/self/cgroup", "0::/lambda/sandbox");
+  sysfs.Write("fs/cgroup/other/cpu.max", "50000 100000");
+  sysfs.Write("fs/cgroup/lambda/sandbox/cpu.max", "max 100000");
+  auto read_quota = [&]() {
+    return CpuTopology::Read({0, 1}, sysfs.root(), sysfs.proc_root()).cpu_quota;
+  };
+  ASSERT_FALSE(read_quota().has_value());
+  // the lowest quota of the ancestors applies
+  sysfs.Write("fs/cgroup/lambda/cpu.max", "150000 100000");
+  ASSERT_DOUBLE_EQ(read_quota().value(), 1.5);
+  sysfs.Write("fs/cgroup/lambda/sandbox/cpu.max", "100000 100000");
+  ASSERT_DOUBLE_EQ(read_quota().value(), 1.);
+}
+
+TEST(CpuTopology, ResolvesCgroupV1Path) {
+  FakeSysfs sysfs;
+  // the unified hierarchy of hybrid hosts has no controller
+  sysfs.Write("proc/self/cgroup",
+              "12:memory:/docker/abc\n4:cpu,cpuacct:/docker/abc\n0::/");
+  sysfs.Write("fs/cgroup/cpu,cpuacct/cpu.cfs_quota_us", "-1");
+  sysfs.Write("fs/cgroup/cpu,cpuacct/cpu.cfs_period_us", "100000");
+  sysfs.Write("fs/cgroup/cpu,cpuacct/docker/abc/cpu.cfs_quota_us", "50000");
+  sysfs.Write("fs/cgroup/cpu,cpuacct/docker/abc/cpu.cfs_period_us", "100000");
+  auto read_quota = [&]() {
+    return CpuTopology::Read({0, 1}, sysfs.root(), sysfs.proc_root()).cpu_quota;
+  };
+  ASSERT_DOUBLE_EQ(read_quota().value(), 0.5);
+
+  // without a cgroup namespace, the mount of a container is its own cgroup
+  std::filesystem::remove_all(sysfs.root() + "/fs/cgroup/cpu,cpuacct/docker");
+  sysfs.Write("fs/cgroup/cpu,cpuacct/cpu.cfs_quota_us", "300000");
+  ASSERT_DOUBLE_EQ(read_quota().value(), 3.);
+}
+
+TEST(PlacementPolicy, IoOnFirstCoreDecodeOnOthers) {
+  CpuTopology topology;
+  topology.cores = {{0, 4}, {1, 5}, {2, 6}, {3, 7}};
+  auto policy = PlacementPolicy::Make(topology);
+  ASSERT_EQ(policy.io_cpus, std::vector<int>({0, 4}));
+  // one worker per core before the siblings
+  ASSERT_EQ(policy.cpu_worker_cpus, std::vector<int>({1, 2, 3, 5, 6, 7}));
+  ASSERT_EQ(policy.cpu_workers, 6);
+
+  // the quota caps the decode workers
+  topology.cpu_quota = 3.;
+  policy = PlacementPolicy::Make(topology);
+  ASSERT_EQ(policy.cpu_worker_cpus, std::vector<int>({1, 2}));
+  ASSERT_EQ(policy.cpu_workers, 2);
+
+  auto unpinned = PlacementPolicy::Make(topology, false);
+  ASSERT_FALSE(unpinned.pinned());
+  ASSERT_EQ(unpinned.cpu_workers, 2);
+}
+
+TEST(PlacementPolicy, SmallLambdas) {
+  // two vCPUs that are siblings of a single core
+  CpuTopology topology;
+  topology.cores = {{0, 1}};
+  auto policy = PlacementPolicy::Make(topology);
+  ASSERT_EQ(policy.io_cpus, std::vector<int>({0}));
+  ASSERT_EQ(policy.cpu_worker_cpus, std::vector<int>({1}));
+
+  // less than a CPU worth of quota, nothing to place
+  topology.cpu_quota = 0.6;
+  policy = PlacementPolicy::Make(topology);
+  ASSERT_FALSE(policy.pinned());
+  ASSERT_EQ(policy.cpu_workers, 1);
+}
+
+TEST(CpuTopology, DetectsCurrentProcess) {
+  auto topology = CpuTopology::Detect();
+  ASSERT_GE(topology.num_cpus(), 1);
+  ASSERT_GE(topology.usable_cpus(), 1);
+  ASSERT_LE(topology.usable_cpus(), topology.num_cpus());
+}
+
+}  // namespace Buzz
@@ -20,6 +20,8 @@
 #include <sys/mman.h>
 #define BOOST_STACKTRACE_USE_ADDR2LINE
 #include <algorithm>  // IWYU pragma: keep
+#include <array>
+#include <atomic>
 #include <boost/stacktrace.hpp>
 #include <cstdlib>   // IWYU pragma: keep
 #include <cstring>   // IWYU pragma: keep
@@ -28,10 +30,10 @@
 #include <map>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <unordered_map>
+#include <vector>
 
 static constexpr int64_t PREALLOC_SIZE_BYTES = 1024 * 1024;
-static constexpr int64_t PREALLOC_COUNT = 1500;
 
 namespace Buzz {
 
@@ -45,35 +47,52 @@ size_t whole_page_size(size_t raw_size) {
   return raw_size + page_size - remainder;
 }
 
-class guarded_map {
+/// Sizes of the runway allocations, sharded by address so that concurrent threads
+/// rarely take the same lock. The total is maintained aside for bytes_allocated().
+class sharded_size_map {
  private:
-  std::map<uint8_t*, int64_t> map_;
-  mutable std::mutex mutex_;
+  static constexpr int SHARD_BITS = 4;
+  struct alignas(64) shard {
+    std::unordered_map<uint8_t*, int64_t> map;
+    std::mutex mutex;
+  };
+  std::array<shard, 1 << SHARD_BITS> shards_;
+  std::atomic<int64_t> sum_{0};
+
+  shard& shard_for(uint8_t* key) {
+    // the runways are page aligned, mix the page number with a Fibonacci hash
+    auto page = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key) >> 12);
+    return shards_[(page * 0x9E3779B97F4A7C15ull) >> (64 - SHARD_BITS)];
+  }
 
  public:
   void set(uint8_t* key, int64_t value) {
-    std::lock_guard<std::mutex> lk(mutex_);
-    map_[key] = value;
+    auto& shard = shard_for(key);
+    std::lock_guard<std::mutex> lk(shard.mutex);
+    auto& entry = shard.map[key];
+    sum_ += value - entry;
+    entry = value;
   }
 
   bool erase(uint8_t* key) {
-    std::lock_guard<std::mutex> lk(mutex_);
-    return map_.erase(key);
+    auto& shard = shard_for(key);
+    std::lock_guard<std::mutex> lk(shard.mutex);
+    auto entry = shard.map.find(key);
+    if (entry == shard.map.end()) {
+      return false;
+    }
+    sum_ -= entry->second;
+    shard.map.erase(entry);
+    return true;
   }
 
-  bool contains(uint8_t* key) const {
-    std::lock_guard<std::mutex> lk(mutex_);
-    return map_.find(key) != map_.end();
+  bool contains(uint8_t* key) {
+    auto& shard = shard_for(key);
+    std::lock_guard<std::mutex> lk(shard.mutex);
+    return shard.map.find(key) != shard.map.end();
   }
 
-  int64_t sum() const {
-    std::lock_guard<std::mutex> lk(mutex_);
-    int64_t sum = 0;
-    for (auto alloc : map_) {
-      sum += alloc.second;
-    }
-    return sum;
-  }
+  int64_t sum() const { return sum_; }
 };
 
 class linked_set {
@@ -127,53 +146,111 @@ class linked_set {
   }
 };
 
-class guarded_queue {
+/// The preallocated blocks that are not cached by any thread. They are exchanged in
+/// batches with the thread caches, so the lock is taken once per batch.
+class block_depot {
  private:
-  std::queue<uint8_t*> queue_;
-  mutable std::mutex mutex_;
+  uint8_t* region_;
+  int64_t region_size_;
+  std::vector<uint8_t*> blocks_;
+  std::mutex mutex_;
 
  public:
-  uint8_t* pop() {
-    std::lock_guard<std::mutex> lk(mutex_);
-    if (queue_.size() == 0) {
-      return nullptr;
+  explicit block_depot(int64_t count) : region_size_(count * PREALLOC_SIZE_BYTES) {
+    void* raw_ptr = mmap(nullptr,  // attribute address automatically
+                         region_size_, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, 0,
+                         0);
+    region_ = raw_ptr == MAP_FAILED ? nullptr : reinterpret_cast<uint8_t*>(raw_ptr);
+    if (region_ == nullptr) {
+      return;
+    }
+    memset(region_, 1, static_cast<size_t>(region_size_));
+    for (int64_t i = 0; i < count; i++) {
+      blocks_.push_back(region_ + i * PREALLOC_SIZE_BYTES);
+    }
+  }
+
+  ~block_depot() {
+    if (region_ != nullptr) {
+      munmap(region_, region_size_);
     }
-    auto res = queue_.front();
-    queue_.pop();
-    return res;
   }
 
-  void push(uint8_t* key) {
+  /// Move up to `count` blocks to the back of `out`
+  void take(std::vector<uint8_t*>* out, int count) {
     std::lock_guard<std::mutex> lk(mutex_);
-    queue_.push(key);
+    auto taken = std::min<size_t>(count, blocks_.size());
+    out->insert(out->end(), blocks_.end() - taken, blocks_.end());
+    blocks_.resize(blocks_.size() - taken);
+  }
+
+  /// Move the first `count` blocks of `blocks` back to the depot
+  void give(std::vector<uint8_t*>* blocks, int count) {
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+      blocks_.insert(blocks_.end(), blocks->begin(), blocks->begin() + count);
+    }
+    blocks->erase(blocks->begin(), blocks->begin() + count);
   }
 };
 
+/// The blocks a thread cached from each depot it allocated from. The depots are
+/// identified by a unique id rather than by address, as a new pool could reuse the
+/// address of a destroyed one. The blocks are given back when the thread exits, unless
+/// their pool was destroyed in the meantime.
+class thread_block_caches {
+ private:
+  struct cache {
+    uint64_t depot_id;
+    std::weak_ptr<block_depot> depot;
+    std::vector<uint8_t*> blocks;
+  };
+  std::vector<cache> caches_;
+
+ public:
+  ~thread_block_caches() {
+    for (auto& cache : caches_) {
+      if (auto depot = cache.depot.lock()) {
+        depot->give(&cache.blocks, cache.blocks.size());
+      }
+    }
+  }
+
+  std::vector<uint8_t*>& get(uint64_t depot_id,
+                             const std::shared_ptr<block_depot>& depot) {
+    for (auto& cache : caches_) {
+      if (cache.depot_id == depot_id) {
+        return cache.blocks;
+      }
+    }
+    // forget the caches of the destroyed pools, their blocks are unmapped already
+    caches_.erase(std::remove_if(caches_.begin(), caches_.end(),
+                                 [](const cache& c) { return c.depot.expired(); }),
+                  caches_.end());
+    caches_.push_back({depot_id, depot, {}});
+    return caches_.back().blocks;
+  }
+};
+
+static std::atomic<uint64_t> next_depot_id{0};
+static thread_local thread_block_caches block_caches;
+
 class CustomMemoryPool::CustomMemoryPoolImpl {
  public:
-  explicit CustomMemoryPoolImpl(MemoryPool* pool) : pool_(pool) {
+  CustomMemoryPoolImpl(MemoryPool* pool, CustomMemoryPoolOptions options)
+      : pool_(pool), options_(options) {
 #ifdef ACTIVATE_ALLOCATION_LINKING
     std::cout << "ACTIVATE_ALLOCATION_LINKING = ON" << std::endl;
 #else
     std::cout << "ACTIVATE_ALLOCATION_LINKING = OFF" << std::endl;
 #endif
-#ifdef ACTIVATE_RUNWAY_ALLOCATOR
-    std::cout << "ACTIVATE_RUNWAY_ALLOCATOR = ON" << std::endl;
-#else
-    std::cout << "ACTIVATE_RUNWAY_ALLOCATOR = OFF" << std::endl;
-#endif
-#ifdef ACTIVATE_POOL_ALLOCATOR
-    for (int i = 0; i < PREALLOC_COUNT; i++) {
-      void* raw_ptr =
-          mmap(nullptr,  // attribute address automatically
-               PREALLOC_SIZE_BYTES, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, 0, 0);
-      pool_allocs_.push(reinterpret_cast<uint8_t*>(raw_ptr));
-      memset(raw_ptr, 1, static_cast<size_t>(PREALLOC_SIZE_BYTES));
+    std::cout << "ACTIVATE_RUNWAY_ALLOCATOR = "
+              << (options_.runway_allocator ? "ON" : "OFF") << std::endl;
+    if (options_.pool_allocator) {
+      depot_ = std::make_shared<block_depot>(options_.prealloc_count);
     }
-    std::cout << "ACTIVATE_POOL_ALLOCATOR = ON" << std::endl;
-#else
-    std::cout << "ACTIVATE_POOL_ALLOCATOR = OFF" << std::endl;
-#endif
+    std::cout << "ACTIVATE_POOL_ALLOCATOR = " << (options_.pool_allocator ? "ON" : "OFF")
+              << std::endl;
   }
 
   Status Allocate(int64_t size, uint8_t** out) {
@@ -182,20 +259,16 @@ class CustomMemoryPool::CustomMemoryPoolImpl {
       std::cout << "Allocate," << size << "," << size << "," << 0 << std::endl;
     }
 #endif
-#ifdef ACTIVATE_RUNWAY_ALLOCATOR
-    if (size >= HUGE_ALLOC_THRESHOLD_BYTES) {
+    if (options_.runway_allocator && size >= HUGE_ALLOC_THRESHOLD_BYTES) {
       auto status = runway_allocate(size, out);
       linked_allocs_.add(nullptr, *out, size);
       return status;
     }
-#endif
-#ifdef ACTIVATE_POOL_ALLOCATOR
-    if (size > 0) {
+    if (options_.pool_allocator && size > 0) {
       auto status = pool_allocate(size, out);
       linked_allocs_.add(nullptr, *out, size);
       return status;
     }
-#endif
     auto status = pool_->Allocate(size, out);
     linked_allocs_.add(nullptr, *out, size);
     return status;
@@ -203,9 +276,8 @@ class CustomMemoryPool::CustomMemoryPoolImpl {
 
   Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) {
     uint8_t* previous_ptr = *ptr;
-#ifdef ACTIVATE_RUNWAY_ALLOCATOR
-    if (old_size >= SMALL_ALLOC_THRESHOLD_BYTES ||
-        new_size >= HUGE_ALLOC_THRESHOLD_BYTES) {
+    if (options_.runway_allocator && (old_size >= SMALL_ALLOC_THRESHOLD_BYTES ||
+                                      new_size >= HUGE_ALLOC_THRESHOLD_BYTES)) {
       // this seems to be meat for the custom allocator
       auto result = runway_reallocate(old_size, new_size, ptr);
       RETURN_NOT_OK(result.status());
@@ -215,9 +287,7 @@ class CustomMemoryPool::CustomMemoryPoolImpl {
         return Status::OK();
       }
     }
-#endif
-#ifdef ACTIVATE_POOL_ALLOCATOR
-    if (new_size > 0) {
+    if (options_.pool_allocator && new_size > 0) {
       // this seems to be meat for the custom allocator
       auto result = pool_reallocate(old_size, new_size, ptr);
       RETURN_NOT_OK(result.status());
@@ -227,7 +297,6 @@ class CustomMemoryPool::CustomMemoryPoolImpl {
         return Status::OK();
       }
     }
-#endif
     RETURN_NOT_OK(pool_->Reallocate(old_size, new_size, ptr));
     linked_allocs_.add(previous_ptr, *ptr, new_size);
     print_realloc(old_size, new_size, previous_ptr, *ptr);
@@ -240,18 +309,14 @@ class CustomMemoryPool::CustomMemoryPoolImpl {
       std::cout << "Free," << -size << "," << 0 << "," << size << std::endl;
     }
 #endif
-#ifdef ACTIVATE_RUNWAY_ALLOCATOR
-    if (size >= SMALL_ALLOC_THRESHOLD_BYTES) {
+    if (options_.runway_allocator && size >= SMALL_ALLOC_THRESHOLD_BYTES) {
       runway_free(buffer, size);
       return;
     }
-#endif
-#ifdef ACTIVATE_POOL_ALLOCATOR
-    if (size > 0) {
+    if (options_.pool_allocator && size > 0) {
       pool_free(buffer, size);
       return;
     }
-#endif
     pool_->Free(buffer, size);
   }
 
@@ -264,13 +329,16 @@ class CustomMemoryPool::CustomMemoryPoolImpl {
 
   std::string backend_name() const { return pool_->backend_name() + "_custom"; }
 
-  int64_t copied_bytes_;
+  /// bytes copied by reallocations that moved the buffer
+  std::atomic<int64_t> copied_bytes_{0};
 
  private:
   MemoryPool* pool_;
-  guarded_map large_allocs_;
+  CustomMemoryPoolOptions options_;
+  sharded_size_map large_allocs_;
   linked_set linked_allocs_;
-  guarded_queue pool_allocs_;
+  std::shared_ptr<block_depot> depot_;
+  uint64_t depot_id_ = next_depot_id++;
 
   Status runway_allocate(int64_t size, uint8_t** out) {
     void* raw_ptr = mmap(nullptr,  // attribute address automatically
@@ -285,13 +353,16 @@ class CustomMemoryPool::CustomMemoryPoolImpl {
     if (size > PREALLOC_SIZE_BYTES) {
       return Status::ExecutionError("Allocation larger than PREALLOC_SIZE_BYTES");
     }
-    auto alloc = pool_allocs_.pop();
-    if (alloc != nullptr) {
-      *out = alloc;
-      return Status::OK();
-    } else {
+    auto& blocks = block_caches.get(depot_id_, depot_);
+    if (blocks.empty()) {
+      depot_->take(&blocks, std::max(1, options_.thread_cache_blocks / 2));
+    }
+    if (blocks.empty()) {
       return Status::ExecutionError("no more alloc in pool");
     }
+    *out = blocks.back();
+    blocks.pop_back();
+    return Status::OK();
   }
 
   Result<bool> runway_reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) {
@@ -346,13 +417,22 @@ class CustomMemoryPool::CustomMemoryPoolImpl {
     }
   }
 
-  void pool_free(uint8_t* buffer, int64_t size) { pool_allocs_.push(buffer); }
+  void pool_free(uint8_t* buffer, int64_t size) {
+    auto& blocks = block_caches.get(depot_id_, depot_);
+    blocks.push_back(buffer);
+    if (static_cast<int64_t>(blocks.size()) > options_.thread_cache_blocks) {
+      // the oldest blocks are the least likely to still be in the CPU caches
+      depot_->give(&blocks, std::max<int>(1, blocks.size() / 2));
+    }
+  }
 
   void print_realloc(int64_t old_size, int64_t new_size, uint8_t* old_ptr,
                      uint8_t* new_ptr) {
+    if (old_ptr != new_ptr) {
+      copied_bytes_ += std::min(old_size, new_size);
+    }
 #ifdef ACTIVATE_ALLOCATION_PRINTING
     if (old_ptr != new_ptr) {
-      copied_bytes_ += old_size;
       std::cout << "ReallocateCopy,";
     } else {
       std::cout << "Reallocate,";
@@ -362,8 +442,8 @@ class CustomMemoryPool::CustomMemoryPoolImpl {
   }
 };
 
-CustomMemoryPool::CustomMemoryPool(MemoryPool* pool) {
-  impl_.reset(new CustomMemoryPoolImpl(pool));
+CustomMemoryPool::CustomMemoryPool(MemoryPool* pool, CustomMemoryPoolOptions options) {
+  impl_.reset(new CustomMemoryPoolImpl(pool, options));
 }
 
 CustomMemoryPool::~CustomMemoryPool() {}
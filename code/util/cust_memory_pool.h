@@ -33,13 +33,34 @@ inline constexpr int64_t HUGE_ALLOC_THRESHOLD_BYTES = 1024 * 1024;
 inline constexpr int64_t SMALL_ALLOC_THRESHOLD_BYTES = 256 * 1024;
 inline constexpr int64_t HUGE_ALLOC_RUNWAY_SIZE_BYTES = 1024 * 1024 * 1024;
 
+/// The allocators enabled by default follow the ACTIVATE_* defines
+struct CustomMemoryPoolOptions {
+#ifdef ACTIVATE_RUNWAY_ALLOCATOR
+  bool runway_allocator = true;
+#else
+  bool runway_allocator = false;
+#endif
+#ifdef ACTIVATE_POOL_ALLOCATOR
+  bool pool_allocator = true;
+#else
+  bool pool_allocator = false;
+#endif
+  /// number of 1MB blocks mapped upfront by the pool allocator
+  int64_t prealloc_count = 1500;
+  /// blocks each thread keeps aside before returning half of them to the shared
+  /// depot, a thread can't use the blocks cached by the others. If 0, all the
+  /// allocations take the depot lock.
+  int thread_cache_blocks = 16;
+};
+
 /// Derived class for memory allocation.
 ///
 /// Optimizes large allocations an re-allocations
 /// Forwards small allocations to inner allocator
 class ARROW_EXPORT CustomMemoryPool : public arrow::MemoryPool {
  public:
-  explicit CustomMemoryPool(arrow::MemoryPool* pool);
+  explicit CustomMemoryPool(arrow::MemoryPool* pool,
+                            CustomMemoryPoolOptions options = CustomMemoryPoolOptions());
   ~CustomMemoryPool() override;
 
   Status Allocate(int64_t size, uint8_t** out) override;
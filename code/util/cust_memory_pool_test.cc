@@ -21,6 +21,8 @@
 #include <gtest/gtest.h>
 
 #include <cstdint>
+#include <thread>
+#include <vector>
 
 namespace Buzz {
 
@@ -80,4 +82,103 @@ TEST(CustomMemoryPool, Custom) {
 }
 #endif
 
+#ifndef ACTIVATE_POOL_ALLOCATOR
+TEST(CustomMemoryPool, CopiedBytes) {
+  CustomMemoryPool pool(arrow::default_memory_pool());
+  ASSERT_EQ(pool.copied_bytes(), 0);
+  uint8_t* data;
+  ASSERT_OK(pool.Allocate(64, &data));
+  auto previous_data = data;
+  auto grown_size = 16 * 1024 * 1024;
+  ASSERT_OK(pool.Reallocate(64, grown_size, &data));
+  // only reallocations that move the buffer copy it
+  ASSERT_EQ(pool.copied_bytes(), data == previous_data ? 0 : 64);
+  pool.Free(data, grown_size);
+}
+#endif
+
+TEST(CustomMemoryPool, PoolAllocatorRecyclesBlocks) {
+  CustomMemoryPoolOptions options;
+  options.runway_allocator = false;
+  options.pool_allocator = true;
+  options.prealloc_count = 4;
+  options.thread_cache_blocks = 2;
+  CustomMemoryPool pool(arrow::default_memory_pool(), options);
+  std::vector<uint8_t*> blocks(4);
+  for (auto& block : blocks) {
+    ASSERT_OK(pool.Allocate(1024, &block));
+  }
+  uint8_t* exhausted;
+  ASSERT_RAISES(ExecutionError, pool.Allocate(1024, &exhausted));
+  // the blocks overflowing the thread cache are given back to the depot
+  for (auto block : blocks) {
+    pool.Free(block, 1024);
+  }
+  for (auto& block : blocks) {
+    ASSERT_OK(pool.Allocate(1024, &block));
+  }
+  for (auto block : blocks) {
+    pool.Free(block, 1024);
+  }
+}
+
+TEST(CustomMemoryPool, ThreadCachesReturnBlocksOnExit) {
+  CustomMemoryPoolOptions options;
+  options.runway_allocator = false;
+  options.pool_allocator = true;
+  options.prealloc_count = 4;
+  options.thread_cache_blocks = 16;
+  CustomMemoryPool pool(arrow::default_memory_pool(), options);
+  std::thread worker([&pool]() {
+    std::vector<uint8_t*> blocks(4);
+    for (auto& block : blocks) {
+      ASSERT_OK(pool.Allocate(1024, &block));
+    }
+    // all the blocks stay in the cache of the worker
+    for (auto block : blocks) {
+      pool.Free(block, 1024);
+    }
+  });
+  worker.join();
+  std::vector<uint8_t*> blocks(4);
+  for (auto& block : blocks) {
+    ASSERT_OK(pool.Allocate(1024, &block));
+  }
+  for (auto block : blocks) {
+    pool.Free(block, 1024);
+  }
+}
+
+TEST(CustomMemoryPool, ConcurrentRunways) {
+  CustomMemoryPoolOptions options;
+  options.runway_allocator = true;
+  options.pool_allocator = false;
+  CustomMemoryPool pool(arrow::default_memory_pool(), options);
+  auto base_bytes = pool.bytes_allocated();
+  constexpr int kThreads = 4;
+  constexpr int kAllocs = 8;
+  std::vector<std::vector<uint8_t*>> allocs(kThreads, std::vector<uint8_t*>(kAllocs));
+  std::vector<std::thread> workers;
+  for (int t = 0; t < kThreads; t++) {
+    workers.emplace_back([&, t]() {
+      for (auto& alloc : allocs[t]) {
+        ASSERT_OK(pool.Allocate(HUGE_ALLOC_THRESHOLD_BYTES, &alloc));
+        ASSERT_OK(pool.Reallocate(HUGE_ALLOC_THRESHOLD_BYTES,
+                                  2 * HUGE_ALLOC_THRESHOLD_BYTES, &alloc));
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  ASSERT_EQ(pool.bytes_allocated() - base_bytes,
+            kThreads * kAllocs * 2 * HUGE_ALLOC_THRESHOLD_BYTES);
+  for (auto& thread_allocs : allocs) {
+    for (auto alloc : thread_allocs) {
+      pool.Free(alloc, 2 * HUGE_ALLOC_THRESHOLD_BYTES);
+    }
+  }
+  ASSERT_EQ(pool.bytes_allocated(), base_bytes);
+}
+
 }  // namespace Buzz
@@ -0,0 +1,153 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "dictionary-aggregator.h"
+
+#include <algorithm>
+
+namespace Buzz {
+
+namespace {
+
+template <typename IndexType>
+void CountIndices(const arrow::Array& indices, int64_t* counts, int64_t* null_count) {
+  auto raw_indices =
+      static_cast<const arrow::NumericArray<IndexType>&>(indices).raw_values();
+  if (indices.null_count() == 0) {
+    for (int64_t i = 0; i < indices.length(); i++) {
+      counts[raw_indices[i]]++;
+    }
+    return;
+  }
+  for (int64_t i = 0; i < indices.length(); i++) {
+    if (indices.IsNull(i)) {
+      (*null_count)++;
+    } else {
+      counts[raw_indices[i]]++;
+    }
+  }
+}
+
+}  // namespace
+
+DictionaryCounter::DictionaryCounter(std::unique_ptr<HashAggregator> aggregator,
+                                     std::shared_ptr<arrow::DataType> value_type,
+                                     arrow::MemoryPool* pool)
+    : aggregator_(std::move(aggregator)),
+      value_type_(std::move(value_type)),
+      pool_(pool),
+      null_count_(0) {}
+
+Result<std::unique_ptr<DictionaryCounter>> DictionaryCounter::Make(
+    const std::string& column_name, const std::shared_ptr<arrow::DataType>& value_type,
+    arrow::MemoryPool* pool) {
+  if (value_type->id() != arrow::Type::STRING &&
+      value_type->id() != arrow::Type::BINARY) {
+    return Status::NotImplemented("Dictionary group by on ", value_type->ToString(),
+                                  " values");
+  }
+  auto input_schema = arrow::schema({arrow::field(column_name, value_type)});
+  ARROW_ASSIGN_OR_RAISE(auto aggregator,
+                        HashAggregator::Make(input_schema, {column_name},
+                                             {{AggregateKind::Count, ""}}, pool));
+  return std::unique_ptr<DictionaryCounter>(
+      new DictionaryCounter(std::move(aggregator), value_type, pool));
+}
+
+Status DictionaryCounter::Consume(const arrow::DictionaryArray& array) {
+  if (!array.dictionary()->type()->Equals(*value_type_)) {
+    return Status::TypeError("Expected dictionary values of type ",
+                             value_type_->ToString(), " got ",
+                             array.dictionary()->type()->ToString());
+  }
+  if (array.dictionary() != dictionary_) {
+    RETURN_NOT_OK(Flush());
+    dictionary_ = array.dictionary();
+    counts_.assign(dictionary_->length(), 0);
+  }
+  auto indices = array.indices();
+  switch (indices->type_id()) {
+    case arrow::Type::INT8:
+      CountIndices<arrow::Int8Type>(*indices, counts_.data(), &null_count_);
+      break;
+    case arrow::Type::INT16:
+      CountIndices<arrow::Int16Type>(*indices, counts_.data(), &null_count_);
+      break;
+    case arrow::Type::INT32:
+      CountIndices<arrow::Int32Type>(*indices, counts_.data(), &null_count_);
+      break;
+    case arrow::Type::INT64:
+      CountIndices<arrow::Int64Type>(*indices, counts_.data(), &null_count_);
+      break;
+    default:
+      return Status::NotImplemented("Dictionary indices of type ",
+                                    indices->type()->ToString());
+  }
+  return Status::OK();
+}
+
+Status DictionaryCounter::Flush() {
+  if (dictionary_ == nullptr && null_count_ == 0) {
+    return Status::OK();
+  }
+  std::unique_ptr<arrow::ArrayBuilder> builder;
+  RETURN_NOT_OK(arrow::MakeBuilder(pool_, value_type_, &builder));
+  auto key_builder = static_cast<arrow::BinaryBuilder*>(builder.get());
+  arrow::Int64Builder count_builder(pool_);
+  if (dictionary_ != nullptr) {
+    auto& values = static_cast<const arrow::BinaryArray&>(*dictionary_);
+    for (int64_t i = 0; i < values.length(); i++) {
+      // entries that were not referenced must not create empty groups
+      if (counts_[i] == 0) {
+        continue;
+      }
+      if (values.IsNull(i)) {
+        RETURN_NOT_OK(key_builder->AppendNull());
+      } else {
+        RETURN_NOT_OK(key_builder->Append(values.GetView(i)));
+      }
+      RETURN_NOT_OK(count_builder.Append(counts_[i]));
+    }
+  }
+  if (null_count_ > 0) {
+    RETURN_NOT_OK(key_builder->AppendNull());
+    RETURN_NOT_OK(count_builder.Append(null_count_));
+  }
+  std::shared_ptr<arrow::Array> keys, counts;
+  RETURN_NOT_OK(key_builder->Finish(&keys));
+  RETURN_NOT_OK(count_builder.Finish(&counts));
+  auto partial = arrow::RecordBatch::Make(aggregator_->partial_schema(), keys->length(),
+                                          {keys, counts});
+  RETURN_NOT_OK(aggregator_->Merge(*partial));
+
+  std::fill(counts_.begin(), counts_.end(), 0);
+  null_count_ = 0;
+  return Status::OK();
+}
+
+std::shared_ptr<arrow::Schema> DictionaryCounter::partial_schema() const {
+  return aggregator_->partial_schema();
+}
+
+Result<std::shared_ptr<arrow::RecordBatch>> DictionaryCounter::Finish() {
+  RETURN_NOT_OK(Flush());
+  return aggregator_->Finish();
+}
+
+int64_t DictionaryCounter::num_groups() const { return aggregator_->num_groups(); }
+
+}  // namespace Buzz
@@ -0,0 +1,72 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+#include <result.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hash-aggregator.h"
+
+namespace Buzz {
+
+/// COUNT(*) grouped by a dictionary encoded string column.
+///
+/// Rows are counted on the dictionary indices in a dense array as long as the dictionary
+/// does not change (typically for a whole row group). When a new dictionary comes in,
+/// the dense counts are translated to the dictionary values and merged into a hash
+/// aggregator, so strings are only hashed once per dictionary entry.
+class DictionaryCounter {
+ public:
+  /// value_type is the type of the dictionary values (STRING or BINARY)
+  static Result<std::unique_ptr<DictionaryCounter>> Make(
+      const std::string& column_name, const std::shared_ptr<arrow::DataType>& value_type,
+      arrow::MemoryPool* pool = arrow::default_memory_pool());
+
+  /// Count the rows of a chunk, only the dictionary pointer is compared to detect a
+  /// dictionary change
+  Status Consume(const arrow::DictionaryArray& array);
+
+  /// Same partial aggregate format as HashAggregator with a COUNT(*) aggregate
+  std::shared_ptr<arrow::Schema> partial_schema() const;
+
+  /// Partial aggregates of all the groups seen so far
+  Result<std::shared_ptr<arrow::RecordBatch>> Finish();
+
+  /// Number of groups merged so far, the current dictionary is only merged by Finish()
+  int64_t num_groups() const;
+
+ private:
+  DictionaryCounter(std::unique_ptr<HashAggregator> aggregator,
+                    std::shared_ptr<arrow::DataType> value_type, arrow::MemoryPool* pool);
+
+  /// Merge the dense counts of the current dictionary into the global groups
+  Status Flush();
+
+  std::unique_ptr<HashAggregator> aggregator_;
+  std::shared_ptr<arrow::DataType> value_type_;
+  arrow::MemoryPool* pool_;
+  std::shared_ptr<arrow::Array> dictionary_;
+  std::vector<int64_t> counts_;
+  int64_t null_count_;
+};
+
+}  // namespace Buzz
@@ -0,0 +1,99 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "dictionary-aggregator.h"
+
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+
+#include <map>
+
+namespace Buzz {
+
+namespace {
+
+std::shared_ptr<arrow::DictionaryArray> MakeDictionaryArray(
+    const std::vector<std::string>& dictionary, const std::vector<int32_t>& indices,
+    const std::vector<bool>& is_valid = {}) {
+  arrow::StringBuilder dictionary_builder;
+  arrow::Int32Builder index_builder;
+  ARROW_EXPECT_OK(dictionary_builder.AppendValues(dictionary));
+  if (is_valid.empty()) {
+    ARROW_EXPECT_OK(index_builder.AppendValues(indices));
+  } else {
+    ARROW_EXPECT_OK(index_builder.AppendValues(indices, is_valid));
+  }
+  std::shared_ptr<arrow::Array> values, index_array;
+  ARROW_EXPECT_OK(dictionary_builder.Finish(&values));
+  ARROW_EXPECT_OK(index_builder.Finish(&index_array));
+  auto type = arrow::dictionary(arrow::int32(), arrow::utf8());
+  return std::make_shared<arrow::DictionaryArray>(type, index_array, values);
+}
+
+std::map<std::string, int64_t> ToMap(const arrow::RecordBatch& batch) {
+  auto keys = std::static_pointer_cast<arrow::StringArray>(batch.column(0));
+  auto counts = std::static_pointer_cast<arrow::Int64Array>(batch.column(1));
+  std::map<std::string, int64_t> result;
+  for (int64_t i = 0; i < batch.num_rows(); i++) {
+    result[keys->IsNull(i) ? "<null>" : keys->GetString(i)] = counts->Value(i);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(DictionaryCounter, ChangingDictionaries) {
+  auto counter = DictionaryCounter::Make("name", arrow::utf8()).ValueOrDie();
+  // two chunks of the same row group share their dictionary
+  auto first = MakeDictionaryArray({"a", "b", "unused"}, {0, 1, 1, 0, 1},
+                                   {true, true, true, false, true});
+  auto second = std::make_shared<arrow::DictionaryArray>(
+      first->type(), MakeDictionaryArray({}, {1, 1})->indices(),
+      first->dictionary());
+  // the next row group has a different dictionary order
+  auto third = MakeDictionaryArray({"c", "b"}, {0, 1, 1});
+  ASSERT_OK(counter->Consume(*first));
+  ASSERT_OK(counter->Consume(*second));
+  ASSERT_OK(counter->Consume(*third));
+
+  auto result = counter->Finish().ValueOrDie();
+  ASSERT_TRUE(result->schema()->Equals(*counter->partial_schema()));
+  std::map<std::string, int64_t> expected = {
+      {"a", 1}, {"b", 7}, {"c", 1}, {"<null>", 1}};
+  ASSERT_EQ(ToMap(*result), expected);
+  ASSERT_EQ(counter->num_groups(), 4);
+}
+
+TEST(DictionaryCounter, MergeWithHashAggregator) {
+  auto counter = DictionaryCounter::Make("name", arrow::utf8()).ValueOrDie();
+  ASSERT_OK(counter->Consume(*MakeDictionaryArray({"x", "y"}, {0, 0, 1})));
+  auto partial = counter->Finish().ValueOrDie();
+
+  auto hive = HashAggregator::MakeFromPartialSchema(partial->schema()).ValueOrDie();
+  ASSERT_OK(hive->Merge(*partial));
+  ASSERT_OK(hive->Merge(*partial));
+  std::map<std::string, int64_t> expected = {{"x", 4}, {"y", 2}};
+  ASSERT_EQ(ToMap(*hive->Finalize().ValueOrDie()), expected);
+}
+
+TEST(DictionaryCounter, InvalidTypes) {
+  ASSERT_RAISES(NotImplemented, DictionaryCounter::Make("value", arrow::float64()));
+  auto counter = DictionaryCounter::Make("name", arrow::binary()).ValueOrDie();
+  ASSERT_RAISES(TypeError, counter->Consume(*MakeDictionaryArray({"a"}, {0})));
+}
+
+}  // namespace Buzz
@@ -0,0 +1,97 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "dictionary-filter.h"
+
+#include <arrow/io/memory.h>
+#include <parquet/column_page.h>
+#include <parquet/column_reader.h>
+#include <parquet/exception.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Buzz {
+
+std::optional<DictionaryPageRange> GetPrunableDictionaryPage(
+    const parquet::ColumnChunkMetaData& col_chunck_meta) {
+  if (!col_chunck_meta.has_dictionary_page()) {
+    return std::nullopt;
+  }
+  auto& encodings = col_chunck_meta.encodings();
+  auto has_encoding = [&encodings](parquet::Encoding::type encoding) {
+    return std::find(encodings.begin(), encodings.end(), encoding) != encodings.end();
+  };
+  bool is_dict_encoded = has_encoding(parquet::Encoding::PLAIN_DICTIONARY) ||
+                         has_encoding(parquet::Encoding::RLE_DICTIONARY);
+  if (!is_dict_encoded || has_encoding(parquet::Encoding::PLAIN)) {
+    return std::nullopt;
+  }
+  auto dict_start = col_chunck_meta.dictionary_page_offset();
+  auto data_start = col_chunck_meta.data_page_offset();
+  if (dict_start >= data_start) {
+    return std::nullopt;
+  }
+  return DictionaryPageRange{dict_start, data_start - 1};
+}
+
+Result<bool> DictionaryContains(const std::shared_ptr<arrow::Buffer>& page_data,
+                                const parquet::ColumnChunkMetaData& col_chunck_meta,
+                                const std::string& value) {
+  if (col_chunck_meta.type() != parquet::Type::BYTE_ARRAY) {
+    return Status::NotImplemented("Dictionary probing only supports BYTE_ARRAY");
+  }
+  std::shared_ptr<parquet::Page> page;
+  try {
+    auto stream = std::make_shared<arrow::io::BufferReader>(page_data);
+    auto page_reader = parquet::PageReader::Open(stream, col_chunck_meta.num_values(),
+                                                 col_chunck_meta.compression());
+    page = page_reader->NextPage();
+  } catch (const parquet::ParquetException& e) {
+    return Status::IOError("Could not read dictionary page: ", e.what());
+  }
+  if (page == nullptr || page->type() != parquet::PageType::DICTIONARY_PAGE) {
+    return Status::IOError("First page of the range is not a dictionary page");
+  }
+  auto dict_page = std::static_pointer_cast<parquet::DictionaryPage>(page);
+  if (dict_page->encoding() != parquet::Encoding::PLAIN &&
+      dict_page->encoding() != parquet::Encoding::PLAIN_DICTIONARY) {
+    return Status::NotImplemented("Unexpected dictionary page encoding");
+  }
+
+  // PLAIN byte arrays: 4 bytes little endian length followed by the bytes
+  const uint8_t* data = dict_page->data();
+  const uint8_t* data_end = data + dict_page->size();
+  for (int32_t i = 0; i < dict_page->num_values(); i++) {
+    if (data + sizeof(uint32_t) > data_end) {
+      return Status::IOError("Truncated dictionary page");
+    }
+    uint32_t len;
+    memcpy(&len, data, sizeof(uint32_t));
+    data += sizeof(uint32_t);
+    if (data + len > data_end) {
+      return Status::IOError("Truncated dictionary page");
+    }
+    if (len == value.size() && memcmp(data, value.data(), len) == 0) {
+      return true;
+    }
+    data += len;
+  }
+  return false;
+}
+
+}  // namespace Buzz
@@ -0,0 +1,52 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <arrow/buffer.h>
+#include <parquet/metadata.h>
+#include <result.h>
+
+#include <optional>
+#include <string>
+
+namespace Buzz {
+
+/// Byte range of a dictionary page, inclusive like DownloadRequest
+struct DictionaryPageRange {
+  int64_t start;
+  int64_t end;
+
+  int64_t length() const { return end - start + 1; }
+};
+
+/// Get the dictionary page range of a column chunck if a value that is missing from the
+/// dictionary is guarantied to be missing from the whole chunck.
+///
+/// This is only the case if the writer did not fall back to plain encoding. Without the
+/// page encoding stats, a PLAIN entry in the chunck encodings is ambiguous (it can be the
+/// dictionary page itself or a fallback data page), so these chuncks are not prunable.
+std::optional<DictionaryPageRange> GetPrunableDictionaryPage(
+    const parquet::ColumnChunkMetaData& col_chunck_meta);
+
+/// Decode the dictionary page in `page_data` and look for `value` in it.
+/// Only BYTE_ARRAY columns are supported for now.
+Result<bool> DictionaryContains(const std::shared_ptr<arrow::Buffer>& page_data,
+                                const parquet::ColumnChunkMetaData& col_chunck_meta,
+                                const std::string& value);
+
+}  // namespace Buzz
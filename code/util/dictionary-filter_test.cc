@@ -0,0 +1,64 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "dictionary-filter.h"
+
+#include <arrow/api.h>
+#include <arrow/io/memory.h>
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/file_reader.h>
+
+namespace Buzz {
+
+namespace {
+std::shared_ptr<arrow::Buffer> WriteStringColumn(int nb_rows, int cardinality) {
+  arrow::StringBuilder builder;
+  for (int i = 0; i < nb_rows; i++) {
+    ARROW_EXPECT_OK(builder.Append("val" + std::to_string(i % cardinality)));
+  }
+  std::shared_ptr<arrow::Array> array;
+  ARROW_EXPECT_OK(builder.Finish(&array));
+  auto table = arrow::Table::Make(
+      arrow::schema({arrow::field("col", arrow::utf8())}), {array});
+  auto sink = arrow::io::BufferOutputStream::Create().ValueOrDie();
+  auto props = parquet::WriterProperties::Builder()
+                   .version(parquet::ParquetVersion::PARQUET_1_0)
+                   ->build();
+  ARROW_EXPECT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), sink,
+                                             nb_rows, props));
+  return sink->Finish().ValueOrDie();
+}
+}  // namespace
+
+TEST(DictionaryFilter, ProbeDictionaryPage) {
+  auto file_buffer = WriteStringColumn(1000, 10);
+  auto reader = parquet::ParquetFileReader::Open(
+      std::make_shared<arrow::io::BufferReader>(file_buffer));
+  auto col_chunck_meta = reader->metadata()->RowGroup(0)->ColumnChunk(0);
+
+  auto range = GetPrunableDictionaryPage(*col_chunck_meta);
+  ASSERT_TRUE(range.has_value());
+  auto page_data = arrow::SliceBuffer(file_buffer, range->start, range->length());
+
+  ASSERT_EQ(DictionaryContains(page_data, *col_chunck_meta, "val3"), Result<bool>(true));
+  ASSERT_EQ(DictionaryContains(page_data, *col_chunck_meta, "val10"),
+            Result<bool>(false));
+}
+
+}  // namespace Buzz
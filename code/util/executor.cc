@@ -0,0 +1,220 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "executor.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "mpmc-queue.h"
+
+namespace Buzz {
+
+namespace {
+/// capacity of the injection queue of each lane before it spills
+const size_t kInjectionCapacity = 4096;
+
+// the lane and worker of the current thread, if it is a worker
+thread_local const void* current_lane = nullptr;
+thread_local void* current_worker = nullptr;
+}  // namespace
+
+struct Executor::Worker {
+  std::mutex mutex;
+  std::deque<std::function<void()>> tasks;
+  std::thread thread;
+  std::minstd_rand rng;
+};
+
+struct Executor::LaneState {
+  explicit LaneState(size_t capacity) : injected(capacity) {}
+
+  SpillQueue<std::function<void()>> injected;
+  EventCount events;
+  std::mutex grow_mutex;
+  std::array<std::unique_ptr<Worker>, kMaxWorkers> workers;
+  std::atomic<int> nb_workers{0};
+};
+
+Executor& Executor::Default() {
+  static Executor executor(PlacementPolicy::Make(CpuTopology::Detect()));
+  return executor;
+}
+
+Executor::Executor(int cpu_threads, int io_threads) : Executor(PlacementPolicy()) {
+  Reserve(Lane::CPU, cpu_threads);
+  Reserve(Lane::IO, io_threads);
+}
+
+Executor::Executor(const PlacementPolicy& placement) : placement_(placement) {
+  for (auto& lane : lanes_) {
+    lane.reset(new LaneState(kInjectionCapacity));
+  }
+  Reserve(Lane::CPU, placement_.cpu_workers);
+}
+
+Executor::~Executor() {
+  stop_.store(true);
+  for (auto& lane : lanes_) {
+    lane->events.NotifyAll();
+  }
+  for (auto& lane : lanes_) {
+    std::lock_guard<std::mutex> lock(lane->grow_mutex);
+    for (int i = 0; i < lane->nb_workers.load(); i++) {
+      lane->workers[i]->thread.join();
+    }
+  }
+}
+
+void Executor::Submit(Lane lane_id, std::function<void()> task) {
+  auto lane = lanes_[static_cast<int>(lane_id)].get();
+  if (current_lane == lane) {
+    auto self = static_cast<Worker*>(current_worker);
+    std::lock_guard<std::mutex> lock(self->mutex);
+    self->tasks.push_back(std::move(task));
+  } else {
+    if (lane->nb_workers.load() == 0) {
+      Reserve(lane_id, 1);
+    }
+    lane->injected.Push(std::move(task));
+  }
+  lane->events.NotifyOne();
+}
+
+void Executor::Reserve(Lane lane_id, int nb_threads) {
+  auto lane = lanes_[static_cast<int>(lane_id)].get();
+  std::lock_guard<std::mutex> lock(lane->grow_mutex);
+  for (int i = lane->nb_workers.load(); i < std::min(nb_threads, kMaxWorkers); i++) {
+    auto worker = new Worker();
+    worker->rng.seed(i + 1);
+    lane->workers[i].reset(worker);
+    // published before it runs, the thieves only look at the first nb_workers
+    lane->nb_workers.store(i + 1);
+    std::vector<int> cpus;
+    if (placement_.pinned() && lane_id == Lane::IO) {
+      cpus = placement_.io_cpus;
+    } else if (placement_.pinned()) {
+      auto& worker_cpus = placement_.cpu_worker_cpus;
+      cpus = {worker_cpus[i % worker_cpus.size()]};
+    }
+    worker->thread = std::thread([this, lane, worker, cpus]() {
+      // the placement is best effort, e.g. the affinity mask may have changed since
+      if (!cpus.empty()) {
+        (void)PinCurrentThread(cpus);
+      }
+      Run(lane, worker);
+    });
+  }
+}
+
+int Executor::num_threads(Lane lane_id) const {
+  return lanes_[static_cast<int>(lane_id)]->nb_workers.load();
+}
+
+void Executor::Run(LaneState* lane, Worker* self) {
+  current_lane = lane;
+  current_worker = self;
+  std::function<void()> task;
+  while (true) {
+    if (TryTake(lane, self, &task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+    // check again once registered as a waiter, not to miss a notification
+    auto key = lane->events.PrepareWait();
+    if (TryTake(lane, self, &task)) {
+      lane->events.CancelWait();
+      task();
+      task = nullptr;
+      continue;
+    }
+    if (stop_.load()) {
+      lane->events.CancelWait();
+      return;
+    }
+    lane->events.Wait(key);
+  }
+}
+
+bool Executor::TryTake(LaneState* lane, Worker* self, std::function<void()>* task) {
+  {
+    std::lock_guard<std::mutex> lock(self->mutex);
+    if (!self->tasks.empty()) {
+      *task = std::move(self->tasks.back());
+      self->tasks.pop_back();
+      return true;
+    }
+  }
+  if (lane->injected.TryPop(task)) {
+    return true;
+  }
+  // steal the oldest task of another worker, starting from a random one
+  auto nb_workers = lane->nb_workers.load();
+  auto first = self->rng() % nb_workers;
+  for (int i = 0; i < nb_workers; i++) {
+    auto victim = lane->workers[(first + i) % nb_workers].get();
+    if (victim == self) {
+      continue;
+    }
+    std::lock_guard<std::mutex> lock(victim->mutex);
+    if (!victim->tasks.empty()) {
+      *task = std::move(victim->tasks.front());
+      victim->tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void Executor::ParallelFor(int parallelism, const std::function<void(int)>& work) {
+  struct Helpers {
+    std::mutex mutex;
+    std::condition_variable done;
+    bool closed = false;
+    int running = 0;
+  };
+  auto helpers = std::make_shared<Helpers>();
+  for (int i = 1; i < parallelism; i++) {
+    Submit(Lane::CPU, [helpers, &work, i]() {
+      {
+        std::lock_guard<std::mutex> lock(helpers->mutex);
+        if (helpers->closed) {
+          return;
+        }
+        helpers->running++;
+      }
+      work(i);
+      std::lock_guard<std::mutex> lock(helpers->mutex);
+      if (--helpers->running == 0) {
+        helpers->done.notify_all();
+      }
+    });
+  }
+  if (parallelism > 0) {
+    work(0);
+  }
+  std::unique_lock<std::mutex> lock(helpers->mutex);
+  helpers->closed = true;
+  helpers->done.wait(lock, [&helpers]() { return helpers->running == 0; });
+}
+
+}  // namespace Buzz
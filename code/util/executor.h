@@ -0,0 +1,83 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "cpu-topology.h"
+
+namespace Buzz {
+
+/// IO tasks mostly block (e.g. downloads), CPU tasks keep their core busy (e.g.
+/// decompression). They run on separate workers so that blocked IO tasks never delay
+/// the CPU tasks, and the CPU lane is sized to the cores.
+enum class Lane : int { IO = 0, CPU = 1 };
+
+/// Work-stealing thread pool shared by the subsystems of a process.
+///
+/// Each worker owns a deque: the tasks it submits go to the back of its own deque and
+/// it runs them LIFO while they are hot in cache, idle workers of the same lane steal
+/// from the front of the others. Tasks submitted from outside the lane go through a
+/// lock-free injection queue. Idle workers sleep on an EventCount.
+class Executor {
+ public:
+  /// The CPU lane is sized and placed by the PlacementPolicy of the detected
+  /// CpuTopology, the IO lane grows with Reserve()
+  static Executor& Default();
+
+  /// Unpinned workers
+  Executor(int cpu_threads, int io_threads);
+  /// The workers are pinned as they start, the IO lane starts empty
+  explicit Executor(const PlacementPolicy& placement);
+  /// Runs the tasks already submitted, then stops the workers
+  ~Executor();
+
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  void Submit(Lane lane, std::function<void()> task);
+
+  /// Grow the lane to at least `nb_threads` workers, capped to kMaxWorkers
+  void Reserve(Lane lane, int nb_threads);
+
+  int num_threads(Lane lane) const;
+
+  /// Run `work(i)` for i in [0, parallelism) concurrently on the CPU lane, the calling
+  /// thread runs `work(0)`. The work is expected to be shared through a common counter:
+  /// the calls that did not start by the time the caller is done are skipped, so that
+  /// it never waits on a busy lane (nor deadlocks when called from a CPU worker).
+  void ParallelFor(int parallelism, const std::function<void(int)>& work);
+
+  static constexpr int kMaxWorkers = 256;
+
+ private:
+  struct Worker;
+  struct LaneState;
+
+  void Run(LaneState* lane, Worker* self);
+  bool TryTake(LaneState* lane, Worker* self, std::function<void()>* task);
+
+  PlacementPolicy placement_;
+  std::array<std::unique_ptr<LaneState>, 2> lanes_;
+  std::atomic<bool> stop_{false};
+};
+
+}  // namespace Buzz
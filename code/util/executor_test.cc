@@ -0,0 +1,129 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "executor.h"
+
+#include <gtest/gtest.h>
+#include <sched.h>
+
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace Buzz {
+
+namespace {
+/// Wait until `counter` reaches `expected`, false on timeout
+bool WaitFor(const std::atomic<int>& counter, int expected) {
+  for (int i = 0; i < 10000 && counter.load() < expected; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return counter.load() == expected;
+}
+}  // namespace
+
+TEST(Executor, RunsTasksOnBothLanes) {
+  Executor executor(2, 1);
+  std::atomic<int> done{0};
+  for (int i = 0; i < 100; i++) {
+    executor.Submit(i % 2 == 0 ? Lane::CPU : Lane::IO, [&done]() { done++; });
+  }
+  ASSERT_TRUE(WaitFor(done, 100));
+  ASSERT_EQ(executor.num_threads(Lane::CPU), 2);
+  ASSERT_EQ(executor.num_threads(Lane::IO), 1);
+  executor.Reserve(Lane::IO, 3);
+  ASSERT_EQ(executor.num_threads(Lane::IO), 3);
+}
+
+TEST(Executor, StealsTasksSubmittedByAWorker) {
+  Executor executor(4, 0);
+  std::atomic<int> done{0};
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  executor.Submit(Lane::CPU, [&]() {
+    // all the tasks go to the deque of this worker, the others have to steal them
+    for (int i = 0; i < 40; i++) {
+      executor.Submit(Lane::CPU, [&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+        done++;
+      });
+    }
+  });
+  ASSERT_TRUE(WaitFor(done, 40));
+  ASSERT_GT(threads.size(), 1);
+}
+
+TEST(Executor, BlockedIoDoesNotDelayCpu) {
+  Executor executor(1, 1);
+  std::atomic<bool> release{false};
+  std::atomic<int> done{0};
+  executor.Submit(Lane::IO, [&]() {
+    while (!release.load()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  executor.Submit(Lane::CPU, [&done]() { done++; });
+  ASSERT_TRUE(WaitFor(done, 1));
+  release.store(true);
+}
+
+TEST(Executor, ParallelForFromAWorker) {
+  // with a single CPU worker busy in the outer loop, the inner helpers never start
+  Executor executor(1, 0);
+  std::atomic<int> done{0};
+  executor.Submit(Lane::CPU, [&]() {
+    std::atomic<int> next{0};
+    std::atomic<int> sum{0};
+    executor.ParallelFor(4, [&](int) {
+      for (auto i = next++; i < 100; i = next++) {
+        sum += i;
+      }
+    });
+    if (sum.load() == 4950) {
+      done++;
+    }
+  });
+  ASSERT_TRUE(WaitFor(done, 1));
+}
+
+TEST(Executor, PinsWorkersToThePlacement) {
+  auto cpu = CpuTopology::Detect().cores[0][0];
+  PlacementPolicy placement;
+  placement.cpu_workers = 2;
+  placement.io_cpus = {cpu};
+  placement.cpu_worker_cpus = {cpu};
+  Executor executor(placement);
+  ASSERT_EQ(executor.num_threads(Lane::CPU), 2);
+  ASSERT_EQ(executor.num_threads(Lane::IO), 0);
+  std::atomic<int> done{0};
+  std::atomic<int> pinned{0};
+  for (auto lane : {Lane::CPU, Lane::CPU, Lane::IO}) {
+    executor.Submit(lane, [&]() {
+      if (sched_getcpu() == cpu) {
+        pinned++;
+      }
+      done++;
+    });
+  }
+  ASSERT_TRUE(WaitFor(done, 3));
+  ASSERT_EQ(pinned.load(), 3);
+}
+
+}  // namespace Buzz
@@ -0,0 +1,55 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "footer-aggregates.h"
+
+namespace Buzz {
+
+bool IsFooterAggregate(const AggregateSpec& spec) {
+  switch (spec.kind) {
+    case AggregateKind::Count:
+    case AggregateKind::Min:
+    case AggregateKind::Max:
+      return true;
+    default:
+      return false;
+  }
+}
+
+Status CheckFooterStatsSupport(const parquet::ColumnDescriptor& descr) {
+  if (descr.max_repetition_level() > 0) {
+    return Status::NotImplemented("Footer statistics of repeated column ", descr.name(),
+                                  " count the leaf values, not the rows");
+  }
+  switch (descr.physical_type()) {
+    case parquet::Type::INT32:
+    case parquet::Type::INT64:
+    case parquet::Type::FLOAT:
+    case parquet::Type::DOUBLE:
+      break;
+    default:
+      return Status::NotImplemented("Footer statistics of column ", descr.name(),
+                                    " might not be exact for its physical type");
+  }
+  // unsigned logical types are ordered differently than their physical type
+  if (descr.sort_order() != parquet::SortOrder::SIGNED) {
+    return Status::NotImplemented("Column ", descr.name(), " is not signed");
+  }
+  return Status::OK();
+}
+
+}  // namespace Buzz
@@ -0,0 +1,97 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <parquet/metadata.h>
+#include <parquet/statistics.h>
+#include <result.h>
+
+#include <vector>
+
+#include "hash-aggregator.h"
+#include "stats.h"
+
+namespace Buzz {
+
+/// COUNT, MIN and MAX can be answered from the row group statistics of the footer
+bool IsFooterAggregate(const AggregateSpec& spec);
+
+/// Fail if the footer statistics of the column cannot be trusted to be exact: only flat
+/// numeric columns with a signed sort order are supported (writers are allowed to
+/// truncate the min and max of binary columns).
+Status CheckFooterStatsSupport(const parquet::ColumnDescriptor& descr);
+
+/// Count, null count, min and max of a column, merged from the footer statistics of the
+/// row groups that have exact statistics
+template <typename DType>
+struct FooterStats {
+  using CType = typename DType::c_type;
+
+  int64_t count = 0;
+  int64_t null_count = 0;
+  /// only meaningful if count > 0
+  CType min = stats::MinIdentity<CType>();
+  CType max = stats::MaxIdentity<CType>();
+  /// row groups that are not included above and must be scanned
+  std::vector<int> row_groups_to_scan;
+
+  /// Include a row group that had to be scanned
+  void Merge(const ColumnStats<DType>& scanned) {
+    count += scanned.count();
+    null_count += scanned.null_count();
+    min = scanned.min() < min ? scanned.min() : min;
+    max = scanned.max() > max ? scanned.max() : max;
+  }
+};
+
+/// Collect the statistics of `column` from the footer without reading any data. DType
+/// must be one of the numeric physical types accepted by CheckFooterStatsSupport().
+template <typename DType>
+Result<FooterStats<DType>> GetFooterStats(const parquet::FileMetaData& metadata,
+                                          int column) {
+  RETURN_NOT_OK(CheckFooterStatsSupport(*metadata.schema()->Column(column)));
+  FooterStats<DType> result;
+  for (int rg = 0; rg < metadata.num_row_groups(); rg++) {
+    auto col_chunck_meta = metadata.RowGroup(rg)->ColumnChunk(column);
+    // is_stats_set() also rejects the statistics of writers known to get them wrong
+    if (!col_chunck_meta->is_stats_set()) {
+      result.row_groups_to_scan.push_back(rg);
+      continue;
+    }
+    auto stats = col_chunck_meta->statistics();
+    if (!stats->HasNullCount()) {
+      result.row_groups_to_scan.push_back(rg);
+      continue;
+    }
+    auto count = col_chunck_meta->num_values() - stats->null_count();
+    if (count > 0 && !stats->HasMinMax()) {
+      result.row_groups_to_scan.push_back(rg);
+      continue;
+    }
+    result.count += count;
+    result.null_count += stats->null_count();
+    if (count > 0) {
+      auto& typed_stats = static_cast<const parquet::TypedStatistics<DType>&>(*stats);
+      result.min = typed_stats.min() < result.min ? typed_stats.min() : result.min;
+      result.max = typed_stats.max() > result.max ? typed_stats.max() : result.max;
+    }
+  }
+  return result;
+}
+
+}  // namespace Buzz
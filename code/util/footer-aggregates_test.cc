@@ -0,0 +1,101 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "footer-aggregates.h"
+
+#include <arrow/api.h>
+#include <arrow/io/memory.h>
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/file_reader.h>
+
+namespace Buzz {
+
+namespace {
+
+/// 1000 rows in row groups of 300: "ts" = i * 10 with a null every 100 rows
+/// and "name" = "n" + i
+std::shared_ptr<parquet::FileMetaData> WriteFile(bool with_stats) {
+  arrow::Int64Builder ts_builder;
+  arrow::StringBuilder name_builder;
+  for (int i = 0; i < 1000; i++) {
+    if (i % 100 == 50) {
+      ARROW_EXPECT_OK(ts_builder.AppendNull());
+    } else {
+      ARROW_EXPECT_OK(ts_builder.Append(i * 10));
+    }
+    ARROW_EXPECT_OK(name_builder.Append("n" + std::to_string(i)));
+  }
+  std::shared_ptr<arrow::Array> ts, names;
+  ARROW_EXPECT_OK(ts_builder.Finish(&ts));
+  ARROW_EXPECT_OK(name_builder.Finish(&names));
+  auto table = arrow::Table::Make(arrow::schema({arrow::field("ts", arrow::int64()),
+                                                 arrow::field("name", arrow::utf8())}),
+                                  {ts, names});
+  auto sink = arrow::io::BufferOutputStream::Create().ValueOrDie();
+  parquet::WriterProperties::Builder props_builder;
+  if (!with_stats) {
+    props_builder.disable_statistics();
+  }
+  ARROW_EXPECT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), sink,
+                                             300, props_builder.build()));
+  auto reader = parquet::ParquetFileReader::Open(
+      std::make_shared<arrow::io::BufferReader>(sink->Finish().ValueOrDie()));
+  return reader->metadata();
+}
+
+}  // namespace
+
+TEST(FooterAggregates, ExactStats) {
+  auto metadata = WriteFile(true);
+  ASSERT_EQ(metadata->num_row_groups(), 4);
+  auto stats = GetFooterStats<parquet::Int64Type>(*metadata, 0).ValueOrDie();
+  ASSERT_TRUE(stats.row_groups_to_scan.empty());
+  ASSERT_EQ(stats.count, 990);
+  ASSERT_EQ(stats.null_count, 10);
+  ASSERT_EQ(stats.min, 0);
+  ASSERT_EQ(stats.max, 9990);
+}
+
+TEST(FooterAggregates, MissingStats) {
+  auto metadata = WriteFile(false);
+  auto stats = GetFooterStats<parquet::Int64Type>(*metadata, 0).ValueOrDie();
+  ASSERT_EQ(stats.row_groups_to_scan, std::vector<int>({0, 1, 2, 3}));
+  ASSERT_EQ(stats.count, 0);
+
+  // the scanned row groups are merged afterwards
+  ColumnStats<parquet::Int64Type> scanned;
+  std::vector<int64_t> values = {-5, 7};
+  scanned.Update(values.data(), 2, 3);
+  stats.Merge(scanned);
+  ASSERT_EQ(stats.count, 2);
+  ASSERT_EQ(stats.null_count, 1);
+  ASSERT_EQ(stats.min, -5);
+  ASSERT_EQ(stats.max, 7);
+}
+
+TEST(FooterAggregates, Support) {
+  auto metadata = WriteFile(true);
+  ASSERT_OK(CheckFooterStatsSupport(*metadata->schema()->Column(0)));
+  ASSERT_RAISES(NotImplemented, CheckFooterStatsSupport(*metadata->schema()->Column(1)));
+  ASSERT_TRUE(IsFooterAggregate({AggregateKind::Count, ""}));
+  ASSERT_TRUE(IsFooterAggregate({AggregateKind::Max, "ts"}));
+  ASSERT_FALSE(IsFooterAggregate({AggregateKind::Sum, "ts"}));
+}
+
+}  // namespace Buzz
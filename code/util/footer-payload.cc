@@ -0,0 +1,271 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "footer-payload.h"
+
+#include <arrow/io/memory.h>
+#include <arrow/util/base64.h>
+#include <parquet/exception.h>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <numeric>
+
+namespace Buzz {
+
+Result<std::vector<int>> FooterPayload::AssignedRowGroups(int num_row_groups) const {
+  if (row_groups.has_value()) {
+    for (auto row_group : row_groups.value()) {
+      if (row_group < 0 || row_group >= num_row_groups) {
+        return Status::Invalid("Payload row group ", row_group, " out of range for ",
+                               num_row_groups, " row groups");
+      }
+    }
+    return row_groups.value();
+  }
+  std::vector<int> all_row_groups(num_row_groups);
+  std::iota(all_row_groups.begin(), all_row_groups.end(), 0);
+  return all_row_groups;
+}
+
+Result<std::string> SerializeFooter(const parquet::FileMetaData& metadata) {
+  ARROW_ASSIGN_OR_RAISE(auto stream, arrow::io::BufferOutputStream::Create());
+  try {
+    metadata.WriteTo(stream.get());
+  } catch (const parquet::ParquetException& e) {
+    return Status::IOError("Could not serialize footer: ", e.what());
+  }
+  ARROW_ASSIGN_OR_RAISE(auto buffer, stream->Finish());
+  return arrow::util::base64_encode(buffer->data(),
+                                    static_cast<unsigned int>(buffer->size()));
+}
+
+Result<std::shared_ptr<parquet::FileMetaData>> DeserializeFooter(
+    const std::string& encoded) {
+  auto serialized = arrow::util::base64_decode(encoded);
+  auto length = static_cast<uint32_t>(serialized.size());
+  try {
+    return parquet::FileMetaData::Make(serialized.data(), &length);
+  } catch (const parquet::ParquetException& e) {
+    return Status::Invalid("Could not deserialize footer: ", e.what());
+  }
+}
+
+namespace {
+
+using JsonWriter = rapidjson::Writer<rapidjson::StringBuffer>;
+
+/// Write the JSON object of one file, with its key if not empty
+Status WriteFileObject(const std::string& key, const parquet::FileMetaData& metadata,
+                       const std::vector<int>& row_groups, PayloadFooter footer_kind,
+                       JsonWriter& writer) {
+  for (auto row_group : row_groups) {
+    if (row_group < 0 || row_group >= metadata.num_row_groups()) {
+      return Status::Invalid("Row group ", row_group, " out of range");
+    }
+  }
+  std::string footer;
+  if (footer_kind == PayloadFooter::Subset) {
+    ARROW_ASSIGN_OR_RAISE(footer, SerializeFooter(*metadata.Subset(row_groups)));
+  } else if (footer_kind == PayloadFooter::Full) {
+    ARROW_ASSIGN_OR_RAISE(footer, SerializeFooter(metadata));
+  }
+
+  writer.StartObject();
+  if (!key.empty()) {
+    writer.Key("key");
+    writer.String(key.data(), static_cast<rapidjson::SizeType>(key.size()));
+  }
+  if (footer_kind != PayloadFooter::None) {
+    writer.Key("footer");
+    writer.String(footer.data(), static_cast<rapidjson::SizeType>(footer.size()));
+  }
+  if (footer_kind != PayloadFooter::Subset) {
+    writer.Key("row_groups");
+    writer.StartArray();
+    for (auto row_group : row_groups) {
+      writer.Int(row_group);
+    }
+    writer.EndArray();
+  }
+  writer.EndObject();
+  return Status::OK();
+}
+
+Result<FooterPayload> ParseFileObject(const rapidjson::Value& document) {
+  FooterPayload result;
+  auto key = document.FindMember("key");
+  if (key != document.MemberEnd()) {
+    if (!key->value.IsString()) {
+      return Status::Invalid("Payload key should be a string");
+    }
+    result.key = std::string(key->value.GetString(), key->value.GetStringLength());
+  }
+  auto footer = document.FindMember("footer");
+  if (footer != document.MemberEnd()) {
+    if (!footer->value.IsString()) {
+      return Status::Invalid("Payload footer should be a base64 string");
+    }
+    ARROW_ASSIGN_OR_RAISE(
+        result.file_metadata,
+        DeserializeFooter(
+            std::string(footer->value.GetString(), footer->value.GetStringLength())));
+  }
+  auto row_groups = document.FindMember("row_groups");
+  if (row_groups != document.MemberEnd()) {
+    if (!row_groups->value.IsArray()) {
+      return Status::Invalid("Payload row_groups should be an array");
+    }
+    result.row_groups.emplace();
+    for (auto& row_group : row_groups->value.GetArray()) {
+      if (!row_group.IsInt()) {
+        return Status::Invalid("Payload row_groups should be integers");
+      }
+      result.row_groups->push_back(row_group.GetInt());
+    }
+  }
+  if (result.file_metadata != nullptr && result.row_groups.has_value()) {
+    for (auto row_group : result.row_groups.value()) {
+      if (row_group < 0 || row_group >= result.file_metadata->num_row_groups()) {
+        return Status::Invalid("Payload row group ", row_group, " out of range");
+      }
+    }
+  }
+  return result;
+}
+
+Status ParseDocument(const std::string& payload, rapidjson::Document& document) {
+  document.Parse(payload.c_str());
+  if (document.HasParseError() || !document.IsObject()) {
+    return Status::Invalid("Invocation payload is not a JSON object");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Result<std::string> MakeFooterPayload(const parquet::FileMetaData& metadata,
+                                      const std::vector<int>& row_groups,
+                                      PayloadFooter footer) {
+  rapidjson::StringBuffer buffer;
+  JsonWriter writer(buffer);
+  RETURN_NOT_OK(WriteFileObject("", metadata, row_groups, footer, writer));
+  return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+Result<FooterPayload> ParseFooterPayload(const std::string& payload) {
+  if (payload.empty()) {
+    return FooterPayload{};
+  }
+  rapidjson::Document document;
+  RETURN_NOT_OK(ParseDocument(payload, document));
+  return ParseFileObject(document);
+}
+
+Result<std::string> MakeTaskPayload(const std::vector<FileAssignment>& files,
+                                    PayloadFooter footer) {
+  rapidjson::StringBuffer buffer;
+  JsonWriter writer(buffer);
+  writer.StartObject();
+  writer.Key("files");
+  writer.StartArray();
+  for (auto& file : files) {
+    RETURN_NOT_OK(
+        WriteFileObject(file.key, *file.metadata, file.row_groups, footer, writer));
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+Result<std::string> MakeBoundedTaskPayload(const std::vector<FileAssignment>& files,
+                                           PayloadFooter footer, size_t max_bytes) {
+  while (true) {
+    ARROW_ASSIGN_OR_RAISE(auto payload, MakeTaskPayload(files, footer));
+    if (payload.size() <= max_bytes) {
+      return payload;
+    }
+    if (footer == PayloadFooter::None) {
+      return Status::Invalid("Payload of ", payload.size(),
+                             " bytes exceeds the limit of ", max_bytes, " bytes");
+    }
+    footer = footer == PayloadFooter::Full ? PayloadFooter::Subset : PayloadFooter::None;
+  }
+}
+
+Result<std::vector<FooterPayload>> ParseTaskPayload(const std::string& payload) {
+  if (payload.empty()) {
+    return std::vector<FooterPayload>{FooterPayload{}};
+  }
+  rapidjson::Document document;
+  RETURN_NOT_OK(ParseDocument(payload, document));
+  auto files = document.FindMember("files");
+  if (files == document.MemberEnd()) {
+    ARROW_ASSIGN_OR_RAISE(auto file, ParseFileObject(document));
+    return std::vector<FooterPayload>{file};
+  }
+  if (!files->value.IsArray() || files->value.Empty()) {
+    return Status::Invalid("Payload files should be a non empty array");
+  }
+  std::vector<FooterPayload> result;
+  for (auto& file_object : files->value.GetArray()) {
+    if (!file_object.IsObject()) {
+      return Status::Invalid("Payload files should be objects");
+    }
+    ARROW_ASSIGN_OR_RAISE(auto file, ParseFileObject(file_object));
+    result.push_back(std::move(file));
+  }
+  return result;
+}
+
+Result<std::string> SetPayloadTaskId(const std::string& payload, int task_id) {
+  rapidjson::Document document;
+  if (payload.empty()) {
+    document.SetObject();
+  } else {
+    RETURN_NOT_OK(ParseDocument(payload, document));
+  }
+  auto member = document.FindMember("task_id");
+  if (member != document.MemberEnd()) {
+    member->value.SetInt(task_id);
+  } else {
+    document.AddMember("task_id", task_id, document.GetAllocator());
+  }
+  rapidjson::StringBuffer buffer;
+  JsonWriter writer(buffer);
+  document.Accept(writer);
+  return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+Result<std::optional<int>> GetPayloadTaskId(const std::string& payload) {
+  if (payload.empty()) {
+    return std::nullopt;
+  }
+  rapidjson::Document document;
+  RETURN_NOT_OK(ParseDocument(payload, document));
+  auto member = document.FindMember("task_id");
+  if (member == document.MemberEnd()) {
+    return std::nullopt;
+  }
+  if (!member->value.IsInt()) {
+    return Status::Invalid("Payload task_id should be an integer");
+  }
+  return member->value.GetInt();
+}
+
+}  // namespace Buzz
@@ -0,0 +1,108 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <parquet/metadata.h>
+#include <result.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Buzz {
+
+/// Footer and row groups that the scheduler assigns to a bee in its invocation payload,
+/// so that the bee can start downloading column chuncks without fetching the footer.
+///
+/// The payload is a JSON object {"footer": "<base64 thrift FileMetaData>",
+/// "row_groups": [ids]} where both fields are optional. A task spanning several files
+/// of the bucket is sent as {"files": [{"key": "<object key>", "footer": ...,
+/// "row_groups": ...}]}.
+struct FooterPayload {
+  /// object key of the file, empty for the default file of the bee
+  std::string key;
+  /// nullptr if the payload has no footer, the bee must then fetch it
+  std::shared_ptr<parquet::FileMetaData> file_metadata;
+  /// row groups to read, all of them if not set
+  std::optional<std::vector<int>> row_groups;
+
+  /// The assigned row groups out of the `num_row_groups` of the footer, Invalid if one
+  /// of them is not in the footer
+  Result<std::vector<int>> AssignedRowGroups(int num_row_groups) const;
+};
+
+/// Footer sent to a bee along with its row groups
+enum class PayloadFooter {
+  /// only the row groups, the bee fetches the footer itself
+  None,
+  Full,
+  /// only the metadata of the assigned row groups, see MakeFooterPayload()
+  Subset,
+};
+
+/// Largest payload of an asynchronous (Event) Lambda invocation
+inline constexpr size_t kMaxPayloadBytes = 256 * 1024;
+
+/// Serialize the footer as base64 encoded thrift
+Result<std::string> SerializeFooter(const parquet::FileMetaData& metadata);
+
+Result<std::shared_ptr<parquet::FileMetaData>> DeserializeFooter(
+    const std::string& encoded);
+
+/// Payload for a bee that reads `row_groups` of the file described by `metadata`.
+///
+/// With PayloadFooter::Subset, only the metadata of the assigned row groups is sent. They
+/// are renumbered from 0 in the subset and the bee reads all of them, which keeps the
+/// payload small for files with many row groups (the column chunck offsets are absolute
+/// so the subset can still be used to read the original file).
+Result<std::string> MakeFooterPayload(const parquet::FileMetaData& metadata,
+                                      const std::vector<int>& row_groups,
+                                      PayloadFooter footer);
+
+/// Parse an invocation payload, an empty payload has neither footer nor row groups
+Result<FooterPayload> ParseFooterPayload(const std::string& payload);
+
+/// Row groups of one file in a bee task
+struct FileAssignment {
+  std::string key;
+  std::shared_ptr<parquet::FileMetaData> metadata;
+  std::vector<int> row_groups;
+};
+
+/// Payload for a bee that reads row groups of several files, `footer` is applied to each
+/// file as in MakeFooterPayload()
+Result<std::string> MakeTaskPayload(const std::vector<FileAssignment>& files,
+                                    PayloadFooter footer);
+
+/// MakeTaskPayload() that falls back to smaller footers until the payload fits in
+/// `max_bytes`: from the full footers to their subsets, then to no footer at all
+Result<std::string> MakeBoundedTaskPayload(const std::vector<FileAssignment>& files,
+                                           PayloadFooter footer, size_t max_bytes);
+
+/// Parse a payload made by MakeTaskPayload() or MakeFooterPayload(), the latter gives a
+/// single file with an empty key. A task always has at least one file.
+Result<std::vector<FooterPayload>> ParseTaskPayload(const std::string& payload);
+
+/// Add the id of the task to a payload as "task_id", the bee tags its result with it
+Result<std::string> SetPayloadTaskId(const std::string& payload, int task_id);
+
+/// The task id of a payload, if any
+Result<std::optional<int>> GetPayloadTaskId(const std::string& payload);
+
+}  // namespace Buzz
@@ -0,0 +1,183 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "footer-payload.h"
+
+#include <arrow/api.h>
+#include <arrow/io/memory.h>
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/column_reader.h>
+#include <parquet/file_reader.h>
+
+namespace Buzz {
+
+namespace {
+
+/// 1000 rows of "value" = i in row groups of 250
+std::shared_ptr<arrow::Buffer> WriteFile() {
+  arrow::Int64Builder builder;
+  for (int i = 0; i < 1000; i++) {
+    ARROW_EXPECT_OK(builder.Append(i));
+  }
+  std::shared_ptr<arrow::Array> values;
+  ARROW_EXPECT_OK(builder.Finish(&values));
+  auto table = arrow::Table::Make(
+      arrow::schema({arrow::field("value", arrow::int64())}), {values});
+  auto sink = arrow::io::BufferOutputStream::Create().ValueOrDie();
+  ARROW_EXPECT_OK(
+      parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), sink, 250));
+  return sink->Finish().ValueOrDie();
+}
+
+int64_t ReadFirstValue(const std::shared_ptr<arrow::Buffer>& file_buffer,
+                       const std::shared_ptr<parquet::FileMetaData>& metadata, int rg) {
+  auto reader = parquet::ParquetFileReader::Open(
+      std::make_shared<arrow::io::BufferReader>(file_buffer),
+      parquet::default_reader_properties(), metadata);
+  auto col_reader = reader->RowGroup(rg)->Column(0);
+  auto typed_reader = static_cast<parquet::Int64Reader*>(col_reader.get());
+  int64_t value;
+  int64_t values_read;
+  typed_reader->ReadBatch(1, nullptr, nullptr, &value, &values_read);
+  EXPECT_EQ(values_read, 1);
+  return value;
+}
+
+}  // namespace
+
+TEST(FooterPayload, FullFooter) {
+  auto file_buffer = WriteFile();
+  auto metadata = parquet::ParquetFileReader::Open(
+                      std::make_shared<arrow::io::BufferReader>(file_buffer))
+                      ->metadata();
+  auto payload = MakeFooterPayload(*metadata, {1, 3}, PayloadFooter::Full).ValueOrDie();
+
+  auto parsed = ParseFooterPayload(payload).ValueOrDie();
+  ASSERT_NE(parsed.file_metadata, nullptr);
+  ASSERT_TRUE(parsed.file_metadata->Equals(*metadata));
+  ASSERT_EQ(parsed.AssignedRowGroups(4).ValueOrDie(), std::vector<int>({1, 3}));
+  ASSERT_EQ(ReadFirstValue(file_buffer, parsed.file_metadata, 3), 750);
+}
+
+TEST(FooterPayload, SubsetFooter) {
+  auto file_buffer = WriteFile();
+  auto metadata = parquet::ParquetFileReader::Open(
+                      std::make_shared<arrow::io::BufferReader>(file_buffer))
+                      ->metadata();
+  auto payload = MakeFooterPayload(*metadata, {1, 3}, PayloadFooter::Subset).ValueOrDie();
+
+  auto parsed = ParseFooterPayload(payload).ValueOrDie();
+  ASSERT_EQ(parsed.file_metadata->num_row_groups(), 2);
+  ASSERT_EQ(parsed.file_metadata->num_rows(), 500);
+  ASSERT_FALSE(parsed.row_groups.has_value());
+  ASSERT_EQ(parsed.AssignedRowGroups(2).ValueOrDie(), std::vector<int>({0, 1}));
+  // the subset still points to the chuncks of the original file
+  ASSERT_EQ(ReadFirstValue(file_buffer, parsed.file_metadata, 0), 250);
+  ASSERT_EQ(ReadFirstValue(file_buffer, parsed.file_metadata, 1), 750);
+}
+
+TEST(FooterPayload, TaskPayload) {
+  auto file_buffer = WriteFile();
+  auto metadata = parquet::ParquetFileReader::Open(
+                      std::make_shared<arrow::io::BufferReader>(file_buffer))
+                      ->metadata();
+  auto payload =
+      MakeTaskPayload({{"a.parquet", metadata, {0, 2}}, {"b.parquet", metadata, {3}}},
+                      PayloadFooter::Full)
+          .ValueOrDie();
+
+  auto parsed = ParseTaskPayload(payload).ValueOrDie();
+  ASSERT_EQ(parsed.size(), 2);
+  ASSERT_EQ(parsed[0].key, "a.parquet");
+  ASSERT_EQ(parsed[0].AssignedRowGroups(4).ValueOrDie(), std::vector<int>({0, 2}));
+  ASSERT_EQ(parsed[1].key, "b.parquet");
+  ASSERT_EQ(parsed[1].AssignedRowGroups(4).ValueOrDie(), std::vector<int>({3}));
+  ASSERT_TRUE(parsed[1].file_metadata->Equals(*metadata));
+
+  // a single file payload is a task on the default file of the bee
+  auto single_payload =
+      MakeFooterPayload(*metadata, {1}, PayloadFooter::Full).ValueOrDie();
+  auto single = ParseTaskPayload(single_payload).ValueOrDie();
+  ASSERT_EQ(single.size(), 1);
+  ASSERT_EQ(single[0].key, "");
+  ASSERT_EQ(single[0].AssignedRowGroups(4).ValueOrDie(), std::vector<int>({1}));
+  ASSERT_EQ(ParseTaskPayload("").ValueOrDie().size(), 1);
+  ASSERT_RAISES(Invalid, ParseTaskPayload(R"({"files": {}})"));
+  ASSERT_RAISES(Invalid, ParseTaskPayload(R"({"files": []})"));
+}
+
+TEST(FooterPayload, BoundedPayload) {
+  auto file_buffer = WriteFile();
+  auto metadata = parquet::ParquetFileReader::Open(
+                      std::make_shared<arrow::io::BufferReader>(file_buffer))
+                      ->metadata();
+  std::vector<FileAssignment> files{{"a.parquet", metadata, {1}}};
+  auto full = MakeTaskPayload(files, PayloadFooter::Full).ValueOrDie();
+  auto subset = MakeTaskPayload(files, PayloadFooter::Subset).ValueOrDie();
+  auto none = MakeTaskPayload(files, PayloadFooter::None).ValueOrDie();
+  ASSERT_LT(subset.size(), full.size());
+  ASSERT_LT(none.size(), subset.size());
+  auto parsed = ParseTaskPayload(none).ValueOrDie();
+  ASSERT_EQ(parsed[0].file_metadata, nullptr);
+  ASSERT_EQ(parsed[0].AssignedRowGroups(4).ValueOrDie(), std::vector<int>({1}));
+
+  ASSERT_EQ(MakeBoundedTaskPayload(files, PayloadFooter::Full, kMaxPayloadBytes)
+                .ValueOrDie(),
+            full);
+  ASSERT_EQ(
+      MakeBoundedTaskPayload(files, PayloadFooter::Full, full.size() - 1).ValueOrDie(),
+      subset);
+  ASSERT_EQ(
+      MakeBoundedTaskPayload(files, PayloadFooter::Full, subset.size() - 1).ValueOrDie(),
+      none);
+  ASSERT_RAISES(Invalid,
+                MakeBoundedTaskPayload(files, PayloadFooter::Subset, none.size() - 1));
+}
+
+TEST(FooterPayload, TaskId) {
+  auto file_buffer = WriteFile();
+  auto metadata = parquet::ParquetFileReader::Open(
+                      std::make_shared<arrow::io::BufferReader>(file_buffer))
+                      ->metadata();
+  auto payload = MakeFooterPayload(*metadata, {1}, PayloadFooter::Full).ValueOrDie();
+  ASSERT_FALSE(GetPayloadTaskId(payload).ValueOrDie().has_value());
+  auto tagged = SetPayloadTaskId(payload, 7).ValueOrDie();
+  ASSERT_EQ(GetPayloadTaskId(tagged).ValueOrDie(), 7);
+  ASSERT_EQ(GetPayloadTaskId(SetPayloadTaskId(tagged, 8).ValueOrDie()).ValueOrDie(), 8);
+  // the rest of the payload is preserved
+  auto parsed = ParseTaskPayload(tagged).ValueOrDie();
+  ASSERT_EQ(parsed[0].AssignedRowGroups(4).ValueOrDie(), std::vector<int>({1}));
+  ASSERT_EQ(GetPayloadTaskId(SetPayloadTaskId("", 3).ValueOrDie()).ValueOrDie(), 3);
+  ASSERT_RAISES(Invalid, GetPayloadTaskId(R"({"task_id": "a"})"));
+}
+
+TEST(FooterPayload, Invalid) {
+  auto empty = ParseFooterPayload("").ValueOrDie();
+  ASSERT_EQ(empty.file_metadata, nullptr);
+  ASSERT_EQ(empty.AssignedRowGroups(2).ValueOrDie(), std::vector<int>({0, 1}));
+  ASSERT_RAISES(Invalid, ParseFooterPayload("not json"));
+  ASSERT_RAISES(Invalid, ParseFooterPayload(R"({"row_groups": "all"})"));
+  ASSERT_RAISES(Invalid, ParseFooterPayload(R"({"footer": "AAAA"})"));
+  // without footer the row groups are only checked against the one fetched by the bee
+  auto unchecked = ParseFooterPayload(R"({"row_groups": [1, 5]})").ValueOrDie();
+  ASSERT_RAISES(Invalid, unchecked.AssignedRowGroups(4));
+  ASSERT_EQ(unchecked.AssignedRowGroups(6).ValueOrDie(), std::vector<int>({1, 5}));
+}
+
+}  // namespace Buzz
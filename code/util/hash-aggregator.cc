@@ -0,0 +1,884 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "hash-aggregator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <type_traits>
+
+#include "hashing.h"
+
+namespace Buzz {
+
+namespace {
+
+constexpr const char* NUM_KEYS_META_KEY = "buzz.num_keys";
+constexpr const char* AGGREGATES_META_KEY = "buzz.aggregates";
+constexpr int32_t INT_KEY_WIDTH = 1 + sizeof(int64_t);
+constexpr int32_t BINARY_KEY_HEADER_WIDTH = 1 + sizeof(uint32_t);
+
+const char* KindName(AggregateKind kind) {
+  switch (kind) {
+    case AggregateKind::Count:
+      return "count";
+    case AggregateKind::Sum:
+      return "sum";
+    case AggregateKind::Min:
+      return "min";
+    case AggregateKind::Max:
+      return "max";
+    case AggregateKind::Avg:
+      return "avg";
+  }
+  return "unknown";
+}
+
+Result<AggregateKind> ParseKind(const std::string& name) {
+  for (auto kind : {AggregateKind::Count, AggregateKind::Sum, AggregateKind::Min,
+                    AggregateKind::Max, AggregateKind::Avg}) {
+    if (name == KindName(kind)) return kind;
+  }
+  return Status::Invalid("Unknown aggregate kind: ", name);
+}
+
+/// Call func with the raw values of a numeric array
+template <typename Func>
+Status VisitNumericValues(const arrow::Array& array, Func&& func) {
+  switch (array.type_id()) {
+#define NUMERIC_VALUES_CASE(TYPE_ID, ARRAY_TYPE) \
+  case arrow::Type::TYPE_ID:                     \
+    return func(static_cast<const arrow::ARRAY_TYPE&>(array).raw_values());
+
+    NUMERIC_VALUES_CASE(INT8, Int8Array)
+    NUMERIC_VALUES_CASE(INT16, Int16Array)
+    NUMERIC_VALUES_CASE(INT32, Int32Array)
+    NUMERIC_VALUES_CASE(INT64, Int64Array)
+    NUMERIC_VALUES_CASE(UINT8, UInt8Array)
+    NUMERIC_VALUES_CASE(UINT16, UInt16Array)
+    NUMERIC_VALUES_CASE(UINT32, UInt32Array)
+    NUMERIC_VALUES_CASE(UINT64, UInt64Array)
+    NUMERIC_VALUES_CASE(FLOAT, FloatArray)
+    NUMERIC_VALUES_CASE(DOUBLE, DoubleArray)
+#undef NUMERIC_VALUES_CASE
+    default:
+      return Status::NotImplemented("Cannot aggregate values of type ",
+                                    array.type()->ToString());
+  }
+}
+
+bool IsFloating(const arrow::DataType& type) {
+  return type.id() == arrow::Type::FLOAT || type.id() == arrow::Type::DOUBLE;
+}
+
+//// KEYS ////
+
+/// The keys of a batch, encoded row by row
+struct EncodedKeys {
+  std::vector<int32_t> offsets;
+  std::vector<int32_t> cursors;
+  std::vector<uint8_t> bytes;
+  std::vector<uint64_t> hashes;
+};
+
+/// Encodes the values of one key column into the rows, and decodes them back
+class KeyCodec {
+ public:
+  virtual ~KeyCodec() = default;
+  /// Add the encoded size of each value to lengths
+  virtual void AddLengths(const arrow::Array& array, int32_t* lengths) const = 0;
+  /// Write each value at its row cursor and combine its hash with the row hash
+  virtual void Encode(const arrow::Array& array, int32_t* cursors, uint8_t* bytes,
+                      uint64_t* hashes) const = 0;
+  /// Append the value under cursor to the output and move the cursor after it
+  virtual Status Decode(const uint8_t** cursor) = 0;
+  virtual Result<std::shared_ptr<arrow::Array>> Finish() = 0;
+};
+
+template <typename ArrowType>
+class IntKeyCodec : public KeyCodec {
+ public:
+  using ArrayType = typename arrow::TypeTraits<ArrowType>::ArrayType;
+  using BuilderType = typename arrow::TypeTraits<ArrowType>::BuilderType;
+  using CType = typename ArrowType::c_type;
+
+  explicit IntKeyCodec(arrow::MemoryPool* pool) : builder_(pool) {}
+
+  void AddLengths(const arrow::Array& array, int32_t* lengths) const override {
+    for (int64_t i = 0; i < array.length(); i++) {
+      lengths[i] += INT_KEY_WIDTH;
+    }
+  }
+
+  void Encode(const arrow::Array& array, int32_t* cursors, uint8_t* bytes,
+              uint64_t* hashes) const override {
+    auto raw_values = static_cast<const ArrayType&>(array).raw_values();
+    for (int64_t i = 0; i < array.length(); i++) {
+      uint8_t is_valid = array.IsValid(i);
+      int64_t value = is_valid ? static_cast<int64_t>(raw_values[i]) : 0;
+      bytes[cursors[i]] = is_valid;
+      memcpy(bytes + cursors[i] + 1, &value, sizeof(int64_t));
+      cursors[i] += INT_KEY_WIDTH;
+      auto hash = is_valid ? hashing::HashInt(value) : hashing::NULL_HASH;
+      hashes[i] = hashing::CombineHashes(hashes[i], hash);
+    }
+  }
+
+  Status Decode(const uint8_t** cursor) override {
+    bool is_valid = (*cursor)[0];
+    int64_t value;
+    memcpy(&value, *cursor + 1, sizeof(int64_t));
+    *cursor += INT_KEY_WIDTH;
+    if (!is_valid) return builder_.AppendNull();
+    return builder_.Append(static_cast<CType>(value));
+  }
+
+  Result<std::shared_ptr<arrow::Array>> Finish() override {
+    std::shared_ptr<arrow::Array> out;
+    RETURN_NOT_OK(builder_.Finish(&out));
+    return out;
+  }
+
+ private:
+  BuilderType builder_;
+};
+
+template <typename ArrowType>
+class BinaryKeyCodec : public KeyCodec {
+ public:
+  using ArrayType = typename arrow::TypeTraits<ArrowType>::ArrayType;
+  using BuilderType = typename arrow::TypeTraits<ArrowType>::BuilderType;
+
+  explicit BinaryKeyCodec(arrow::MemoryPool* pool) : builder_(pool) {}
+
+  void AddLengths(const arrow::Array& array, int32_t* lengths) const override {
+    auto& typed_array = static_cast<const ArrayType&>(array);
+    for (int64_t i = 0; i < array.length(); i++) {
+      lengths[i] += BINARY_KEY_HEADER_WIDTH + typed_array.value_length(i);
+    }
+  }
+
+  void Encode(const arrow::Array& array, int32_t* cursors, uint8_t* bytes,
+              uint64_t* hashes) const override {
+    auto& typed_array = static_cast<const ArrayType&>(array);
+    for (int64_t i = 0; i < array.length(); i++) {
+      uint8_t is_valid = array.IsValid(i);
+      int32_t length = 0;
+      auto data = typed_array.GetValue(i, &length);
+      uint32_t stored_length = is_valid ? length : 0;
+      bytes[cursors[i]] = is_valid;
+      memcpy(bytes + cursors[i] + 1, &stored_length, sizeof(uint32_t));
+      memcpy(bytes + cursors[i] + BINARY_KEY_HEADER_WIDTH, data, stored_length);
+      cursors[i] += BINARY_KEY_HEADER_WIDTH + stored_length;
+      auto hash = is_valid ? hashing::HashBytes(data, length) : hashing::NULL_HASH;
+      hashes[i] = hashing::CombineHashes(hashes[i], hash);
+    }
+  }
+
+  Status Decode(const uint8_t** cursor) override {
+    bool is_valid = (*cursor)[0];
+    uint32_t length;
+    memcpy(&length, *cursor + 1, sizeof(uint32_t));
+    auto data = *cursor + BINARY_KEY_HEADER_WIDTH;
+    *cursor += BINARY_KEY_HEADER_WIDTH + length;
+    if (!is_valid) return builder_.AppendNull();
+    return builder_.Append(data, length);
+  }
+
+  Result<std::shared_ptr<arrow::Array>> Finish() override {
+    std::shared_ptr<arrow::Array> out;
+    RETURN_NOT_OK(builder_.Finish(&out));
+    return out;
+  }
+
+ private:
+  BuilderType builder_;
+};
+
+Result<std::unique_ptr<KeyCodec>> MakeKeyCodec(const arrow::DataType& type,
+                                               arrow::MemoryPool* pool) {
+  switch (type.id()) {
+#define INT_KEY_CASE(TYPE_ID, ARROW_TYPE) \
+  case arrow::Type::TYPE_ID:              \
+    return std::unique_ptr<KeyCodec>(new IntKeyCodec<arrow::ARROW_TYPE>(pool));
+
+    INT_KEY_CASE(INT8, Int8Type)
+    INT_KEY_CASE(INT16, Int16Type)
+    INT_KEY_CASE(INT32, Int32Type)
+    INT_KEY_CASE(INT64, Int64Type)
+    INT_KEY_CASE(UINT8, UInt8Type)
+    INT_KEY_CASE(UINT16, UInt16Type)
+    INT_KEY_CASE(UINT32, UInt32Type)
+    INT_KEY_CASE(UINT64, UInt64Type)
+#undef INT_KEY_CASE
+    case arrow::Type::STRING:
+      return std::unique_ptr<KeyCodec>(new BinaryKeyCodec<arrow::StringType>(pool));
+    case arrow::Type::BINARY:
+      return std::unique_ptr<KeyCodec>(new BinaryKeyCodec<arrow::BinaryType>(pool));
+    default:
+      return Status::NotImplemented("Cannot group by type ", type.ToString());
+  }
+}
+
+/// Open addressing table that maps encoded keys to dense group ids
+class GroupTable {
+ public:
+  GroupTable() : slots_(INITIAL_CAPACITY, Slot{0, 0}), mask_(INITIAL_CAPACITY - 1) {
+    key_offsets_.push_back(0);
+  }
+
+  uint32_t FindOrInsert(uint64_t hash, const uint8_t* key, int32_t key_length) {
+    uint32_t tag = static_cast<uint32_t>(hash >> 32);
+    uint64_t index = hash & mask_;
+    while (true) {
+      auto& slot = slots_[index];
+      if (slot.group_id_plus_one == 0) {
+        return Insert(&slot, hash, key, key_length);
+      }
+      if (slot.tag == tag) {
+        auto group_id = slot.group_id_plus_one - 1;
+        auto group_key_start = key_offsets_[group_id];
+        auto group_key_length = key_offsets_[group_id + 1] - group_key_start;
+        if (group_key_length == key_length &&
+            memcmp(key_bytes_.data() + group_key_start, key, key_length) == 0) {
+          return group_id;
+        }
+      }
+      index = (index + 1) & mask_;
+    }
+  }
+
+  int64_t num_groups() const { return group_hashes_.size(); }
+
+  const uint8_t* key(uint32_t group_id) const {
+    return key_bytes_.data() + key_offsets_[group_id];
+  }
+
+ private:
+  static constexpr uint64_t INITIAL_CAPACITY = 1024;
+
+  struct Slot {
+    uint32_t tag;
+    uint32_t group_id_plus_one;
+  };
+
+  uint32_t Insert(Slot* slot, uint64_t hash, const uint8_t* key, int32_t key_length) {
+    uint32_t group_id = group_hashes_.size();
+    slot->tag = static_cast<uint32_t>(hash >> 32);
+    slot->group_id_plus_one = group_id + 1;
+    group_hashes_.push_back(hash);
+    key_bytes_.insert(key_bytes_.end(), key, key + key_length);
+    key_offsets_.push_back(key_bytes_.size());
+    // keep the load factor under 1/2
+    if (group_hashes_.size() * 2 > slots_.size()) {
+      Grow();
+    }
+    return group_id;
+  }
+
+  void Grow() {
+    std::vector<Slot> new_slots(slots_.size() * 2, Slot{0, 0});
+    uint64_t new_mask = new_slots.size() - 1;
+    for (uint32_t group_id = 0; group_id < group_hashes_.size(); group_id++) {
+      auto hash = group_hashes_[group_id];
+      uint64_t index = hash & new_mask;
+      while (new_slots[index].group_id_plus_one != 0) {
+        index = (index + 1) & new_mask;
+      }
+      new_slots[index] = Slot{static_cast<uint32_t>(hash >> 32), group_id + 1};
+    }
+    slots_ = std::move(new_slots);
+    mask_ = new_mask;
+  }
+
+  std::vector<Slot> slots_;
+  uint64_t mask_;
+  std::vector<uint64_t> group_hashes_;
+  std::vector<uint8_t> key_bytes_;
+  std::vector<int64_t> key_offsets_;
+};
+
+//// AGGREGATES ////
+
+class Accumulator {
+ public:
+  virtual ~Accumulator() = default;
+  virtual void Resize(int64_t num_groups) = 0;
+  /// values is null for COUNT(*)
+  virtual Status Consume(const arrow::Array* values, int64_t length,
+                         const uint32_t* group_ids) = 0;
+  /// Merge partial states, the first state column of this aggregate is state_columns[0]
+  virtual Status Merge(const std::shared_ptr<arrow::Array>* state_columns,
+                       int64_t length, const uint32_t* group_ids) = 0;
+  virtual arrow::FieldVector state_fields(const std::string& name) const = 0;
+  virtual Status FinishStates(arrow::ArrayVector* out) const = 0;
+  virtual std::shared_ptr<arrow::Field> final_field(const std::string& name) const {
+    return state_fields(name)[0];
+  }
+  virtual Result<std::shared_ptr<arrow::Array>> FinishFinal() const {
+    arrow::ArrayVector out;
+    RETURN_NOT_OK(FinishStates(&out));
+    return out[0];
+  }
+};
+
+/// integer sums wrap around on overflow, as the sum kernel of Arrow does
+template <typename StateType>
+struct SumOp {
+  static StateType Identity() { return 0; }
+  static StateType Apply(StateType state, StateType value) {
+    if constexpr (std::is_integral_v<StateType>) {
+      using Unsigned = std::make_unsigned_t<StateType>;
+      return static_cast<StateType>(static_cast<Unsigned>(state) +
+                                    static_cast<Unsigned>(value));
+    } else {
+      return state + value;
+    }
+  }
+};
+
+template <typename StateType>
+struct MinOp {
+  static StateType Identity() {
+    return std::numeric_limits<StateType>::has_infinity
+               ? std::numeric_limits<StateType>::infinity()
+               : std::numeric_limits<StateType>::max();
+  }
+  static StateType Apply(StateType state, StateType value) {
+    return std::min(state, value);
+  }
+};
+
+template <typename StateType>
+struct MaxOp {
+  static StateType Identity() {
+    return std::numeric_limits<StateType>::has_infinity
+               ? -std::numeric_limits<StateType>::infinity()
+               : std::numeric_limits<StateType>::lowest();
+  }
+  static StateType Apply(StateType state, StateType value) {
+    return std::max(state, value);
+  }
+};
+
+/// SUM, MIN and MAX, their partial state is of the same kind as their result
+template <typename StateType, template <typename> class Op>
+class ReduceAccumulator : public Accumulator {
+ public:
+  using StateArrowType = typename arrow::CTypeTraits<StateType>::ArrowType;
+  using StateBuilderType = typename arrow::TypeTraits<StateArrowType>::BuilderType;
+
+  explicit ReduceAccumulator(arrow::MemoryPool* pool) : pool_(pool) {}
+
+  void Resize(int64_t num_groups) override {
+    states_.resize(num_groups, Op<StateType>::Identity());
+    has_value_.resize(num_groups, 0);
+  }
+
+  Status Consume(const arrow::Array* values, int64_t,
+                 const uint32_t* group_ids) override {
+    return VisitNumericValues(*values, [&](const auto* raw_values) {
+      Update(raw_values, *values, group_ids);
+      return Status::OK();
+    });
+  }
+
+  Status Merge(const std::shared_ptr<arrow::Array>* state_columns, int64_t length,
+               const uint32_t* group_ids) override {
+    return Consume(state_columns[0].get(), length, group_ids);
+  }
+
+  arrow::FieldVector state_fields(const std::string& name) const override {
+    return {arrow::field(name, arrow::TypeTraits<StateArrowType>::type_singleton())};
+  }
+
+  Status FinishStates(arrow::ArrayVector* out) const override {
+    StateBuilderType builder(pool_);
+    RETURN_NOT_OK(
+        builder.AppendValues(states_.data(), states_.size(), has_value_.data()));
+    std::shared_ptr<arrow::Array> array;
+    RETURN_NOT_OK(builder.Finish(&array));
+    out->push_back(array);
+    return Status::OK();
+  }
+
+ private:
+  template <typename CType>
+  void Update(const CType* raw_values, const arrow::Array& array,
+              const uint32_t* group_ids) {
+    auto states = states_.data();
+    auto has_value = has_value_.data();
+    if (array.null_count() == 0) {
+      for (int64_t i = 0; i < array.length(); i++) {
+        auto group_id = group_ids[i];
+        states[group_id] =
+            Op<StateType>::Apply(states[group_id], static_cast<StateType>(raw_values[i]));
+        has_value[group_id] = 1;
+      }
+    } else {
+      for (int64_t i = 0; i < array.length(); i++) {
+        if (array.IsNull(i)) continue;
+        auto group_id = group_ids[i];
+        states[group_id] =
+            Op<StateType>::Apply(states[group_id], static_cast<StateType>(raw_values[i]));
+        has_value[group_id] = 1;
+      }
+    }
+  }
+
+  arrow::MemoryPool* pool_;
+  std::vector<StateType> states_;
+  std::vector<uint8_t> has_value_;
+};
+
+/// COUNT(*) if values is null, COUNT(col) otherwise
+class CountAccumulator : public Accumulator {
+ public:
+  explicit CountAccumulator(arrow::MemoryPool* pool) : pool_(pool) {}
+
+  void Resize(int64_t num_groups) override { counts_.resize(num_groups, 0); }
+
+  Status Consume(const arrow::Array* values, int64_t length,
+                 const uint32_t* group_ids) override {
+    auto counts = counts_.data();
+    if (values == nullptr || values->null_count() == 0) {
+      for (int64_t i = 0; i < length; i++) {
+        counts[group_ids[i]]++;
+      }
+    } else {
+      for (int64_t i = 0; i < length; i++) {
+        counts[group_ids[i]] += values->IsValid(i);
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Merge(const std::shared_ptr<arrow::Array>* state_columns, int64_t length,
+               const uint32_t* group_ids) override {
+    if (state_columns[0]->type_id() != arrow::Type::INT64) {
+      return Status::Invalid("Count state should be INT64");
+    }
+    auto counts = counts_.data();
+    auto partial_counts =
+        static_cast<const arrow::Int64Array&>(*state_columns[0]).raw_values();
+    for (int64_t i = 0; i < length; i++) {
+      counts[group_ids[i]] += partial_counts[i];
+    }
+    return Status::OK();
+  }
+
+  arrow::FieldVector state_fields(const std::string& name) const override {
+    return {arrow::field(name, arrow::int64(), false)};
+  }
+
+  Status FinishStates(arrow::ArrayVector* out) const override {
+    arrow::Int64Builder builder(pool_);
+    RETURN_NOT_OK(builder.AppendValues(counts_));
+    std::shared_ptr<arrow::Array> array;
+    RETURN_NOT_OK(builder.Finish(&array));
+    out->push_back(array);
+    return Status::OK();
+  }
+
+ private:
+  arrow::MemoryPool* pool_;
+  std::vector<int64_t> counts_;
+};
+
+/// AVG is shipped as a sum and a count
+class AvgAccumulator : public Accumulator {
+ public:
+  explicit AvgAccumulator(arrow::MemoryPool* pool) : pool_(pool) {}
+
+  void Resize(int64_t num_groups) override {
+    sums_.resize(num_groups, 0.);
+    counts_.resize(num_groups, 0);
+  }
+
+  Status Consume(const arrow::Array* values, int64_t length,
+                 const uint32_t* group_ids) override {
+    return VisitNumericValues(*values, [&](const auto* raw_values) {
+      auto sums = sums_.data();
+      auto counts = counts_.data();
+      for (int64_t i = 0; i < length; i++) {
+        if (values->IsNull(i)) continue;
+        sums[group_ids[i]] += static_cast<double>(raw_values[i]);
+        counts[group_ids[i]]++;
+      }
+      return Status::OK();
+    });
+  }
+
+  Status Merge(const std::shared_ptr<arrow::Array>* state_columns, int64_t length,
+               const uint32_t* group_ids) override {
+    if (state_columns[0]->type_id() != arrow::Type::DOUBLE ||
+        state_columns[1]->type_id() != arrow::Type::INT64) {
+      return Status::Invalid("Avg states should be DOUBLE and INT64");
+    }
+    auto partial_sums =
+        static_cast<const arrow::DoubleArray&>(*state_columns[0]).raw_values();
+    auto partial_counts =
+        static_cast<const arrow::Int64Array&>(*state_columns[1]).raw_values();
+    for (int64_t i = 0; i < length; i++) {
+      sums_[group_ids[i]] += partial_sums[i];
+      counts_[group_ids[i]] += partial_counts[i];
+    }
+    return Status::OK();
+  }
+
+  arrow::FieldVector state_fields(const std::string& name) const override {
+    return {arrow::field(name + ".sum", arrow::float64(), false),
+            arrow::field(name + ".count", arrow::int64(), false)};
+  }
+
+  Status FinishStates(arrow::ArrayVector* out) const override {
+    arrow::DoubleBuilder sum_builder(pool_);
+    arrow::Int64Builder count_builder(pool_);
+    RETURN_NOT_OK(sum_builder.AppendValues(sums_));
+    RETURN_NOT_OK(count_builder.AppendValues(counts_));
+    std::shared_ptr<arrow::Array> sum_array;
+    std::shared_ptr<arrow::Array> count_array;
+    RETURN_NOT_OK(sum_builder.Finish(&sum_array));
+    RETURN_NOT_OK(count_builder.Finish(&count_array));
+    out->push_back(sum_array);
+    out->push_back(count_array);
+    return Status::OK();
+  }
+
+  std::shared_ptr<arrow::Field> final_field(const std::string& name) const override {
+    return arrow::field(name, arrow::float64());
+  }
+
+  Result<std::shared_ptr<arrow::Array>> FinishFinal() const override {
+    arrow::DoubleBuilder builder(pool_);
+    RETURN_NOT_OK(builder.Reserve(sums_.size()));
+    for (size_t i = 0; i < sums_.size(); i++) {
+      if (counts_[i] == 0) {
+        builder.UnsafeAppendNull();
+      } else {
+        builder.UnsafeAppend(sums_[i] / counts_[i]);
+      }
+    }
+    std::shared_ptr<arrow::Array> array;
+    RETURN_NOT_OK(builder.Finish(&array));
+    return array;
+  }
+
+ private:
+  arrow::MemoryPool* pool_;
+  std::vector<double> sums_;
+  std::vector<int64_t> counts_;
+};
+
+/// state_is_floating is ignored for COUNT and AVG
+std::unique_ptr<Accumulator> MakeAccumulator(AggregateKind kind, bool state_is_floating,
+                                             arrow::MemoryPool* pool) {
+  switch (kind) {
+    case AggregateKind::Count:
+      return std::unique_ptr<Accumulator>(new CountAccumulator(pool));
+    case AggregateKind::Avg:
+      return std::unique_ptr<Accumulator>(new AvgAccumulator(pool));
+    case AggregateKind::Sum:
+      if (state_is_floating) {
+        return std::unique_ptr<Accumulator>(new ReduceAccumulator<double, SumOp>(pool));
+      }
+      return std::unique_ptr<Accumulator>(new ReduceAccumulator<int64_t, SumOp>(pool));
+    case AggregateKind::Min:
+      if (state_is_floating) {
+        return std::unique_ptr<Accumulator>(new ReduceAccumulator<double, MinOp>(pool));
+      }
+      return std::unique_ptr<Accumulator>(new ReduceAccumulator<int64_t, MinOp>(pool));
+    case AggregateKind::Max:
+      if (state_is_floating) {
+        return std::unique_ptr<Accumulator>(new ReduceAccumulator<double, MaxOp>(pool));
+      }
+      return std::unique_ptr<Accumulator>(new ReduceAccumulator<int64_t, MaxOp>(pool));
+  }
+  return nullptr;
+}
+
+std::string SerializeSpecs(const std::vector<AggregateSpec>& specs) {
+  std::stringstream ss;
+  for (size_t i = 0; i < specs.size(); i++) {
+    if (i > 0) ss << ";";
+    ss << KindName(specs[i].kind) << ":" << specs[i].column;
+  }
+  return ss.str();
+}
+
+Result<std::vector<AggregateSpec>> ParseSpecs(const std::string& serialized) {
+  std::vector<AggregateSpec> specs;
+  std::stringstream ss(serialized);
+  std::string item;
+  while (std::getline(ss, item, ';')) {
+    auto split = item.find(':');
+    if (split == std::string::npos) {
+      return Status::Invalid("Invalid aggregate spec: ", item);
+    }
+    ARROW_ASSIGN_OR_RAISE(auto kind, ParseKind(item.substr(0, split)));
+    specs.push_back({kind, item.substr(split + 1)});
+  }
+  return specs;
+}
+
+}  // namespace
+
+std::string ToString(const AggregateSpec& spec) {
+  auto column = spec.column.empty() ? "*" : spec.column;
+  return std::string(KindName(spec.kind)) + "(" + column + ")";
+}
+
+class HashAggregator::Impl {
+ public:
+  explicit Impl(arrow::MemoryPool* pool) : pool_(pool) {}
+
+  Status ComputeGroupIds(const arrow::ArrayVector& key_arrays, int64_t length) {
+    keys_.offsets.assign(length + 1, 0);
+    keys_.hashes.assign(length, 0);
+    for (size_t k = 0; k < key_codecs_.size(); k++) {
+      key_codecs_[k]->AddLengths(*key_arrays[k], keys_.offsets.data() + 1);
+    }
+    for (int64_t i = 0; i < length; i++) {
+      keys_.offsets[i + 1] += keys_.offsets[i];
+    }
+    keys_.cursors.assign(keys_.offsets.begin(), keys_.offsets.end() - 1);
+    keys_.bytes.resize(keys_.offsets[length]);
+    for (size_t k = 0; k < key_codecs_.size(); k++) {
+      key_codecs_[k]->Encode(*key_arrays[k], keys_.cursors.data(), keys_.bytes.data(),
+                             keys_.hashes.data());
+    }
+    group_ids_.resize(length);
+    for (int64_t i = 0; i < length; i++) {
+      group_ids_[i] =
+          table_.FindOrInsert(keys_.hashes[i], keys_.bytes.data() + keys_.offsets[i],
+                              keys_.offsets[i + 1] - keys_.offsets[i]);
+    }
+    for (auto& accumulator : accumulators_) {
+      accumulator->Resize(table_.num_groups());
+    }
+    return Status::OK();
+  }
+
+  Status Consume(const arrow::RecordBatch& batch) {
+    if (input_schema_ == nullptr) {
+      return Status::Invalid("Aggregator can only merge partial aggregates");
+    }
+    if (!batch.schema()->Equals(*input_schema_, false)) {
+      return Status::Invalid("Batch schema does not match the aggregator input schema");
+    }
+    arrow::ArrayVector key_arrays;
+    for (auto key_index : key_indices_) {
+      key_arrays.push_back(batch.column(key_index));
+    }
+    RETURN_NOT_OK(ComputeGroupIds(key_arrays, batch.num_rows()));
+    for (size_t a = 0; a < accumulators_.size(); a++) {
+      std::shared_ptr<arrow::Array> values;
+      if (value_indices_[a] >= 0) {
+        values = batch.column(value_indices_[a]);
+      }
+      RETURN_NOT_OK(
+          accumulators_[a]->Consume(values.get(), batch.num_rows(), group_ids_.data()));
+    }
+    return Status::OK();
+  }
+
+  Status Merge(const arrow::RecordBatch& partial) {
+    if (!partial.schema()->Equals(*partial_schema_, false)) {
+      return Status::Invalid("Batch schema does not match the partial aggregate schema");
+    }
+    arrow::ArrayVector columns;
+    for (int i = 0; i < partial.num_columns(); i++) {
+      columns.push_back(partial.column(i));
+    }
+    arrow::ArrayVector key_arrays(columns.begin(), columns.begin() + key_codecs_.size());
+    RETURN_NOT_OK(ComputeGroupIds(key_arrays, partial.num_rows()));
+    auto state_column = columns.data() + key_codecs_.size();
+    for (size_t a = 0; a < accumulators_.size(); a++) {
+      RETURN_NOT_OK(
+          accumulators_[a]->Merge(state_column, partial.num_rows(), group_ids_.data()));
+      state_column += accumulators_[a]->state_fields("").size();
+    }
+    return Status::OK();
+  }
+
+  Status FinishKeys(arrow::ArrayVector* out) {
+    for (uint32_t group_id = 0; group_id < table_.num_groups(); group_id++) {
+      auto cursor = table_.key(group_id);
+      for (auto& codec : key_codecs_) {
+        RETURN_NOT_OK(codec->Decode(&cursor));
+      }
+    }
+    for (auto& codec : key_codecs_) {
+      ARROW_ASSIGN_OR_RAISE(auto array, codec->Finish());
+      out->push_back(array);
+    }
+    return Status::OK();
+  }
+
+  Result<std::shared_ptr<arrow::RecordBatch>> Finish() {
+    arrow::ArrayVector columns;
+    RETURN_NOT_OK(FinishKeys(&columns));
+    for (auto& accumulator : accumulators_) {
+      RETURN_NOT_OK(accumulator->FinishStates(&columns));
+    }
+    return arrow::RecordBatch::Make(partial_schema_, table_.num_groups(), columns);
+  }
+
+  Result<std::shared_ptr<arrow::RecordBatch>> Finalize() {
+    arrow::ArrayVector columns;
+    RETURN_NOT_OK(FinishKeys(&columns));
+    arrow::FieldVector fields(partial_schema_->fields().begin(),
+                              partial_schema_->fields().begin() + key_codecs_.size());
+    for (size_t a = 0; a < accumulators_.size(); a++) {
+      fields.push_back(accumulators_[a]->final_field(ToString(specs_[a])));
+      ARROW_ASSIGN_OR_RAISE(auto array, accumulators_[a]->FinishFinal());
+      columns.push_back(array);
+    }
+    return arrow::RecordBatch::Make(arrow::schema(fields), table_.num_groups(), columns);
+  }
+
+  /// Build the partial schema from the key fields and the accumulators
+  void InitPartialSchema(const arrow::FieldVector& key_fields) {
+    arrow::FieldVector fields = key_fields;
+    for (size_t a = 0; a < accumulators_.size(); a++) {
+      auto state_fields = accumulators_[a]->state_fields(ToString(specs_[a]));
+      fields.insert(fields.end(), state_fields.begin(), state_fields.end());
+    }
+    auto metadata = arrow::key_value_metadata(
+        {NUM_KEYS_META_KEY, AGGREGATES_META_KEY},
+        {std::to_string(key_fields.size()), SerializeSpecs(specs_)});
+    partial_schema_ = arrow::schema(fields, metadata);
+  }
+
+  arrow::MemoryPool* pool_;
+  std::shared_ptr<arrow::Schema> input_schema_;
+  std::shared_ptr<arrow::Schema> partial_schema_;
+  std::vector<int> key_indices_;
+  std::vector<std::unique_ptr<KeyCodec>> key_codecs_;
+  std::vector<AggregateSpec> specs_;
+  std::vector<int> value_indices_;
+  std::vector<std::unique_ptr<Accumulator>> accumulators_;
+  GroupTable table_;
+  EncodedKeys keys_;
+  std::vector<uint32_t> group_ids_;
+};
+
+Result<std::unique_ptr<HashAggregator>> HashAggregator::Make(
+    const std::shared_ptr<arrow::Schema>& input_schema, std::vector<std::string> keys,
+    std::vector<AggregateSpec> aggregates, arrow::MemoryPool* pool) {
+  std::unique_ptr<Impl> impl(new Impl(pool));
+  impl->input_schema_ = input_schema;
+  arrow::FieldVector key_fields;
+  for (auto& key : keys) {
+    auto index = input_schema->GetFieldIndex(key);
+    if (index < 0) {
+      return Status::Invalid("Group by key not found: ", key);
+    }
+    auto field = input_schema->field(index);
+    ARROW_ASSIGN_OR_RAISE(auto codec, MakeKeyCodec(*field->type(), pool));
+    impl->key_indices_.push_back(index);
+    impl->key_codecs_.push_back(std::move(codec));
+    key_fields.push_back(field);
+  }
+  for (auto& spec : aggregates) {
+    int value_index = -1;
+    bool state_is_floating = false;
+    if (!spec.column.empty()) {
+      value_index = input_schema->GetFieldIndex(spec.column);
+      if (value_index < 0) {
+        return Status::Invalid("Aggregated column not found: ", spec.column);
+      }
+      state_is_floating = IsFloating(*input_schema->field(value_index)->type());
+    } else if (spec.kind != AggregateKind::Count) {
+      return Status::Invalid("Only COUNT can be applied to *");
+    }
+    impl->value_indices_.push_back(value_index);
+    impl->accumulators_.push_back(MakeAccumulator(spec.kind, state_is_floating, pool));
+  }
+  impl->specs_ = std::move(aggregates);
+  impl->InitPartialSchema(key_fields);
+  return std::unique_ptr<HashAggregator>(new HashAggregator(std::move(impl)));
+}
+
+Result<std::unique_ptr<HashAggregator>> HashAggregator::MakeFromPartialSchema(
+    const std::shared_ptr<arrow::Schema>& partial_schema, arrow::MemoryPool* pool) {
+  auto metadata = partial_schema->metadata();
+  if (metadata == nullptr || metadata->FindKey(NUM_KEYS_META_KEY) < 0 ||
+      metadata->FindKey(AGGREGATES_META_KEY) < 0) {
+    return Status::Invalid("Schema is missing the partial aggregate metadata");
+  }
+  auto num_keys = std::stoi(metadata->value(metadata->FindKey(NUM_KEYS_META_KEY)));
+  ARROW_ASSIGN_OR_RAISE(
+      auto specs, ParseSpecs(metadata->value(metadata->FindKey(AGGREGATES_META_KEY))));
+
+  std::unique_ptr<Impl> impl(new Impl(pool));
+  arrow::FieldVector key_fields;
+  for (int k = 0; k < num_keys; k++) {
+    auto field = partial_schema->field(k);
+    ARROW_ASSIGN_OR_RAISE(auto codec, MakeKeyCodec(*field->type(), pool));
+    impl->key_codecs_.push_back(std::move(codec));
+    key_fields.push_back(field);
+  }
+  int state_index = num_keys;
+  for (auto& spec : specs) {
+    if (state_index >= partial_schema->num_fields()) {
+      return Status::Invalid("Partial schema is missing aggregate states");
+    }
+    bool state_is_floating = IsFloating(*partial_schema->field(state_index)->type());
+    auto accumulator = MakeAccumulator(spec.kind, state_is_floating, pool);
+    state_index += accumulator->state_fields("").size();
+    impl->value_indices_.push_back(-1);
+    impl->accumulators_.push_back(std::move(accumulator));
+  }
+  impl->specs_ = std::move(specs);
+  impl->InitPartialSchema(key_fields);
+  return std::unique_ptr<HashAggregator>(new HashAggregator(std::move(impl)));
+}
+
+HashAggregator::HashAggregator(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+
+HashAggregator::~HashAggregator() {}
+
+Status HashAggregator::Consume(const arrow::RecordBatch& batch) {
+  return impl_->Consume(batch);
+}
+
+Status HashAggregator::Merge(const arrow::RecordBatch& partial) {
+  return impl_->Merge(partial);
+}
+
+std::shared_ptr<arrow::Schema> HashAggregator::partial_schema() const {
+  return impl_->partial_schema_;
+}
+
+Result<std::shared_ptr<arrow::RecordBatch>> HashAggregator::Finish() {
+  return impl_->Finish();
+}
+
+Result<std::shared_ptr<arrow::RecordBatch>> HashAggregator::Finalize() {
+  return impl_->Finalize();
+}
+
+int64_t HashAggregator::num_groups() const { return impl_->table_.num_groups(); }
+
+int HashAggregator::num_keys() const {
+  return static_cast<int>(impl_->key_codecs_.size());
+}
+
+}  // namespace Buzz
@@ -0,0 +1,89 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+#include <result.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Buzz {
+
+enum class AggregateKind : int8_t { Count, Sum, Min, Max, Avg };
+
+struct AggregateSpec {
+  AggregateKind kind;
+  /// name of the aggregated column, empty for COUNT(*)
+  std::string column;
+};
+
+/// Group-by operator that pre-aggregates decoded batches on the bees.
+///
+/// Groups are stored in an open addressing table (linear probing on 8 byte slots that
+/// only contain a hash tag and the group id) and the aggregate states are stored in one
+/// vector per aggregate, indexed by group id. Batches are processed column by column:
+/// first all the key hashes, then the group ids, then each aggregate.
+///
+/// Finish() emits the partial aggregates (keys followed by aggregate states) that can be
+/// merged by an other aggregator with the same spec (typically on the hive).
+class HashAggregator {
+ public:
+  /// Create an aggregator for batches with the given input schema.
+  static Result<std::unique_ptr<HashAggregator>> Make(
+      const std::shared_ptr<arrow::Schema>& input_schema, std::vector<std::string> keys,
+      std::vector<AggregateSpec> aggregates,
+      arrow::MemoryPool* pool = arrow::default_memory_pool());
+
+  /// Create an aggregator that merges partial aggregates with the given schema.
+  static Result<std::unique_ptr<HashAggregator>> MakeFromPartialSchema(
+      const std::shared_ptr<arrow::Schema>& partial_schema,
+      arrow::MemoryPool* pool = arrow::default_memory_pool());
+
+  ~HashAggregator();
+
+  /// Aggregate the rows of a decoded batch that follows the input schema
+  Status Consume(const arrow::RecordBatch& batch);
+
+  /// Merge a batch of partial aggregates as produced by Finish()
+  Status Merge(const arrow::RecordBatch& partial);
+
+  /// Schema of the batches returned by Finish()
+  std::shared_ptr<arrow::Schema> partial_schema() const;
+
+  /// Partial aggregates of all the groups seen so far
+  Result<std::shared_ptr<arrow::RecordBatch>> Finish();
+
+  /// Final results, with the AVG states resolved
+  Result<std::shared_ptr<arrow::RecordBatch>> Finalize();
+
+  int64_t num_groups() const;
+
+  /// Number of key columns, they come first in the input and partial schemas
+  int num_keys() const;
+
+ private:
+  class Impl;
+  explicit HashAggregator(std::unique_ptr<Impl> impl);
+  std::unique_ptr<Impl> impl_;
+};
+
+std::string ToString(const AggregateSpec& spec);
+
+}  // namespace Buzz
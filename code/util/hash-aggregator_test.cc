@@ -0,0 +1,147 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "hash-aggregator.h"
+
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <map>
+
+namespace Buzz {
+
+namespace {
+
+std::shared_ptr<arrow::Schema> InputSchema() {
+  return arrow::schema({arrow::field("name", arrow::utf8()),
+                        arrow::field("code", arrow::int32()),
+                        arrow::field("value", arrow::float64())});
+}
+
+/// rows: name = "n" + (i % 3), code = i % 2, value = i
+std::shared_ptr<arrow::RecordBatch> MakeBatch(int nb_rows) {
+  arrow::StringBuilder name_builder;
+  arrow::Int32Builder code_builder;
+  arrow::DoubleBuilder value_builder;
+  for (int i = 0; i < nb_rows; i++) {
+    ARROW_EXPECT_OK(name_builder.Append("n" + std::to_string(i % 3)));
+    ARROW_EXPECT_OK(code_builder.Append(i % 2));
+    ARROW_EXPECT_OK(value_builder.Append(i));
+  }
+  std::shared_ptr<arrow::Array> names, codes, values;
+  ARROW_EXPECT_OK(name_builder.Finish(&names));
+  ARROW_EXPECT_OK(code_builder.Finish(&codes));
+  ARROW_EXPECT_OK(value_builder.Finish(&values));
+  return arrow::RecordBatch::Make(InputSchema(), nb_rows, {names, codes, values});
+}
+
+std::vector<AggregateSpec> Specs() {
+  return {{AggregateKind::Count, ""},
+          {AggregateKind::Sum, "value"},
+          {AggregateKind::Min, "value"},
+          {AggregateKind::Max, "code"},
+          {AggregateKind::Avg, "value"}};
+}
+
+}  // namespace
+
+TEST(HashAggregator, SingleKey) {
+  auto aggregator = HashAggregator::Make(InputSchema(), {"name"}, Specs()).ValueOrDie();
+  ASSERT_OK(aggregator->Consume(*MakeBatch(10)));
+  ASSERT_OK(aggregator->Consume(*MakeBatch(5)));
+  ASSERT_EQ(aggregator->num_groups(), 3);
+
+  auto result = aggregator->Finalize().ValueOrDie();
+  ASSERT_EQ(result->num_columns(), 6);
+  ASSERT_EQ(result->schema()->field(5)->name(), "avg(value)");
+  auto names = std::static_pointer_cast<arrow::StringArray>(result->column(0));
+  auto counts = std::static_pointer_cast<arrow::Int64Array>(result->column(1));
+  auto sums = std::static_pointer_cast<arrow::DoubleArray>(result->column(2));
+  auto mins = std::static_pointer_cast<arrow::DoubleArray>(result->column(3));
+  auto maxs = std::static_pointer_cast<arrow::Int64Array>(result->column(4));
+  std::map<std::string, int> rows;
+  for (int i = 0; i < result->num_rows(); i++) {
+    rows[names->GetString(i)] = i;
+  }
+  // n0 <- 0,3,6,9 + 0,3
+  auto n0 = rows["n0"];
+  ASSERT_EQ(counts->Value(n0), 6);
+  ASSERT_EQ(sums->Value(n0), 21.);
+  ASSERT_EQ(mins->Value(n0), 0.);
+  ASSERT_EQ(maxs->Value(n0), 1);
+  // n2 <- 2,5,8 + 2
+  auto n2 = rows["n2"];
+  ASSERT_EQ(counts->Value(n2), 4);
+  ASSERT_EQ(sums->Value(n2), 17.);
+  ASSERT_EQ(mins->Value(n2), 2.);
+}
+
+TEST(HashAggregator, MergePartials) {
+  auto bee1 =
+      HashAggregator::Make(InputSchema(), {"name", "code"}, Specs()).ValueOrDie();
+  auto bee2 =
+      HashAggregator::Make(InputSchema(), {"name", "code"}, Specs()).ValueOrDie();
+  auto single =
+      HashAggregator::Make(InputSchema(), {"name", "code"}, Specs()).ValueOrDie();
+  ASSERT_OK(bee1->Consume(*MakeBatch(100)));
+  ASSERT_OK(bee2->Consume(*MakeBatch(37)));
+  ASSERT_OK(single->Consume(*MakeBatch(100)));
+  ASSERT_OK(single->Consume(*MakeBatch(37)));
+
+  auto partial1 = bee1->Finish().ValueOrDie();
+  auto partial2 = bee2->Finish().ValueOrDie();
+  ASSERT_EQ(partial1->num_rows(), 6);
+
+  auto hive = HashAggregator::MakeFromPartialSchema(partial1->schema()).ValueOrDie();
+  ASSERT_OK(hive->Merge(*partial1));
+  ASSERT_OK(hive->Merge(*partial2));
+  ASSERT_EQ(hive->num_groups(), 6);
+
+  // groups are numbered in order of appearance, which is the same in both cases
+  auto expected = single->Finalize().ValueOrDie();
+  auto merged = hive->Finalize().ValueOrDie();
+  ASSERT_TRUE(merged->Equals(*expected));
+}
+
+TEST(HashAggregator, IntegerSumWraps) {
+  auto schema = arrow::schema({arrow::field("key", arrow::int32()),
+                               arrow::field("value", arrow::int64())});
+  arrow::Int32Builder key_builder;
+  arrow::Int64Builder value_builder;
+  ARROW_EXPECT_OK(key_builder.AppendValues({0, 0}));
+  ARROW_EXPECT_OK(value_builder.AppendValues({std::numeric_limits<int64_t>::max(), 2}));
+  std::shared_ptr<arrow::Array> keys, values;
+  ARROW_EXPECT_OK(key_builder.Finish(&keys));
+  ARROW_EXPECT_OK(value_builder.Finish(&values));
+  auto aggregator =
+      HashAggregator::Make(schema, {"key"}, {{AggregateKind::Sum, "value"}}).ValueOrDie();
+  ASSERT_OK(aggregator->Consume(*arrow::RecordBatch::Make(schema, 2, {keys, values})));
+
+  auto result = aggregator->Finalize().ValueOrDie();
+  auto sums = std::static_pointer_cast<arrow::Int64Array>(result->column(1));
+  ASSERT_EQ(sums->Value(0), std::numeric_limits<int64_t>::min() + 1);
+}
+
+TEST(HashAggregator, InvalidSpecs) {
+  ASSERT_RAISES(Invalid, HashAggregator::Make(InputSchema(), {"missing"}, Specs()));
+  ASSERT_RAISES(Invalid, HashAggregator::Make(InputSchema(), {"name"},
+                                              {{AggregateKind::Sum, ""}}));
+  ASSERT_RAISES(NotImplemented, HashAggregator::Make(InputSchema(), {"value"}, Specs()));
+}
+
+}  // namespace Buzz
@@ -0,0 +1,64 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <arrow/util/hashing.h>
+
+#include <cstdint>
+
+namespace Buzz {
+
+namespace hashing {
+
+inline constexpr uint64_t NULL_HASH = 0x9e3779b97f4a7c15ULL;
+
+/// Murmur3 64 bit finalizer, good enough mixing for integer keys
+inline uint64_t HashInt(uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+inline uint64_t HashBytes(const void* data, int64_t length) {
+  return arrow::internal::ComputeStringHash<0>(data, length);
+}
+
+/// The high bits of the arrow small string hash are poorly mixed, use this one to index
+/// on them (e.g. the HyperLogLog registers)
+inline uint64_t FinalizedHashBytes(const void* data, int64_t length) {
+  return HashInt(HashBytes(data, length));
+}
+
+inline uint64_t CombineHashes(uint64_t seed, uint64_t hash) {
+  return seed ^ (hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+/// Hash a batch of integers. Branchless so that the compiler can vectorize it.
+template <typename T>
+void HashInts(const T* values, int64_t length, uint64_t* out) {
+  for (int64_t i = 0; i < length; i++) {
+    out[i] = HashInt(static_cast<uint64_t>(values[i]));
+  }
+}
+
+}  // namespace hashing
+
+}  // namespace Buzz
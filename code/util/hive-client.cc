@@ -0,0 +1,109 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "hive-client.h"
+
+#include <arrow/flight/api.h>
+
+namespace Buzz {
+
+HiveClient::HiveClient(std::unique_ptr<arrow::flight::FlightClient> client)
+    : client_(std::move(client)) {}
+
+HiveClient::~HiveClient() = default;
+
+Result<std::unique_ptr<HiveClient>> HiveClient::Connect(const std::string& endpoint) {
+  arrow::flight::Location location;
+  RETURN_NOT_OK(arrow::flight::Location::Parse("grpc+tcp://" + endpoint, &location));
+  std::unique_ptr<arrow::flight::FlightClient> client;
+  RETURN_NOT_OK(arrow::flight::FlightClient::Connect(location, &client));
+  return std::unique_ptr<HiveClient>(new HiveClient(std::move(client)));
+}
+
+Status HiveClient::Send(const std::string& command,
+                        const std::shared_ptr<arrow::Schema>& schema,
+                        const std::vector<std::shared_ptr<arrow::RecordBatch>>& batches,
+                        const arrow::ipc::IpcWriteOptions& write_options) {
+  arrow::flight::FlightCallOptions call_options;
+  call_options.write_options = write_options;
+  std::unique_ptr<arrow::flight::FlightStreamWriter> writer;
+  std::unique_ptr<arrow::flight::FlightMetadataReader> metadata_reader;
+  RETURN_NOT_OK(client_->DoPut(call_options,
+                               arrow::flight::FlightDescriptor::Command(command),
+                               schema, &writer, &metadata_reader));
+  for (auto& batch : batches) {
+    RETURN_NOT_OK(writer->WriteRecordBatch(*batch));
+  }
+  RETURN_NOT_OK(writer->DoneWriting());
+  return writer->Close();
+}
+
+Result<std::vector<std::string>> HiveClient::DoAction(const std::string& type,
+                                                      const std::string& body) {
+  arrow::flight::Action action{type, arrow::Buffer::FromString(body)};
+  std::unique_ptr<arrow::flight::ResultStream> stream;
+  RETURN_NOT_OK(client_->DoAction(action, &stream));
+  std::vector<std::string> results;
+  while (true) {
+    std::unique_ptr<arrow::flight::Result> result;
+    RETURN_NOT_OK(stream->Next(&result));
+    if (result == nullptr) {
+      break;
+    }
+    results.push_back(result->body->ToString());
+  }
+  return results;
+}
+
+Status HiveClient::RegisterTasks(const std::string& query_id, int nb_tasks) {
+  return DoAction("register_tasks", query_id + ":" + std::to_string(nb_tasks)).status();
+}
+
+Result<std::vector<int>> HiveClient::TakeStragglers(const std::string& query_id) {
+  ARROW_ASSIGN_OR_RAISE(auto results, DoAction("take_stragglers", query_id));
+  std::vector<int> stragglers;
+  for (auto& result : results) {
+    stragglers.push_back(std::stoi(result));
+  }
+  return stragglers;
+}
+
+Result<int> HiveClient::CompletedTasks(const std::string& query_id) {
+  ARROW_ASSIGN_OR_RAISE(auto results, DoAction("completed_tasks", query_id));
+  if (results.size() != 1) {
+    return Status::IOError("Unexpected completed_tasks response for ", query_id);
+  }
+  return std::stoi(results[0]);
+}
+
+Result<std::shared_ptr<arrow::Table>> HiveClient::GetResult(const std::string& query_id) {
+  std::unique_ptr<arrow::flight::FlightStreamReader> reader;
+  RETURN_NOT_OK(client_->DoGet(arrow::flight::Ticket{query_id}, &reader));
+  std::shared_ptr<arrow::Table> table;
+  RETURN_NOT_OK(reader->ReadAll(&table));
+  return table;
+}
+
+Status SendToHive(const std::string& endpoint, const std::string& command,
+                  const std::shared_ptr<arrow::Schema>& schema,
+                  const std::vector<std::shared_ptr<arrow::RecordBatch>>& batches,
+                  const arrow::ipc::IpcWriteOptions& write_options) {
+  ARROW_ASSIGN_OR_RAISE(auto client, HiveClient::Connect(endpoint));
+  return client->Send(command, schema, batches, write_options);
+}
+
+}  // namespace Buzz
@@ -0,0 +1,80 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/ipc/options.h>
+#include <result.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace arrow {
+namespace flight {
+class FlightClient;
+}  // namespace flight
+}  // namespace arrow
+
+namespace Buzz {
+
+/// Client of the hive Flight server
+class HiveClient {
+ public:
+  /// Connect to the hive at `endpoint` ("host:port")
+  static Result<std::unique_ptr<HiveClient>> Connect(const std::string& endpoint);
+
+  ~HiveClient();
+
+  /// Send partial aggregates as one DoPut stream tagged with `command` (a query id or a
+  /// task command, see MakeTaskCommand()), the batches are written with `write_options`
+  /// (e.g. to compress them, see MakeIpcWriteOptions()). A stream without batches still
+  /// tells the hive that the task is complete.
+  Status Send(const std::string& command, const std::shared_ptr<arrow::Schema>& schema,
+              const std::vector<std::shared_ptr<arrow::RecordBatch>>& batches,
+              const arrow::ipc::IpcWriteOptions& write_options);
+
+  /// Start tracking the `nb_tasks` bee tasks of a query, invoked now
+  Status RegisterTasks(const std::string& query_id, int nb_tasks);
+
+  /// The straggling tasks of the query that should be invoked again
+  Result<std::vector<int>> TakeStragglers(const std::string& query_id);
+
+  /// The number of tasks of the query with a complete result
+  Result<int> CompletedTasks(const std::string& query_id);
+
+  /// The merged aggregates of the query, which is then forgotten by the hive
+  Result<std::shared_ptr<arrow::Table>> GetResult(const std::string& query_id);
+
+ private:
+  explicit HiveClient(std::unique_ptr<arrow::flight::FlightClient> client);
+
+  /// Run an action and return the bodies of its results
+  Result<std::vector<std::string>> DoAction(const std::string& type,
+                                            const std::string& body);
+
+  std::unique_ptr<arrow::flight::FlightClient> client_;
+};
+
+/// Send partial aggregates to the hive at `endpoint` with a new connection
+Status SendToHive(const std::string& endpoint, const std::string& command,
+                  const std::shared_ptr<arrow::Schema>& schema,
+                  const std::vector<std::shared_ptr<arrow::RecordBatch>>& batches,
+                  const arrow::ipc::IpcWriteOptions& write_options);
+
+}  // namespace Buzz
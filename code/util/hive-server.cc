@@ -0,0 +1,299 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "hive-server.h"
+
+#include <condition_variable>
+#include <iostream>
+
+#include "cpu-topology.h"
+#include "partitioned-merger.h"
+
+namespace Buzz {
+
+struct QueryMerge {
+  /// guards the creation of the merger and the stream count, not the merges
+  std::mutex mutex;
+  std::unique_ptr<PartitionedMerger> merger;
+  int64_t merged_streams = 0;
+  /// set if the bee tasks of the query were registered
+  std::shared_ptr<TaskTracker> tracker;
+  int64_t duplicate_streams = 0;
+  /// streams whose batches are not all merged yet, DoGet waits for them
+  int64_t merging_streams = 0;
+  std::condition_variable streams_merged;
+  /// first merge failure, the merged partial aggregates are then incomplete
+  Status merge_status;
+};
+
+HiveFlightServer::HiveFlightServer(HiveServerOptions options)
+    : options_(std::move(options)) {}
+
+Status HiveFlightServer::ListFlights(
+    const arrow::flight::ServerCallContext& context,
+    const arrow::flight::Criteria* criteria,
+    std::unique_ptr<arrow::flight::FlightListing>* listings) {
+  std::vector<arrow::flight::FlightInfo> flights;
+  std::lock_guard<std::mutex> lock(queries_mutex_);
+  for (auto& query : queries_) {
+    std::lock_guard<std::mutex> query_lock(query.second->mutex);
+    flights.push_back(arrow::flight::FlightInfo(arrow::flight::FlightInfo::Data{
+        .schema = "",
+        .descriptor = arrow::flight::FlightDescriptor::Command(query.first),
+        .endpoints = {},
+        .total_records = query.second->merged_streams,
+        .total_bytes = -1,
+    }));
+  }
+  *listings = std::unique_ptr<arrow::flight::FlightListing>(
+      new arrow::flight::SimpleFlightListing(flights));
+  return Status::OK();
+}
+
+Status HiveFlightServer::DoPut(
+    const arrow::flight::ServerCallContext& context,
+    std::unique_ptr<arrow::flight::FlightMessageReader> reader,
+    std::unique_ptr<arrow::flight::FlightMetadataWriter> writer) {
+  auto& descriptor = reader->descriptor();
+  if (descriptor.type != arrow::flight::FlightDescriptor::CMD) {
+    return Status::Invalid("Partial aggregates should be tagged with a query id");
+  }
+  ARROW_ASSIGN_OR_RAISE(auto schema, reader->GetSchema());
+  ARROW_ASSIGN_OR_RAISE(auto command, ParseTaskCommand(descriptor.cmd));
+  auto& query_id = command.first;
+  auto query = GetOrCreateQuery(query_id);
+  if (query == nullptr && command.second.has_value()) {
+    // typically the duplicate of a speculated task, its result was already merged
+    arrow::flight::FlightStreamChunk chunk;
+    do {
+      RETURN_NOT_OK(reader->Next(&chunk));
+    } while (chunk.data != nullptr);
+    std::cout << "query:" << query_id << "/late_task:" << command.second.value()
+              << std::endl;
+    return Status::OK();
+  }
+  if (query == nullptr) {
+    return Status::Invalid("Query ", query_id, " is already finished");
+  }
+  std::shared_ptr<TaskTracker> tracker;
+  {
+    std::lock_guard<std::mutex> lock(query->mutex);
+    if (query->merger == nullptr) {
+      auto num_partitions = options_.merge_partitions > 0
+                                ? options_.merge_partitions
+                                : CpuTopology::Detect().usable_cpus();
+      ARROW_ASSIGN_OR_RAISE(query->merger,
+                            PartitionedMerger::Make(schema, num_partitions));
+    } else if (!schema->Equals(*query->merger->partial_schema())) {
+      return Status::Invalid("Partial aggregates do not match query ", query_id);
+    }
+    if (command.second.has_value()) {
+      tracker = query->tracker;
+    }
+    query->merging_streams++;
+  }
+  Status status;
+  if (tracker != nullptr) {
+    status = MergeTaskStream(query, tracker, command.second.value(), reader.get());
+  } else {
+    status = MergeStream(query, reader.get());
+  }
+  std::lock_guard<std::mutex> lock(query->mutex);
+  if (!status.ok() && query->merge_status.ok()) {
+    query->merge_status = status;
+  }
+  if (--query->merging_streams == 0) {
+    query->streams_merged.notify_all();
+  }
+  return status;
+}
+
+Status HiveFlightServer::DoGet(const arrow::flight::ServerCallContext& context,
+                               const arrow::flight::Ticket& request,
+                               std::unique_ptr<arrow::flight::FlightDataStream>* stream) {
+  auto query = TakeQuery(request.ticket);
+  if (query == nullptr) {
+    return Status::KeyError("No partial aggregates for query ", request.ticket);
+  }
+  std::unique_lock<std::mutex> lock(query->mutex);
+  // a task is complete before its batches are merged
+  query->streams_merged.wait(lock, [&query] { return query->merging_streams == 0; });
+  ARROW_ASSIGN_OR_RAISE(auto result, query->merger->Finalize());
+  if (!query->merge_status.ok()) {
+    return Status::Invalid("Partial aggregates of query ", request.ticket,
+                           " are incomplete: ", query->merge_status.ToString());
+  }
+  std::cout << "query:" << request.ticket << "/merged_streams:" << query->merged_streams
+            << "/duplicate_streams:" << query->duplicate_streams
+            << "/groups:" << result->num_rows() << std::endl;
+  ARROW_ASSIGN_OR_RAISE(auto batch_reader,
+                        arrow::RecordBatchReader::Make({result}, result->schema()));
+  *stream = std::unique_ptr<arrow::flight::FlightDataStream>(
+      new arrow::flight::RecordBatchStream(batch_reader));
+  return Status::OK();
+}
+
+Status HiveFlightServer::DoAction(const arrow::flight::ServerCallContext& context,
+                                  const arrow::flight::Action& action,
+                                  std::unique_ptr<arrow::flight::ResultStream>* result) {
+  auto body = action.body == nullptr ? "" : action.body->ToString();
+  std::vector<std::string> results;
+  if (action.type == "register_tasks") {
+    // body is "<query_id>:<nb_tasks>"
+    ARROW_ASSIGN_OR_RAISE(auto command, ParseTaskCommand(body));
+    if (!command.second.has_value()) {
+      return Status::Invalid("register_tasks expects <query_id>:<nb_tasks>");
+    }
+    auto query = GetOrCreateQuery(command.first);
+    if (query == nullptr) {
+      return Status::Invalid("Query ", command.first, " is already finished");
+    }
+    std::lock_guard<std::mutex> lock(query->mutex);
+    query->tracker = std::make_shared<TaskTracker>(command.second.value(),
+                                                   options_.speculation, time::now());
+  } else if (action.type == "take_stragglers") {
+    auto tracker = GetTracker(body);
+    if (tracker == nullptr) {
+      return Status::KeyError("No tasks registered for query ", body);
+    }
+    for (auto task_id : tracker->TakeStragglers(time::now())) {
+      std::cout << "query:" << body << "/speculated_task:" << task_id << std::endl;
+      results.push_back(std::to_string(task_id));
+    }
+  } else if (action.type == "completed_tasks") {
+    auto tracker = GetTracker(body);
+    if (tracker == nullptr) {
+      return Status::KeyError("No tasks registered for query ", body);
+    }
+    results.push_back(std::to_string(tracker->nb_completed()));
+  } else {
+    return Status::NotImplemented("Unknown action ", action.type);
+  }
+  std::vector<arrow::flight::Result> flight_results;
+  for (auto& result_body : results) {
+    flight_results.push_back({arrow::Buffer::FromString(result_body)});
+  }
+  *result = std::unique_ptr<arrow::flight::ResultStream>(
+      new arrow::flight::SimpleResultStream(std::move(flight_results)));
+  return Status::OK();
+}
+
+Status HiveFlightServer::ListActions(const arrow::flight::ServerCallContext& context,
+                                     std::vector<arrow::flight::ActionType>* actions) {
+  *actions = {{"register_tasks", "Track the tasks of a query: <query_id>:<nb_tasks>"},
+              {"take_stragglers", "Tasks of a query to invoke again: <query_id>"},
+              {"completed_tasks", "Number of complete tasks of a query: <query_id>"}};
+  return Status::OK();
+}
+
+Status HiveFlightServer::MergeStream(const std::shared_ptr<QueryMerge>& query,
+                                     arrow::flight::FlightMessageReader* reader) {
+  // the batches are split on the stream thread and merged by the workers
+  arrow::flight::FlightStreamChunk chunk;
+  while (true) {
+    RETURN_NOT_OK(reader->Next(&chunk));
+    if (chunk.data == nullptr) {
+      break;
+    }
+    RETURN_NOT_OK(query->merger->Merge(chunk.data));
+  }
+  std::lock_guard<std::mutex> lock(query->mutex);
+  query->merged_streams++;
+  return Status::OK();
+}
+
+Status HiveFlightServer::MergeTaskStream(const std::shared_ptr<QueryMerge>& query,
+                                         const std::shared_ptr<TaskTracker>& tracker,
+                                         int task_id,
+                                         arrow::flight::FlightMessageReader* reader) {
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  arrow::flight::FlightStreamChunk chunk;
+  while (true) {
+    RETURN_NOT_OK(reader->Next(&chunk));
+    if (chunk.data == nullptr) {
+      break;
+    }
+    RETURN_NOT_OK(tracker->Progress(task_id, chunk.data->num_rows(), time::now()));
+    batches.push_back(chunk.data);
+  }
+  ARROW_ASSIGN_OR_RAISE(auto first, tracker->Complete(task_id, time::now()));
+  if (!first) {
+    std::lock_guard<std::mutex> lock(query->mutex);
+    query->duplicate_streams++;
+    return Status::OK();
+  }
+  for (auto& batch : batches) {
+    auto status = query->merger->Merge(batch);
+    if (!status.ok()) {
+      // the query fails anyway, but the tracker should not count the task as done
+      (void)tracker->Reopen(task_id, time::now());
+      return status;
+    }
+  }
+  std::lock_guard<std::mutex> lock(query->mutex);
+  query->merged_streams++;
+  return Status::OK();
+}
+
+std::shared_ptr<QueryMerge> HiveFlightServer::GetOrCreateQuery(
+    const std::string& query_id) {
+  std::lock_guard<std::mutex> lock(queries_mutex_);
+  if (finished_queries_.count(query_id) > 0) {
+    return nullptr;
+  }
+  auto& query = queries_[query_id];
+  if (query == nullptr) {
+    query = std::make_shared<QueryMerge>();
+  }
+  return query;
+}
+
+std::shared_ptr<TaskTracker> HiveFlightServer::GetTracker(const std::string& query_id) {
+  std::lock_guard<std::mutex> lock(queries_mutex_);
+  auto query_it = queries_.find(query_id);
+  if (query_it == queries_.end()) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> query_lock(query_it->second->mutex);
+  return query_it->second->tracker;
+}
+
+std::shared_ptr<QueryMerge> HiveFlightServer::TakeQuery(const std::string& query_id) {
+  std::lock_guard<std::mutex> lock(queries_mutex_);
+  auto query_it = queries_.find(query_id);
+  if (query_it == queries_.end()) {
+    return nullptr;
+  }
+  auto query = query_it->second;
+  {
+    // the merger is created by DoPut under the query mutex
+    std::lock_guard<std::mutex> query_lock(query->mutex);
+    if (query->merger == nullptr) {
+      return nullptr;
+    }
+  }
+  queries_.erase(query_it);
+  finished_queries_.insert(query_id);
+  finished_order_.push_back(query_id);
+  if (finished_order_.size() > kMaxFinishedQueries) {
+    finished_queries_.erase(finished_order_.front());
+    finished_order_.pop_front();
+  }
+  return query;
+}
+
+}  // namespace Buzz
@@ -0,0 +1,114 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <arrow/flight/api.h>
+#include <result.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "task-tracker.h"
+
+namespace Buzz {
+
+struct HiveServerOptions {
+  /// number of merge workers of each query, the usable CPUs (affinity and quota) if 0
+  int merge_partitions = 0;
+  /// applied to the queries that register their tasks
+  SpeculationOptions speculation;
+};
+
+/// Partial aggregates of a query merged so far
+struct QueryMerge;
+
+/// The hive reduces the partial aggregates of the bees:
+/// - each bee DoPuts the batches returned by HashAggregator::Finish() with the query id
+///   as descriptor command, they are merged into the partitioned hash tables of the
+///   query as they arrive
+/// - once all the bees are done, DoGet with the query id as ticket waits for the streams
+///   still being merged, streams the final result and forgets the query
+/// - if the scheduler registered the tasks of the query ("register_tasks" action), the
+///   bees tag their stream with their task (see MakeTaskCommand()). The streams of a
+///   task are then buffered and only the first complete one is merged, so that the
+///   straggling tasks ("take_stragglers" action) can be invoked again
+/// - the late streams of the tasks of a query already returned by DoGet are dropped,
+///   the other streams of such a query are rejected
+/// - if a stream fails to merge, its task is reopened and DoGet fails rather than
+///   returning partial aggregates
+class HiveFlightServer : public arrow::flight::FlightServerBase {
+ public:
+  explicit HiveFlightServer(HiveServerOptions options = HiveServerOptions());
+
+  Status ListFlights(const arrow::flight::ServerCallContext& context,
+                     const arrow::flight::Criteria* criteria,
+                     std::unique_ptr<arrow::flight::FlightListing>* listings) override;
+
+  Status DoPut(const arrow::flight::ServerCallContext& context,
+               std::unique_ptr<arrow::flight::FlightMessageReader> reader,
+               std::unique_ptr<arrow::flight::FlightMetadataWriter> writer) override;
+
+  Status DoGet(const arrow::flight::ServerCallContext& context,
+               const arrow::flight::Ticket& request,
+               std::unique_ptr<arrow::flight::FlightDataStream>* stream) override;
+
+  Status DoAction(const arrow::flight::ServerCallContext& context,
+                  const arrow::flight::Action& action,
+                  std::unique_ptr<arrow::flight::ResultStream>* result) override;
+
+  Status ListActions(const arrow::flight::ServerCallContext& context,
+                     std::vector<arrow::flight::ActionType>* actions) override;
+
+ private:
+  /// Merge the batches of an untagged stream as they arrive
+  Status MergeStream(const std::shared_ptr<QueryMerge>& query,
+                     arrow::flight::FlightMessageReader* reader);
+
+  /// Buffer the stream of a task and merge it if it is the first complete one, a
+  /// speculated task might still be running and send a duplicate result
+  Status MergeTaskStream(const std::shared_ptr<QueryMerge>& query,
+                         const std::shared_ptr<TaskTracker>& tracker, int task_id,
+                         arrow::flight::FlightMessageReader* reader);
+
+  /// Null if the query was already returned by DoGet
+  std::shared_ptr<QueryMerge> GetOrCreateQuery(const std::string& query_id);
+
+  std::shared_ptr<TaskTracker> GetTracker(const std::string& query_id);
+
+  /// Remove the query if it received partial aggregates, it is then remembered as
+  /// finished
+  std::shared_ptr<QueryMerge> TakeQuery(const std::string& query_id);
+
+  /// number of finished query ids remembered to recognize their late streams
+  static constexpr size_t kMaxFinishedQueries = 4096;
+
+  HiveServerOptions options_;
+  /// only guards the containers, each query has its own merge workers
+  std::mutex queries_mutex_;
+  std::unordered_map<std::string, std::shared_ptr<QueryMerge>> queries_;
+  std::unordered_set<std::string> finished_queries_;
+  /// the finished query ids from the oldest, to forget them
+  std::deque<std::string> finished_order_;
+};
+
+}  // namespace Buzz
@@ -0,0 +1,153 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "hive-server.h"
+
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+
+#include <map>
+
+#include "hash-aggregator.h"
+#include "hive-client.h"
+
+namespace Buzz {
+
+namespace {
+
+std::shared_ptr<arrow::Schema> InputSchema() {
+  return arrow::schema(
+      {arrow::field("name", arrow::utf8()), arrow::field("value", arrow::int64())});
+}
+
+/// Partial aggregates of a bee: name = "n" + ((i + offset) % 10), value = i
+std::shared_ptr<arrow::RecordBatch> MakePartial(int nb_rows, int offset) {
+  arrow::StringBuilder name_builder;
+  arrow::Int64Builder value_builder;
+  for (int i = 0; i < nb_rows; i++) {
+    ARROW_EXPECT_OK(name_builder.Append("n" + std::to_string((i + offset) % 10)));
+    ARROW_EXPECT_OK(value_builder.Append(i));
+  }
+  std::shared_ptr<arrow::Array> names, values;
+  ARROW_EXPECT_OK(name_builder.Finish(&names));
+  ARROW_EXPECT_OK(value_builder.Finish(&values));
+  std::vector<AggregateSpec> specs = {{AggregateKind::Count, ""},
+                                      {AggregateKind::Sum, "value"}};
+  auto bee = HashAggregator::Make(InputSchema(), {"name"}, specs).ValueOrDie();
+  ARROW_EXPECT_OK(
+      bee->Consume(*arrow::RecordBatch::Make(InputSchema(), nb_rows, {names, values})));
+  return bee->Finish().ValueOrDie();
+}
+
+/// name -> (count, sum)
+std::map<std::string, std::pair<int64_t, int64_t>> ToMap(const arrow::Table& table) {
+  auto combined = table.CombineChunks().ValueOrDie();
+  std::map<std::string, std::pair<int64_t, int64_t>> rows;
+  if (combined->num_rows() == 0) {
+    return rows;
+  }
+  auto column = [&combined](int i) { return combined->column(i)->chunk(0); };
+  auto names = std::static_pointer_cast<arrow::StringArray>(column(0));
+  auto counts = std::static_pointer_cast<arrow::Int64Array>(column(1));
+  auto sums = std::static_pointer_cast<arrow::Int64Array>(column(2));
+  for (int64_t i = 0; i < combined->num_rows(); i++) {
+    rows[names->GetString(i)] = {counts->Value(i), sums->Value(i)};
+  }
+  return rows;
+}
+
+/// The partials merged by a single aggregator
+std::map<std::string, std::pair<int64_t, int64_t>> MergeLocally(
+    const std::vector<std::shared_ptr<arrow::RecordBatch>>& partials) {
+  auto aggregator =
+      HashAggregator::MakeFromPartialSchema(partials[0]->schema()).ValueOrDie();
+  for (auto& partial : partials) {
+    ARROW_EXPECT_OK(aggregator->Merge(*partial));
+  }
+  auto result = aggregator->Finish().ValueOrDie();
+  return ToMap(*arrow::Table::FromRecordBatches({result}).ValueOrDie());
+}
+
+/// Start a hive on a free local port
+std::unique_ptr<HiveFlightServer> StartServer() {
+  HiveServerOptions options;
+  options.merge_partitions = 2;
+  auto server = std::make_unique<HiveFlightServer>(options);
+  arrow::flight::Location location;
+  ARROW_EXPECT_OK(arrow::flight::Location::ForGrpcTcp("localhost", 0, &location));
+  ARROW_EXPECT_OK(server->Init(arrow::flight::FlightServerOptions(location)));
+  return server;
+}
+
+}  // namespace
+
+TEST(HiveServer, LoopbackMerge) {
+  auto server = StartServer();
+  auto client = HiveClient::Connect("localhost:" + std::to_string(server->port()));
+  ASSERT_OK(client.status());
+  auto& hive = *client.ValueOrDie();
+
+  auto partial_1 = MakePartial(50, 0);
+  auto partial_2 = MakePartial(80, 3);
+  auto schema = partial_1->schema();
+  auto write_options = arrow::ipc::IpcWriteOptions::Defaults();
+  ASSERT_OK(hive.Send("query", schema, {partial_1}, write_options));
+  ASSERT_OK(hive.Send("query", schema, {partial_2}, write_options));
+  auto result = hive.GetResult("query");
+  ASSERT_OK(result.status());
+  auto expected = MergeLocally({partial_1, partial_2});
+  ASSERT_EQ(expected.size(), 10);
+  ASSERT_EQ(ToMap(*result.ValueOrDie()), expected);
+
+  // the query is forgotten once its result was read
+  ASSERT_FALSE(hive.GetResult("query").ok());
+  ASSERT_OK(server->Shutdown());
+}
+
+TEST(HiveServer, TaskStreams) {
+  auto server = StartServer();
+  auto client = HiveClient::Connect("localhost:" + std::to_string(server->port()));
+  ASSERT_OK(client.status());
+  auto& hive = *client.ValueOrDie();
+  ASSERT_OK(hive.RegisterTasks("query", 3));
+
+  auto partial_0 = MakePartial(50, 0);
+  auto partial_2 = MakePartial(80, 3);
+  auto schema = partial_0->schema();
+  auto write_options = arrow::ipc::IpcWriteOptions::Defaults();
+  ASSERT_OK(hive.Send(MakeTaskCommand("query", 0), schema, {partial_0}, write_options));
+  // a task without any group still completes
+  ASSERT_OK(hive.Send(MakeTaskCommand("query", 1), schema, {}, write_options));
+  ASSERT_OK(hive.Send(MakeTaskCommand("query", 2), schema, {partial_2}, write_options));
+  // the duplicate of a speculated task is not merged
+  ASSERT_OK(hive.Send(MakeTaskCommand("query", 2), schema, {partial_2}, write_options));
+  ASSERT_EQ(hive.CompletedTasks("query").ValueOrDie(), 3);
+
+  auto result = hive.GetResult("query");
+  ASSERT_OK(result.status());
+  ASSERT_EQ(ToMap(*result.ValueOrDie()), MergeLocally({partial_0, partial_2}));
+
+  // a straggler answering after the result was read is dropped without reviving the
+  // query, the untagged streams are rejected
+  ASSERT_OK(hive.Send(MakeTaskCommand("query", 2), schema, {partial_2}, write_options));
+  ASSERT_FALSE(hive.Send("query", schema, {partial_2}, write_options).ok());
+  ASSERT_FALSE(hive.RegisterTasks("query", 3).ok());
+  ASSERT_FALSE(hive.GetResult("query").ok());
+  ASSERT_OK(server->Shutdown());
+}
+
+}  // namespace Buzz
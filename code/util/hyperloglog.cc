@@ -0,0 +1,159 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "hyperloglog.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "serialization.h"
+
+namespace Buzz {
+
+namespace {
+
+constexpr uint8_t DENSE_FORMAT = 0;
+constexpr uint8_t SPARSE_FORMAT = 1;
+
+}  // namespace
+
+HyperLogLog::HyperLogLog(int precision)
+    : precision_(precision), registers_(size_t{1} << precision, 0) {}
+
+Result<HyperLogLog> HyperLogLog::Make(int precision) {
+  if (precision < MIN_PRECISION || precision > MAX_PRECISION) {
+    return Status::Invalid("HyperLogLog precision should be between ", MIN_PRECISION,
+                           " and ", MAX_PRECISION, ", got ", precision);
+  }
+  return HyperLogLog(precision);
+}
+
+void HyperLogLog::UpdateHashes(const uint64_t* hashes, int64_t length) {
+  auto registers = registers_.data();
+  auto index_shift = 64 - precision_;
+  // the guard bit bounds the rank when all the remaining bits are zero
+  auto guard_bit = uint64_t{1} << (precision_ - 1);
+  for (int64_t i = 0; i < length; i++) {
+    auto index = hashes[i] >> index_shift;
+    auto rank =
+        static_cast<uint8_t>(__builtin_clzll((hashes[i] << precision_) | guard_bit) + 1);
+    registers[index] = std::max(registers[index], rank);
+  }
+}
+
+void HyperLogLog::Update(const parquet::ByteArray* values, int64_t length) {
+  uint64_t hashes[HASH_BATCH_SIZE];
+  for (int64_t offset = 0; offset < length; offset += HASH_BATCH_SIZE) {
+    auto batch_length = std::min(HASH_BATCH_SIZE, length - offset);
+    for (int64_t i = 0; i < batch_length; i++) {
+      auto& value = values[offset + i];
+      hashes[i] = hashing::FinalizedHashBytes(value.ptr, value.len);
+    }
+    UpdateHashes(hashes, batch_length);
+  }
+}
+
+double HyperLogLog::Estimate() const {
+  double nb_registers = registers_.size();
+  double inverse_sum = 0;
+  int64_t zeros = 0;
+  for (auto value : registers_) {
+    inverse_sum += std::ldexp(1., -value);
+    zeros += value == 0;
+  }
+  double alpha;
+  switch (precision_) {
+    case 4:
+      alpha = 0.673;
+      break;
+    case 5:
+      alpha = 0.697;
+      break;
+    case 6:
+      alpha = 0.709;
+      break;
+    default:
+      alpha = 0.7213 / (1. + 1.079 / nb_registers);
+  }
+  double estimate = alpha * nb_registers * nb_registers / inverse_sum;
+  // linear counting is more accurate for small cardinalities
+  if (estimate <= 2.5 * nb_registers && zeros > 0) {
+    return nb_registers * std::log(nb_registers / zeros);
+  }
+  return estimate;
+}
+
+Status HyperLogLog::Merge(const HyperLogLog& other) {
+  if (other.precision_ != precision_) {
+    return Status::Invalid("Cannot merge HyperLogLog sketches with precisions ",
+                           precision_, " and ", other.precision_);
+  }
+  for (size_t i = 0; i < registers_.size(); i++) {
+    registers_[i] = std::max(registers_[i], other.registers_[i]);
+  }
+  return Status::OK();
+}
+
+std::string HyperLogLog::Serialize() const {
+  std::string out;
+  auto non_zeros =
+      registers_.size() - std::count(registers_.begin(), registers_.end(), 0);
+  // sparse entries take 4 bytes: the register index and its value
+  bool sparse = non_zeros * sizeof(uint32_t) < registers_.size();
+  serialization::Write(&out, sparse ? SPARSE_FORMAT : DENSE_FORMAT);
+  serialization::Write(&out, static_cast<uint8_t>(precision_));
+  if (sparse) {
+    serialization::Write(&out, static_cast<uint32_t>(non_zeros));
+    for (uint32_t i = 0; i < registers_.size(); i++) {
+      if (registers_[i] != 0) {
+        serialization::Write(&out, i << 8 | registers_[i]);
+      }
+    }
+  } else {
+    out.append(reinterpret_cast<const char*>(registers_.data()), registers_.size());
+  }
+  return out;
+}
+
+Result<HyperLogLog> HyperLogLog::Deserialize(std::string_view data) {
+  uint8_t format, precision;
+  if (!serialization::Read(&data, &format) || !serialization::Read(&data, &precision)) {
+    return Status::Invalid("Malformed serialized HyperLogLog");
+  }
+  ARROW_ASSIGN_OR_RAISE(auto sketch, Make(precision));
+  if (format == DENSE_FORMAT && data.size() == sketch.registers_.size()) {
+    std::memcpy(sketch.registers_.data(), data.data(), data.size());
+    return sketch;
+  }
+  uint32_t nb_entries;
+  if (format != SPARSE_FORMAT || !serialization::Read(&data, &nb_entries) ||
+      data.size() != nb_entries * sizeof(uint32_t)) {
+    return Status::Invalid("Malformed serialized HyperLogLog");
+  }
+  for (uint32_t i = 0; i < nb_entries; i++) {
+    uint32_t entry = 0;
+    serialization::Read(&data, &entry);
+    auto index = entry >> 8;
+    if (index >= sketch.registers_.size()) {
+      return Status::Invalid("Malformed serialized HyperLogLog");
+    }
+    sketch.registers_[index] = static_cast<uint8_t>(entry);
+  }
+  return sketch;
+}
+
+}  // namespace Buzz
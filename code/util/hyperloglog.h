@@ -0,0 +1,95 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <parquet/types.h>
+#include <result.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "hashing.h"
+
+namespace Buzz {
+
+/// HyperLogLog sketch to estimate distinct counts.
+///
+/// Values are hashed by batches into a small buffer then scattered into 2^precision one
+/// byte registers, the relative error is about 1.04 / sqrt(2^precision). Sketches with
+/// the same precision can be merged, the bees send their Serialize() form to the hive.
+class HyperLogLog {
+ public:
+  static constexpr int MIN_PRECISION = 4;
+  static constexpr int MAX_PRECISION = 18;
+
+  static Result<HyperLogLog> Make(int precision = 14);
+
+  /// Add values that are already hashed
+  void UpdateHashes(const uint64_t* hashes, int64_t length);
+
+  void Update(const parquet::ByteArray* values, int64_t length);
+
+  /// Add numeric values, floating point values are hashed on their bit pattern
+  template <typename CType>
+  void Update(const CType* values, int64_t length) {
+    static_assert(std::is_arithmetic<CType>::value, "numeric values only");
+    uint64_t hashes[HASH_BATCH_SIZE];
+    for (int64_t offset = 0; offset < length; offset += HASH_BATCH_SIZE) {
+      auto batch_length = std::min(HASH_BATCH_SIZE, length - offset);
+      if constexpr (std::is_floating_point<CType>::value) {
+        for (int64_t i = 0; i < batch_length; i++) {
+          // -0.0 and 0.0 are the same value
+          CType value = values[offset + i] == 0 ? 0 : values[offset + i];
+          uint64_t bits = 0;
+          std::memcpy(&bits, &value, sizeof(CType));
+          hashes[i] = hashing::HashInt(bits);
+        }
+      } else {
+        hashing::HashInts(values + offset, batch_length, hashes);
+      }
+      UpdateHashes(hashes, batch_length);
+    }
+  }
+
+  /// Estimated number of distinct values
+  double Estimate() const;
+
+  Status Merge(const HyperLogLog& other);
+
+  int precision() const { return precision_; }
+
+  /// Compact form, only the non zero registers are written if they are few
+  std::string Serialize() const;
+
+  static Result<HyperLogLog> Deserialize(std::string_view data);
+
+ private:
+  static constexpr int64_t HASH_BATCH_SIZE = 1024;
+
+  explicit HyperLogLog(int precision);
+
+  int precision_;
+  std::vector<uint8_t> registers_;
+};
+
+}  // namespace Buzz
@@ -0,0 +1,100 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "hyperloglog.h"
+
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <vector>
+
+namespace Buzz {
+
+namespace {
+
+std::vector<int64_t> Range(int64_t start, int64_t end) {
+  std::vector<int64_t> values(end - start);
+  std::iota(values.begin(), values.end(), start);
+  return values;
+}
+
+}  // namespace
+
+TEST(HyperLogLog, Estimate) {
+  auto sketch = HyperLogLog::Make(14).ValueOrDie();
+  ASSERT_EQ(sketch.Estimate(), 0.);
+  auto values = Range(0, 1000);
+  // duplicates do not change the estimate
+  sketch.Update(values.data(), values.size());
+  sketch.Update(values.data(), values.size());
+  ASSERT_NEAR(sketch.Estimate(), 1000., 20.);
+
+  values = Range(0, 1000000);
+  sketch.Update(values.data(), values.size());
+  ASSERT_NEAR(sketch.Estimate(), 1000000., 30000.);
+}
+
+TEST(HyperLogLog, ByteArrays) {
+  auto sketch = HyperLogLog::Make(12).ValueOrDie();
+  std::vector<std::string> strings;
+  for (int i = 0; i < 5000; i++) {
+    strings.push_back("user_" + std::to_string(i % 2500));
+  }
+  std::vector<parquet::ByteArray> values;
+  for (auto& str : strings) {
+    values.emplace_back(str.size(), reinterpret_cast<const uint8_t*>(str.data()));
+  }
+  sketch.Update(values.data(), values.size());
+  ASSERT_NEAR(sketch.Estimate(), 2500., 150.);
+}
+
+TEST(HyperLogLog, MergeAndSerialize) {
+  auto bee1 = HyperLogLog::Make().ValueOrDie();
+  auto bee2 = HyperLogLog::Make().ValueOrDie();
+  auto single = HyperLogLog::Make().ValueOrDie();
+  auto first = Range(0, 100);
+  auto second = Range(50, 200000);
+  bee1.Update(first.data(), first.size());
+  bee2.Update(second.data(), second.size());
+  single.Update(first.data(), first.size());
+  single.Update(second.data(), second.size());
+
+  // the small sketch uses the sparse form
+  auto serialized1 = bee1.Serialize();
+  ASSERT_LT(serialized1.size(), 1000);
+  auto serialized2 = bee2.Serialize();
+  ASSERT_EQ(serialized2.size(), (1 << 14) + 2);
+
+  auto hive = HyperLogLog::Deserialize(serialized1).ValueOrDie();
+  ASSERT_EQ(hive.Estimate(), bee1.Estimate());
+  ASSERT_OK(hive.Merge(HyperLogLog::Deserialize(serialized2).ValueOrDie()));
+  ASSERT_EQ(hive.Estimate(), single.Estimate());
+
+  ASSERT_RAISES(Invalid, hive.Merge(HyperLogLog::Make(10).ValueOrDie()));
+  ASSERT_RAISES(Invalid, HyperLogLog::Make(30));
+  ASSERT_RAISES(Invalid, HyperLogLog::Deserialize(serialized2.substr(0, 100)));
+}
+
+TEST(HyperLogLog, FloatingPoint) {
+  auto sketch = HyperLogLog::Make().ValueOrDie();
+  std::vector<double> values = {0.5, 0.25, -0., 0., 0.5};
+  sketch.Update(values.data(), values.size());
+  ASSERT_NEAR(sketch.Estimate(), 3., 0.01);
+}
+
+}  // namespace Buzz
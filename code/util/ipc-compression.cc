@@ -0,0 +1,147 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ipc-compression.h"
+
+#include <arrow/io/memory.h>
+#include <arrow/ipc/dictionary.h>
+#include <arrow/ipc/reader.h>
+#include <arrow/ipc/writer.h>
+
+#include <algorithm>
+
+#include "toolbox.h"
+
+namespace Buzz {
+
+namespace {
+
+double SecondsSince(time::time_point start) {
+  return std::chrono::duration<double>(time::now() - start).count();
+}
+
+bool IsAvailable(arrow::Compression::type compression) {
+  return compression == arrow::Compression::UNCOMPRESSED ||
+         arrow::util::Codec::Create(compression).ok();
+}
+
+Result<IpcCodecProfile> ProfileIpcCompression(const arrow::RecordBatch& sample,
+                                              arrow::Compression::type compression,
+                                              int repetitions) {
+  ARROW_ASSIGN_OR_RAISE(auto options, MakeIpcWriteOptions(compression));
+  IpcCodecProfile profile{compression, 0, 0, 0., 0.};
+  std::shared_ptr<arrow::Buffer> encoded;
+  for (int i = 0; i < repetitions; i++) {
+    auto start = time::now();
+    ARROW_ASSIGN_OR_RAISE(encoded, arrow::ipc::SerializeRecordBatch(sample, options));
+    auto seconds = SecondsSince(start);
+    profile.encode_seconds = i == 0 ? seconds : std::min(profile.encode_seconds, seconds);
+  }
+  profile.encoded_bytes = encoded->size();
+  arrow::ipc::DictionaryMemo dictionary_memo;
+  for (int i = 0; i < repetitions; i++) {
+    auto start = time::now();
+    arrow::io::BufferReader reader(encoded);
+    ARROW_ASSIGN_OR_RAISE(auto decoded, arrow::ipc::ReadRecordBatch(
+                                            sample.schema(), &dictionary_memo,
+                                            arrow::ipc::IpcReadOptions::Defaults(),
+                                            &reader));
+    auto seconds = SecondsSince(start);
+    profile.decode_seconds = i == 0 ? seconds : std::min(profile.decode_seconds, seconds);
+  }
+  return profile;
+}
+
+}  // namespace
+
+Result<std::optional<arrow::Compression::type>> ParseIpcCompression(
+    const std::string& name) {
+  if (name == "auto") {
+    return std::nullopt;
+  }
+  if (name == "none") {
+    return arrow::Compression::UNCOMPRESSED;
+  }
+  if (name == "lz4") {
+    return arrow::Compression::LZ4_FRAME;
+  }
+  if (name == "zstd") {
+    return arrow::Compression::ZSTD;
+  }
+  return Status::Invalid("Unknown IPC compression: ", name);
+}
+
+Result<arrow::ipc::IpcWriteOptions> MakeIpcWriteOptions(
+    arrow::Compression::type compression) {
+  // only LZ4 frames and ZSTD are allowed in the IPC format
+  if (compression != arrow::Compression::UNCOMPRESSED &&
+      compression != arrow::Compression::LZ4_FRAME &&
+      compression != arrow::Compression::ZSTD) {
+    return Status::Invalid("Unsupported IPC compression: ",
+                           arrow::util::Codec::GetCodecAsString(compression));
+  }
+  if (!IsAvailable(compression)) {
+    return Status::NotImplemented("IPC compression not built: ",
+                                  arrow::util::Codec::GetCodecAsString(compression));
+  }
+  auto options = arrow::ipc::IpcWriteOptions::Defaults();
+  options.compression = compression;
+  return options;
+}
+
+double IpcCodecProfile::EstimateTransferSeconds(int64_t bytes,
+                                                double link_bytes_per_sec) const {
+  if (raw_bytes == 0) {
+    return 0.;
+  }
+  auto scale = static_cast<double>(bytes) / raw_bytes;
+  return scale * (encode_seconds + encoded_bytes / link_bytes_per_sec + decode_seconds);
+}
+
+Result<std::vector<IpcCodecProfile>> ProfileIpcCompressions(
+    const arrow::RecordBatch& sample, int repetitions) {
+  std::vector<IpcCodecProfile> profiles;
+  for (auto compression : {arrow::Compression::UNCOMPRESSED,
+                           arrow::Compression::LZ4_FRAME, arrow::Compression::ZSTD}) {
+    if (!IsAvailable(compression)) {
+      continue;
+    }
+    ARROW_ASSIGN_OR_RAISE(auto profile,
+                          ProfileIpcCompression(sample, compression, repetitions));
+    profiles.push_back(profile);
+  }
+  for (auto& profile : profiles) {
+    profile.raw_bytes = profiles[0].encoded_bytes;
+  }
+  return profiles;
+}
+
+arrow::Compression::type ChooseIpcCompression(
+    const std::vector<IpcCodecProfile>& profiles, double link_bytes_per_sec) {
+  auto best = arrow::Compression::UNCOMPRESSED;
+  double best_seconds = -1.;
+  for (auto& profile : profiles) {
+    auto seconds = profile.EstimateTransferSeconds(profile.raw_bytes, link_bytes_per_sec);
+    if (best_seconds < 0. || seconds < best_seconds) {
+      best = profile.compression;
+      best_seconds = seconds;
+    }
+  }
+  return best;
+}
+
+}  // namespace Buzz
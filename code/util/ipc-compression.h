@@ -0,0 +1,67 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+#include <arrow/ipc/options.h>
+#include <arrow/util/compression.h>
+#include <result.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Buzz {
+
+/// Parse the IPC compression of the batches sent to the hive: "none", "lz4" or "zstd".
+/// "auto" returns nullopt, the codec should then be chosen with ChooseIpcCompression().
+Result<std::optional<arrow::Compression::type>> ParseIpcCompression(
+    const std::string& name);
+
+/// IPC write options compressing the record batch bodies with `compression`
+Result<arrow::ipc::IpcWriteOptions> MakeIpcWriteOptions(
+    arrow::Compression::type compression);
+
+/// Cost of sending record batches with an IPC compression, measured on a sample batch
+struct IpcCodecProfile {
+  arrow::Compression::type compression;
+  /// size of the sample serialized without compression
+  int64_t raw_bytes;
+  /// size of the sample serialized with this compression
+  int64_t encoded_bytes;
+  /// time to serialize the sample on the sender
+  double encode_seconds;
+  /// time to read back the sample on the receiver
+  double decode_seconds;
+
+  /// Estimated time to encode, send and decode `bytes` of uncompressed IPC data similar
+  /// to the sample through a link of `link_bytes_per_sec`
+  double EstimateTransferSeconds(int64_t bytes, double link_bytes_per_sec) const;
+};
+
+/// Profile the IPC compressions available in this build on `sample`, each measure is the
+/// best of `repetitions` runs. The uncompressed profile always comes first.
+Result<std::vector<IpcCodecProfile>> ProfileIpcCompressions(
+    const arrow::RecordBatch& sample, int repetitions = 3);
+
+/// The compression with the lowest estimated transfer time for a link of
+/// `link_bytes_per_sec` (see IpcCodecProfile::EstimateTransferSeconds)
+arrow::Compression::type ChooseIpcCompression(
+    const std::vector<IpcCodecProfile>& profiles, double link_bytes_per_sec);
+
+}  // namespace Buzz
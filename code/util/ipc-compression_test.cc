@@ -0,0 +1,94 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "ipc-compression.h"
+
+#include <arrow/io/memory.h>
+#include <arrow/ipc/dictionary.h>
+#include <arrow/ipc/reader.h>
+#include <arrow/ipc/writer.h>
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+
+namespace Buzz {
+
+namespace {
+
+/// partial aggregates with few distinct keys, which compress well
+std::shared_ptr<arrow::RecordBatch> MakePartials(int nb_rows) {
+  arrow::StringBuilder key_builder;
+  arrow::Int64Builder count_builder;
+  for (int i = 0; i < nb_rows; i++) {
+    ARROW_EXPECT_OK(key_builder.Append("key-" + std::to_string(i % 10)));
+    ARROW_EXPECT_OK(count_builder.Append(i % 7));
+  }
+  std::shared_ptr<arrow::Array> keys, counts;
+  ARROW_EXPECT_OK(key_builder.Finish(&keys));
+  ARROW_EXPECT_OK(count_builder.Finish(&counts));
+  auto schema = arrow::schema(
+      {arrow::field("key", arrow::utf8()), arrow::field("count", arrow::int64())});
+  return arrow::RecordBatch::Make(schema, nb_rows, {keys, counts});
+}
+
+}  // namespace
+
+TEST(IpcCompression, Parse) {
+  ASSERT_EQ(ParseIpcCompression("none").ValueOrDie(), arrow::Compression::UNCOMPRESSED);
+  ASSERT_EQ(ParseIpcCompression("lz4").ValueOrDie(), arrow::Compression::LZ4_FRAME);
+  ASSERT_EQ(ParseIpcCompression("zstd").ValueOrDie(), arrow::Compression::ZSTD);
+  ASSERT_FALSE(ParseIpcCompression("auto").ValueOrDie().has_value());
+  ASSERT_RAISES(Invalid, ParseIpcCompression("gzip"));
+  ASSERT_RAISES(Invalid, MakeIpcWriteOptions(arrow::Compression::SNAPPY));
+}
+
+TEST(IpcCompression, RoundTrip) {
+  auto batch = MakePartials(10000);
+  auto profiles = ProfileIpcCompressions(*batch).ValueOrDie();
+  ASSERT_EQ(profiles[0].compression, arrow::Compression::UNCOMPRESSED);
+  for (auto& profile : profiles) {
+    auto options = MakeIpcWriteOptions(profile.compression).ValueOrDie();
+    auto encoded = arrow::ipc::SerializeRecordBatch(*batch, options).ValueOrDie();
+    ASSERT_EQ(encoded->size(), profile.encoded_bytes);
+    ASSERT_EQ(profile.raw_bytes, profiles[0].encoded_bytes);
+    arrow::ipc::DictionaryMemo dictionary_memo;
+    arrow::io::BufferReader reader(encoded);
+    auto decoded =
+        arrow::ipc::ReadRecordBatch(batch->schema(), &dictionary_memo,
+                                    arrow::ipc::IpcReadOptions::Defaults(), &reader)
+            .ValueOrDie();
+    ASSERT_TRUE(decoded->Equals(*batch));
+    if (profile.compression != arrow::Compression::UNCOMPRESSED) {
+      ASSERT_LT(profile.encoded_bytes, profile.raw_bytes);
+    }
+  }
+}
+
+TEST(IpcCompression, Choose) {
+  auto none = IpcCodecProfile{arrow::Compression::UNCOMPRESSED, 1000, 1000, 0., 0.};
+  auto lz4 = IpcCodecProfile{arrow::Compression::LZ4_FRAME, 1000, 500, 1e-6, 1e-6};
+  auto zstd = IpcCodecProfile{arrow::Compression::ZSTD, 1000, 200, 1e-5, 2e-6};
+  std::vector<IpcCodecProfile> profiles{none, lz4, zstd};
+  // 1000 bytes over 1GB/s take 1us, compressing is not worth it
+  ASSERT_EQ(ChooseIpcCompression(profiles, 1e9), arrow::Compression::UNCOMPRESSED);
+  // at 100MB/s: none 10us, lz4 2us + 5us, zstd 12us + 2us
+  ASSERT_EQ(ChooseIpcCompression(profiles, 1e8), arrow::Compression::LZ4_FRAME);
+  // at 1MB/s: none 1ms, lz4 0.5ms, zstd 0.2ms
+  ASSERT_EQ(ChooseIpcCompression(profiles, 1e6), arrow::Compression::ZSTD);
+  ASSERT_DOUBLE_EQ(zstd.EstimateTransferSeconds(2000, 1e6), 2 * (1.2e-5 + 2e-4));
+}
+
+}  // namespace Buzz
@@ -0,0 +1,191 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kll-sketch.h"
+
+#include <cstring>
+
+#include "serialization.h"
+
+namespace Buzz {
+
+namespace {
+
+/// Capacity ratio between two consecutive levels
+constexpr double LEVEL_CAPACITY_RATIO = 2. / 3.;
+
+}  // namespace
+
+KllSketch::KllSketch(int k) : k_(k) { AddLevel(); }
+
+Result<KllSketch> KllSketch::Make(int k) {
+  if (k < 8 || k > 65535) {
+    return Status::Invalid("KLL parameter k should be between 8 and 65535, got ", k);
+  }
+  return KllSketch(k);
+}
+
+int64_t KllSketch::LevelCapacity(size_t level) const {
+  auto depth = static_cast<int>(levels_.size() - level - 1);
+  return static_cast<int64_t>(std::ceil(std::pow(LEVEL_CAPACITY_RATIO, depth) * k_)) + 1;
+}
+
+void KllSketch::AddLevel() {
+  levels_.emplace_back();
+  max_size_ = 0;
+  for (size_t level = 0; level < levels_.size(); level++) {
+    max_size_ += LevelCapacity(level);
+  }
+}
+
+void KllSketch::Compress() {
+  for (size_t h = 0; h < levels_.size(); h++) {
+    if (static_cast<int64_t>(levels_[h].size()) < LevelCapacity(h)) {
+      continue;
+    }
+    if (h + 1 == levels_.size()) {
+      AddLevel();
+    }
+    auto& level = levels_[h];
+    auto& next_level = levels_[h + 1];
+    std::sort(level.begin(), level.end());
+    // with an odd size the smallest item stays on this level
+    size_t first = level.size() % 2;
+    size_t offset = random_() & 1;
+    auto nb_promoted = level.size() / 2;
+    for (size_t i = 0; i < nb_promoted; i++) {
+      next_level.push_back(level[first + 2 * i + offset]);
+    }
+    level.resize(first);
+    size_ -= nb_promoted;
+    if (size_ < max_size_) {
+      return;
+    }
+  }
+}
+
+Status KllSketch::Merge(const KllSketch& other) {
+  if (other.k_ != k_) {
+    return Status::Invalid("Cannot merge KLL sketches with k ", k_, " and ", other.k_);
+  }
+  while (levels_.size() < other.levels_.size()) {
+    AddLevel();
+  }
+  for (size_t h = 0; h < other.levels_.size(); h++) {
+    levels_[h].insert(levels_[h].end(), other.levels_[h].begin(), other.levels_[h].end());
+  }
+  size_ += other.size_;
+  count_ += other.count_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+  while (size_ >= max_size_) {
+    Compress();
+  }
+  return Status::OK();
+}
+
+double KllSketch::Quantile(double rank) const { return Quantiles({rank})[0]; }
+
+std::vector<double> KllSketch::Quantiles(const std::vector<double>& ranks) const {
+  std::vector<double> results;
+  if (count_ == 0) {
+    results.resize(ranks.size(), std::numeric_limits<double>::quiet_NaN());
+    return results;
+  }
+  // items sorted by value with their weight
+  std::vector<std::pair<double, int64_t>> items;
+  items.reserve(size_);
+  for (size_t h = 0; h < levels_.size(); h++) {
+    for (auto value : levels_[h]) {
+      items.emplace_back(value, int64_t{1} << h);
+    }
+  }
+  std::sort(items.begin(), items.end());
+  for (auto rank : ranks) {
+    if (rank <= 0.) {
+      results.push_back(min_);
+      continue;
+    }
+    if (rank >= 1.) {
+      results.push_back(max_);
+      continue;
+    }
+    auto target = rank * count_;
+    int64_t cumulative_weight = 0;
+    auto result = max_;
+    for (auto& item : items) {
+      cumulative_weight += item.second;
+      if (cumulative_weight >= target) {
+        result = item.first;
+        break;
+      }
+    }
+    results.push_back(result);
+  }
+  return results;
+}
+
+std::string KllSketch::Serialize() const {
+  std::string out;
+  serialization::Write(&out, static_cast<uint16_t>(k_));
+  serialization::Write(&out, count_);
+  serialization::Write(&out, min_);
+  serialization::Write(&out, max_);
+  serialization::Write(&out, static_cast<uint8_t>(levels_.size()));
+  for (auto& level : levels_) {
+    serialization::Write(&out, static_cast<uint32_t>(level.size()));
+    out.append(reinterpret_cast<const char*>(level.data()),
+               level.size() * sizeof(double));
+  }
+  return out;
+}
+
+Result<KllSketch> KllSketch::Deserialize(std::string_view data) {
+  uint16_t k;
+  int64_t count;
+  double min, max;
+  uint8_t nb_levels;
+  if (!serialization::Read(&data, &k) || !serialization::Read(&data, &count) ||
+      !serialization::Read(&data, &min) || !serialization::Read(&data, &max) ||
+      !serialization::Read(&data, &nb_levels) || nb_levels == 0) {
+    return Status::Invalid("Malformed serialized KLL sketch");
+  }
+  ARROW_ASSIGN_OR_RAISE(auto sketch, Make(k));
+  while (sketch.levels_.size() < nb_levels) {
+    sketch.AddLevel();
+  }
+  for (auto& level : sketch.levels_) {
+    uint32_t level_size;
+    if (!serialization::Read(&data, &level_size) ||
+        data.size() < level_size * sizeof(double)) {
+      return Status::Invalid("Malformed serialized KLL sketch");
+    }
+    level.resize(level_size);
+    std::memcpy(level.data(), data.data(), level_size * sizeof(double));
+    data.remove_prefix(level_size * sizeof(double));
+    sketch.size_ += level_size;
+  }
+  if (!data.empty()) {
+    return Status::Invalid("Malformed serialized KLL sketch");
+  }
+  sketch.count_ = count;
+  sketch.min_ = min;
+  sketch.max_ = max;
+  return sketch;
+}
+
+}  // namespace Buzz
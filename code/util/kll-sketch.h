@@ -0,0 +1,112 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <result.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace Buzz {
+
+/// KLL quantile sketch (Karnin, Lang, Liberty) on numeric values.
+///
+/// Values are buffered in a hierarchy of compactors where an item of level h stands for
+/// 2^h input values. When the sketch is full, the lowest full level is sorted and every
+/// other item is promoted to the next level. Memory stays around 3k values and the rank
+/// error is about 1.7 / k. Sketches can be merged, the bees send their Serialize() form
+/// to the hive.
+class KllSketch {
+ public:
+  static Result<KllSketch> Make(int k = 200);
+
+  void Update(double value) { Update(&value, 1); }
+
+  /// Add a batch of decoded values, NaNs are ignored
+  template <typename CType>
+  void Update(const CType* values, int64_t length) {
+    static_assert(std::is_arithmetic<CType>::value, "numeric values only");
+    int64_t offset = 0;
+    while (offset < length) {
+      auto& level = levels_[0];
+      auto previous_size = level.size();
+      auto batch_end = offset + std::min(length - offset, max_size_ - size_);
+      for (int64_t i = offset; i < batch_end; i++) {
+        auto value = static_cast<double>(values[i]);
+        if (std::isnan(value)) {
+          continue;
+        }
+        min_ = value < min_ ? value : min_;
+        max_ = value > max_ ? value : max_;
+        level.push_back(value);
+      }
+      offset = batch_end;
+      auto added = static_cast<int64_t>(level.size() - previous_size);
+      size_ += added;
+      count_ += added;
+      while (size_ >= max_size_) {
+        Compress();
+      }
+    }
+  }
+
+  Status Merge(const KllSketch& other);
+
+  /// Value at the given normalized rank (0 is the min, 1 is the max)
+  double Quantile(double rank) const;
+
+  /// Same as Quantile() for several ranks, with a single sort of the sketch
+  std::vector<double> Quantiles(const std::vector<double>& ranks) const;
+
+  /// Number of values added to the sketch
+  int64_t count() const { return count_; }
+  double min() const { return min_; }
+  double max() const { return max_; }
+  /// Number of values retained in the sketch
+  int64_t size() const { return size_; }
+
+  std::string Serialize() const;
+
+  static Result<KllSketch> Deserialize(std::string_view data);
+
+ private:
+  explicit KllSketch(int k);
+
+  int64_t LevelCapacity(size_t level) const;
+  void AddLevel();
+  /// Compact the full levels from the bottom until the sketch is not full anymore
+  void Compress();
+
+  int k_;
+  int64_t count_ = 0;
+  int64_t size_ = 0;
+  int64_t max_size_ = 0;
+  double min_ = std::numeric_limits<double>::infinity();
+  double max_ = -std::numeric_limits<double>::infinity();
+  std::vector<std::vector<double>> levels_;
+  std::mt19937_64 random_;
+};
+
+}  // namespace Buzz
@@ -0,0 +1,91 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "kll-sketch.h"
+
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace Buzz {
+
+namespace {
+
+/// shuffled values from 0 to length - 1
+std::vector<int64_t> ShuffledRange(int64_t length, int seed) {
+  std::vector<int64_t> values(length);
+  std::iota(values.begin(), values.end(), 0);
+  std::shuffle(values.begin(), values.end(), std::mt19937(seed));
+  return values;
+}
+
+}  // namespace
+
+TEST(KllSketch, Quantiles) {
+  auto sketch = KllSketch::Make().ValueOrDie();
+  ASSERT_TRUE(std::isnan(sketch.Quantile(0.5)));
+  auto values = ShuffledRange(1000000, 0);
+  sketch.Update(values.data(), values.size());
+  ASSERT_EQ(sketch.count(), 1000000);
+  ASSERT_LT(sketch.size(), 1000);
+
+  auto quantiles = sketch.Quantiles({0., 0.5, 0.95, 0.99, 1.});
+  ASSERT_EQ(quantiles[0], 0.);
+  ASSERT_NEAR(quantiles[1], 500000., 15000.);
+  ASSERT_NEAR(quantiles[2], 950000., 15000.);
+  ASSERT_NEAR(quantiles[3], 990000., 15000.);
+  ASSERT_EQ(quantiles[4], 999999.);
+}
+
+TEST(KllSketch, SmallInputIsExact) {
+  auto sketch = KllSketch::Make().ValueOrDie();
+  std::vector<double> values = {5., 1., NAN, 3., 2., 4.};
+  sketch.Update(values.data(), values.size());
+  ASSERT_EQ(sketch.count(), 5);
+  ASSERT_EQ(sketch.Quantile(0.5), 3.);
+  ASSERT_EQ(sketch.Quantile(0.2), 1.);
+}
+
+TEST(KllSketch, MergeAndSerialize) {
+  auto hive = KllSketch::Make(100).ValueOrDie();
+  for (int bee = 0; bee < 10; bee++) {
+    auto sketch = KllSketch::Make(100).ValueOrDie();
+    // bee i holds the values [i * 100000, (i + 1) * 100000)
+    auto values = ShuffledRange(100000, bee);
+    for (auto& value : values) {
+      value += bee * 100000;
+    }
+    sketch.Update(values.data(), values.size());
+    auto serialized = sketch.Serialize();
+    ASSERT_OK(hive.Merge(KllSketch::Deserialize(serialized).ValueOrDie()));
+  }
+  ASSERT_EQ(hive.count(), 1000000);
+  ASSERT_EQ(hive.min(), 0.);
+  ASSERT_EQ(hive.max(), 999999.);
+  ASSERT_NEAR(hive.Quantile(0.5), 500000., 30000.);
+  ASSERT_NEAR(hive.Quantile(0.99), 990000., 30000.);
+
+  ASSERT_RAISES(Invalid, hive.Merge(KllSketch::Make(200).ValueOrDie()));
+  ASSERT_RAISES(Invalid, KllSketch::Make(2));
+  ASSERT_RAISES(Invalid, KllSketch::Deserialize(hive.Serialize().substr(0, 40)));
+}
+
+}  // namespace Buzz
@@ -0,0 +1,100 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "mpmc-queue.h"
+
+#include <climits>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Buzz {
+
+namespace {
+const uint64_t kWaiter = 1;
+const uint64_t kWaitersMask = 0xffffffff;
+const uint64_t kPendingWake = uint64_t{1} << 32;
+
+void FutexWake(std::atomic<uint32_t>* address, int count) {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAKE_PRIVATE, count,
+          nullptr, nullptr, 0);
+#endif
+}
+}  // namespace
+
+uint32_t EventCount::PrepareWait() {
+  state_.fetch_add(kWaiter);
+  return epoch_.load();
+}
+
+void EventCount::CancelWait() { Leave(); }
+
+void EventCount::Wait(uint32_t key) {
+  while (epoch_.load() == key) {
+#ifdef __linux__
+    // returns immediately if the epoch changed, spurious wake-ups loop
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, key,
+            nullptr, nullptr, 0);
+#else
+    std::this_thread::yield();
+#endif
+  }
+  Leave();
+}
+
+void EventCount::Leave() {
+  auto state = state_.load();
+  uint64_t next;
+  do {
+    next = state - kWaiter;
+    if (next >= kPendingWake) {
+      next -= kPendingWake;
+    }
+  } while (!state_.compare_exchange_weak(state, next));
+}
+
+void EventCount::NotifyOne() {
+  epoch_.fetch_add(1);
+  auto state = state_.load();
+  do {
+    // every waiter will see the new epoch, a wake-up is only needed for the ones that
+    // might be sleeping and were not woken already
+    if ((state & kWaitersMask) <= (state >> 32)) {
+      return;
+    }
+  } while (!state_.compare_exchange_weak(state, state + kPendingWake));
+  FutexWake(&epoch_, 1);
+}
+
+void EventCount::NotifyAll() {
+  epoch_.fetch_add(1);
+  auto state = state_.load();
+  do {
+    if ((state & kWaitersMask) <= (state >> 32)) {
+      return;
+    }
+  } while (!state_.compare_exchange_weak(
+      state, (state & kWaitersMask) | ((state & kWaitersMask) << 32)));
+  FutexWake(&epoch_, INT_MAX);
+}
+
+}  // namespace Buzz
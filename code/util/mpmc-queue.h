@@ -0,0 +1,216 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Buzz {
+
+/// Bounded lock-free multi-producer multi-consumer queue (Vyukov's ring buffer). Each
+/// slot carries a sequence number telling whether it is free for the current lap, so
+/// producers and consumers only contend on the CAS of their position.
+template <typename T>
+class MpmcQueue {
+ public:
+  /// capacity is rounded up to a power of 2
+  explicit MpmcQueue(size_t capacity);
+  ~MpmcQueue();
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  /// Return false without moving `value` if the queue is full
+  template <typename U>
+  bool TryPush(U&& value);
+
+  /// Return false if the queue is empty
+  bool TryPop(T* value);
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  const size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  // on separate cache lines, producers and consumers do not invalidate each other
+  alignas(64) std::atomic<size_t> enqueue_pos_;
+  alignas(64) std::atomic<size_t> dequeue_pos_;
+};
+
+/// A MpmcQueue with a locked overflow, so that pushing never blocks nor fails
+template <typename T>
+class SpillQueue {
+ public:
+  explicit SpillQueue(size_t capacity) : ring_(capacity) {}
+
+  void Push(T value) {
+    if (spilled_.load() == 0 && ring_.TryPush(std::move(value))) {
+      return;
+    }
+    // keep the order once spilled, the ring is used again when the spill is empty
+    std::lock_guard<std::mutex> lock(spill_mutex_);
+    spill_.push_back(std::move(value));
+    spilled_++;
+  }
+
+  bool TryPop(T* value) {
+    if (ring_.TryPop(value)) {
+      return true;
+    }
+    if (spilled_.load() == 0) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(spill_mutex_);
+    if (spill_.empty()) {
+      return false;
+    }
+    *value = std::move(spill_.front());
+    spill_.pop_front();
+    spilled_--;
+    return true;
+  }
+
+ private:
+  MpmcQueue<T> ring_;
+  std::atomic<size_t> spilled_{0};
+  std::mutex spill_mutex_;
+  std::deque<T> spill_;
+};
+
+/// Lets threads sleep until a condition becomes true, without taking a lock to notify
+/// them. A waiter registers before checking the condition:
+///
+///   auto key = events.PrepareWait();
+///   if (condition()) { events.CancelWait(); } else { events.Wait(key); }
+///
+/// Notify after making the condition true, it only costs a syscall (futex) if some
+/// thread is waiting.
+class EventCount {
+ public:
+  uint32_t PrepareWait();
+  void CancelWait();
+  /// Sleep unless a notification happened since PrepareWait() returned `key`
+  void Wait(uint32_t key);
+  void NotifyOne();
+  void NotifyAll();
+
+ private:
+  /// Leave the waiters, consuming a pending wake-up if any
+  void Leave();
+
+  std::atomic<uint32_t> epoch_{0};
+  // waiters in the low 32 bits, woken but not yet left in the high 32 bits: a notify
+  // only issues a wake-up if some waiter is not about to leave already
+  std::atomic<uint64_t> state_{0};
+};
+
+//// MpmcQueue HEADER ONLY BECAUSE OF TEMPLATING ////
+
+namespace detail {
+inline size_t RoundUpToPowerOf2(size_t value) {
+  size_t result = 2;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+}  // namespace detail
+
+template <typename T>
+MpmcQueue<T>::MpmcQueue(size_t capacity)
+    : mask_(detail::RoundUpToPowerOf2(capacity) - 1),
+      slots_(new Slot[mask_ + 1]),
+      enqueue_pos_(0),
+      dequeue_pos_(0) {
+  for (size_t i = 0; i <= mask_; i++) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+MpmcQueue<T>::~MpmcQueue() {
+  auto end = enqueue_pos_.load(std::memory_order_relaxed);
+  for (auto pos = dequeue_pos_.load(std::memory_order_relaxed); pos != end; pos++) {
+    std::launder(reinterpret_cast<T*>(&slots_[pos & mask_].storage))->~T();
+  }
+}
+
+template <typename T>
+template <typename U>
+bool MpmcQueue<T>::TryPush(U&& value) {
+  Slot* slot;
+  auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    slot = &slots_[pos & mask_];
+    auto sequence = slot->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // the slot still holds the value of the previous lap
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  new (&slot->storage) T(std::forward<U>(value));
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool MpmcQueue<T>::TryPop(T* value) {
+  Slot* slot;
+  auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    slot = &slots_[pos & mask_];
+    auto sequence = slot->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+    if (diff == 0) {
+      if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // the slot was not written in this lap yet
+      return false;
+    } else {
+      pos = dequeue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  auto item = std::launder(reinterpret_cast<T*>(&slot->storage));
+  *value = std::move(*item);
+  item->~T();
+  slot->sequence.store(pos + mask_ + 1, std::memory_order_release);
+  return true;
+}
+
+}  // namespace Buzz
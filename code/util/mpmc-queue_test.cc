@@ -0,0 +1,103 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "mpmc-queue.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Buzz {
+
+TEST(MpmcQueue, FifoUntilFull) {
+  MpmcQueue<std::unique_ptr<int>> queue(3);
+  ASSERT_EQ(queue.capacity(), 4);
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(queue.TryPush(std::make_unique<int>(i)));
+  }
+  auto rejected = std::make_unique<int>(4);
+  ASSERT_FALSE(queue.TryPush(std::move(rejected)));
+  ASSERT_NE(rejected, nullptr);
+
+  std::unique_ptr<int> value;
+  for (int lap = 0; lap < 3; lap++) {
+    for (int i = 0; i < 4; i++) {
+      ASSERT_TRUE(queue.TryPop(&value));
+      ASSERT_EQ(*value, lap * 4 + i);
+      ASSERT_TRUE(queue.TryPush(std::make_unique<int>(lap * 4 + i + 4)));
+    }
+  }
+  // the values left in the ring are released with it
+  ASSERT_TRUE(queue.TryPop(&value));
+  ASSERT_EQ(*value, 12);
+}
+
+TEST(MpmcQueue, ConcurrentProducersAndConsumers) {
+  const int nb_threads = 4;
+  const int64_t per_producer = 100000;
+  MpmcQueue<int64_t> queue(64);
+  std::atomic<int64_t> sum{0};
+  std::atomic<int64_t> popped{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nb_threads; t++) {
+    threads.emplace_back([&]() {
+      for (int64_t i = 1; i <= per_producer; i++) {
+        while (!queue.TryPush(i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&]() {
+      int64_t value;
+      while (popped.load() < nb_threads * per_producer) {
+        if (queue.TryPop(&value)) {
+          sum += value;
+          popped++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(popped.load(), nb_threads * per_producer);
+  ASSERT_EQ(sum.load(), nb_threads * per_producer * (per_producer + 1) / 2);
+}
+
+TEST(EventCount, WakesWaiter) {
+  EventCount events;
+  std::atomic<bool> ready{false};
+  std::thread waiter([&]() {
+    while (!ready.load()) {
+      auto key = events.PrepareWait();
+      if (ready.load()) {
+        events.CancelWait();
+        break;
+      }
+      events.Wait(key);
+    }
+  });
+  ready.store(true);
+  events.NotifyAll();
+  waiter.join();
+}
+
+}  // namespace Buzz
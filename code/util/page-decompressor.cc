@@ -0,0 +1,251 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "page-decompressor.h"
+
+#include <arrow/io/memory.h>
+#include <arrow/util/compression.h>
+#include <parquet/column_page.h>
+#include <parquet/exception.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "executor.h"
+
+namespace Buzz {
+
+namespace {
+
+/// Compact protocol type of the i32 thrift fields
+constexpr uint8_t THRIFT_I32 = 5;
+
+/// A page as stored in the column chunck
+struct RawPage {
+  std::shared_ptr<parquet::Page> page;
+  int64_t uncompressed_size;
+  /// leading bytes that are stored uncompressed (levels of V2 data pages)
+  int64_t uncompressed_prefix;
+  bool is_compressed;
+};
+
+/// Serves pages that were all loaded in memory beforehand
+class PreloadedPageReader : public parquet::PageReader {
+ public:
+  explicit PreloadedPageReader(std::vector<std::shared_ptr<parquet::Page>> pages)
+      : pages_(std::move(pages)) {}
+
+  std::shared_ptr<parquet::Page> NextPage() override {
+    if (next_page_ == pages_.size()) {
+      return nullptr;
+    }
+    return pages_[next_page_++];
+  }
+
+  void set_max_page_header_size(uint32_t size) override {}
+
+ private:
+  std::vector<std::shared_ptr<parquet::Page>> pages_;
+  size_t next_page_ = 0;
+};
+
+Result<int64_t> ReadZigZagVarint(const uint8_t*& data, const uint8_t* end) {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64 && data < end; shift += 7) {
+    uint8_t byte = *data++;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+  }
+  return Status::IOError("Truncated varint in page header");
+}
+
+/// Parquet does not expose the uncompressed size of dictionary pages, read it from the
+/// thrift page header: it is the second field, right after the page type.
+Result<int32_t> ReadUncompressedPageSize(const uint8_t* data, const uint8_t* end) {
+  int field_id = 0;
+  while (data < end) {
+    uint8_t field_header = *data++;
+    // writers use the short form (id delta in the high bits) for these first fields
+    int delta = field_header >> 4;
+    if ((field_header & 0x0f) != THRIFT_I32 || delta == 0) {
+      break;
+    }
+    field_id += delta;
+    ARROW_ASSIGN_OR_RAISE(auto value, ReadZigZagVarint(data, end));
+    if (field_id == 2) {
+      return static_cast<int32_t>(value);
+    }
+    if (field_id > 2) {
+      break;
+    }
+  }
+  return Status::IOError("Unexpected page header layout");
+}
+
+Status DecompressPage(arrow::util::Codec* codec, const RawPage& raw_page, uint8_t* out) {
+  auto& input = *raw_page.page->buffer();
+  auto prefix = raw_page.uncompressed_prefix;
+  if (input.size() < prefix || raw_page.uncompressed_size < prefix) {
+    return Status::IOError("Page levels are larger than the page");
+  }
+  memcpy(out, input.data(), prefix);
+  auto expected_size = raw_page.uncompressed_size - prefix;
+  ARROW_ASSIGN_OR_RAISE(auto decompressed_size,
+                        codec->Decompress(input.size() - prefix, input.data() + prefix,
+                                          expected_size, out + prefix));
+  if (decompressed_size != expected_size) {
+    return Status::IOError("Page decompressed to ", decompressed_size,
+                           " bytes instead of ", expected_size);
+  }
+  return Status::OK();
+}
+
+/// Same page with another content
+std::shared_ptr<parquet::Page> WithBuffer(const parquet::Page& page,
+                                          std::shared_ptr<arrow::Buffer> buffer) {
+  switch (page.type()) {
+    case parquet::PageType::DICTIONARY_PAGE: {
+      auto& dict_page = static_cast<const parquet::DictionaryPage&>(page);
+      return std::make_shared<parquet::DictionaryPage>(
+          buffer, dict_page.num_values(), dict_page.encoding(), dict_page.is_sorted());
+    }
+    case parquet::PageType::DATA_PAGE: {
+      auto& data_page = static_cast<const parquet::DataPageV1&>(page);
+      return std::make_shared<parquet::DataPageV1>(
+          buffer, data_page.num_values(), data_page.encoding(),
+          data_page.definition_level_encoding(), data_page.repetition_level_encoding(),
+          data_page.uncompressed_size(), data_page.statistics());
+    }
+    default: {
+      auto& data_page = static_cast<const parquet::DataPageV2&>(page);
+      return std::make_shared<parquet::DataPageV2>(
+          buffer, data_page.num_values(), data_page.num_nulls(), data_page.num_rows(),
+          data_page.encoding(), data_page.definition_levels_byte_length(),
+          data_page.repetition_levels_byte_length(), data_page.uncompressed_size(),
+          false, data_page.statistics());
+    }
+  }
+}
+
+}  // namespace
+
+Result<std::unique_ptr<parquet::PageReader>> DecompressColumnChunck(
+    const std::shared_ptr<arrow::io::RandomAccessFile>& file,
+    const parquet::ColumnChunkMetaData& col_chunck_meta, int parallelism,
+    arrow::MemoryPool* pool) {
+  auto chunck_start = col_chunck_meta.has_dictionary_page()
+                          ? col_chunck_meta.dictionary_page_offset()
+                          : col_chunck_meta.data_page_offset();
+  ARROW_ASSIGN_OR_RAISE(
+      auto chunck_data,
+      file->ReadAt(chunck_start, col_chunck_meta.total_compressed_size()));
+  bool is_chunck_compressed =
+      col_chunck_meta.compression() != parquet::Compression::UNCOMPRESSED;
+
+  // walk the page headers, without a codec parquet slices the pages as they are stored
+  std::vector<RawPage> raw_pages;
+  std::vector<std::unique_ptr<arrow::util::Codec>> codecs;
+  try {
+    auto stream = std::make_shared<arrow::io::BufferReader>(chunck_data);
+    auto page_reader =
+        parquet::PageReader::Open(stream, col_chunck_meta.num_values(),
+                                  parquet::Compression::UNCOMPRESSED, pool);
+    while (auto page = page_reader->NextPage()) {
+      RawPage raw_page{page, 0, 0, is_chunck_compressed};
+      if (page->type() == parquet::PageType::DICTIONARY_PAGE) {
+        if (!raw_pages.empty()) {
+          return Status::IOError("Dictionary page is not the first page of the chunck");
+        }
+        ARROW_ASSIGN_OR_RAISE(raw_page.uncompressed_size,
+                              ReadUncompressedPageSize(
+                                  chunck_data->data(),
+                                  chunck_data->data() + chunck_data->size()));
+      } else if (page->type() == parquet::PageType::DATA_PAGE) {
+        raw_page.uncompressed_size =
+            static_cast<const parquet::DataPage&>(*page).uncompressed_size();
+      } else {
+        auto& data_page = static_cast<const parquet::DataPageV2&>(*page);
+        raw_page.uncompressed_size = data_page.uncompressed_size();
+        raw_page.uncompressed_prefix = data_page.definition_levels_byte_length() +
+                                       data_page.repetition_levels_byte_length();
+        raw_page.is_compressed = is_chunck_compressed && data_page.is_compressed();
+      }
+      raw_pages.push_back(std::move(raw_page));
+    }
+    if (is_chunck_compressed) {
+      // codecs are not all thread safe, each thread gets its own
+      for (int i = 0; i < std::max(parallelism, 1); i++) {
+        codecs.push_back(parquet::GetCodec(col_chunck_meta.compression()));
+      }
+    }
+  } catch (const parquet::ParquetException& e) {
+    return Status::IOError("Could not read page headers: ", e.what());
+  }
+
+  // all the decompressed pages share a single allocation
+  std::vector<int64_t> out_offsets(raw_pages.size());
+  std::vector<size_t> compressed_pages;
+  int64_t out_size = 0;
+  for (size_t i = 0; i < raw_pages.size(); i++) {
+    if (raw_pages[i].is_compressed) {
+      out_offsets[i] = out_size;
+      out_size += raw_pages[i].uncompressed_size;
+      compressed_pages.push_back(i);
+    }
+  }
+  ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Buffer> out_buffer,
+                        arrow::AllocateBuffer(out_size, pool));
+
+  auto nb_threads = std::min<size_t>(std::max(parallelism, 1), compressed_pages.size());
+  std::atomic<size_t> next_page{0};
+  std::vector<Status> statuses(nb_threads);
+  auto worker = [&](size_t thread_idx) {
+    for (auto i = next_page++; i < compressed_pages.size(); i = next_page++) {
+      auto page_idx = compressed_pages[i];
+      statuses[thread_idx] =
+          DecompressPage(codecs[thread_idx].get(), raw_pages[page_idx],
+                         out_buffer->mutable_data() + out_offsets[page_idx]);
+      if (!statuses[thread_idx].ok()) {
+        return;
+      }
+    }
+  };
+  // the calling thread takes its share, the others run on the shared CPU workers
+  Executor::Default().ParallelFor(nb_threads, worker);
+  for (auto& status : statuses) {
+    RETURN_NOT_OK(status);
+  }
+
+  std::vector<std::shared_ptr<parquet::Page>> pages;
+  pages.reserve(raw_pages.size());
+  for (size_t i = 0; i < raw_pages.size(); i++) {
+    if (raw_pages[i].is_compressed) {
+      auto page_data =
+          arrow::SliceBuffer(out_buffer, out_offsets[i], raw_pages[i].uncompressed_size);
+      pages.push_back(WithBuffer(*raw_pages[i].page, std::move(page_data)));
+    } else {
+      pages.push_back(raw_pages[i].page);
+    }
+  }
+  return std::make_unique<PreloadedPageReader>(std::move(pages));
+}
+
+}  // namespace Buzz
@@ -0,0 +1,42 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <arrow/io/interfaces.h>
+#include <arrow/memory_pool.h>
+#include <parquet/column_reader.h>
+#include <parquet/metadata.h>
+#include <result.h>
+
+#include <memory>
+
+namespace Buzz {
+
+/// Read all the pages of a column chunck from `file` and decompress them with up to
+/// `parallelism` threads (the caller and the CPU workers of the default Executor) into
+/// a single buffer allocated from `pool`.
+///
+/// The returned page reader serves the decompressed pages in order, it can be passed to
+/// parquet::ColumnReader::Make() to decode the chunck. Parquet otherwise decompresses
+/// the pages one by one on the decoding thread.
+Result<std::unique_ptr<parquet::PageReader>> DecompressColumnChunck(
+    const std::shared_ptr<arrow::io::RandomAccessFile>& file,
+    const parquet::ColumnChunkMetaData& col_chunck_meta, int parallelism,
+    arrow::MemoryPool* pool = arrow::default_memory_pool());
+
+}  // namespace Buzz
@@ -0,0 +1,121 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "page-decompressor.h"
+
+#include <arrow/api.h>
+#include <arrow/io/memory.h>
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/file_reader.h>
+
+namespace Buzz {
+
+namespace {
+
+constexpr int NB_ROWS = 10000;
+
+/// Many small pages of nullable ints (one null every 7 rows) and low cardinality strings
+std::shared_ptr<arrow::Buffer> WriteFile(parquet::Compression::type compression) {
+  arrow::Int64Builder int_builder;
+  arrow::StringBuilder str_builder;
+  for (int i = 0; i < NB_ROWS; i++) {
+    if (i % 7 == 0) {
+      ARROW_EXPECT_OK(int_builder.AppendNull());
+    } else {
+      ARROW_EXPECT_OK(int_builder.Append(i));
+    }
+    ARROW_EXPECT_OK(str_builder.Append("val" + std::to_string(i % 100)));
+  }
+  std::shared_ptr<arrow::Array> ints, strs;
+  ARROW_EXPECT_OK(int_builder.Finish(&ints));
+  ARROW_EXPECT_OK(str_builder.Finish(&strs));
+  auto table = arrow::Table::Make(arrow::schema({arrow::field("int", arrow::int64()),
+                                                 arrow::field("str", arrow::utf8())}),
+                                  {ints, strs});
+  auto sink = arrow::io::BufferOutputStream::Create().ValueOrDie();
+  auto props = parquet::WriterProperties::Builder()
+                   .compression(compression)
+                   ->data_pagesize(1024)
+                   ->write_batch_size(128)
+                   ->build();
+  ARROW_EXPECT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), sink,
+                                             NB_ROWS, props));
+  return sink->Finish().ValueOrDie();
+}
+
+int64_t CopyValue(int64_t value) { return value; }
+
+/// ByteArrays point into the decoded page which is released by the next batches
+std::string CopyValue(const parquet::ByteArray& value) {
+  return parquet::ByteArrayToString(value);
+}
+
+template <typename DType>
+auto ReadValues(const std::shared_ptr<arrow::Buffer>& file_buffer, int column,
+                int parallelism) {
+  auto file = std::make_shared<arrow::io::BufferReader>(file_buffer);
+  auto reader = parquet::ParquetFileReader::Open(file);
+  auto col_chunck_meta = reader->metadata()->RowGroup(0)->ColumnChunk(column);
+  auto page_reader =
+      DecompressColumnChunck(file, *col_chunck_meta, parallelism).ValueOrDie();
+  auto descr = reader->metadata()->schema()->Column(column);
+  auto col_reader = parquet::ColumnReader::Make(descr, std::move(page_reader));
+  auto typed_reader = static_cast<parquet::TypedColumnReader<DType>*>(col_reader.get());
+  std::vector<decltype(CopyValue(typename DType::c_type()))> values;
+  std::vector<typename DType::c_type> batch(NB_ROWS);
+  std::vector<int16_t> def_levels(NB_ROWS);
+  int64_t total_levels_read = 0;
+  while (typed_reader->HasNext()) {
+    int64_t values_read;
+    total_levels_read += typed_reader->ReadBatch(NB_ROWS, def_levels.data(), nullptr,
+                                                 batch.data(), &values_read);
+    for (int64_t i = 0; i < values_read; i++) {
+      values.push_back(CopyValue(batch[i]));
+    }
+  }
+  EXPECT_EQ(total_levels_read, NB_ROWS);
+  return values;
+}
+
+}  // namespace
+
+TEST(PageDecompressor, ParallelGzip) {
+  auto file_buffer = WriteFile(parquet::Compression::GZIP);
+  for (int parallelism : {1, 3}) {
+    auto ints = ReadValues<parquet::Int64Type>(file_buffer, 0, parallelism);
+    ASSERT_EQ(ints.size(), NB_ROWS - (NB_ROWS + 6) / 7);
+    ASSERT_EQ(ints[0], 1);
+    ASSERT_EQ(ints.back(), NB_ROWS - 1);
+
+    // dictionary page followed by the data pages
+    auto strs = ReadValues<parquet::ByteArrayType>(file_buffer, 1, parallelism);
+    ASSERT_EQ(strs.size(), NB_ROWS);
+    ASSERT_EQ(strs[123], "val23");
+  }
+}
+
+TEST(PageDecompressor, Uncompressed) {
+  auto file_buffer = WriteFile(parquet::Compression::UNCOMPRESSED);
+  auto ints = ReadValues<parquet::Int64Type>(file_buffer, 0, 2);
+  ASSERT_EQ(ints.size(), NB_ROWS - (NB_ROWS + 6) / 7);
+  auto strs = ReadValues<parquet::ByteArrayType>(file_buffer, 1, 2);
+  ASSERT_EQ(strs[NB_ROWS - 1], "val99");
+}
+
+}  // namespace Buzz
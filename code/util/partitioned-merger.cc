@@ -0,0 +1,317 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "partitioned-merger.h"
+
+#include <arrow/array/concatenate.h>
+#include <arrow/compute/api.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hash-aggregator.h"
+#include "hashing.h"
+
+namespace Buzz {
+
+namespace {
+
+/// Blocking queue of at most capacity items
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+  /// Fails once the queue is closed, also if it was closed while waiting for a slot
+  Status Push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return items_.size() < capacity_ || closed_; });
+    if (closed_) {
+      return Status::Invalid("Cannot push to a closed queue");
+    }
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return Status::OK();
+  }
+
+  /// Return false once the queue is closed and empty
+  bool Pop(T* item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return !items_.empty() || closed_; });
+    if (items_.empty()) {
+      return false;
+    }
+    *item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+ private:
+  size_t capacity_;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<T> items_;
+  bool closed_ = false;
+};
+
+template <typename ArrowType>
+void HashIntKeys(const arrow::Array& array, uint64_t* hashes) {
+  using ArrayType = typename arrow::TypeTraits<ArrowType>::ArrayType;
+  auto raw_values = static_cast<const ArrayType&>(array).raw_values();
+  for (int64_t i = 0; i < array.length(); i++) {
+    auto hash = array.IsValid(i) ? hashing::HashInt(static_cast<int64_t>(raw_values[i]))
+                                 : hashing::NULL_HASH;
+    hashes[i] = hashing::CombineHashes(hashes[i], hash);
+  }
+}
+
+template <typename ArrowType>
+void HashBinaryKeys(const arrow::Array& array, uint64_t* hashes) {
+  using ArrayType = typename arrow::TypeTraits<ArrowType>::ArrayType;
+  auto& typed_array = static_cast<const ArrayType&>(array);
+  for (int64_t i = 0; i < array.length(); i++) {
+    int32_t length = 0;
+    auto data = typed_array.GetValue(i, &length);
+    // the partition is picked with the high bits
+    auto hash =
+        array.IsValid(i) ? hashing::FinalizedHashBytes(data, length) : hashing::NULL_HASH;
+    hashes[i] = hashing::CombineHashes(hashes[i], hash);
+  }
+}
+
+/// Combine the hashes of a key column into the row hashes
+Status HashKeys(const arrow::Array& array, uint64_t* hashes) {
+  switch (array.type_id()) {
+#define INT_KEY_CASE(TYPE_ID, ARROW_TYPE)            \
+  case arrow::Type::TYPE_ID:                         \
+    HashIntKeys<arrow::ARROW_TYPE>(array, hashes); \
+    return Status::OK();
+
+    INT_KEY_CASE(INT8, Int8Type)
+    INT_KEY_CASE(INT16, Int16Type)
+    INT_KEY_CASE(INT32, Int32Type)
+    INT_KEY_CASE(INT64, Int64Type)
+    INT_KEY_CASE(UINT8, UInt8Type)
+    INT_KEY_CASE(UINT16, UInt16Type)
+    INT_KEY_CASE(UINT32, UInt32Type)
+    INT_KEY_CASE(UINT64, UInt64Type)
+#undef INT_KEY_CASE
+    case arrow::Type::STRING:
+      HashBinaryKeys<arrow::StringType>(array, hashes);
+      return Status::OK();
+    case arrow::Type::BINARY:
+      HashBinaryKeys<arrow::BinaryType>(array, hashes);
+      return Status::OK();
+    default:
+      return Status::NotImplemented("Cannot partition on type ",
+                                    array.type()->ToString());
+  }
+}
+
+}  // namespace
+
+class PartitionedMerger::Impl {
+ public:
+  struct Partition {
+    explicit Partition(size_t queue_capacity) : queue(queue_capacity) {}
+
+    std::unique_ptr<HashAggregator> aggregator;
+    BoundedQueue<std::shared_ptr<arrow::RecordBatch>> queue;
+    /// first merge error, the worker keeps draining its queue so producers never block
+    Status status;
+    std::thread worker;
+  };
+
+  Impl(int num_keys, arrow::MemoryPool* pool) : num_keys_(num_keys), pool_(pool) {}
+
+  ~Impl() { Stop(); }
+
+  void Start() {
+    for (auto& partition : partitions_) {
+      auto partition_ptr = partition.get();
+      partition->worker = std::thread([partition_ptr] {
+        std::shared_ptr<arrow::RecordBatch> batch;
+        while (partition_ptr->queue.Pop(&batch)) {
+          if (partition_ptr->status.ok()) {
+            partition_ptr->status = partition_ptr->aggregator->Merge(*batch);
+          }
+        }
+      });
+    }
+  }
+
+  void Stop() {
+    for (auto& partition : partitions_) {
+      partition->queue.Close();
+    }
+    for (auto& partition : partitions_) {
+      if (partition->worker.joinable()) {
+        partition->worker.join();
+      }
+    }
+  }
+
+  Status Merge(const std::shared_ptr<arrow::RecordBatch>& partial) {
+    {
+      std::lock_guard<std::mutex> lock(merges_mutex_);
+      if (finalized_) {
+        return Status::Invalid("Cannot merge into a finalized merger");
+      }
+      active_merges_++;
+    }
+    auto status = SplitAndPush(partial);
+    std::lock_guard<std::mutex> lock(merges_mutex_);
+    if (--active_merges_ == 0) {
+      merges_done_.notify_all();
+    }
+    return status;
+  }
+
+  Status SplitAndPush(const std::shared_ptr<arrow::RecordBatch>& partial) {
+    auto num_partitions = static_cast<uint64_t>(partitions_.size());
+    if (num_partitions == 1) {
+      return partitions_[0]->queue.Push(partial);
+    }
+
+    auto num_rows = partial->num_rows();
+    std::vector<uint64_t> hashes(num_rows, 0);
+    for (int k = 0; k < num_keys_; k++) {
+      RETURN_NOT_OK(HashKeys(*partial->column(k), hashes.data()));
+    }
+    // the high bits select the partition, the low bits index the slots of its table
+    std::vector<std::vector<int32_t>> indices(num_partitions);
+    for (int64_t i = 0; i < num_rows; i++) {
+      indices[((hashes[i] >> 32) * num_partitions) >> 32].push_back(i);
+    }
+
+    arrow::compute::ExecContext exec_context(pool_);
+    for (size_t p = 0; p < num_partitions; p++) {
+      if (indices[p].empty()) {
+        continue;
+      }
+      if (static_cast<int64_t>(indices[p].size()) == num_rows) {
+        RETURN_NOT_OK(partitions_[p]->queue.Push(partial));
+        continue;
+      }
+      arrow::Int32Builder indices_builder(pool_);
+      RETURN_NOT_OK(indices_builder.AppendValues(indices[p]));
+      std::shared_ptr<arrow::Array> indices_array;
+      RETURN_NOT_OK(indices_builder.Finish(&indices_array));
+      ARROW_ASSIGN_OR_RAISE(
+          auto part, arrow::compute::Take(partial, indices_array,
+                                          arrow::compute::TakeOptions::Defaults(),
+                                          &exec_context));
+      RETURN_NOT_OK(partitions_[p]->queue.Push(part.record_batch()));
+    }
+    return Status::OK();
+  }
+
+  Result<std::shared_ptr<arrow::RecordBatch>> Finalize() {
+    {
+      std::unique_lock<std::mutex> lock(merges_mutex_);
+      if (finalized_) {
+        return Status::Invalid("Merger already finalized");
+      }
+      finalized_ = true;
+      // the new Merge() calls fail, wait for the batches of the running ones
+      merges_done_.wait(lock, [this] { return active_merges_ == 0; });
+    }
+    Stop();
+    std::vector<std::shared_ptr<arrow::RecordBatch>> results;
+    int64_t num_groups = 0;
+    for (auto& partition : partitions_) {
+      RETURN_NOT_OK(partition->status);
+      ARROW_ASSIGN_OR_RAISE(auto result, partition->aggregator->Finalize());
+      num_groups += result->num_rows();
+      results.push_back(std::move(result));
+    }
+    arrow::ArrayVector columns;
+    for (int c = 0; c < results[0]->num_columns(); c++) {
+      arrow::ArrayVector chuncks;
+      for (auto& result : results) {
+        chuncks.push_back(result->column(c));
+      }
+      ARROW_ASSIGN_OR_RAISE(auto column, arrow::Concatenate(chuncks, pool_));
+      columns.push_back(std::move(column));
+    }
+    return arrow::RecordBatch::Make(results[0]->schema(), num_groups, columns);
+  }
+
+  int num_keys_;
+  arrow::MemoryPool* pool_;
+  std::vector<std::unique_ptr<Partition>> partitions_;
+  /// guards the Merge() calls in progress and the finalization
+  std::mutex merges_mutex_;
+  std::condition_variable merges_done_;
+  int active_merges_ = 0;
+  bool finalized_ = false;
+};
+
+Result<std::unique_ptr<PartitionedMerger>> PartitionedMerger::Make(
+    const std::shared_ptr<arrow::Schema>& partial_schema, int num_partitions,
+    int queue_capacity, arrow::MemoryPool* pool) {
+  if (num_partitions < 1 || queue_capacity < 1) {
+    return Status::Invalid("A merger needs at least one partition and queue slot");
+  }
+  std::unique_ptr<Impl> impl;
+  for (int p = 0; p < num_partitions; p++) {
+    auto partition = std::make_unique<Impl::Partition>(queue_capacity);
+    ARROW_ASSIGN_OR_RAISE(partition->aggregator,
+                          HashAggregator::MakeFromPartialSchema(partial_schema, pool));
+    if (impl == nullptr) {
+      impl.reset(new Impl(partition->aggregator->num_keys(), pool));
+    }
+    impl->partitions_.push_back(std::move(partition));
+  }
+  impl->Start();
+  return std::unique_ptr<PartitionedMerger>(new PartitionedMerger(std::move(impl)));
+}
+
+PartitionedMerger::PartitionedMerger(std::unique_ptr<Impl> impl)
+    : impl_(std::move(impl)) {}
+
+PartitionedMerger::~PartitionedMerger() {}
+
+Status PartitionedMerger::Merge(const std::shared_ptr<arrow::RecordBatch>& partial) {
+  return impl_->Merge(partial);
+}
+
+Result<std::shared_ptr<arrow::RecordBatch>> PartitionedMerger::Finalize() {
+  return impl_->Finalize();
+}
+
+std::shared_ptr<arrow::Schema> PartitionedMerger::partial_schema() const {
+  return impl_->partitions_[0]->aggregator->partial_schema();
+}
+
+int PartitionedMerger::num_partitions() const {
+  return static_cast<int>(impl_->partitions_.size());
+}
+
+}  // namespace Buzz
@@ -0,0 +1,65 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+#include <result.h>
+
+#include <memory>
+
+namespace Buzz {
+
+/// Merge of partial aggregates on the hive, spread on worker threads.
+///
+/// The groups are hash partitioned on their keys and each worker owns the HashAggregator
+/// of one partition, so the hash tables are updated without any lock. Merge() splits the
+/// incoming batches on the calling threads (typically one per bee stream) and queues the
+/// parts to the workers through bounded queues, which blocks the producers if the
+/// workers fall behind. The partitions hold disjoint groups, the final result is their
+/// concatenation.
+class PartitionedMerger {
+ public:
+  /// Create a merger for partial aggregates with the given schema (as produced by
+  /// HashAggregator::Finish()), each of the num_partitions workers buffers at most
+  /// queue_capacity batches.
+  static Result<std::unique_ptr<PartitionedMerger>> Make(
+      const std::shared_ptr<arrow::Schema>& partial_schema, int num_partitions,
+      int queue_capacity = 16, arrow::MemoryPool* pool = arrow::default_memory_pool());
+
+  /// Stops the workers, discarding the batches that were not merged
+  ~PartitionedMerger();
+
+  /// Queue a batch of partial aggregates, can be called concurrently
+  Status Merge(const std::shared_ptr<arrow::RecordBatch>& partial);
+
+  /// Wait for the Merge() calls in progress and the queued batches to be merged, then
+  /// return the final results of all the partitions. Must be called once, the later
+  /// Merge() calls fail.
+  Result<std::shared_ptr<arrow::RecordBatch>> Finalize();
+
+  std::shared_ptr<arrow::Schema> partial_schema() const;
+
+  int num_partitions() const;
+
+ private:
+  class Impl;
+  explicit PartitionedMerger(std::unique_ptr<Impl> impl);
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace Buzz
@@ -0,0 +1,139 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "partitioned-merger.h"
+
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include "hash-aggregator.h"
+
+namespace Buzz {
+
+namespace {
+
+std::shared_ptr<arrow::Schema> InputSchema() {
+  return arrow::schema(
+      {arrow::field("name", arrow::utf8()), arrow::field("value", arrow::int64())});
+}
+
+/// Partial aggregates of a bee: name = "n" + ((i + offset) % 100), value = i
+std::shared_ptr<arrow::RecordBatch> MakePartial(int nb_rows, int offset) {
+  arrow::StringBuilder name_builder;
+  arrow::Int64Builder value_builder;
+  for (int i = 0; i < nb_rows; i++) {
+    ARROW_EXPECT_OK(name_builder.Append("n" + std::to_string((i + offset) % 100)));
+    ARROW_EXPECT_OK(value_builder.Append(i));
+  }
+  std::shared_ptr<arrow::Array> names, values;
+  ARROW_EXPECT_OK(name_builder.Finish(&names));
+  ARROW_EXPECT_OK(value_builder.Finish(&values));
+  std::vector<AggregateSpec> specs = {{AggregateKind::Count, ""},
+                                      {AggregateKind::Sum, "value"}};
+  auto bee = HashAggregator::Make(InputSchema(), {"name"}, specs).ValueOrDie();
+  ARROW_EXPECT_OK(
+      bee->Consume(*arrow::RecordBatch::Make(InputSchema(), nb_rows, {names, values})));
+  return bee->Finish().ValueOrDie();
+}
+
+/// name -> (count, sum)
+std::map<std::string, std::pair<int64_t, int64_t>> ToMap(
+    const arrow::RecordBatch& batch) {
+  auto names = std::static_pointer_cast<arrow::StringArray>(batch.column(0));
+  auto counts = std::static_pointer_cast<arrow::Int64Array>(batch.column(1));
+  auto sums = std::static_pointer_cast<arrow::Int64Array>(batch.column(2));
+  std::map<std::string, std::pair<int64_t, int64_t>> rows;
+  for (int64_t i = 0; i < batch.num_rows(); i++) {
+    rows[names->GetString(i)] = {counts->Value(i), sums->Value(i)};
+  }
+  return rows;
+}
+
+}  // namespace
+
+TEST(PartitionedMerger, ConcurrentStreams) {
+  std::vector<std::shared_ptr<arrow::RecordBatch>> partials;
+  for (int bee = 0; bee < 32; bee++) {
+    partials.push_back(MakePartial(50 + bee, bee));
+  }
+  auto single = HashAggregator::MakeFromPartialSchema(partials[0]->schema()).ValueOrDie();
+  for (auto& partial : partials) {
+    ASSERT_OK(single->Merge(*partial));
+  }
+  auto merger = PartitionedMerger::Make(partials[0]->schema(), 4, 2).ValueOrDie();
+  ASSERT_EQ(merger->num_partitions(), 4);
+
+  // one producer thread per group of bee streams
+  std::vector<std::thread> streams;
+  for (int t = 0; t < 4; t++) {
+    streams.emplace_back([&merger, &partials, t] {
+      for (size_t bee = t; bee < partials.size(); bee += 4) {
+        ASSERT_OK(merger->Merge(partials[bee]));
+      }
+    });
+  }
+  for (auto& stream : streams) {
+    stream.join();
+  }
+
+  auto merged = merger->Finalize().ValueOrDie();
+  auto expected = single->Finalize().ValueOrDie();
+  ASSERT_EQ(merged->num_rows(), 100);
+  ASSERT_TRUE(merged->schema()->Equals(*expected->schema()));
+  ASSERT_EQ(ToMap(*merged), ToMap(*expected));
+  ASSERT_RAISES(Invalid, merger->Merge(partials[0]));
+}
+
+TEST(PartitionedMerger, FinalizeDuringMerges) {
+  auto partial = MakePartial(100, 0);
+  auto merger = PartitionedMerger::Make(partial->schema(), 3, 1).ValueOrDie();
+  std::atomic<int64_t> merged_partials{0};
+  std::vector<std::thread> streams;
+  for (int t = 0; t < 4; t++) {
+    streams.emplace_back([&merger, &partial, &merged_partials] {
+      // merge until the merger is finalized
+      while (merger->Merge(partial).ok()) {
+        merged_partials++;
+      }
+    });
+  }
+  while (merged_partials < 50) {
+    std::this_thread::yield();
+  }
+  auto merged = merger->Finalize().ValueOrDie();
+  for (auto& stream : streams) {
+    stream.join();
+  }
+  // every accepted partial is in the result, the rejected ones are not
+  int64_t total_count = 0;
+  for (auto& row : ToMap(*merged)) {
+    total_count += row.second.first;
+  }
+  ASSERT_EQ(total_count, merged_partials * 100);
+}
+
+TEST(PartitionedMerger, Invalid) {
+  auto partial = MakePartial(10, 0);
+  ASSERT_RAISES(Invalid, PartitionedMerger::Make(partial->schema(), 0));
+  ASSERT_RAISES(Invalid, PartitionedMerger::Make(InputSchema(), 2));
+}
+
+}  // namespace Buzz
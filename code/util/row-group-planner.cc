@@ -0,0 +1,93 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "row-group-planner.h"
+
+#include <algorithm>
+#include <queue>
+
+namespace Buzz {
+
+int64_t RowGroupCompressedBytes(const parquet::RowGroupMetaData& row_group,
+                                const std::vector<int>& columns) {
+  int64_t compressed_bytes = 0;
+  if (columns.empty()) {
+    for (int i = 0; i < row_group.num_columns(); i++) {
+      compressed_bytes += row_group.ColumnChunk(i)->total_compressed_size();
+    }
+  } else {
+    for (auto column : columns) {
+      compressed_bytes += row_group.ColumnChunk(column)->total_compressed_size();
+    }
+  }
+  return compressed_bytes;
+}
+
+std::vector<RowGroupCost> RowGroupCosts(
+    const std::vector<std::shared_ptr<parquet::FileMetaData>>& footers,
+    const std::vector<int>& columns, int64_t request_cost_bytes) {
+  std::vector<RowGroupCost> costs;
+  for (int file = 0; file < static_cast<int>(footers.size()); file++) {
+    auto& footer = *footers[file];
+    for (int rg = 0; rg < footer.num_row_groups(); rg++) {
+      auto row_group = footer.RowGroup(rg);
+      auto nb_chuncks = columns.empty() ? row_group->num_columns()
+                                        : static_cast<int>(columns.size());
+      auto compressed_bytes = RowGroupCompressedBytes(*row_group, columns);
+      costs.push_back({file, rg, compressed_bytes,
+                       compressed_bytes + nb_chuncks * request_cost_bytes});
+    }
+  }
+  return costs;
+}
+
+std::vector<BeeTask> PlanBeeTasks(std::vector<RowGroupCost> row_groups, int nb_bees) {
+  if (row_groups.empty()) {
+    return {};
+  }
+  // there is no empty task if each bee gets at least one row group
+  nb_bees = std::max(1, std::min(nb_bees, static_cast<int>(row_groups.size())));
+  std::vector<BeeTask> tasks(nb_bees);
+  // ties are broken on the position in the table for a deterministic plan
+  std::stable_sort(row_groups.begin(), row_groups.end(),
+                   [](const RowGroupCost& a, const RowGroupCost& b) {
+                     return a.cost > b.cost;
+                   });
+  // min-heap of (cost, task index)
+  using Load = std::pair<int64_t, int>;
+  std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+  for (int i = 0; i < nb_bees; i++) {
+    loads.push({0, i});
+  }
+  for (auto& row_group : row_groups) {
+    auto least_loaded = loads.top();
+    loads.pop();
+    auto& task = tasks[least_loaded.second];
+    task.row_groups[row_group.file].push_back(row_group.row_group);
+    task.compressed_bytes += row_group.compressed_bytes;
+    task.cost += row_group.cost;
+    loads.push({task.cost, least_loaded.second});
+  }
+  for (auto& task : tasks) {
+    for (auto& file_row_groups : task.row_groups) {
+      std::sort(file_row_groups.second.begin(), file_row_groups.second.end());
+    }
+  }
+  return tasks;
+}
+
+}  // namespace Buzz
@@ -0,0 +1,64 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <parquet/metadata.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace Buzz {
+
+/// A row group of one of the files of a table, with the estimated cost of downloading
+/// it expressed in bytes
+struct RowGroupCost {
+  int file;
+  int row_group;
+  int64_t compressed_bytes;
+  /// compressed bytes plus the latency of the GET request of each column chunck
+  int64_t cost;
+};
+
+/// Row groups assigned to a bee
+struct BeeTask {
+  /// sorted row groups to read, by file index
+  std::map<int, std::vector<int>> row_groups;
+  int64_t compressed_bytes = 0;
+  int64_t cost = 0;
+};
+
+/// Compressed size of the `columns` of a row group, all the columns if empty
+int64_t RowGroupCompressedBytes(const parquet::RowGroupMetaData& row_group,
+                                const std::vector<int>& columns);
+
+/// The row groups of all the files with their download cost. `request_cost_bytes` is
+/// the amount of data that a bee could download during the latency of one request, it
+/// is paid once per column chunck.
+std::vector<RowGroupCost> RowGroupCosts(
+    const std::vector<std::shared_ptr<parquet::FileMetaData>>& footers,
+    const std::vector<int>& columns, int64_t request_cost_bytes);
+
+/// Bin-pack the row groups into at most `nb_bees` tasks of even cost.
+///
+/// The row groups are assigned in decreasing cost order to the least loaded bee (LPT),
+/// so the most expensive task is at most 4/3 of the optimum and a large file is spread
+/// over several bees instead of driving the tail latency. Returns no empty task.
+std::vector<BeeTask> PlanBeeTasks(std::vector<RowGroupCost> row_groups, int nb_bees);
+
+}  // namespace Buzz
@@ -0,0 +1,106 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "row-group-planner.h"
+
+#include <arrow/api.h>
+#include <arrow/io/memory.h>
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/file_reader.h>
+
+#include <algorithm>
+
+namespace Buzz {
+
+namespace {
+
+/// `nb_rows` rows of two int64 columns in row groups of `row_group_size`
+std::shared_ptr<parquet::FileMetaData> WriteFile(int nb_rows, int row_group_size) {
+  arrow::Int64Builder builder;
+  for (int i = 0; i < nb_rows; i++) {
+    ARROW_EXPECT_OK(builder.Append(i * 7919));
+  }
+  std::shared_ptr<arrow::Array> values;
+  ARROW_EXPECT_OK(builder.Finish(&values));
+  auto table = arrow::Table::Make(arrow::schema({arrow::field("a", arrow::int64()),
+                                                 arrow::field("b", arrow::int64())}),
+                                  {values, values});
+  auto sink = arrow::io::BufferOutputStream::Create().ValueOrDie();
+  ARROW_EXPECT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), sink,
+                                             row_group_size));
+  auto buffer = sink->Finish().ValueOrDie();
+  auto reader =
+      parquet::ParquetFileReader::Open(std::make_shared<arrow::io::BufferReader>(buffer));
+  return reader->metadata();
+}
+
+}  // namespace
+
+TEST(RowGroupPlanner, Costs) {
+  auto footer = WriteFile(1000, 400);
+  auto costs = RowGroupCosts({footer, footer}, {}, 100);
+  ASSERT_EQ(costs.size(), 6);
+  ASSERT_EQ(costs[3].file, 1);
+  ASSERT_EQ(costs[3].row_group, 0);
+  auto row_group = footer->RowGroup(2);
+  auto a_bytes = row_group->ColumnChunk(0)->total_compressed_size();
+  auto b_bytes = row_group->ColumnChunk(1)->total_compressed_size();
+  ASSERT_EQ(costs[2].compressed_bytes, a_bytes + b_bytes);
+  ASSERT_EQ(costs[2].cost, a_bytes + b_bytes + 2 * 100);
+
+  auto b_costs = RowGroupCosts({footer}, {1}, 100);
+  ASSERT_EQ(b_costs[2].compressed_bytes, b_bytes);
+  ASSERT_EQ(b_costs[2].cost, b_bytes + 100);
+}
+
+TEST(RowGroupPlanner, BalancedTasks) {
+  // one large file and many small ones, as in a table with a skewed partition
+  std::vector<RowGroupCost> row_groups;
+  for (int rg = 0; rg < 8; rg++) {
+    row_groups.push_back({0, rg, 100, 100});
+  }
+  for (int file = 1; file < 9; file++) {
+    row_groups.push_back({file, 0, 50, 50});
+    row_groups.push_back({file, 1, 25, 25});
+  }
+  auto tasks = PlanBeeTasks(row_groups, 4);
+  ASSERT_EQ(tasks.size(), 4);
+  int nb_row_groups = 0;
+  for (auto& task : tasks) {
+    // the total of 1400 is split evenly
+    ASSERT_EQ(task.cost, 350);
+    ASSERT_EQ(task.compressed_bytes, 350);
+    for (auto& file_row_groups : task.row_groups) {
+      ASSERT_TRUE(std::is_sorted(file_row_groups.second.begin(),
+                                 file_row_groups.second.end()));
+      nb_row_groups += file_row_groups.second.size();
+    }
+  }
+  ASSERT_EQ(nb_row_groups, row_groups.size());
+}
+
+TEST(RowGroupPlanner, MoreBeesThanRowGroups) {
+  auto tasks = PlanBeeTasks({{0, 0, 10, 10}, {0, 1, 20, 20}}, 5);
+  ASSERT_EQ(tasks.size(), 2);
+  ASSERT_EQ(tasks[0].row_groups.at(0), std::vector<int>({1}));
+  ASSERT_EQ(tasks[1].row_groups.at(0), std::vector<int>({0}));
+  ASSERT_TRUE(PlanBeeTasks({}, 5).empty());
+}
+
+}  // namespace Buzz
@@ -0,0 +1,103 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <parquet/column_reader.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace Buzz {
+
+/// Rows of a row group selected by a filter, as sorted and disjoint ranges
+class RowSelection {
+ public:
+  struct Range {
+    int64_t start;
+    int64_t length;
+  };
+
+  /// Select the rows i for which mask[i] is not 0
+  static RowSelection FromMask(const uint8_t* mask, int64_t num_rows) {
+    RowSelection selection;
+    int64_t i = 0;
+    while (i < num_rows) {
+      while (i < num_rows && mask[i] == 0) {
+        i++;
+      }
+      auto start = i;
+      while (i < num_rows && mask[i] != 0) {
+        i++;
+      }
+      if (i > start) {
+        selection.ranges_.push_back({start, i - start});
+        selection.num_selected_ += i - start;
+      }
+    }
+    return selection;
+  }
+
+  static RowSelection All(int64_t num_rows) {
+    RowSelection selection;
+    if (num_rows > 0) {
+      selection.ranges_.push_back({0, num_rows});
+      selection.num_selected_ = num_rows;
+    }
+    return selection;
+  }
+
+  const std::vector<Range>& ranges() const { return ranges_; }
+  int64_t num_selected() const { return num_selected_; }
+  bool empty() const { return num_selected_ == 0; }
+
+ private:
+  std::vector<Range> ranges_;
+  int64_t num_selected_ = 0;
+};
+
+/// Read only the selected rows of a flat column. The reader skips ahead between ranges,
+/// pages that are entirely skipped are not decoded. The consumer is called with the
+/// arguments of TypedColumnReader::ReadBatch: (values, num_values, num_levels).
+///
+/// values and def_levels are buffers of batch_size elements provided by the caller.
+template <typename DType, typename Consumer>
+int64_t ReadSelectedRows(parquet::TypedColumnReader<DType>* reader,
+                         const RowSelection& selection, int64_t batch_size,
+                         typename DType::c_type* values, int16_t* def_levels,
+                         Consumer&& consumer) {
+  int64_t position = 0;
+  int64_t rows_read = 0;
+  for (auto& range : selection.ranges()) {
+    if (range.start > position) {
+      position += reader->Skip(range.start - position);
+    }
+    auto range_end = range.start + range.length;
+    while (position < range_end && reader->HasNext()) {
+      int64_t values_read = 0;
+      auto levels_read = reader->ReadBatch(std::min(batch_size, range_end - position),
+                                           def_levels, nullptr, values, &values_read);
+      consumer(values, values_read, levels_read);
+      position += levels_read;
+      rows_read += levels_read;
+    }
+  }
+  return rows_read;
+}
+
+}  // namespace Buzz
@@ -0,0 +1,103 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "row-selection.h"
+
+#include <arrow/api.h>
+#include <arrow/io/memory.h>
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/file_reader.h>
+
+namespace Buzz {
+
+namespace {
+/// nullable int64 column where value i is i and every 10th value is null
+std::shared_ptr<arrow::Buffer> WriteInt64Column(int nb_rows) {
+  arrow::Int64Builder builder;
+  for (int i = 0; i < nb_rows; i++) {
+    if (i % 10 == 0) {
+      ARROW_EXPECT_OK(builder.AppendNull());
+    } else {
+      ARROW_EXPECT_OK(builder.Append(i));
+    }
+  }
+  std::shared_ptr<arrow::Array> array;
+  ARROW_EXPECT_OK(builder.Finish(&array));
+  auto table =
+      arrow::Table::Make(arrow::schema({arrow::field("col", arrow::int64())}), {array});
+  auto sink = arrow::io::BufferOutputStream::Create().ValueOrDie();
+  // small pages so that whole pages are skipped
+  auto props = parquet::WriterProperties::Builder()
+                   .data_pagesize(1024)
+                   ->write_batch_size(100)
+                   ->disable_dictionary()
+                   ->build();
+  ARROW_EXPECT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), sink,
+                                             nb_rows, props));
+  return sink->Finish().ValueOrDie();
+}
+}  // namespace
+
+TEST(RowSelection, FromMask) {
+  std::vector<uint8_t> mask = {0, 1, 1, 0, 0, 1, 0, 1};
+  auto selection = RowSelection::FromMask(mask.data(), mask.size());
+  ASSERT_EQ(selection.num_selected(), 4);
+  ASSERT_EQ(selection.ranges().size(), 3);
+  ASSERT_EQ(selection.ranges()[0].start, 1);
+  ASSERT_EQ(selection.ranges()[0].length, 2);
+  ASSERT_EQ(selection.ranges()[2].start, 7);
+  ASSERT_TRUE(RowSelection::FromMask(mask.data(), 1).empty());
+  ASSERT_EQ(RowSelection::All(5).num_selected(), 5);
+}
+
+TEST(RowSelection, ReadSelectedRows) {
+  constexpr int nb_rows = 10000;
+  auto file_buffer = WriteInt64Column(nb_rows);
+  auto reader = parquet::ParquetFileReader::Open(
+      std::make_shared<arrow::io::BufferReader>(file_buffer));
+  auto column = reader->RowGroup(0)->Column(0);
+  auto typed_reader = static_cast<parquet::Int64Reader*>(column.get());
+
+  // rows 5 to 14 and 9000 to 9001
+  std::vector<uint8_t> mask(nb_rows, 0);
+  for (int i = 5; i < 15; i++) {
+    mask[i] = 1;
+  }
+  mask[9000] = mask[9001] = 1;
+  auto selection = RowSelection::FromMask(mask.data(), nb_rows);
+
+  constexpr int64_t batch_size = 4;
+  int64_t values[batch_size];
+  int16_t def_levels[batch_size];
+  std::vector<int64_t> read_values;
+  int64_t nulls = 0;
+  auto rows_read = ReadSelectedRows(
+      typed_reader, selection, batch_size, values, def_levels,
+      [&](const int64_t* batch, int64_t num_values, int64_t num_levels) {
+        read_values.insert(read_values.end(), batch, batch + num_values);
+        nulls += num_levels - num_values;
+      });
+  ASSERT_EQ(rows_read, 12);
+  // rows 10 and 9000 are null
+  ASSERT_EQ(nulls, 2);
+  std::vector<int64_t> expected = {5, 6, 7, 8, 9, 11, 12, 13, 14, 9001};
+  ASSERT_EQ(read_values, expected);
+}
+
+}  // namespace Buzz
@@ -0,0 +1,70 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace Buzz {
+
+/// Minimal helpers to write and read the partial results (statistics, sketches) that
+/// bees send to the hive. Values are copied with their host representation, bees and
+/// hive are expected to run on the same architecture.
+namespace serialization {
+
+template <typename T>
+void Write(std::string* out, const T& value) {
+  static_assert(std::is_trivially_copyable<T>::value, "only plain values");
+  out->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/// Write a u32 length prefix followed by the bytes
+inline void WriteBytes(std::string* out, std::string_view bytes) {
+  Write(out, static_cast<uint32_t>(bytes.size()));
+  out->append(bytes.data(), bytes.size());
+}
+
+/// Read a value and advance the input, returns false if the input is too short
+template <typename T>
+bool Read(std::string_view* in, T* value) {
+  static_assert(std::is_trivially_copyable<T>::value, "only plain values");
+  if (in->size() < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(value, in->data(), sizeof(T));
+  in->remove_prefix(sizeof(T));
+  return true;
+}
+
+/// Read bytes written by WriteBytes, the result points into the input
+inline bool ReadBytes(std::string_view* in, std::string_view* bytes) {
+  uint32_t length;
+  if (!Read(in, &length) || in->size() < length) {
+    return false;
+  }
+  *bytes = in->substr(0, length);
+  in->remove_prefix(length);
+  return true;
+}
+
+}  // namespace serialization
+
+}  // namespace Buzz
@@ -0,0 +1,288 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "space-saving.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "hashing.h"
+#include "serialization.h"
+
+namespace Buzz {
+
+SpaceSaving::SpaceSaving(int capacity) : capacity_(capacity) {
+  size_t nb_slots = 1;
+  // keep the table at most half full
+  while (nb_slots < 2 * static_cast<size_t>(capacity)) {
+    nb_slots *= 2;
+  }
+  slots_.resize(nb_slots, -1);
+  counters_.reserve(capacity);
+  heap_.reserve(capacity);
+  heap_positions_.reserve(capacity);
+}
+
+Result<SpaceSaving> SpaceSaving::Make(int capacity) {
+  if (capacity < 1 || capacity > (1 << 24)) {
+    return Status::Invalid("SpaceSaving capacity should be between 1 and 2^24, got ",
+                           capacity);
+  }
+  return SpaceSaving(capacity);
+}
+
+void SpaceSaving::Update(const parquet::ByteArray* values, int64_t length) {
+  uint64_t hashes[HASH_BATCH_SIZE];
+  for (int64_t offset = 0; offset < length; offset += HASH_BATCH_SIZE) {
+    auto batch_length = std::min(HASH_BATCH_SIZE, length - offset);
+    auto batch = values + offset;
+    for (int64_t i = 0; i < batch_length; i++) {
+      hashes[i] = hashing::HashBytes(batch[i].ptr, batch[i].len);
+    }
+    for (int64_t i = 0; i < batch_length; i++) {
+      Update(std::string_view(reinterpret_cast<const char*>(batch[i].ptr), batch[i].len),
+             hashes[i]);
+    }
+  }
+}
+
+void SpaceSaving::Update(const std::string_view* values, int64_t length) {
+  for (int64_t i = 0; i < length; i++) {
+    Update(values[i], hashing::HashBytes(values[i].data(), values[i].size()));
+  }
+}
+
+void SpaceSaving::Update(std::string_view value, uint64_t hash) {
+  count_++;
+  auto found = Find(value, hash);
+  if (found >= 0) {
+    counters_[found].count++;
+    SiftDown(heap_positions_[found]);
+    return;
+  }
+  if (counters_.size() < static_cast<size_t>(capacity_)) {
+    uint32_t counter_index = counters_.size();
+    counters_.push_back({std::string(value), hash, 1, 0});
+    heap_.push_back(counter_index);
+    heap_positions_.push_back(counter_index);
+    SiftUp(counter_index);
+    InsertSlot(counter_index);
+    return;
+  }
+  // take over the counter with the smallest count
+  auto counter_index = heap_[0];
+  EraseSlot(counter_index);
+  auto& counter = counters_[counter_index];
+  counter.value.assign(value.data(), value.size());
+  counter.hash = hash;
+  counter.error = counter.count;
+  counter.count++;
+  InsertSlot(counter_index);
+  SiftDown(0);
+}
+
+int64_t SpaceSaving::MinCount() const {
+  if (counters_.size() < static_cast<size_t>(capacity_)) {
+    return 0;
+  }
+  return counters_[heap_[0]].count;
+}
+
+int32_t SpaceSaving::Find(std::string_view value, uint64_t hash) const {
+  auto mask = slots_.size() - 1;
+  for (auto position = hash & mask; slots_[position] != -1;
+       position = (position + 1) & mask) {
+    auto& counter = counters_[slots_[position]];
+    if (counter.hash == hash && counter.value == value) {
+      return slots_[position];
+    }
+  }
+  return -1;
+}
+
+void SpaceSaving::InsertSlot(uint32_t counter_index) {
+  auto mask = slots_.size() - 1;
+  auto position = counters_[counter_index].hash & mask;
+  while (slots_[position] != -1) {
+    position = (position + 1) & mask;
+  }
+  slots_[position] = counter_index;
+}
+
+void SpaceSaving::EraseSlot(uint32_t counter_index) {
+  auto mask = slots_.size() - 1;
+  auto position = counters_[counter_index].hash & mask;
+  while (slots_[position] != static_cast<int32_t>(counter_index)) {
+    position = (position + 1) & mask;
+  }
+  slots_[position] = -1;
+  // backward shift the following entries that can move closer to their ideal slot
+  for (auto next = (position + 1) & mask; slots_[next] != -1; next = (next + 1) & mask) {
+    auto ideal = counters_[slots_[next]].hash & mask;
+    if (((next - ideal) & mask) >= ((next - position) & mask)) {
+      slots_[position] = slots_[next];
+      slots_[next] = -1;
+      position = next;
+    }
+  }
+}
+
+void SpaceSaving::SwapHeap(uint32_t position1, uint32_t position2) {
+  std::swap(heap_[position1], heap_[position2]);
+  heap_positions_[heap_[position1]] = position1;
+  heap_positions_[heap_[position2]] = position2;
+}
+
+void SpaceSaving::SiftDown(uint32_t heap_position) {
+  while (true) {
+    auto smallest = heap_position;
+    for (auto child = 2 * heap_position + 1;
+         child <= 2 * heap_position + 2 && child < heap_.size(); child++) {
+      if (counters_[heap_[child]].count < counters_[heap_[smallest]].count) {
+        smallest = child;
+      }
+    }
+    if (smallest == heap_position) {
+      return;
+    }
+    SwapHeap(heap_position, smallest);
+    heap_position = smallest;
+  }
+}
+
+void SpaceSaving::SiftUp(uint32_t heap_position) {
+  while (heap_position > 0) {
+    auto parent = (heap_position - 1) / 2;
+    if (counters_[heap_[parent]].count <= counters_[heap_[heap_position]].count) {
+      return;
+    }
+    SwapHeap(heap_position, parent);
+    heap_position = parent;
+  }
+}
+
+void SpaceSaving::Rebuild(std::vector<Counter> counters) {
+  counters_ = std::move(counters);
+  heap_.resize(counters_.size());
+  heap_positions_.resize(counters_.size());
+  std::iota(heap_.begin(), heap_.end(), 0);
+  std::iota(heap_positions_.begin(), heap_positions_.end(), 0);
+  for (auto position = static_cast<int64_t>(heap_.size()) / 2 - 1; position >= 0;
+       position--) {
+    SiftDown(position);
+  }
+  std::fill(slots_.begin(), slots_.end(), -1);
+  for (uint32_t counter_index = 0; counter_index < counters_.size(); counter_index++) {
+    InsertSlot(counter_index);
+  }
+}
+
+Status SpaceSaving::Merge(const SpaceSaving& other) {
+  if (other.capacity_ != capacity_) {
+    return Status::Invalid("Cannot merge SpaceSaving summaries with capacities ",
+                           capacity_, " and ", other.capacity_);
+  }
+  // a value missing from a full summary might have occured up to its min count
+  auto min_count = MinCount();
+  auto other_min_count = other.MinCount();
+  std::vector<Counter> merged;
+  merged.reserve(counters_.size() + other.counters_.size());
+  for (auto& counter : counters_) {
+    auto found = other.Find(counter.value, counter.hash);
+    if (found >= 0) {
+      auto& other_counter = other.counters_[found];
+      merged.push_back({counter.value, counter.hash, counter.count + other_counter.count,
+                        counter.error + other_counter.error});
+    } else {
+      merged.push_back({counter.value, counter.hash, counter.count + other_min_count,
+                        counter.error + other_min_count});
+    }
+  }
+  for (auto& other_counter : other.counters_) {
+    if (Find(other_counter.value, other_counter.hash) < 0) {
+      merged.push_back({other_counter.value, other_counter.hash,
+                        other_counter.count + min_count,
+                        other_counter.error + min_count});
+    }
+  }
+  if (merged.size() > static_cast<size_t>(capacity_)) {
+    std::nth_element(
+        merged.begin(), merged.begin() + capacity_, merged.end(),
+        [](const Counter& a, const Counter& b) { return a.count > b.count; });
+    merged.resize(capacity_);
+  }
+  count_ += other.count_;
+  Rebuild(std::move(merged));
+  return Status::OK();
+}
+
+std::vector<SpaceSaving::Entry> SpaceSaving::TopK(int k) const {
+  std::vector<Entry> entries;
+  entries.reserve(counters_.size());
+  for (auto& counter : counters_) {
+    entries.push_back({counter.value, counter.count, counter.error});
+  }
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return a.count != b.count ? a.count > b.count : a.value < b.value;
+  });
+  if (entries.size() > static_cast<size_t>(k)) {
+    entries.resize(k);
+  }
+  return entries;
+}
+
+std::string SpaceSaving::Serialize() const {
+  std::string out;
+  serialization::Write(&out, static_cast<uint32_t>(capacity_));
+  serialization::Write(&out, count_);
+  serialization::Write(&out, static_cast<uint32_t>(counters_.size()));
+  for (auto& counter : counters_) {
+    serialization::WriteBytes(&out, counter.value);
+    serialization::Write(&out, counter.count);
+    serialization::Write(&out, counter.error);
+  }
+  return out;
+}
+
+Result<SpaceSaving> SpaceSaving::Deserialize(std::string_view data) {
+  uint32_t capacity, nb_counters;
+  int64_t count;
+  if (!serialization::Read(&data, &capacity) || !serialization::Read(&data, &count) ||
+      !serialization::Read(&data, &nb_counters) || nb_counters > capacity) {
+    return Status::Invalid("Malformed serialized SpaceSaving summary");
+  }
+  ARROW_ASSIGN_OR_RAISE(auto summary, Make(capacity));
+  std::vector<Counter> counters(nb_counters);
+  for (auto& counter : counters) {
+    std::string_view value;
+    if (!serialization::ReadBytes(&data, &value) ||
+        !serialization::Read(&data, &counter.count) ||
+        !serialization::Read(&data, &counter.error)) {
+      return Status::Invalid("Malformed serialized SpaceSaving summary");
+    }
+    counter.value.assign(value.data(), value.size());
+    counter.hash = hashing::HashBytes(value.data(), value.size());
+  }
+  if (!data.empty()) {
+    return Status::Invalid("Malformed serialized SpaceSaving summary");
+  }
+  summary.count_ = count;
+  summary.Rebuild(std::move(counters));
+  return summary;
+}
+
+}  // namespace Buzz
@@ -0,0 +1,109 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <parquet/types.h>
+#include <result.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Buzz {
+
+/// SpaceSaving heavy hitters sketch (Metwally et al.) on binary values.
+///
+/// A fixed number of counters is monitored. An unknown value takes over the counter with
+/// the smallest count, which becomes its overestimation error. Any value more frequent
+/// than count() / capacity is guaranteed to be monitored. Values are hashed by batches
+/// and only copied out of the reader buffers when they take over a counter. Summaries
+/// can be merged, the bees send their Serialize() form to the hive.
+class SpaceSaving {
+ public:
+  struct Entry {
+    std::string value;
+    /// upper bound of the frequency of the value
+    int64_t count;
+    /// count - error is a lower bound of the frequency
+    int64_t error;
+  };
+
+  /// capacity is the number of monitored values, a few times the requested top K
+  static Result<SpaceSaving> Make(int capacity = 1024);
+
+  void Update(const parquet::ByteArray* values, int64_t length);
+
+  void Update(std::string_view value) { Update(&value, 1); }
+
+  /// Merge a summary with the same capacity (Agarwal et al. mergeable summaries)
+  Status Merge(const SpaceSaving& other);
+
+  /// The k most frequent values, by decreasing count
+  std::vector<Entry> TopK(int k) const;
+
+  /// Number of values added to the sketch
+  int64_t count() const { return count_; }
+  int capacity() const { return capacity_; }
+
+  std::string Serialize() const;
+
+  static Result<SpaceSaving> Deserialize(std::string_view data);
+
+ private:
+  static constexpr int64_t HASH_BATCH_SIZE = 1024;
+
+  struct Counter {
+    std::string value;
+    uint64_t hash;
+    int64_t count;
+    int64_t error;
+  };
+
+  explicit SpaceSaving(int capacity);
+
+  void Update(const std::string_view* values, int64_t length);
+  void Update(std::string_view value, uint64_t hash);
+
+  /// Smallest count if all the counters are in use, 0 otherwise
+  int64_t MinCount() const;
+
+  /// Index of the counter of a value, -1 if the value is not monitored
+  int32_t Find(std::string_view value, uint64_t hash) const;
+  void InsertSlot(uint32_t counter_index);
+  void EraseSlot(uint32_t counter_index);
+
+  void SiftDown(uint32_t heap_position);
+  void SiftUp(uint32_t heap_position);
+  void SwapHeap(uint32_t position1, uint32_t position2);
+
+  /// Replace all the counters, used by Merge and Deserialize
+  void Rebuild(std::vector<Counter> counters);
+
+  int capacity_;
+  int64_t count_ = 0;
+  std::vector<Counter> counters_;
+  /// min heap of counter indices by count
+  std::vector<uint32_t> heap_;
+  /// position of each counter in the heap
+  std::vector<uint32_t> heap_positions_;
+  /// open addressing table of counter indices, linear probing on the value hash
+  std::vector<int32_t> slots_;
+};
+
+}  // namespace Buzz
@@ -0,0 +1,106 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "space-saving.h"
+
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace Buzz {
+
+namespace {
+
+/// Zipf-like stream: value "v<i>" appears about 10000 / (i + 1) times
+std::vector<std::string> SkewedStrings(int seed) {
+  std::vector<std::string> strings;
+  for (int i = 0; i < 2000; i++) {
+    for (int j = 0; j < 10000 / (i + 1); j++) {
+      strings.push_back("v" + std::to_string(i));
+    }
+  }
+  std::shuffle(strings.begin(), strings.end(), std::mt19937(seed));
+  return strings;
+}
+
+std::vector<parquet::ByteArray> ToByteArrays(const std::vector<std::string>& strings) {
+  std::vector<parquet::ByteArray> values;
+  for (auto& str : strings) {
+    values.emplace_back(str.size(), reinterpret_cast<const uint8_t*>(str.data()));
+  }
+  return values;
+}
+
+}  // namespace
+
+TEST(SpaceSaving, ExactBelowCapacity) {
+  auto summary = SpaceSaving::Make(10).ValueOrDie();
+  for (auto value : {"a", "b", "a", "c", "a", "b"}) {
+    summary.Update(value);
+  }
+  auto top = summary.TopK(2);
+  ASSERT_EQ(top.size(), 2);
+  ASSERT_EQ(top[0].value, "a");
+  ASSERT_EQ(top[0].count, 3);
+  ASSERT_EQ(top[0].error, 0);
+  ASSERT_EQ(top[1].value, "b");
+  ASSERT_EQ(top[1].count, 2);
+}
+
+TEST(SpaceSaving, HeavyHitters) {
+  auto strings = SkewedStrings(0);
+  auto values = ToByteArrays(strings);
+  auto summary = SpaceSaving::Make(200).ValueOrDie();
+  summary.Update(values.data(), values.size());
+  ASSERT_EQ(summary.count(), static_cast<int64_t>(values.size()));
+
+  auto top = summary.TopK(5);
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(top[i].value, "v" + std::to_string(i));
+    auto exact = 10000 / (i + 1);
+    ASSERT_GE(top[i].count, exact);
+    ASSERT_LE(top[i].count - top[i].error, exact);
+  }
+}
+
+TEST(SpaceSaving, MergeAndSerialize) {
+  auto hive = SpaceSaving::Make(200).ValueOrDie();
+  int64_t total = 0;
+  for (int bee = 0; bee < 4; bee++) {
+    auto strings = SkewedStrings(bee);
+    auto values = ToByteArrays(strings);
+    auto summary = SpaceSaving::Make(200).ValueOrDie();
+    summary.Update(values.data(), values.size());
+    total += values.size();
+    ASSERT_OK(hive.Merge(SpaceSaving::Deserialize(summary.Serialize()).ValueOrDie()));
+  }
+  ASSERT_EQ(hive.count(), total);
+  auto top = hive.TopK(3);
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(top[i].value, "v" + std::to_string(i));
+    auto exact = 4 * (10000 / (i + 1));
+    ASSERT_GE(top[i].count, exact);
+    ASSERT_LE(top[i].count - top[i].error, exact);
+  }
+  ASSERT_RAISES(Invalid, hive.Merge(SpaceSaving::Make(10).ValueOrDie()));
+  ASSERT_RAISES(Invalid, SpaceSaving::Deserialize(hive.Serialize().substr(0, 30)));
+}
+
+}  // namespace Buzz
@@ -0,0 +1,103 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "stats.h"
+
+#include <algorithm>
+
+namespace Buzz {
+
+namespace stats {
+
+std::string ToString(__int128 value) {
+  if (value == 0) {
+    return "0";
+  }
+  bool negative = value < 0;
+  std::string digits;
+  while (value != 0) {
+    auto digit = static_cast<int>(value % 10);
+    digits.push_back('0' + (negative ? -digit : digit));
+    value /= 10;
+  }
+  if (negative) {
+    digits.push_back('-');
+  }
+  std::reverse(digits.begin(), digits.end());
+  return digits;
+}
+
+}  // namespace stats
+
+void BinaryColumnStats::UpdateMinMax(std::string_view min, std::string_view max) {
+  // the previous min and max are only meaningful if values were already counted
+  if (count_ == 0 || min < min_) {
+    min_.assign(min.data(), min.size());
+  }
+  if (count_ == 0 || max > max_) {
+    max_.assign(max.data(), max.size());
+  }
+}
+
+void BinaryColumnStats::Merge(const BinaryColumnStats& other) {
+  if (other.count_ > 0) {
+    if (count_ == 0 || other.min_ < min_) {
+      min_ = other.min_;
+    }
+    if (count_ == 0 || other.max_ > max_) {
+      max_ = other.max_;
+    }
+  }
+  count_ += other.count_;
+  null_count_ += other.null_count_;
+  total_length_ += other.total_length_;
+}
+
+std::string BinaryColumnStats::ToString() const {
+  std::string result = "count:" + std::to_string(count_) +
+                       "/null_count:" + std::to_string(null_count_) +
+                       "/total_length:" + std::to_string(total_length_);
+  if (count_ > 0) {
+    result += "/min:" + min_ + "/max:" + max_;
+  }
+  return result;
+}
+
+std::string BinaryColumnStats::Serialize() const {
+  std::string out;
+  serialization::Write(&out, count_);
+  serialization::Write(&out, null_count_);
+  serialization::Write(&out, total_length_);
+  serialization::WriteBytes(&out, min_);
+  serialization::WriteBytes(&out, max_);
+  return out;
+}
+
+Status BinaryColumnStats::ParseFrom(std::string_view data) {
+  std::string_view min, max;
+  if (!serialization::Read(&data, &count_) || !serialization::Read(&data, &null_count_) ||
+      !serialization::Read(&data, &total_length_) ||
+      !serialization::ReadBytes(&data, &min) || !serialization::ReadBytes(&data, &max) ||
+      !data.empty()) {
+    return Status::Invalid("Malformed serialized column stats");
+  }
+  min_.assign(min.data(), min.size());
+  max_.assign(max.data(), max.size());
+  return Status::OK();
+}
+
+}  // namespace Buzz
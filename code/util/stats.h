@@ -0,0 +1,287 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <parquet/types.h>
+#include <result.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "serialization.h"
+
+namespace Buzz {
+
+namespace stats {
+
+/// Accumulator type for the sum of the values of a physical type, wide enough to never
+/// overflow on a column chunck
+template <typename CType>
+struct SumTraits {
+  using SumType = CType;
+};
+template <>
+struct SumTraits<bool> {
+  using SumType = int64_t;
+};
+template <>
+struct SumTraits<int32_t> {
+  using SumType = int64_t;
+};
+template <>
+struct SumTraits<int64_t> {
+  using SumType = __int128;
+};
+template <>
+struct SumTraits<float> {
+  using SumType = double;
+};
+
+std::string ToString(__int128 value);
+
+template <typename T>
+std::string ToString(T value) {
+  std::ostringstream ss;
+  ss << value;
+  return ss.str();
+}
+
+/// Sum a batch in the accumulator type. Plain loops that the compiler can vectorize.
+template <typename CType>
+typename SumTraits<CType>::SumType BatchSum(const CType* values, int64_t length) {
+  typename SumTraits<CType>::SumType sum = 0;
+  for (int64_t i = 0; i < length; i++) {
+    sum += values[i];
+  }
+  return sum;
+}
+
+/// int64 values are split into their signed high and unsigned low 32 bits, which can be
+/// summed in int64 lanes without overflow for blocks of less than 2^31 values
+template <>
+inline __int128 BatchSum<int64_t>(const int64_t* values, int64_t length) {
+  constexpr int64_t BLOCK_SIZE = 1 << 30;
+  __int128 sum = 0;
+  for (int64_t block = 0; block < length; block += BLOCK_SIZE) {
+    auto block_end = std::min(length, block + BLOCK_SIZE);
+    int64_t high = 0;
+    int64_t low = 0;
+    for (int64_t i = block; i < block_end; i++) {
+      high += values[i] >> 32;
+      low += values[i] & 0xFFFFFFFF;
+    }
+    sum += static_cast<__int128>(high) * (int64_t{1} << 32) + low;
+  }
+  return sum;
+}
+
+/// Branchless min/max of a batch. NaNs never win a comparison so they are ignored.
+template <typename CType>
+void BatchMinMax(const CType* values, int64_t length, CType* min, CType* max) {
+  CType batch_min = *min;
+  CType batch_max = *max;
+  for (int64_t i = 0; i < length; i++) {
+    batch_min = values[i] < batch_min ? values[i] : batch_min;
+    batch_max = values[i] > batch_max ? values[i] : batch_max;
+  }
+  *min = batch_min;
+  *max = batch_max;
+}
+
+template <typename CType>
+constexpr CType MinIdentity() {
+  using Limits = std::numeric_limits<CType>;
+  return Limits::has_infinity ? Limits::infinity() : Limits::max();
+}
+
+template <typename CType>
+constexpr CType MaxIdentity() {
+  using Limits = std::numeric_limits<CType>;
+  return Limits::has_infinity ? -Limits::infinity() : Limits::lowest();
+}
+
+}  // namespace stats
+
+/// Exact statistics of a column, updated with the buffers returned by
+/// parquet::TypedColumnReader::ReadBatch.
+///
+/// All the statistics can be merged, so they can be computed per thread or per bee and
+/// combined afterwards. Serialize() gives the compact form sent to the hive.
+template <typename DType>
+class ColumnStats {
+ public:
+  using CType = typename DType::c_type;
+  using SumType = typename stats::SumTraits<CType>::SumType;
+
+  /// Add a batch of num_values non null values read with num_levels definition levels
+  /// (the return value of ReadBatch). Null counts are only exact for flat columns.
+  void Update(const CType* values, int64_t num_values, int64_t num_levels) {
+    count_ += num_values;
+    null_count_ += num_levels - num_values;
+    sum_ += stats::BatchSum(values, num_values);
+    stats::BatchMinMax(values, num_values, &min_, &max_);
+  }
+
+  void Merge(const ColumnStats& other) {
+    count_ += other.count_;
+    null_count_ += other.null_count_;
+    sum_ += other.sum_;
+    min_ = other.min_ < min_ ? other.min_ : min_;
+    max_ = other.max_ > max_ ? other.max_ : max_;
+  }
+
+  int64_t count() const { return count_; }
+  int64_t null_count() const { return null_count_; }
+  SumType sum() const { return sum_; }
+  /// only meaningful if count() > 0
+  CType min() const { return min_; }
+  CType max() const { return max_; }
+
+  std::string ToString() const {
+    std::string result = "count:" + std::to_string(count_) +
+                         "/null_count:" + std::to_string(null_count_) +
+                         "/sum:" + stats::ToString(sum_);
+    if (count_ > 0) {
+      result += "/min:" + stats::ToString(min_) + "/max:" + stats::ToString(max_);
+    }
+    return result;
+  }
+
+  std::string Serialize() const {
+    std::string out;
+    serialization::Write(&out, count_);
+    serialization::Write(&out, null_count_);
+    serialization::Write(&out, sum_);
+    serialization::Write(&out, min_);
+    serialization::Write(&out, max_);
+    return out;
+  }
+
+  static Result<ColumnStats> Deserialize(std::string_view data) {
+    ColumnStats stats;
+    if (!serialization::Read(&data, &stats.count_) ||
+        !serialization::Read(&data, &stats.null_count_) ||
+        !serialization::Read(&data, &stats.sum_) ||
+        !serialization::Read(&data, &stats.min_) ||
+        !serialization::Read(&data, &stats.max_) || !data.empty()) {
+      return Status::Invalid("Malformed serialized column stats");
+    }
+    return stats;
+  }
+
+ private:
+  int64_t count_ = 0;
+  int64_t null_count_ = 0;
+  SumType sum_ = 0;
+  CType min_ = stats::MinIdentity<CType>();
+  CType max_ = stats::MaxIdentity<CType>();
+};
+
+/// Statistics of binary values: the min and max are compared as unsigned bytes and the
+/// sum is the total length of the values
+class BinaryColumnStats {
+ public:
+  void Merge(const BinaryColumnStats& other);
+
+  int64_t count() const { return count_; }
+  int64_t null_count() const { return null_count_; }
+  int64_t sum() const { return total_length_; }
+  const std::string& min() const { return min_; }
+  const std::string& max() const { return max_; }
+
+  std::string ToString() const;
+
+  std::string Serialize() const;
+
+ protected:
+  /// Only the min and max of the batch are copied out of the reader buffers
+  template <typename GetView>
+  void UpdateViews(int64_t num_values, int64_t num_levels, GetView&& get_view) {
+    null_count_ += num_levels - num_values;
+    if (num_values == 0) {
+      return;
+    }
+    auto batch_min = get_view(0);
+    auto batch_max = batch_min;
+    for (int64_t i = 0; i < num_values; i++) {
+      auto value = get_view(i);
+      total_length_ += value.size();
+      batch_min = value < batch_min ? value : batch_min;
+      batch_max = value > batch_max ? value : batch_max;
+    }
+    UpdateMinMax(batch_min, batch_max);
+    count_ += num_values;
+  }
+
+  void UpdateMinMax(std::string_view min, std::string_view max);
+
+  Status ParseFrom(std::string_view data);
+
+  int64_t count_ = 0;
+  int64_t null_count_ = 0;
+  int64_t total_length_ = 0;
+  std::string min_;
+  std::string max_;
+};
+
+template <>
+class ColumnStats<parquet::ByteArrayType> : public BinaryColumnStats {
+ public:
+  void Update(const parquet::ByteArray* values, int64_t num_values, int64_t num_levels) {
+    UpdateViews(num_values, num_levels, [values](int64_t i) {
+      return std::string_view(reinterpret_cast<const char*>(values[i].ptr),
+                              values[i].len);
+    });
+  }
+
+  static Result<ColumnStats> Deserialize(std::string_view data) {
+    ColumnStats stats;
+    RETURN_NOT_OK(stats.ParseFrom(data));
+    return stats;
+  }
+};
+
+template <>
+class ColumnStats<parquet::FLBAType> : public BinaryColumnStats {
+ public:
+  /// type_length is the length of the values from the column descriptor
+  explicit ColumnStats(int type_length) : type_length_(type_length) {}
+
+  void Update(const parquet::FixedLenByteArray* values, int64_t num_values,
+              int64_t num_levels) {
+    UpdateViews(num_values, num_levels, [this, values](int64_t i) {
+      return std::string_view(reinterpret_cast<const char*>(values[i].ptr),
+                              type_length_);
+    });
+  }
+
+  static Result<ColumnStats> Deserialize(std::string_view data, int type_length) {
+    ColumnStats stats(type_length);
+    RETURN_NOT_OK(stats.ParseFrom(data));
+    return stats;
+  }
+
+ private:
+  int type_length_;
+};
+
+}  // namespace Buzz
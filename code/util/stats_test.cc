@@ -0,0 +1,80 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "stats.h"
+
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace Buzz {
+
+TEST(ColumnStats, Int64SumDoesNotOverflow) {
+  std::vector<int64_t> values(1000, std::numeric_limits<int64_t>::max());
+  values.push_back(-5);
+  ColumnStats<parquet::Int64Type> stats;
+  stats.Update(values.data(), values.size(), values.size() + 3);
+  ASSERT_EQ(stats.count(), 1001);
+  ASSERT_EQ(stats.null_count(), 3);
+  ASSERT_EQ(stats.min(), -5);
+  ASSERT_EQ(stats.max(), std::numeric_limits<int64_t>::max());
+  __int128 expected =
+      static_cast<__int128>(std::numeric_limits<int64_t>::max()) * 1000 - 5;
+  ASSERT_TRUE(stats.sum() == expected);
+  ASSERT_EQ(stats::ToString(expected), "9223372036854775806995");
+}
+
+TEST(ColumnStats, MergeAndSerialize) {
+  std::vector<double> first = {1.5, -2., std::nan("")};
+  std::vector<double> second = {10., 0.25};
+  ColumnStats<parquet::DoubleType> stats1, stats2, empty;
+  stats1.Update(first.data(), first.size(), first.size());
+  stats2.Update(second.data(), second.size(), second.size() + 1);
+  stats1.Merge(empty);
+  auto deserialized =
+      ColumnStats<parquet::DoubleType>::Deserialize(stats2.Serialize()).ValueOrDie();
+  stats1.Merge(deserialized);
+  ASSERT_EQ(stats1.count(), 5);
+  ASSERT_EQ(stats1.null_count(), 1);
+  ASSERT_EQ(stats1.min(), -2.);
+  ASSERT_EQ(stats1.max(), 10.);
+  ASSERT_RAISES(Invalid, ColumnStats<parquet::DoubleType>::Deserialize("abc"));
+}
+
+TEST(ColumnStats, ByteArray) {
+  std::vector<std::string> strings = {"banana", "apple", "\xff", "cherry"};
+  std::vector<parquet::ByteArray> values;
+  for (auto& str : strings) {
+    values.emplace_back(str.size(), reinterpret_cast<const uint8_t*>(str.data()));
+  }
+  ColumnStats<parquet::ByteArrayType> stats1, stats2;
+  stats1.Update(values.data(), 2, 2);
+  stats2.Update(values.data() + 2, 2, 5);
+  auto merged =
+      ColumnStats<parquet::ByteArrayType>::Deserialize(stats1.Serialize()).ValueOrDie();
+  merged.Merge(stats2);
+  ASSERT_EQ(merged.count(), 4);
+  ASSERT_EQ(merged.null_count(), 3);
+  ASSERT_EQ(merged.sum(), 18);
+  ASSERT_EQ(merged.min(), "apple");
+  // bytes are compared unsigned
+  ASSERT_EQ(merged.max(), "\xff");
+}
+
+}  // namespace Buzz
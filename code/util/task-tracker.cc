@@ -0,0 +1,155 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "task-tracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace Buzz {
+
+TaskTracker::TaskTracker(int nb_tasks, SpeculationOptions options,
+                         time::time_point start)
+    : options_(options), start_(start), tasks_(nb_tasks) {
+  for (auto& task : tasks_) {
+    task.last_activity = start;
+  }
+}
+
+Status TaskTracker::CheckTaskId(int task_id) const {
+  if (task_id < 0 || task_id >= static_cast<int>(tasks_.size())) {
+    return Status::Invalid("Task ", task_id, " out of range");
+  }
+  return Status::OK();
+}
+
+Status TaskTracker::Progress(int task_id, int64_t rows, time::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  RETURN_NOT_OK(CheckTaskId(task_id));
+  tasks_[task_id].rows += rows;
+  tasks_[task_id].last_activity = now;
+  return Status::OK();
+}
+
+Result<bool> TaskTracker::Complete(int task_id, time::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  RETURN_NOT_OK(CheckTaskId(task_id));
+  auto& task = tasks_[task_id];
+  if (task.completed) {
+    return false;
+  }
+  task.completed = true;
+  task.completion_ms = util::get_duration_ms(start_, now);
+  completion_ms_.push_back(task.completion_ms);
+  return true;
+}
+
+Status TaskTracker::Reopen(int task_id, time::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  RETURN_NOT_OK(CheckTaskId(task_id));
+  auto& task = tasks_[task_id];
+  if (!task.completed) {
+    return Status::OK();
+  }
+  task.completed = false;
+  task.last_activity = now;
+  completion_ms_.erase(
+      std::find(completion_ms_.begin(), completion_ms_.end(), task.completion_ms));
+  return Status::OK();
+}
+
+std::vector<int> TaskTracker::TakeStragglers(time::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<int> stragglers;
+  auto nb_completed = completion_ms_.size();
+  if (nb_completed == 0 || nb_completed == tasks_.size() ||
+      nb_completed < options_.min_completed_fraction * tasks_.size()) {
+    return stragglers;
+  }
+  // the quantile of the tasks completed so far underestimates the one of the fleet, but
+  // only the slowest tasks are still running when it becomes inaccurate
+  std::vector<int64_t> sorted_ms = completion_ms_;
+  auto rank = static_cast<size_t>(std::ceil(options_.quantile * nb_completed));
+  rank = std::min(nb_completed - 1, rank == 0 ? 0 : rank - 1);
+  std::nth_element(sorted_ms.begin(), sorted_ms.begin() + rank, sorted_ms.end());
+  auto threshold_ms = std::max<int64_t>(
+      options_.min_elapsed_ms,
+      static_cast<int64_t>(options_.multiplier * sorted_ms[rank]));
+
+  for (int task_id = 0; task_id < static_cast<int>(tasks_.size()); task_id++) {
+    auto& task = tasks_[task_id];
+    // a speculated task gets a full threshold again before the next speculation
+    if (!task.completed && task.attempts < options_.max_attempts &&
+        util::get_duration_ms(task.last_activity, now) > threshold_ms) {
+      task.attempts++;
+      task.last_activity = now;
+      stragglers.push_back(task_id);
+    }
+  }
+  return stragglers;
+}
+
+int TaskTracker::nb_tasks() const { return static_cast<int>(tasks_.size()); }
+
+int TaskTracker::nb_completed() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<int>(completion_ms_.size());
+}
+
+int TaskTracker::nb_attempts() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int nb_attempts = 0;
+  for (auto& task : tasks_) {
+    nb_attempts += task.attempts;
+  }
+  return nb_attempts;
+}
+
+int64_t TaskTracker::nb_rows() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t nb_rows = 0;
+  for (auto& task : tasks_) {
+    nb_rows += task.rows;
+  }
+  return nb_rows;
+}
+
+std::string MakeTaskCommand(const std::string& query_id, int task_id) {
+  return query_id + ":" + std::to_string(task_id);
+}
+
+Result<std::pair<std::string, std::optional<int>>> ParseTaskCommand(
+    const std::string& command) {
+  auto separator = command.rfind(':');
+  if (separator == std::string::npos) {
+    return std::make_pair(command, std::optional<int>());
+  }
+  auto task_str = command.substr(separator + 1);
+  if (task_str.empty() ||
+      task_str.find_first_not_of("0123456789") != std::string::npos) {
+    return Status::Invalid("Invalid task id in command ", command);
+  }
+  try {
+    return std::make_pair(command.substr(0, separator),
+                          std::optional<int>(std::stoi(task_str)));
+  } catch (const std::out_of_range&) {
+    return Status::Invalid("Task id out of range in command ", command);
+  }
+}
+
+}  // namespace Buzz
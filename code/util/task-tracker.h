@@ -0,0 +1,106 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <result.h>
+#include <toolbox.h>
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Buzz {
+
+struct SpeculationOptions {
+  /// no task is speculated before this fraction of the fleet completed
+  double min_completed_fraction = 0.5;
+  /// quantile of the completion times of the fleet a task is compared to
+  double quantile = 0.9;
+  /// a task straggles if it runs longer than `multiplier` times the quantile
+  double multiplier = 1.5;
+  /// and longer than this duration, which avoids speculating on very short queries
+  int64_t min_elapsed_ms = 1000;
+  /// maximum number of invocations of a task, including the original one
+  int max_attempts = 2;
+};
+
+/// Progress and completion of the bee tasks of a query, to detect the stragglers.
+///
+/// Bees may be invoked several times for the same task, the first complete result of a
+/// task is kept and the later ones are duplicates to discard. Thread safe.
+class TaskTracker {
+ public:
+  /// Track `nb_tasks` tasks with ids in [0, nb_tasks) all invoked at `start`
+  TaskTracker(int nb_tasks, SpeculationOptions options, time::time_point start);
+
+  /// Record that `rows` were received for the task, a task that is streaming its result
+  /// is not considered as straggling
+  Status Progress(int task_id, int64_t rows, time::time_point now);
+
+  /// Record a complete result for the task, true if it is the first one
+  Result<bool> Complete(int task_id, time::time_point now);
+
+  /// Revert the completion of a task whose result could not be used, it can then be
+  /// speculated again
+  Status Reopen(int task_id, time::time_point now);
+
+  /// The incomplete tasks that show no activity well beyond the completion times of the
+  /// fleet and can still be invoked again, they are recorded as re-invoked at `now`
+  std::vector<int> TakeStragglers(time::time_point now);
+
+  int nb_tasks() const;
+
+  int nb_completed() const;
+
+  /// Total number of invocations, including the speculative ones
+  int nb_attempts() const;
+
+  /// Total number of rows received, including the duplicates
+  int64_t nb_rows() const;
+
+ private:
+  struct TaskState {
+    /// last invocation or received rows
+    time::time_point last_activity;
+    int attempts = 1;
+    int64_t rows = 0;
+    bool completed = false;
+    /// entry of completion_ms_, if completed
+    int64_t completion_ms = 0;
+  };
+
+  Status CheckTaskId(int task_id) const;
+
+  SpeculationOptions options_;
+  time::time_point start_;
+  mutable std::mutex mutex_;
+  std::vector<TaskState> tasks_;
+  /// time from the start of the query to the completion of each completed task
+  std::vector<int64_t> completion_ms_;
+};
+
+/// Flight descriptor command of the result stream of a bee task: "<query_id>:<task_id>"
+std::string MakeTaskCommand(const std::string& query_id, int task_id);
+
+/// The query id and task id of a descriptor command, a bare query id has no task id
+Result<std::pair<std::string, std::optional<int>>> ParseTaskCommand(
+    const std::string& command);
+
+}  // namespace Buzz
@@ -0,0 +1,114 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "task-tracker.h"
+
+#include <arrow/testing/gtest_util.h>
+#include <gtest/gtest.h>
+
+namespace Buzz {
+
+namespace {
+
+time::time_point At(time::time_point start, int64_t ms) {
+  return start + std::chrono::milliseconds(ms);
+}
+
+}  // namespace
+
+TEST(TaskTracker, Stragglers) {
+  auto start = time::now();
+  SpeculationOptions options;
+  options.min_completed_fraction = 0.5;
+  options.quantile = 0.9;
+  options.multiplier = 2;
+  options.min_elapsed_ms = 100;
+  TaskTracker tracker(10, options, start);
+
+  // not enough tasks completed to know the completion distribution
+  for (int task = 0; task < 4; task++) {
+    ASSERT_TRUE(tracker.Complete(task, At(start, 1000 + task * 100)).ValueOrDie());
+  }
+  ASSERT_TRUE(tracker.TakeStragglers(At(start, 10000)).empty());
+
+  // the 90% quantile of 1000..1800 is 1800, the threshold is 3600
+  for (int task = 4; task < 9; task++) {
+    ASSERT_TRUE(tracker.Complete(task, At(start, 1000 + task * 100)).ValueOrDie());
+  }
+  ASSERT_TRUE(tracker.TakeStragglers(At(start, 3500)).empty());
+  ASSERT_EQ(tracker.TakeStragglers(At(start, 3700)), std::vector<int>({9}));
+  // the speculated task gets a new threshold, and then reached max_attempts
+  ASSERT_TRUE(tracker.TakeStragglers(At(start, 5000)).empty());
+  ASSERT_TRUE(tracker.TakeStragglers(At(start, 20000)).empty());
+  ASSERT_EQ(tracker.nb_attempts(), 11);
+
+  // the first complete result is kept
+  ASSERT_TRUE(tracker.Complete(9, At(start, 4000)).ValueOrDie());
+  ASSERT_FALSE(tracker.Complete(9, At(start, 4100)).ValueOrDie());
+  ASSERT_EQ(tracker.nb_completed(), 10);
+}
+
+TEST(TaskTracker, ProgressDelaysSpeculation) {
+  auto start = time::now();
+  SpeculationOptions options;
+  options.min_elapsed_ms = 0;
+  options.multiplier = 1;
+  TaskTracker tracker(2, options, start);
+  ASSERT_TRUE(tracker.Complete(0, At(start, 1000)).ValueOrDie());
+  ASSERT_OK(tracker.Progress(1, 50, At(start, 900)));
+  ASSERT_TRUE(tracker.TakeStragglers(At(start, 1500)).empty());
+  ASSERT_EQ(tracker.TakeStragglers(At(start, 2000)), std::vector<int>({1}));
+  ASSERT_EQ(tracker.nb_rows(), 50);
+}
+
+TEST(TaskTracker, ReopenedTaskIsSpeculatedAgain) {
+  auto start = time::now();
+  SpeculationOptions options;
+  options.min_elapsed_ms = 0;
+  options.multiplier = 1;
+  options.max_attempts = 3;
+  TaskTracker tracker(2, options, start);
+  ASSERT_TRUE(tracker.Complete(0, At(start, 1000)).ValueOrDie());
+  ASSERT_TRUE(tracker.Complete(1, At(start, 1100)).ValueOrDie());
+  ASSERT_OK(tracker.Reopen(1, At(start, 1200)));
+  ASSERT_EQ(tracker.nb_completed(), 1);
+  ASSERT_TRUE(tracker.TakeStragglers(At(start, 2100)).empty());
+  ASSERT_EQ(tracker.TakeStragglers(At(start, 2300)), std::vector<int>({1}));
+  // the next result of the task is kept
+  ASSERT_TRUE(tracker.Complete(1, At(start, 2500)).ValueOrDie());
+  ASSERT_EQ(tracker.nb_completed(), 2);
+}
+
+TEST(TaskTracker, TaskCommand) {
+  auto parsed = ParseTaskCommand(MakeTaskCommand("q1", 42)).ValueOrDie();
+  ASSERT_EQ(parsed.first, "q1");
+  ASSERT_EQ(parsed.second, 42);
+  auto bare = ParseTaskCommand("q1").ValueOrDie();
+  ASSERT_EQ(bare.first, "q1");
+  ASSERT_FALSE(bare.second.has_value());
+  ASSERT_RAISES(Invalid, ParseTaskCommand("q1:"));
+  ASSERT_RAISES(Invalid, ParseTaskCommand("q1:-3"));
+  ASSERT_RAISES(Invalid, ParseTaskCommand("q1:99999999999"));
+}
+
+TEST(TaskTracker, Invalid) {
+  TaskTracker tracker(2, SpeculationOptions{}, time::now());
+  ASSERT_RAISES(Invalid, tracker.Complete(2, time::now()));
+  ASSERT_RAISES(Invalid, tracker.Progress(-1, 1, time::now()));
+}
+
+}  // namespace Buzz
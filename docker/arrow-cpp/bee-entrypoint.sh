@@ -20,6 +20,8 @@ if [ "$1" = 'build' ]; then
     -DARROW_JSON=ON \
     -DARROW_FILESYSTEM=ON \
     -DARROW_WITH_ZLIB=ON \
+    -DARROW_WITH_LZ4=ON \
+    -DARROW_WITH_ZSTD=ON \
     -DARROW_FLIGHT=ON \
     -DCMAKE_PREFIX_PATH=/install \
     -DBUZZ_BUILD_FILE=${BUILD_FILE} \
@@ -43,6 +45,8 @@ elif [ "$1" = 'test' ]; then
     -DARROW_JSON=ON \
     -DARROW_FILESYSTEM=ON \
     -DARROW_WITH_ZLIB=ON \
+    -DARROW_WITH_LZ4=ON \
+    -DARROW_WITH_ZSTD=ON \
     -DARROW_FLIGHT=ON \
     -DCMAKE_PREFIX_PATH=/install \
     -DBUZZ_BUILD_TYPE=${BUILD_TYPE} \
@@ -17,11 +17,37 @@ if [ "$1" = 'build' ]; then
       -DARROW_FILESYSTEM=ON \
       -DARROW_FLIGHT=ON \
       -DARROW_WITH_ZLIB=ON \
+      -DARROW_WITH_LZ4=ON \
+      -DARROW_WITH_ZSTD=ON \
       -DBUZZ_BUILD_FILE=${BUILD_FILE} \
       -DBUZZ_BUILD_TYPE=${BUILD_TYPE} \
       -DBUZZ_BUILD_TESTS=${BUILD_TESTS}
     # -DCMAKE_PREFIX_PATH=/install \
     make
+elif [ "$1" = 'test' ]; then
+    mkdir -p /build
+    cd /build
+    cmake /source -DCMAKE_BUILD_TYPE=Release \
+      -DARROW_BUILD_STATIC=ON \
+      -DARROW_SIMD_LEVEL=SSE4_2 \
+      -DARROW_BUILD_SHARED=OFF \
+      -DARROW_BUILD_TESTS=OFF \
+      -DARROW_CXXFLAGS="-ldl -g" \
+      -DARROW_DEPENDENCY_SOURCE=AUTO \
+      -DARROW_JEMALLOC=ON \
+      -DARROW_PARQUET=ON \
+      -DARROW_JSON=ON \
+      -DARROW_FILESYSTEM=ON \
+      -DARROW_FLIGHT=ON \
+      -DARROW_WITH_ZLIB=ON \
+      -DARROW_WITH_LZ4=ON \
+      -DARROW_WITH_ZSTD=ON \
+      -DBUZZ_BUILD_TYPE=${BUILD_TYPE} \
+      -DBUZZ_BUILD_TESTS=ON \
+      -DBUZZ_CXX_STANDARD=${BUZZ_CXX_STANDARD}
+    make
+    cd /build/util
+    ctest --verbose
 else
     exec "$@"
 fi
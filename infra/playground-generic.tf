@@ -11,6 +11,8 @@ locals {
         AS_DICT : "true"
         BUCKET_NAME : "defaultbucket"
         KEY_NAME : "default.parquet"
+        HIVE_ENDPOINT : ""
+        IPC_COMPRESSION : "auto"
       }
       additional_policies = [aws_iam_policy.s3-additional-policy.arn]
     }
@@ -20,6 +22,36 @@ locals {
         MAX_CONCURRENT_DL : 8
         NB_CONN_INIT : 1
         COLUMN_ID : 16
+        DISTINCT_COUNT : "false"
+        TOP_K : 0
+        QUANTILES : "false"
+        MATERIALIZE : "false"
+        DECOMPRESSION_THREADS : 1
+        BUCKET_NAME : "defaultbucket"
+        KEY_NAME : "default.parquet"
+      }
+      additional_policies = [aws_iam_policy.s3-additional-policy.arn]
+    }
+    parquet-selective-reader = {
+      memory_size = 2048
+      environment = {
+        MAX_CONCURRENT_DL : 8
+        NB_CONN_INIT : 1
+        FILTER_COLUMN_ID : 16
+        FILTER_VALUE : ""
+        PROJECTED_COLUMN_IDS : "0,1"
+        BUCKET_NAME : "defaultbucket"
+        KEY_NAME : "default.parquet"
+      }
+      additional_policies = [aws_iam_policy.s3-additional-policy.arn]
+    }
+    parquet-footer-aggregate = {
+      memory_size = 2048
+      environment = {
+        MAX_CONCURRENT_DL : 8
+        NB_CONN_INIT : 1
+        AGGREGATE : "count"
+        COLUMN_ID : 16
         BUCKET_NAME : "defaultbucket"
         KEY_NAME : "default.parquet"
       }